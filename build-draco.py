@@ -5,6 +5,10 @@ Build Draco static library for multiple platforms.
 Draco is a library for compressing and decompressing 3D geometric meshes
 and point clouds. Used by glTF KHR_draco_mesh_compression extension.
 
+Also builds the C API in third_party/draco-c (libdraco_c), which decodes
+straight into caller-provided interleaved vertex/index buffers and batches
+meshes over a worker pool.
+
 Source: https://github.com/google/draco
 """
 
@@ -138,6 +142,58 @@ def build_draco(source_dir, build_dir, platform, arch, config):
     return cmake_build_dir
 
 
+def build_draco_c(c_api_dir, source_dir, draco_build_dir, build_dir, platform, arch, config):
+    """Build the Draco C API against the Draco build it wraps."""
+    cmake_build_dir = build_dir / f"cmake-build-draco-c-{platform}-{arch}"
+    cmake_build_dir.mkdir(parents=True, exist_ok=True)
+
+    cmake_args = [
+        "cmake",
+        str(c_api_dir),
+        f"-DCMAKE_BUILD_TYPE={config}",
+        f"-DDRACO_SRC_DIR={source_dir}",
+        f"-DDRACO_BUILD_DIR={draco_build_dir}",
+    ]
+    if platform == "win":
+        cmake_args.extend([
+            "-DCMAKE_MSVC_RUNTIME_LIBRARY=MultiThreaded",
+            "-DCMAKE_POLICY_DEFAULT_CMP0091=NEW",
+        ])
+    else:
+        cmake_args.extend(["-G", "Ninja", "-DCMAKE_POSITION_INDEPENDENT_CODE=ON"])
+    cmake_args.extend(get_cmake_arch_flags(platform, arch))
+    run_command(cmake_args, cwd=cmake_build_dir)
+
+    build_cmd = ["cmake", "--build", ".", "--config", config]
+    if platform != "win":
+        build_cmd.extend(["--parallel"])
+    run_command(build_cmd, cwd=cmake_build_dir)
+
+    return cmake_build_dir
+
+
+def get_lib_dir(output_dir, platform, arch):
+    lib_dir = output_dir / f"draco-{platform}" / "lib"
+    if platform == "mac":
+        lib_dir = lib_dir / arch
+    return lib_dir
+
+
+def copy_c_api_lib(cmake_build_dir, output_dir, platform, arch, config):
+    """Copy libdraco_c next to libdraco."""
+    lib_name = "draco_c.lib" if platform == "win" else "libdraco_c.a"
+    lib_src = cmake_build_dir / config / lib_name
+    if not lib_src.exists():
+        lib_src = cmake_build_dir / lib_name
+    if not lib_src.exists():
+        print(f"Error: Could not find {lib_name} in {cmake_build_dir}")
+        sys.exit(1)
+
+    lib_dest = get_lib_dir(output_dir, platform, arch) / lib_name
+    print(f"Copying {lib_src} -> {lib_dest}")
+    shutil.copy2(lib_src, lib_dest)
+
+
 def copy_outputs(cmake_build_dir, output_dir, platform, arch, config):
     """Copy built library and headers to output directory."""
     # Determine library name and location
@@ -159,7 +215,7 @@ def copy_outputs(cmake_build_dir, output_dir, platform, arch, config):
         ext = "*.lib" if platform == "win" else "*.a"
         for f in cmake_build_dir.rglob(ext):
             print(f"  Found: {f}")
-            if "draco" in f.name.lower() and "encoder" not in f.name.lower():
+            if "draco" in f.name.lower() and "encoder" not in f.name.lower() and "draco_c" not in f.name.lower():
                 lib_src = f
                 break
 
@@ -169,9 +225,7 @@ def copy_outputs(cmake_build_dir, output_dir, platform, arch, config):
         sys.exit(1)
 
     # Create output directories
-    lib_dir = output_dir / f"draco-{platform}" / "lib"
-    if platform == "mac":
-        lib_dir = lib_dir / arch
+    lib_dir = get_lib_dir(output_dir, platform, arch)
     lib_dir.mkdir(parents=True, exist_ok=True)
 
     # Copy library
@@ -182,8 +236,8 @@ def copy_outputs(cmake_build_dir, output_dir, platform, arch, config):
     return lib_dest
 
 
-def copy_headers(source_dir, cmake_build_dir, output_dir):
-    """Copy Draco headers including CMake-generated draco_features.h."""
+def copy_headers(source_dir, cmake_build_dir, output_dir, c_api_dir):
+    """Copy Draco headers including CMake-generated draco_features.h and the C API."""
     include_dest = output_dir / "include" / "draco"
     include_dest.mkdir(parents=True, exist_ok=True)
 
@@ -213,12 +267,16 @@ def copy_headers(source_dir, cmake_build_dir, output_dir):
     else:
         print("WARNING: draco_features.h not found - build may fail without it")
 
+    shutil.copy2(c_api_dir / "include" / "draco_c.h", include_dest / "draco_c.h")
+    print("Copied header: draco/draco_c.h")
+
 
 def main():
     args = parse_args()
 
     root_dir = Path(__file__).parent.absolute()
     third_party_dir = root_dir / "third_party"
+    c_api_dir = third_party_dir / "draco-c"
     build_dir = Path(args.out).absolute()
 
     # Download Draco source
@@ -240,9 +298,14 @@ def main():
         # Copy outputs
         copy_outputs(cmake_build_dir, build_dir, args.platform, arch, args.config)
 
+        c_api_build_dir = build_draco_c(
+            c_api_dir, source_dir, cmake_build_dir, build_dir, args.platform, arch, args.config
+        )
+        copy_c_api_lib(c_api_build_dir, build_dir, args.platform, arch, args.config)
+
     # Copy headers (only once, not per-arch) — needs cmake_build_dir for generated headers
     if cmake_build_dir:
-        copy_headers(source_dir, cmake_build_dir, build_dir)
+        copy_headers(source_dir, cmake_build_dir, build_dir, c_api_dir)
 
     print(f"\n{'='*60}")
     print("Build complete!")
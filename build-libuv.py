@@ -5,11 +5,16 @@ Build libuv static library for multiple platforms.
 libuv is a multi-platform support library with a focus on asynchronous I/O.
 Used by Node.js and other projects for event loop and async operations.
 
+Also builds libuvtune (third_party/uvtune): thread-pool sizing with a
+build-time default, io_uring-backed file operations on Linux, and a probe
+that samples event-loop lag and thread-pool queue depth for telemetry.
+
 Source: https://github.com/libuv/libuv
 """
 
 import argparse
 import os
+import platform as host_platform
 import shutil
 import subprocess
 import sys
@@ -28,7 +33,17 @@ def parse_args():
     parser.add_argument("-config", choices=["Release", "Debug"], default="Release")
     parser.add_argument("-out", help="Output directory", default="build")
     parser.add_argument("-version", help="libuv version", default=LIBUV_VERSION)
-    return parser.parse_args()
+    parser.add_argument("-threadpool-size", type=int, default=0,
+                        help="Thread pool size libuvtune applies when UV_THREADPOOL_SIZE is unset "
+                             "(1-1024; 0 keeps libuv's 4)")
+    parser.add_argument("-io-uring", choices=["on", "off"], default="on",
+                        help="Route file operations through io_uring on Linux (libuv >= 1.49)")
+    parser.add_argument("--require-io-uring", action="store_true",
+                        help="Fail if the post-build check sees file reads bypass io_uring (Linux)")
+    args = parser.parse_args()
+    if not 0 <= args.threadpool_size <= 1024:
+        parser.error("-threadpool-size must be between 0 and 1024")
+    return args
 
 
 def run_command(cmd, cwd=None, env=None, shell=False):
@@ -178,6 +193,89 @@ def copy_outputs(cmake_build_dir, output_dir, platform, arch, config):
     return lib_dest
 
 
+def build_uvtune(uvtune_dir, source_dir, libuv_lib, build_dir, platform, arch, config,
+                 threadpool_size, io_uring):
+    """Build libuvtune and its uvtune_check tool against the libuv just built."""
+    cmake_build_dir = build_dir / f"cmake-build-uvtune-{platform}-{arch}"
+    cmake_build_dir.mkdir(parents=True, exist_ok=True)
+
+    cmake_args = [
+        "cmake",
+        str(uvtune_dir),
+        f"-DCMAKE_BUILD_TYPE={config}",
+        f"-DLIBUV_SRC_DIR={source_dir}",
+        f"-DLIBUV_LIB={libuv_lib}",
+        f"-DUVTUNE_DEFAULT_THREADPOOL_SIZE={threadpool_size}",
+        f"-DUVTUNE_IO_URING={'ON' if io_uring else 'OFF'}",
+    ]
+    if platform == "win":
+        cmake_args.extend([
+            "-DCMAKE_MSVC_RUNTIME_LIBRARY=MultiThreaded",
+            "-DCMAKE_POLICY_DEFAULT_CMP0091=NEW",
+        ])
+    else:
+        cmake_args.extend(["-G", "Ninja", "-DCMAKE_POSITION_INDEPENDENT_CODE=ON"])
+    cmake_args.extend(get_cmake_arch_flags(platform, arch))
+    run_command(cmake_args, cwd=cmake_build_dir)
+
+    build_cmd = ["cmake", "--build", ".", "--config", config]
+    if platform != "win":
+        build_cmd.extend(["--parallel"])
+    run_command(build_cmd, cwd=cmake_build_dir)
+
+    lib_name = "uvtune.lib" if platform == "win" else "libuvtune.a"
+    lib_src = cmake_build_dir / config / lib_name
+    if not lib_src.exists():
+        lib_src = cmake_build_dir / lib_name
+    if not lib_src.exists():
+        print(f"Error: Could not find {lib_name} in {cmake_build_dir}")
+        sys.exit(1)
+    lib_dest = Path(libuv_lib).parent / lib_name
+    print(f"Copying {lib_src} -> {lib_dest}")
+    shutil.copy2(lib_src, lib_dest)
+
+    return cmake_build_dir
+
+
+def is_host_target(platform, arch):
+    host = {"darwin": "mac", "linux": "linux", "win32": "win"}.get(sys.platform)
+    machine = host_platform.machine().lower()
+    host_arch = {"x86_64": "x64", "amd64": "x64", "aarch64": "arm64"}.get(machine, machine)
+    return platform == host and {"x86_64": "x64"}.get(arch, arch) == host_arch
+
+
+def check_uvtune(cmake_build_dir, lib_dir, platform, arch, config, io_uring, require_io_uring):
+    """Run uvtune_check on the host and record what it saw next to the libs."""
+    exe = "uvtune_check.exe" if platform == "win" else "uvtune_check"
+    check_bin = cmake_build_dir / config / exe
+    if not check_bin.exists():
+        check_bin = cmake_build_dir / exe
+
+    if not is_host_target(platform, arch):
+        print(f"Skipping uvtune_check for {platform} {arch} (not runnable on this host)")
+        return
+
+    print(f"Running: {check_bin}")
+    result = subprocess.run([str(check_bin)], capture_output=True, text=True)
+    print(result.stdout, end="")
+    if result.returncode != 0:
+        print(result.stderr, end="")
+        print("Error: thread pool did not run with the configured size")
+        sys.exit(1)
+
+    values = dict(line.split("=", 1) for line in result.stdout.splitlines() if "=" in line)
+    if platform == "linux" and io_uring and values.get("io_uring") != "1":
+        message = "file reads did not go through io_uring (kernel too old, io_uring disabled or seccomp)"
+        if require_io_uring:
+            print(f"Error: {message}")
+            sys.exit(1)
+        print(f"WARNING: {message}")
+
+    with open(lib_dir / "build_config.txt", "w") as f:
+        for key in ["threadpool_size", "threadpool_observed", "io_uring"]:
+            f.write(f"{key}={values.get(key, 'unknown')}\n")
+
+
 def copy_headers(source_dir, output_dir):
     """Copy libuv headers."""
     include_src = source_dir / "include"
@@ -199,13 +297,19 @@ def copy_headers(source_dir, output_dir):
         shutil.copytree(uv_subdir, uv_dest)
         print(f"Copied uv/ header directory")
 
+    uvtune_header = Path(__file__).parent.absolute() / "third_party" / "uvtune" / "include" / "uvtune.h"
+    shutil.copy2(uvtune_header, include_dest / "uvtune.h")
+    print("Copying header: uvtune.h")
+
 
 def main():
     args = parse_args()
 
     root_dir = Path(__file__).parent.absolute()
     third_party_dir = root_dir / "third_party"
+    uvtune_dir = third_party_dir / "uvtune"
     build_dir = Path(args.out).absolute()
+    io_uring = args.io_uring == "on"
 
     # Download libuv source
     source_dir = download_libuv(args.version, third_party_dir)
@@ -223,7 +327,14 @@ def main():
         )
 
         # Copy outputs
-        copy_outputs(cmake_build_dir, build_dir, args.platform, arch, args.config)
+        libuv_lib = copy_outputs(cmake_build_dir, build_dir, args.platform, arch, args.config)
+
+        uvtune_build_dir = build_uvtune(
+            uvtune_dir, source_dir, libuv_lib, build_dir, args.platform, arch, args.config,
+            args.threadpool_size, io_uring
+        )
+        check_uvtune(uvtune_build_dir, libuv_lib.parent, args.platform, arch, args.config,
+                     io_uring, args.require_io_uring)
 
     # Copy headers (only once, not per-arch)
     copy_headers(source_dir, build_dir)
@@ -20,6 +20,18 @@ from pathlib import Path
 LLAMACPP_VERSION = "b5604"
 LLAMACPP_URL = f"https://github.com/ggerganov/llama.cpp/archive/refs/tags/{LLAMACPP_VERSION}.zip"
 
+# x86-64 CPU variants (-cpu-variant, Linux/Windows x64). "generic" is the portable
+# baseline; avx2/avx512 are separately named libs for hosts known to support the
+# ISA; "dispatch" builds ggml's runtime-selected CPU backends (GGML_BACKEND_DL +
+# GGML_CPU_ALL_VARIANTS) as shared libraries loaded with ggml_backend_load_all().
+AVX2_FLAGS = ["-DGGML_AVX=ON", "-DGGML_AVX2=ON", "-DGGML_FMA=ON", "-DGGML_F16C=ON"]
+CPU_VARIANT_FLAGS = {
+    "generic": ["-DGGML_NATIVE=OFF"],
+    "avx2": ["-DGGML_NATIVE=OFF"] + AVX2_FLAGS,
+    "avx512": ["-DGGML_NATIVE=OFF"] + AVX2_FLAGS + ["-DGGML_AVX512=ON"],
+    "dispatch": ["-DGGML_NATIVE=OFF", "-DGGML_BACKEND_DL=ON", "-DGGML_CPU_ALL_VARIANTS=ON"],
+}
+
 
 def parse_args():
     parser = argparse.ArgumentParser(description="Build llama.cpp static libraries")
@@ -30,7 +42,26 @@ def parse_args():
     parser.add_argument("-out", help="Output directory", default="build")
     parser.add_argument("-version", help="llama.cpp version/tag", default=LLAMACPP_VERSION)
     parser.add_argument("-ndk", help="Android NDK path", default=None)
-    return parser.parse_args()
+    parser.add_argument("-cpu-variant", dest="cpu_variant", choices=list(CPU_VARIANT_FLAGS),
+                        default="generic",
+                        help="x86-64 CPU variant for linux/win (default: generic)")
+    parser.add_argument("--vulkan", action="store_true",
+                        help="Enable the GGML Vulkan backend (android/linux; needs the Vulkan SDK and glslc)")
+    args = parser.parse_args()
+
+    if args.cpu_variant != "generic" and args.platform not in ("linux", "win"):
+        parser.error("-cpu-variant is only supported for linux and win")
+    if args.vulkan and args.platform not in ("android", "linux"):
+        parser.error("--vulkan is only supported for android and linux")
+    return args
+
+
+def variant_suffix(cpu_variant, vulkan):
+    """Output directory suffix, so variants sit next to the generic build."""
+    suffix = {"generic": "", "dispatch": "-dl"}.get(cpu_variant, f"-{cpu_variant}")
+    if vulkan:
+        suffix += "-vulkan"
+    return suffix
 
 
 def run_command(cmd, cwd=None, env=None, shell=False):
@@ -89,11 +120,13 @@ def get_ndk_path(args_ndk):
     sys.exit(1)
 
 
-def get_cmake_flags(platform, arch, config, ndk_path=None):
+def get_cmake_flags(platform, arch, config, ndk_path=None, cpu_variant="generic", vulkan=False):
     """Get CMake configure flags for the target."""
+    # GGML_BACKEND_DL loads backends as modules, which requires shared libraries
+    shared = cpu_variant == "dispatch"
     flags = [
         f"-DCMAKE_BUILD_TYPE={config}",
-        "-DBUILD_SHARED_LIBS=OFF",
+        f"-DBUILD_SHARED_LIBS={'ON' if shared else 'OFF'}",
         "-DLLAMA_BUILD_TESTS=OFF",
         "-DLLAMA_BUILD_EXAMPLES=OFF",
         "-DLLAMA_BUILD_SERVER=OFF",
@@ -144,8 +177,8 @@ def get_cmake_flags(platform, arch, config, ndk_path=None):
         }
         abi = abi_map.get(arch, "arm64-v8a")
         flags.append(f"-DANDROID_ABI={abi}")
-        # CPU-only on Android (Vulkan requires glslc which CI runners lack)
-        flags.append("-DGGML_VULKAN=OFF")
+        # CPU-only unless --vulkan (Vulkan requires glslc which CI runners lack)
+        flags.append(f"-DGGML_VULKAN={'ON' if vulkan else 'OFF'}")
         flags.append("-DGGML_OPENMP=OFF")
         flags.extend(["-G", "Ninja"])
 
@@ -154,6 +187,9 @@ def get_cmake_flags(platform, arch, config, ndk_path=None):
         flags.append("-DCMAKE_POSITION_INDEPENDENT_CODE=ON")
         # CPU-only by default; CUDA can be enabled with -DGGML_CUDA=ON
         flags.append("-DGGML_CUDA=OFF")
+        flags.extend(CPU_VARIANT_FLAGS[cpu_variant])
+        if vulkan:
+            flags.append("-DGGML_VULKAN=ON")
 
     elif platform == "win":
         if arch in ("x64", "x86_64"):
@@ -163,17 +199,20 @@ def get_cmake_flags(platform, arch, config, ndk_path=None):
         # Static CRT
         flags.append("-DCMAKE_MSVC_RUNTIME_LIBRARY=MultiThreaded")
         flags.append("-DCMAKE_POLICY_DEFAULT_CMP0091=NEW")
+        flags.extend(CPU_VARIANT_FLAGS[cpu_variant])
 
     return flags
 
 
-def build_llamacpp(source_dir, build_dir, platform, arch, config, ndk_path=None):
+def build_llamacpp(source_dir, build_dir, platform, arch, config, ndk_path=None,
+                   cpu_variant="generic", vulkan=False):
     """Build llama.cpp using CMake."""
-    cmake_build_dir = build_dir / f"cmake-build-llamacpp-{platform}-{arch}"
+    suffix = variant_suffix(cpu_variant, vulkan)
+    cmake_build_dir = build_dir / f"cmake-build-llamacpp-{platform}{suffix}-{arch}"
     cmake_build_dir.mkdir(parents=True, exist_ok=True)
 
     cmake_args = ["cmake", str(source_dir)]
-    cmake_args.extend(get_cmake_flags(platform, arch, config, ndk_path))
+    cmake_args.extend(get_cmake_flags(platform, arch, config, ndk_path, cpu_variant, vulkan))
 
     # Configure
     run_command(cmake_args, cwd=cmake_build_dir)
@@ -187,42 +226,58 @@ def build_llamacpp(source_dir, build_dir, platform, arch, config, ndk_path=None)
     return cmake_build_dir
 
 
-def find_libraries(cmake_build_dir, platform):
-    """Find all built static libraries."""
-    ext = "*.lib" if platform == "win" else "*.a"
-    libs = {}
+def library_patterns(platform, shared):
+    """Glob patterns for the built libraries (dispatch builds are shared)."""
+    if platform == "win":
+        # Import libraries (.lib) plus the DLLs for shared builds
+        return ["*.lib", "*.dll"] if shared else ["*.lib"]
+    if shared:
+        # ggml's dynamically loaded CPU backends are CMake MODULEs: .so on macOS too
+        return ["*.dylib", "*.so"] if platform == "mac" else ["*.so"]
+    return ["*.a"]
+
 
-    # Key libraries we want from llama.cpp
-    wanted = ["llama", "ggml", "common"]
+def find_libraries(cmake_build_dir, platform, shared=False):
+    """Find all built libraries."""
+    libs = {}
 
-    for f in cmake_build_dir.rglob(ext):
-        name = f.stem.lower()
-        # Remove 'lib' prefix on Unix
-        if name.startswith("lib"):
-            name = name[3:]
-        # Check if this is a library we want
-        for w in wanted:
-            if w in name:
-                libs[f.name] = f
-                break
+    # Key libraries we want from llama.cpp. common is a static library even in
+    # shared (dispatch) builds, so it is also looked for among the static patterns.
+    searches = [(library_patterns(platform, shared), ["llama", "ggml", "common"])]
+    if shared:
+        searches.append((library_patterns(platform, False), ["common"]))
+
+    for patterns, wanted in searches:
+        for f in (f for pattern in patterns for f in cmake_build_dir.rglob(pattern)):
+            name = f.stem.lower()
+            # Remove 'lib' prefix on Unix
+            if name.startswith("lib"):
+                name = name[3:]
+            # Check if this is a library we want
+            for w in wanted:
+                if w in name:
+                    libs[f.name] = f
+                    break
 
     return libs
 
 
-def copy_outputs(cmake_build_dir, output_dir, platform, arch, config):
+def copy_outputs(cmake_build_dir, output_dir, platform, arch, config,
+                 cpu_variant="generic", vulkan=False):
     """Copy built libraries to output directory."""
-    libs = find_libraries(cmake_build_dir, platform)
+    shared = cpu_variant == "dispatch"
+    libs = find_libraries(cmake_build_dir, platform, shared)
 
     if not libs:
         print(f"Error: No libraries found in {cmake_build_dir}")
         # List what's there for debugging
-        ext = "*.lib" if platform == "win" else "*.a"
-        for f in cmake_build_dir.rglob(ext):
-            print(f"  Found: {f}")
+        for pattern in library_patterns(platform, shared):
+            for f in cmake_build_dir.rglob(pattern):
+                print(f"  Found: {f}")
         sys.exit(1)
 
     # Create output directory
-    lib_dir = output_dir / f"llamacpp-{platform}" / "lib"
+    lib_dir = output_dir / f"llamacpp-{platform}{variant_suffix(cpu_variant, vulkan)}" / "lib"
     if platform in ("mac", "ios"):
         lib_dir = lib_dir / arch
     lib_dir.mkdir(parents=True, exist_ok=True)
@@ -288,15 +343,17 @@ def main():
 
     for arch in archs:
         print(f"\n{'='*60}")
-        print(f"Building llama.cpp for {args.platform} {arch} ({args.config})")
+        print(f"Building llama.cpp for {args.platform} {arch} ({args.config}, "
+              f"cpu={args.cpu_variant}{', vulkan' if args.vulkan else ''})")
         print(f"{'='*60}\n")
 
         cmake_build_dir = build_llamacpp(
             source_dir, build_dir, args.platform, arch, args.config,
-            ndk_path=args.ndk,
+            ndk_path=args.ndk, cpu_variant=args.cpu_variant, vulkan=args.vulkan,
         )
 
-        copy_outputs(cmake_build_dir, build_dir, args.platform, arch, args.config)
+        copy_outputs(cmake_build_dir, build_dir, args.platform, arch, args.config,
+                     cpu_variant=args.cpu_variant, vulkan=args.vulkan)
 
     # Copy headers once
     copy_headers(source_dir, build_dir)
@@ -0,0 +1,619 @@
+#!/usr/bin/env python3
+
+"""
+build-matrix.py
+
+Runs several build-*.py jobs concurrently under one compile job budget, and reuses
+their outputs from a content-addressed cache when nothing that feeds a job changed.
+
+Usage:
+    python3 build-matrix.py <job> [<job> ...] [options]
+    python3 build-matrix.py -matrix linux [options]
+
+A job is <library>:<platform>[:<extra args>], for example:
+    skia:linux
+    skia:android:"-archs arm64,x64"
+    llamacpp:linux:"-cpu-variant avx2"
+
+Options:
+    -matrix NAME          Add the preset job list for a host (see MATRICES)
+    -jobs N               Compile jobs shared by all running builds (default: CPU count)
+    -concurrency N        Builds running at once (default: jobs / 8, at least 1)
+    -cache DIR            Cache directory (default: build/cache)
+    -compiler-cache TOOL  auto, ccache, sccache or none (default: auto)
+    --no-cache            Always build; successful results are still stored
+    --dry-run             Print the jobs, their cache keys and cache hits, then exit
+
+Scheduling:
+    Jobs of different libraries run concurrently. Each build gets jobs/concurrency
+    compile jobs, through ninja -j for Skia, CMAKE_BUILD_PARALLEL_LEVEL for CMake
+    and CARGO_BUILD_JOBS for cargo. Skia syncs its checkout once (--sync-only), and
+    then every Skia job builds from it (--no-sync) with its archs in parallel. For the
+    other libraries, the first job of each library downloads the source, and the
+    rest of that library's jobs start once it has finished. libwebp jobs run one at
+    a time because every run resets the shared checkout.
+
+Cache:
+    The key hashes these inputs:
+    - the build script and the patches/ directory
+    - the job arguments
+    - the source revision: branch heads are resolved with git ls-remote, and Skia
+      is pinned to the resolved commit
+    - compiler, CMake and Rust versions, plus NDK/SDK environment variables
+    - for Skia, the GN args printed by build-skia.py --print-gn-args
+    CMake flags are computed by the build scripts from their arguments, so the
+    script hash plus the arguments cover them. An entry holds the job's output
+    directories under build/, and a hit copies them back instead of building.
+
+Copyright (c) 2024-2026 Oli Larkin
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+"""
+
+import argparse
+import hashlib
+import json
+import os
+import shlex
+import shutil
+import subprocess
+import sys
+import threading
+import time
+from concurrent.futures import FIRST_COMPLETED, ThreadPoolExecutor, wait
+from pathlib import Path
+
+# Define ANSI color codes
+class Colors:
+    HEADER = '\033[95m'
+    OKBLUE = '\033[94m'
+    OKCYAN = '\033[96m'
+    OKGREEN = '\033[92m'
+    WARNING = '\033[93m'
+    FAIL = '\033[91m'
+    ENDC = '\033[0m'
+    BOLD = '\033[1m'
+    UNDERLINE = '\033[4m'
+
+_print_lock = threading.Lock()
+
+def colored_print(message, color):
+    with _print_lock:
+        print(f"{color}{message}{Colors.ENDC}", flush=True)
+
+ROOT_DIR = Path(__file__).resolve().parent
+BASE_DIR = ROOT_DIR / "build"
+LOG_DIR = BASE_DIR / "logs"
+
+# Bump to invalidate every cache entry (e.g. when the entry layout changes)
+CACHE_KEY_VERSION = 1
+
+# Build products that in-place builds leave inside hashed source trees (cargo's
+# target/ in third_party/swc-static, local CMake build dirs)
+HASH_SKIP_DIRS = {"target", "build", "__pycache__"}
+
+
+def arg_value(args, name, default=None):
+    """Value of `-name value` in an argument list, else default."""
+    if name in args:
+        index = args.index(name)
+        if index + 1 < len(args):
+            return args[index + 1]
+    return default
+
+
+def skia_outputs(platform, args):
+    variant = arg_value(args, "-variant", "gpu")
+    headers = ["include/include", "include/modules", "include/src", "include/third_party",
+               "include/dawn", "include/webgpu", "share"]
+    if variant == "traced":
+        headers.append("include/trace_shim")  # libtrace_shim sits in the lib dir
+    if platform == "xcframework":
+        return [f"mac-{variant}", f"ios-{variant}", "xcframework"] + headers
+    crt_suffix = "-md" if platform == "win" and arg_value(args, "-crt") == "dynamic" else ""
+    return [f"{platform}-{variant}{crt_suffix}"] + headers
+
+
+def skia_sources(platform, args):
+    variant = arg_value(args, "-variant", "gpu")
+    sources = []
+    if variant == "traced":
+        sources.append("third_party/trace-shim")
+    # PGO training (unless -profile is given) and --link-report build example/
+    if (variant == "gpu-pgo" and "-profile" not in args) or "--link-report" in args:
+        sources.append("example")
+    return sources
+
+
+def webp_outputs(platform, args):
+    crt_suffix = "-md" if platform == "win" and arg_value(args, "-crt") == "dynamic" else ""
+    return [f"webp-{platform}{crt_suffix}", "include/webp", "include/sharpyuv"]
+
+
+def ggml_outputs(name):
+    def outputs(platform, args):
+        suffix = {"avx2": "-avx2", "avx512": "-avx512", "dispatch": "-dl"}.get(
+            arg_value(args, "-cpu-variant", "generic"), "")
+        if "--vulkan" in args:
+            suffix += "-vulkan"
+        return [f"{name}-{platform}{suffix}", f"include/{name}"]
+    return outputs
+
+
+# Per library: build script, output paths under build/ (a function of platform and
+# args), in-repo source trees the build compiles (same signature, hashed into the
+# cache key; default none), how jobs of the same library are ordered, and where
+# branch heads resolve.
+#   order: "sync" (Skia: one --sync-only step, then concurrent --no-sync jobs),
+#          "lead" (first job fetches the source, the rest follow concurrently),
+#          "serial" (jobs share a checkout that every run resets)
+LIBRARIES = {
+    "skia": {
+        "script": "build-skia.py",
+        "outputs": skia_outputs,
+        "sources": skia_sources,
+        "order": "sync",
+        "git_url": "https://github.com/google/skia.git",
+        "branch_arg": "-branch", "default_branch": "main", "commit_arg": "-commit",
+    },
+    "webp": {
+        "script": "build-webp.py",
+        "outputs": webp_outputs,
+        "order": "serial",
+        "git_url": "https://chromium.googlesource.com/webm/libwebp",
+        "branch_arg": "-branch", "default_branch": "main",
+    },
+    "draco": {
+        "script": "build-draco.py",
+        "outputs": lambda platform, args: [f"draco-{platform}", "include/draco"],
+        "sources": lambda platform, args: ["third_party/draco-c"],
+        "order": "lead",
+    },
+    "libuv": {
+        "script": "build-libuv.py",
+        "outputs": lambda platform, args: [f"libuv-{platform}", "include/uv.h", "include/uv",
+                                           "include/uvtune.h"],
+        "sources": lambda platform, args: ["third_party/uvtune"],
+        "order": "lead",
+    },
+    "llamacpp": {
+        "script": "build-llamacpp.py",
+        "outputs": ggml_outputs("llamacpp"),
+        "order": "lead",
+    },
+    "whispercpp": {
+        "script": "build-whispercpp.py",
+        "outputs": ggml_outputs("whispercpp"),
+        "order": "lead",
+    },
+    "sherpaonnx": {
+        "script": "build-sherpaonnx.py",
+        "outputs": lambda platform, args: [f"sherpaonnx-{platform}", "include/sherpaonnx"],
+        "sources": lambda platform, args: ["third_party/sherpa-onnx-shared"],
+        "order": "lead",
+    },
+    "moshi": {
+        "script": "build-moshi.py",
+        "outputs": lambda platform, args: [f"moshi-{platform}", "include/moshi"],
+        "order": "lead",
+    },
+    "quiche": {
+        "script": "build-quiche.py",
+        "outputs": lambda platform, args: [f"quiche-{platform}", "include/quiche.h",
+                                           "include/quiche_udp.h"],
+        "sources": lambda platform, args: ["third_party/quiche-udp"],
+        "order": "lead",
+    },
+    "swc": {
+        "script": "build-swc.py",
+        "outputs": lambda platform, args: [f"swc-{platform}", "include/swc.h"],
+        "sources": lambda platform, args: ["third_party/swc-static"],
+        "order": "lead",
+    },
+    "qwen3speech": {
+        "script": "build-qwen3speech.py",
+        "outputs": lambda platform, args: ["qwen3speech-mac"],
+        "order": "lead",
+    },
+}
+
+# Preset job lists per build host (-matrix NAME)
+MATRICES = {
+    "linux": [
+        "skia:linux", "skia:linux:-variant cpu", "skia:android:-archs arm64,x64", "skia:wasm",
+        "webp:linux", "webp:android", "webp:wasm",
+        "llamacpp:linux", "llamacpp:linux:-cpu-variant avx2", "llamacpp:android",
+        "whispercpp:linux", "whispercpp:linux:-cpu-variant avx2", "whispercpp:android",
+        "sherpaonnx:linux", "sherpaonnx:android",
+        "moshi:linux", "quiche:linux", "quiche:android",
+        "draco:linux", "libuv:linux", "swc:linux",
+    ],
+    "mac": [
+        "skia:mac", "skia:ios", "skia:visionos",
+        "webp:mac", "webp:ios", "webp:visionos",
+        "llamacpp:mac", "llamacpp:ios", "whispercpp:mac", "whispercpp:ios",
+        "sherpaonnx:mac", "sherpaonnx:ios",
+        "moshi:mac", "quiche:mac", "quiche:ios",
+        "draco:mac", "libuv:mac", "swc:mac", "qwen3speech:mac",
+    ],
+    "win": [
+        "skia:win", "skia:win:-crt dynamic",
+        "webp:win",
+        "llamacpp:win", "llamacpp:win:-cpu-variant avx2", "whispercpp:win",
+        "sherpaonnx:win", "moshi:win", "quiche:win",
+        "draco:win", "libuv:win", "swc:win",
+    ],
+}
+
+
+class Job:
+    def __init__(self, spec):
+        parts = spec.split(":", 2)
+        if len(parts) < 2 or parts[0] not in LIBRARIES:
+            raise ValueError(f"Invalid job '{spec}' (expected <library>:<platform>[:<args>], "
+                             f"library one of {', '.join(LIBRARIES)})")
+        self.spec = spec
+        self.library = parts[0]
+        self.platform = parts[1]
+        self.args = shlex.split(parts[2]) if len(parts) > 2 else []
+        self.info = LIBRARIES[self.library]
+        self.name = "-".join([self.library, self.platform] +
+                             [a.lstrip("-").replace(",", "_") for a in self.args])
+        self.after = []  # Jobs that must have finished (successfully or not) first
+        self.revision = ""  # Resolved source commit for git-backed libraries
+        self.key = None
+        self.hit = False  # Cache entry exists for key
+        self.status = "pending"
+        self.seconds = 0.0
+
+    def command(self, build_jobs, compiler_cache):
+        command = [sys.executable, str(ROOT_DIR / self.info["script"]), self.platform] + self.args
+        if self.library == "skia":
+            command += ["--no-sync", "--parallel-archs", "-jobs", str(build_jobs)]
+            if compiler_cache:
+                command += ["-cc-wrapper", compiler_cache]
+        return command
+
+    def outputs(self):
+        return self.info["outputs"](self.platform, self.args)
+
+    def sources(self):
+        return self.info.get("sources", lambda platform, args: [])(self.platform, self.args)
+
+
+class BuildMatrix:
+    def __init__(self):
+        self.jobs = []
+        self.build_jobs = os.cpu_count() or 4
+        self.concurrency = None
+        self.cache_dir = BASE_DIR / "cache"
+        self.compiler_cache = None
+        self.use_cache = True
+        self.dry_run = False
+        self.toolchain = None
+
+    def parse_arguments(self):
+        parser = argparse.ArgumentParser(
+            description="Build several libraries/platforms concurrently with a shared job budget and cache")
+        parser.add_argument("specs", nargs="*", help="Jobs as <library>:<platform>[:<extra args>]")
+        parser.add_argument("-matrix", choices=list(MATRICES), help="Add the preset jobs for a build host")
+        parser.add_argument("-jobs", type=int, default=os.cpu_count() or 4,
+                            help="Compile jobs shared by all running builds (default: CPU count)")
+        parser.add_argument("-concurrency", type=int, help="Builds running at once (default: jobs / 8)")
+        parser.add_argument("-cache", help="Cache directory (default: build/cache)")
+        parser.add_argument("-compiler-cache", choices=["auto", "ccache", "sccache", "none"], default="auto",
+                            help="Compiler launcher for C/C++ (and Rust with sccache)")
+        parser.add_argument("--no-cache", action="store_true", help="Always build (results are still stored)")
+        parser.add_argument("--dry-run", action="store_true", help="Print jobs and cache keys, then exit")
+        args = parser.parse_args()
+
+        specs = list(args.specs)
+        if args.matrix:
+            specs += MATRICES[args.matrix]
+        if not specs:
+            parser.error("no jobs given (pass job specs or -matrix)")
+        try:
+            self.jobs = [Job(spec) for spec in dict.fromkeys(specs)]
+        except ValueError as e:
+            parser.error(str(e))
+
+        if args.jobs < 1 or (args.concurrency is not None and args.concurrency < 1):
+            parser.error("-jobs and -concurrency must be at least 1")
+        self.build_jobs = args.jobs
+        self.concurrency = args.concurrency or max(1, args.jobs // 8)
+        self.concurrency = min(self.concurrency, len(self.jobs))
+        if args.cache:
+            self.cache_dir = Path(args.cache).resolve()
+        self.compiler_cache = self.find_compiler_cache(args.compiler_cache)
+        self.use_cache = not args.no_cache
+        self.dry_run = args.dry_run
+
+    def find_compiler_cache(self, choice):
+        if choice == "none":
+            return None
+        if choice == "auto":
+            # sccache also covers rustc; ccache only C/C++
+            for tool in ["sccache", "ccache"]:
+                if shutil.which(tool):
+                    return tool
+            return None
+        if not shutil.which(choice):
+            colored_print(f"Error: {choice} not found on PATH", Colors.FAIL)
+            sys.exit(1)
+        return choice
+
+    # ----- ordering -----
+
+    def order_jobs(self):
+        by_library = {}
+        for job in self.jobs:
+            by_library.setdefault(job.library, []).append(job)
+        for library, jobs in by_library.items():
+            order = LIBRARIES[library]["order"]
+            for i, job in enumerate(jobs[1:], start=1):
+                if order == "lead":
+                    job.after = [jobs[0]]
+                elif order == "serial":
+                    job.after = [jobs[i - 1]]
+
+    # ----- source revisions -----
+
+    def resolve_revisions(self):
+        """Pin every git-backed job to one commit so its key names what gets built."""
+        skia_commits = set()
+        for job in self.jobs:
+            info = job.info
+            if "git_url" not in info:
+                continue
+            commit = arg_value(job.args, info.get("commit_arg")) if info.get("commit_arg") else None
+            if not commit:
+                branch = arg_value(job.args, info["branch_arg"], info["default_branch"])
+                commit = self.ls_remote(info["git_url"], branch)
+                if info.get("commit_arg"):
+                    job.args += [info["commit_arg"], commit]
+            job.revision = commit
+            if job.library == "skia":
+                skia_commits.add(commit)
+        if len(skia_commits) > 1:
+            colored_print("Error: all skia jobs must build the same branch/commit "
+                          "(they share one checkout)", Colors.FAIL)
+            sys.exit(1)
+
+    def ls_remote(self, url, branch):
+        result = subprocess.run(["git", "ls-remote", url, f"refs/heads/{branch}", f"refs/tags/{branch}"],
+                                capture_output=True, text=True)
+        lines = result.stdout.split()
+        if result.returncode != 0 or not lines:
+            colored_print(f"Error: cannot resolve {branch} at {url}", Colors.FAIL)
+            sys.exit(1)
+        return lines[0]
+
+    # ----- cache keys -----
+
+    def tool_version(self, command):
+        try:
+            result = subprocess.run(command, capture_output=True, text=True, timeout=60)
+            return result.stdout.strip().splitlines()[0] if result.stdout.strip() else ""
+        except (OSError, subprocess.TimeoutExpired):
+            return ""
+
+    def toolchain_fingerprint(self):
+        if self.toolchain is None:
+            parts = [
+                sys.platform,
+                self.tool_version(["clang", "--version"]),
+                self.tool_version(["cc", "--version"]),
+                self.tool_version(["cmake", "--version"]),
+                self.tool_version(["rustc", "--version"]),
+            ]
+            if sys.platform == "darwin":
+                parts.append(self.tool_version(["xcrun", "--show-sdk-version"]))
+            for var in ["ANDROID_NDK_HOME", "ANDROID_NDK_ROOT", "EMSDK", "MACOSX_DEPLOYMENT_TARGET"]:
+                parts.append(f"{var}={os.environ.get(var, '')}")
+            self.toolchain = "\n".join(parts)
+        return self.toolchain
+
+    def hash_tree(self, digest, path):
+        for file in sorted(p for p in path.rglob("*") if p.is_file()):
+            rel = file.relative_to(path)
+            if any(part in HASH_SKIP_DIRS or part.startswith(".") for part in rel.parts[:-1]):
+                continue
+            digest.update(str(rel).encode())
+            digest.update(file.read_bytes())
+
+    def compute_key(self, job):
+        digest = hashlib.sha256()
+        digest.update(f"v{CACHE_KEY_VERSION}\n{job.library}\n{job.platform}\n".encode())
+        digest.update(json.dumps(job.args).encode())
+        digest.update((ROOT_DIR / job.info["script"]).read_bytes())
+        if (ROOT_DIR / "patches").is_dir():
+            self.hash_tree(digest, ROOT_DIR / "patches")
+        for rel in job.sources():
+            digest.update(f"{rel}\n".encode())
+            self.hash_tree(digest, ROOT_DIR / rel)
+        digest.update(job.revision.encode())
+        digest.update(self.toolchain_fingerprint().encode())
+        if job.library == "skia":
+            result = subprocess.run([sys.executable, str(ROOT_DIR / "build-skia.py"), job.platform] +
+                                    job.args + ["--print-gn-args"], capture_output=True, text=True)
+            if result.returncode != 0:
+                colored_print(f"Error: --print-gn-args failed for {job.spec}:\n{result.stderr}", Colors.FAIL)
+                sys.exit(1)
+            digest.update(result.stdout.encode())
+        return digest.hexdigest()
+
+    def entry_dir(self, key):
+        return self.cache_dir / key[:2] / key
+
+    # ----- cache store/restore -----
+
+    def restore(self, job):
+        entry = self.entry_dir(job.key)
+        manifest = entry / "manifest.json"
+        if not manifest.exists():
+            return False
+        for rel in json.loads(manifest.read_text())["outputs"]:
+            src = entry / "files" / rel
+            dest = BASE_DIR / rel
+            dest.parent.mkdir(parents=True, exist_ok=True)
+            if src.is_dir():
+                shutil.copytree(src, dest, dirs_exist_ok=True)
+            elif src.exists():
+                shutil.copy2(src, dest)
+        return True
+
+    def store(self, job):
+        entry = self.entry_dir(job.key)
+        staging = entry.parent / f".{job.key}.{os.getpid()}.tmp"
+        shutil.rmtree(staging, ignore_errors=True)
+        stored = []
+        for rel in job.outputs():
+            src = BASE_DIR / rel
+            dest = staging / "files" / rel
+            if src.is_dir():
+                shutil.copytree(src, dest)
+            elif src.exists():
+                dest.parent.mkdir(parents=True, exist_ok=True)
+                shutil.copy2(src, dest)
+            else:
+                continue
+            stored.append(rel)
+        if not stored:
+            shutil.rmtree(staging, ignore_errors=True)
+            colored_print(f"Warning: {job.name} produced none of {job.outputs()}, not cached", Colors.WARNING)
+            return
+        (staging / "manifest.json").write_text(json.dumps({
+            "job": job.spec, "key": job.key, "outputs": stored,
+            "created": time.strftime("%Y-%m-%dT%H:%M:%SZ", time.gmtime()),
+        }, indent=2))
+        # Publish atomically: a concurrent reader sees either no entry or a complete one
+        shutil.rmtree(entry, ignore_errors=True)
+        os.replace(staging, entry)
+
+    # ----- running -----
+
+    def job_env(self, build_jobs):
+        env = dict(os.environ)
+        env["CMAKE_BUILD_PARALLEL_LEVEL"] = str(build_jobs)
+        env["CARGO_BUILD_JOBS"] = str(build_jobs)
+        if self.compiler_cache:
+            env["CMAKE_C_COMPILER_LAUNCHER"] = self.compiler_cache
+            env["CMAKE_CXX_COMPILER_LAUNCHER"] = self.compiler_cache
+            if self.compiler_cache == "ccache":
+                # Hits across checkouts in different directories
+                env.setdefault("CCACHE_BASEDIR", str(ROOT_DIR))
+            else:
+                env.setdefault("RUSTC_WRAPPER", "sccache")
+        return env
+
+    def run_logged(self, name, command, env):
+        LOG_DIR.mkdir(parents=True, exist_ok=True)
+        log_path = LOG_DIR / f"{name}.log"
+        with open(log_path, "w") as log:
+            log.write(f"$ {' '.join(command)}\n")
+            log.flush()
+            result = subprocess.run(command, cwd=str(ROOT_DIR), env=env,
+                                    stdout=log, stderr=subprocess.STDOUT)
+        if result.returncode != 0:
+            tail = log_path.read_text(errors="replace").splitlines()[-40:]
+            colored_print(f"[{name}] failed (exit {result.returncode}), last lines of {log_path}:\n"
+                          + "\n".join(tail), Colors.FAIL)
+        return result.returncode == 0
+
+    def run_job(self, job, build_jobs):
+        start = time.monotonic()
+        if self.use_cache and self.restore(job):
+            job.status = "cached"
+        else:
+            colored_print(f"[{job.name}] building ({build_jobs} jobs)...", Colors.OKBLUE)
+            if self.run_logged(job.name, job.command(build_jobs, self.compiler_cache), self.job_env(build_jobs)):
+                job.status = "built"
+                self.store(job)
+            else:
+                job.status = "failed"
+        job.seconds = time.monotonic() - start
+        color = Colors.FAIL if job.status == "failed" else Colors.OKGREEN
+        colored_print(f"[{job.name}] {job.status} in {job.seconds:.0f}s", color)
+
+    def sync_skia(self):
+        """One fetch/deps/patch pass over the shared Skia checkout before the Skia jobs."""
+        skia_jobs = [job for job in self.jobs if job.library == "skia" and not job.hit]
+        first = skia_jobs[0]
+        command = [sys.executable, str(ROOT_DIR / "build-skia.py"), first.platform, "--sync-only"]
+        for name in ["-branch", "-commit"]:
+            if arg_value(first.args, name):
+                command += [name, arg_value(first.args, name)]
+        if "--shallow" in first.args:
+            command.append("--shallow")
+        colored_print("[skia] syncing checkout...", Colors.OKBLUE)
+        if not self.run_logged("skia-sync", command, dict(os.environ)):
+            for job in skia_jobs:
+                job.status = "skipped"
+
+    def run(self):
+        self.parse_arguments()
+        self.order_jobs()
+        self.resolve_revisions()
+        for job in self.jobs:
+            job.key = self.compute_key(job)
+            job.hit = self.use_cache and (self.entry_dir(job.key) / "manifest.json").exists()
+
+        if self.dry_run:
+            for job in self.jobs:
+                state = "hit" if job.hit else "miss"
+                print(f"{job.key[:16]}  {state:4}  {job.spec}")
+            return
+
+        build_jobs = max(1, self.build_jobs // self.concurrency)
+        colored_print(f"Running {len(self.jobs)} jobs, {self.concurrency} at a time, "
+                      f"{build_jobs} compile jobs each (compiler cache: {self.compiler_cache or 'none'})",
+                      Colors.HEADER)
+
+        # Jobs restored from the cache never touch the Skia checkout
+        if any(job.library == "skia" and not job.hit for job in self.jobs):
+            self.sync_skia()
+
+        start = time.monotonic()
+        with ThreadPoolExecutor(max_workers=self.concurrency) as pool:
+            running = {}
+            while True:
+                for job in self.jobs:
+                    if (job.status == "pending" and len(running) < self.concurrency
+                            and all(dep.status not in ("pending", "running") for dep in job.after)):
+                        job.status = "running"
+                        running[pool.submit(self.run_job, job, build_jobs)] = job
+                if not running:
+                    break
+                done, _ = wait(running, return_when=FIRST_COMPLETED)
+                for future in done:
+                    job = running.pop(future)
+                    if future.exception():
+                        job.status = "failed"
+                        colored_print(f"[{job.name}] error: {future.exception()}", Colors.FAIL)
+
+        colored_print(f"\nMatrix finished in {time.monotonic() - start:.0f}s:", Colors.HEADER)
+        for job in self.jobs:
+            color = Colors.OKGREEN if job.status in ("built", "cached") else Colors.FAIL
+            colored_print(f"  {job.status:8} {job.seconds:7.0f}s  {job.spec}", color)
+        if any(job.status in ("failed", "skipped") for job in self.jobs):
+            sys.exit(1)
+
+
+if __name__ == "__main__":
+    BuildMatrix().run()
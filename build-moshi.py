@@ -133,9 +133,9 @@ def setup_ffi_crate(source_dir):
     """Create the moshi-ffi crate that wraps moshi-core with C ABI exports."""
     ffi_dir = source_dir / "rust" / "moshi-ffi"
 
+    # Always rewrite the generated sources so FFI changes reach existing checkouts
     if ffi_dir.exists():
-        print(f"moshi-ffi crate already exists at {ffi_dir}")
-        return ffi_dir
+        print(f"Updating moshi-ffi crate at {ffi_dir}")
 
     ffi_dir.mkdir(parents=True, exist_ok=True)
     src_dir = ffi_dir / "src"
@@ -176,9 +176,14 @@ metal = ["moshi/metal", "candle/metal", "candle-nn/metal"]
 
 use std::cell::RefCell;
 use std::ffi::{CStr, CString};
-use std::os::raw::c_char;
+use std::os::raw::{c_char, c_void};
+use std::cell::UnsafeCell;
+use std::sync::atomic::{AtomicBool, AtomicPtr, AtomicU64, AtomicUsize, Ordering};
+use std::sync::{Arc, Mutex};
+use std::time::{Duration, Instant};
 
 use candle::{DType, Device, Tensor};
+use candle_transformers::generation::{LogitsProcessor, Sampling};
 use moshi::mimi;
 use moshi::lm;
 
@@ -198,6 +203,54 @@ fn clear_error() {
     });
 }
 
+/// Trace hooks (mirrors MoshiTraceHooks in moshi.h), called around each
+/// moshi_forward*, moshi_step, moshi_batch_step and mimi_*_step call.
+#[repr(C)]
+#[derive(Clone, Copy)]
+pub struct MoshiTraceHooks {
+    pub begin: Option<extern "C" fn(user_data: *mut c_void, name: *const c_char)>,
+    pub end: Option<extern "C" fn(user_data: *mut c_void, name: *const c_char)>,
+    pub user_data: *mut c_void,
+}
+
+static TRACE_HOOKS: AtomicPtr<MoshiTraceHooks> = AtomicPtr::new(std::ptr::null_mut());
+
+/// Install (or with null, remove) the trace hooks. The struct is copied. A
+/// replaced copy is never freed, since a span on another thread may still be
+/// about to call its end hook; hooks are meant to be set once per process.
+#[no_mangle]
+pub extern "C" fn moshi_set_trace_hooks(hooks: *const MoshiTraceHooks) {
+    let copy = match unsafe { hooks.as_ref() } {
+        Some(h) => Box::into_raw(Box::new(*h)),
+        None => std::ptr::null_mut(),
+    };
+    TRACE_HOOKS.store(copy, Ordering::Release);
+}
+
+/// begin hook now, end hook on drop; one atomic load when no hooks are set
+struct TraceSpan {
+    hooks: *const MoshiTraceHooks,
+    name: &'static CStr,
+}
+
+impl TraceSpan {
+    fn new(name: &'static CStr) -> Self {
+        let hooks = TRACE_HOOKS.load(Ordering::Acquire);
+        if let Some(begin) = unsafe { hooks.as_ref() }.and_then(|h| h.begin) {
+            begin(unsafe { (*hooks).user_data }, name.as_ptr());
+        }
+        TraceSpan { hooks, name }
+    }
+}
+
+impl Drop for TraceSpan {
+    fn drop(&mut self) {
+        if let Some(end) = unsafe { self.hooks.as_ref() }.and_then(|h| h.end) {
+            end(unsafe { (*self.hooks).user_data }, self.name.as_ptr());
+        }
+    }
+}
+
 fn get_device() -> Device {
     #[cfg(feature = "metal")]
     {
@@ -213,16 +266,620 @@ fn get_device() -> Device {
     }
 }
 
+/// Load progress callback: bytes of weights loaded so far and the total.
+pub type MoshiProgressFn = Option<extern "C" fn(user_data: *mut c_void, loaded_bytes: u64, total_bytes: u64)>;
+
+pub const MOSHI_DTYPE_AUTO: u32 = 0;
+pub const MOSHI_DTYPE_F32: u32 = 1;
+pub const MOSHI_DTYPE_F16: u32 = 2;
+pub const MOSHI_DTYPE_BF16: u32 = 3;
+
+/// Load options for the *_load_ex functions (mirrors MoshiLoadOptions in moshi.h).
+#[repr(C)]
+pub struct MoshiLoadOptions {
+    /// MOSHI_DTYPE_*; AUTO picks bf16 on GPU devices and f32 on CPU. Null options
+    /// and the loaders without options always use f32.
+    pub dtype: u32,
+    pub progress: MoshiProgressFn,
+    pub progress_user_data: *mut c_void,
+}
+
+fn load_dtype(options: Option<&MoshiLoadOptions>, device: &Device) -> Result<DType, String> {
+    match options.map_or(MOSHI_DTYPE_F32, |o| o.dtype) {
+        MOSHI_DTYPE_AUTO => Ok(if device.is_cpu() { DType::F32 } else { DType::BF16 }),
+        MOSHI_DTYPE_F32 => Ok(DType::F32),
+        MOSHI_DTYPE_F16 => Ok(DType::F16),
+        MOSHI_DTYPE_BF16 => Ok(DType::BF16),
+        other => Err(format!("Unknown dtype {other}")),
+    }
+}
+
+fn path_from_c<'a>(path: *const c_char) -> Result<&'a str, String> {
+    if path.is_null() {
+        return Err("Null model path".into());
+    }
+    unsafe { CStr::from_ptr(path) }.to_str().map_err(|_| "Invalid UTF-8 in model path".into())
+}
+
+/// VarBuilder backend over the mmapped safetensors that reports progress as
+/// tensors are materialized. Tensors are read straight from the mapping in the
+/// requested dtype, so no intermediate f32 copy of a bf16 checkpoint is made;
+/// the mapping is released once the model is built.
+struct ProgressBackend {
+    inner: candle::safetensors::MmapedSafetensors,
+    total_bytes: u64,
+    loaded_bytes: AtomicU64,
+    progress: MoshiProgressFn,
+    // Stored as an integer so the backend is Send + Sync as VarBuilder requires
+    user_data: usize,
+}
+
+impl ProgressBackend {
+    fn new(path: &str, options: Option<&MoshiLoadOptions>) -> candle::Result<Self> {
+        let inner = unsafe { candle::safetensors::MmapedSafetensors::new(path)? };
+        let total_bytes = inner.tensors().iter().map(|(_, view)| view.data().len() as u64).sum();
+        let backend = ProgressBackend {
+            inner,
+            total_bytes,
+            loaded_bytes: AtomicU64::new(0),
+            progress: options.and_then(|o| o.progress),
+            user_data: options.map_or(0, |o| o.progress_user_data as usize),
+        };
+        backend.report(0);
+        Ok(backend)
+    }
+
+    fn report(&self, bytes: u64) {
+        let loaded = self.loaded_bytes.fetch_add(bytes, Ordering::Relaxed) + bytes;
+        if let Some(progress) = self.progress {
+            progress(self.user_data as *mut c_void, loaded, self.total_bytes);
+        }
+    }
+
+    fn tensor_bytes(&self, name: &str) -> u64 {
+        self.inner.get(name).map_or(0, |view| view.data().len() as u64)
+    }
+}
+
+impl candle_nn::var_builder::SimpleBackend for ProgressBackend {
+    fn get(
+        &self,
+        s: candle::Shape,
+        name: &str,
+        h: candle_nn::Init,
+        dtype: DType,
+        dev: &Device,
+    ) -> candle::Result<Tensor> {
+        let tensor = candle_nn::var_builder::SimpleBackend::get(&self.inner, s, name, h, dtype, dev)?;
+        self.report(self.tensor_bytes(name));
+        Ok(tensor)
+    }
+
+    fn get_unchecked(&self, name: &str, dtype: DType, dev: &Device) -> candle::Result<Tensor> {
+        let tensor = candle_nn::var_builder::SimpleBackend::get_unchecked(&self.inner, name, dtype, dev)?;
+        self.report(self.tensor_bytes(name));
+        Ok(tensor)
+    }
+
+    fn contains_tensor(&self, name: &str) -> bool {
+        candle_nn::var_builder::SimpleBackend::contains_tensor(&self.inner, name)
+    }
+}
+
+/// Load the LM. gguf files hold pre-quantized (q8/q4) weights and go through
+/// moshi's quantized loader, which reports progress only at start and end.
+fn load_lm(path: &str, options: Option<&MoshiLoadOptions>) -> Result<(lm::LmModel, Device), String> {
+    let device = get_device();
+    let dtype = load_dtype(options, &device)?;
+    if path.ends_with(".gguf") {
+        let progress = options.and_then(|o| o.progress);
+        let user_data = options.map_or(std::ptr::null_mut(), |o| o.progress_user_data);
+        let total = std::fs::metadata(path).map(|m| m.len()).unwrap_or(0);
+        if let Some(progress) = progress { progress(user_data, 0, total); }
+        let model = lm::load(path, dtype, &device)
+            .map_err(|e| format!("Failed to load Moshi model: {e}"))?;
+        if let Some(progress) = progress { progress(user_data, total, total); }
+        return Ok((model, device));
+    }
+
+    let backend = ProgressBackend::new(path, options)
+        .map_err(|e| format!("Failed to map Moshi model: {e}"))?;
+    let vb = candle_nn::VarBuilder::from_backend(Box::new(backend), dtype, device.clone());
+    let model = lm::LmModel::new(&lm::Config::v0_1(), moshi::nn::MaybeQuantizedVarBuilder::Real(vb))
+        .map_err(|e| format!("Failed to load Moshi model: {e}"))?;
+    Ok((model, device))
+}
+
 /// Opaque handle to a Mimi codec instance.
 pub struct MimiCodec {
     mimi: mimi::Mimi,
     device: Device,
 }
 
+/// Opaque handle to loaded Moshi LM weights. Never stepped itself; sessions
+/// and batches clone it, which shares the weight tensors and copies only the
+/// (empty) streaming state.
+pub struct MoshiWeights {
+    model: lm::LmModel,
+    device: Device,
+}
+
+/// Acoustic delay of the released Moshi models (moshi's
+/// lm_generate_multistream::Config::v0_1): each speaker's first, semantic
+/// codebook is undelayed and the acoustic codebooks lag it by this many frames.
+const ACOUSTIC_DELAY: usize = 2;
+/// Steps of history a delay line keeps
+const DELAY_HISTORY: usize = ACOUSTIC_DELAY + 1;
+
+fn codebook_delay(codebook: usize) -> usize {
+    if codebook == 0 { 0 } else { ACOUSTIC_DELAY }
+}
+
+/// Per-codebook delay lines for one conversation. The LM sees every audio
+/// stream shifted by its codebook's delay: at step t, codebook c carries frame
+/// t - delay(c). The depformer's codes come out in those shifted positions and
+/// are fed straight back as the model's own streams on the next step; the
+/// aligned frame mimi_decode_step needs (frame t - ACOUSTIC_DELAY) is assembled
+/// here once step t has run.
+struct DelayLines {
+    generated: usize,
+    user: usize,
+    pad: u32,
+    step: usize,
+    /// Depformer codes of the last DELAY_HISTORY steps, [step % DELAY_HISTORY][generated]
+    model_codes: Vec<u32>,
+    /// User codes of the last DELAY_HISTORY frames, [frame % DELAY_HISTORY][user]
+    user_codes: Vec<u32>,
+}
+
+impl DelayLines {
+    fn new(generated: usize, user: usize, pad: u32) -> Self {
+        DelayLines {
+            generated,
+            user,
+            pad,
+            step: 0,
+            model_codes: vec![pad; DELAY_HISTORY * generated],
+            user_codes: vec![pad; DELAY_HISTORY * user],
+        }
+    }
+
+    fn reset(&mut self) {
+        self.step = 0;
+        let pad = self.pad;
+        self.model_codes.iter_mut().for_each(|t| *t = pad);
+        self.user_codes.iter_mut().for_each(|t| *t = pad);
+    }
+
+    /// Record this frame's user codes (`user` of them) and append the step's
+    /// audio inputs to `out`: the model's own streams, then the user's.
+    fn inputs(&mut self, user_codes: &[u32], out: &mut Vec<u32>) {
+        let t = self.step;
+        let row = (t % DELAY_HISTORY) * self.user;
+        self.user_codes[row..row + self.user].copy_from_slice(user_codes);
+        if t == 0 {
+            out.extend(std::iter::repeat(self.pad).take(self.generated));
+        } else {
+            let row = ((t - 1) % DELAY_HISTORY) * self.generated;
+            out.extend_from_slice(&self.model_codes[row..row + self.generated]);
+        }
+        for c in 0..self.user {
+            let d = codebook_delay(c);
+            out.push(if t < d { self.pad } else { self.user_codes[((t - d) % DELAY_HISTORY) * self.user + c] });
+        }
+    }
+
+    /// Record the depformer's codes for this step and advance. Writes the frame
+    /// completed by this step into `frame` and returns true, or returns false
+    /// for the first ACOUSTIC_DELAY steps, while the acoustic codebooks fill.
+    fn push(&mut self, codes: &[u32], frame: &mut [u32]) -> bool {
+        let t = self.step;
+        let row = (t % DELAY_HISTORY) * self.generated;
+        for c in 0..self.generated {
+            // Positions before a codebook's delay hold no real frame
+            self.model_codes[row + c] = if t < codebook_delay(c) {
+                self.pad
+            } else {
+                codes.get(c).copied().unwrap_or(self.pad)
+            };
+        }
+        self.step += 1;
+        if t < ACOUSTIC_DELAY {
+            return false;
+        }
+        let frame_idx = t - ACOUSTIC_DELAY;
+        for (c, code) in frame[..self.generated].iter_mut().enumerate() {
+            *code = self.model_codes[((frame_idx + codebook_delay(c)) % DELAY_HISTORY) * self.generated + c];
+        }
+        true
+    }
+}
+
 /// Opaque handle to a Moshi LM model instance.
 pub struct MoshiModel {
     model: lm::LmModel,
     device: Device,
+    /// Host staging buffer for one step's input ids (text token + audio codes),
+    /// kept across steps so the streaming path does not allocate on the host.
+    step_ids: Vec<u32>,
+    /// moshi_step state: the text token generated by the previous step, fed back
+    /// as the model's own text stream on the next one, and the audio delay lines.
+    last_text_token: u32,
+    delays: DelayLines,
+    /// One step's audio inputs, reused across steps
+    audio_in: Vec<u32>,
+    /// Depformer sampler, rebuilt only when the sampling parameters change so its
+    /// RNG keeps advancing across steps.
+    audio_lp: Option<(MoshiSamplingParams, LogitsProcessor)>,
+}
+
+impl MoshiModel {
+    fn new(model: lm::LmModel, device: Device) -> Self {
+        let step_ids = Vec::with_capacity(1 + model.in_audio_codebooks());
+        let last_text_token = model.text_start_token();
+        let generated = model.generated_audio_codebooks();
+        let user = model.in_audio_codebooks().saturating_sub(generated);
+        let delays = DelayLines::new(generated, user, model.audio_pad_token());
+        let audio_in = Vec::with_capacity(model.in_audio_codebooks());
+        MoshiModel {
+            model,
+            device,
+            step_ids,
+            last_text_token,
+            delays,
+            audio_in,
+            audio_lp: None,
+        }
+    }
+
+    fn reset_step_state(&mut self) {
+        self.last_text_token = self.model.text_start_token();
+        self.delays.reset();
+    }
+
+    /// Upload one step's inputs as a single [1, 1 + num_codebooks] tensor and split
+    /// it into the per-stream [1, 1] views the LM expects. Views share the upload,
+    /// so there is one device allocation per step instead of one per codebook.
+    fn step_inputs(
+        &mut self,
+        text_token: u32,
+        audio_codes: &[u32],
+    ) -> candle::Result<(Tensor, Vec<Option<Tensor>>)> {
+        self.step_ids.clear();
+        self.step_ids.push(text_token);
+        self.step_ids.extend_from_slice(audio_codes);
+        let ids = Tensor::from_slice(&self.step_ids, (1, self.step_ids.len()), &self.device)?;
+
+        let text_ids = ids.narrow(1, 0, 1)?;
+        let mut audio_ids = Vec::with_capacity(audio_codes.len());
+        for i in 0..audio_codes.len() {
+            audio_ids.push(Some(ids.narrow(1, 1 + i, 1)?));
+        }
+        Ok((text_ids, audio_ids))
+    }
+}
+
+/// Opaque handle to B conversations stepped together in one forward pass.
+/// The streaming state carries a batch dimension of B, so every slot advances
+/// on each moshi_batch_step; inactive slots are masked and keep their state.
+pub struct MoshiBatch {
+    model: lm::LmModel,
+    device: Device,
+    batch_size: usize,
+    /// Host staging buffer for one step's ids, [batch_size, 1 + in_audio_codebooks]
+    step_ids: Vec<u32>,
+    last_text_tokens: Vec<u32>,
+    /// One set of delay lines per slot
+    delays: Vec<DelayLines>,
+    /// One depformer sampler per slot, rebuilt when the parameters change
+    audio_lps: Vec<LogitsProcessor>,
+    audio_lp_params: Option<MoshiSamplingParams>,
+}
+
+impl MoshiBatch {
+    fn reset(&mut self) {
+        self.model.reset_state();
+        let text_start = self.model.text_start_token();
+        self.last_text_tokens.iter_mut().for_each(|t| *t = text_start);
+        self.delays.iter_mut().for_each(DelayLines::reset);
+    }
+}
+
+/// Sampling parameters for moshi_step (mirrors MoshiSamplingParams in moshi.h).
+/// A temperature <= 0 selects greedy argmax; top_k == 0 samples the full vocabulary.
+#[repr(C)]
+#[derive(Clone, Copy, PartialEq)]
+pub struct MoshiSamplingParams {
+    pub text_temperature: f32,
+    pub text_top_k: u32,
+    pub audio_temperature: f32,
+    pub audio_top_k: u32,
+    pub seed: u64,
+}
+
+fn sampling_for(temperature: f32, top_k: u32) -> Sampling {
+    if temperature <= 0.0 {
+        Sampling::ArgMax
+    } else if top_k == 0 {
+        Sampling::All { temperature: temperature as f64 }
+    } else {
+        Sampling::TopK { k: top_k as usize, temperature: temperature as f64 }
+    }
+}
+
+/// Widest row handed to arg_sort: candle's CUDA and Metal kernels sort a whole
+/// row in shared memory sized to the next power of two of its length, which the
+/// ~32k text vocabulary overflows.
+const SORT_MAX_COLS: usize = 1024;
+/// Largest k selected chunk-wise; bigger k falls back to repeated argmax
+const CHUNKED_TOP_K_MAX: usize = SORT_MAX_COLS / 4;
+
+/// The k largest entries of each row of `x` ([rows, cols], f32), highest first,
+/// as (values, ids) of shape [rows, k]. Never sorts more than SORT_MAX_COLS
+/// columns at once: wide rows are cut into chunks, each chunk keeps its own top
+/// k (a k-th largest overall is among them), and the survivors are reduced again.
+fn top_k_rows(x: &Tensor, k: usize) -> candle::Result<(Tensor, Tensor)> {
+    let (rows, cols) = x.dims2()?;
+    let dev = x.device();
+    if cols <= SORT_MAX_COLS {
+        let ids = x.arg_sort_last_dim(false)?.narrow(1, 0, k)?.contiguous()?;
+        return Ok((x.gather(&ids, 1)?, ids));
+    }
+
+    if k > CHUNKED_TOP_K_MAX {
+        // Repeated argmax, masking out each pick: k passes, but no sort at all
+        let col_ids = Tensor::arange(0u32, cols as u32, dev)?.unsqueeze(0)?;
+        let masked = Tensor::full(f32::NEG_INFINITY, (rows, cols), dev)?;
+        let mut rest = x.clone();
+        let (mut values, mut ids) = (Vec::with_capacity(k), Vec::with_capacity(k));
+        for _ in 0..k {
+            let id = rest.argmax_keepdim(1)?;
+            values.push(rest.gather(&id, 1)?);
+            rest = col_ids.broadcast_eq(&id)?.where_cond(&masked, &rest)?;
+            ids.push(id);
+        }
+        return Ok((Tensor::cat(&values, 1)?, Tensor::cat(&ids, 1)?));
+    }
+
+    let chunks = cols.div_ceil(SORT_MAX_COLS);
+    let padded = chunks * SORT_MAX_COLS;
+    let x = if padded > cols {
+        Tensor::cat(&[x.clone(), Tensor::full(f32::NEG_INFINITY, (rows, padded - cols), dev)?], 1)?
+    } else {
+        x.clone()
+    };
+    let x = x.reshape((rows * chunks, SORT_MAX_COLS))?;
+    let local = x.arg_sort_last_dim(false)?.narrow(1, 0, k)?.contiguous()?;
+    let values = x.gather(&local, 1)?.reshape((rows, chunks * k))?;
+    // Chunk-local ids to row ids; the per-chunk offsets are a tiny upload
+    let offsets: Vec<u32> = (0..rows * chunks).map(|i| ((i % chunks) * SORT_MAX_COLS) as u32).collect();
+    let offsets = Tensor::from_vec(offsets, (rows * chunks, 1), dev)?;
+    let ids = local.broadcast_add(&offsets)?.reshape((rows, chunks * k))?;
+
+    let (top_values, picks) = top_k_rows(&values, k)?;
+    Ok((top_values, ids.gather(&picks, 1)?))
+}
+
+/// Sample one token per row of `logits` ([rows, vocab]) without leaving the device.
+/// Temperature sampling uses the Gumbel-max trick: argmax(logits / T + G) with
+/// G = -log(-log(U)) draws from softmax(logits / T), so only the chosen indices
+/// are read back. Top-k restricts the candidates on the device first (top_k_rows).
+fn sample_rows_on_device(logits: &Tensor, temperature: f32, top_k: u32) -> candle::Result<Vec<u32>> {
+    let logits = logits.to_dtype(DType::F32)?;
+    if temperature <= 0.0 {
+        return logits.argmax(1)?.to_vec1::<u32>();
+    }
+
+    let (_, vocab) = logits.dims2()?;
+    let (candidates, top_ids) = if top_k > 0 && (top_k as usize) < vocab {
+        let (values, ids) = top_k_rows(&logits, top_k as usize)?;
+        (values, Some(ids))
+    } else {
+        (logits, None)
+    };
+
+    let scaled = (candidates / temperature as f64)?;
+    let uniform = Tensor::rand(1e-7f32, 1.0f32, scaled.shape(), scaled.device())?;
+    let gumbel = uniform.log()?.neg()?.log()?.neg()?;
+    let choices = (scaled + gumbel)?.argmax(1)?.to_vec1::<u32>()?;
+
+    match top_ids {
+        // Only k ids per row come back to map candidate indices to vocabulary ids
+        Some(ids) => {
+            let ids = ids.to_vec2::<u32>()?;
+            Ok(choices.iter().zip(ids.iter()).map(|(&c, row)| row[c as usize]).collect())
+        }
+        None => Ok(choices),
+    }
+}
+
+fn sample_on_device(logits: &Tensor, temperature: f32, top_k: u32) -> candle::Result<u32> {
+    let logits = logits.flatten_all()?;
+    let vocab = logits.elem_count();
+    Ok(sample_rows_on_device(&logits.reshape((1, vocab))?, temperature, top_k)?[0])
+}
+
+/// Copy a tensor into the caller's `out` without building nested Vecs. CPU tensors
+/// are read straight out of their storage (no host allocation); device tensors are
+/// read back once, flat. Returns the number of elements written.
+fn copy_into<T: candle::WithDType>(tensor: &Tensor, out: &mut [T]) -> Result<usize, String> {
+    let tensor = tensor.flatten_all().map_err(|e| format!("flatten: {e}"))?;
+    let len = tensor.elem_count();
+    if len > out.len() {
+        return Err(format!("Output buffer too small: need {len}, have {}", out.len()));
+    }
+
+    if tensor.device().is_cpu() {
+        let (storage, layout) = tensor.storage_and_layout();
+        if let (candle::Storage::Cpu(cpu), Some((start, end))) = (&*storage, layout.contiguous_offsets()) {
+            let data = cpu.as_slice::<T>().map_err(|e| format!("storage: {e}"))?;
+            out[..len].copy_from_slice(&data[start..end]);
+            return Ok(len);
+        }
+    }
+
+    let data = tensor.to_vec1::<T>().map_err(|e| format!("readback: {e}"))?;
+    out[..len].copy_from_slice(&data);
+    Ok(len)
+}
+
+// ---------------------------------------------------------------------------
+// Arenas
+//
+// The same contract as SwcArena in swc.h: outputs whose size the caller cannot
+// know up front (mimi_encode_arena / mimi_decode_arena) are bump-allocated from
+// a chain of blocks. Reset rewinds it without freeing blocks, so once the arena
+// has grown to fit a call's outputs, later calls allocate nothing. Blocks come
+// from the caller's MoshiAllocator if one was given, else from the global heap.
+// ---------------------------------------------------------------------------
+
+/// Mirrors MoshiAllocator in moshi.h
+#[repr(C)]
+#[derive(Clone, Copy)]
+pub struct MoshiAllocator {
+    pub alloc: Option<unsafe extern "C" fn(user_data: *mut c_void, size: usize, align: usize) -> *mut c_void>,
+    pub free: Option<unsafe extern "C" fn(user_data: *mut c_void, ptr: *mut c_void, size: usize)>,
+    pub user_data: *mut c_void,
+}
+
+const ARENA_DEFAULT_BLOCK: usize = 1 << 20;
+// Block and allocation alignment; enough for any output element type
+const ARENA_ALIGN: usize = 16;
+
+struct ArenaBlock {
+    base: *mut u8,
+    size: usize,
+}
+
+/// Opaque arena handed to C as `MoshiArena*`.
+pub struct MoshiArena {
+    allocator: Option<MoshiAllocator>,
+    block_size: usize,
+    blocks: Vec<ArenaBlock>,
+    current: usize, // block being filled
+    used: usize,    // bytes taken from blocks[current]
+}
+
+impl MoshiArena {
+    fn alloc_block(&self, size: usize) -> Result<*mut u8, String> {
+        let layout = Layout::from_size_align(size, ARENA_ALIGN)
+            .map_err(|_| format!("Arena block too large: {size} bytes"))?;
+        let base = match self.allocator {
+            Some(MoshiAllocator { alloc: Some(alloc_fn), user_data, .. }) => unsafe {
+                alloc_fn(user_data, size, ARENA_ALIGN) as *mut u8
+            },
+            _ => unsafe { std::alloc::alloc(layout) },
+        };
+        if base.is_null() {
+            return Err(format!("Arena allocator returned NULL for {size} bytes"));
+        }
+        Ok(base)
+    }
+
+    fn free_block(&self, block: &ArenaBlock) {
+        match self.allocator {
+            Some(MoshiAllocator { free: Some(free_fn), user_data, .. }) => unsafe {
+                free_fn(user_data, block.base as *mut c_void, block.size)
+            },
+            Some(_) => {} // no free callback: the caller reclaims its own memory
+            None => unsafe {
+                std::alloc::dealloc(block.base, Layout::from_size_align(block.size, ARENA_ALIGN).unwrap())
+            },
+        }
+    }
+
+    /// `size` bytes aligned to ARENA_ALIGN, valid until the next reset.
+    fn alloc(&mut self, size: usize) -> Result<*mut u8, String> {
+        let size = (size.max(1) + ARENA_ALIGN - 1) & !(ARENA_ALIGN - 1);
+        if let Some(block) = self.blocks.get(self.current) {
+            if block.size - self.used >= size {
+                let p = unsafe { block.base.add(self.used) };
+                self.used += size;
+                return Ok(p);
+            }
+        }
+
+        // Move on to the next retained block that fits, or add one after the current
+        let mut next = if self.blocks.is_empty() { 0 } else { self.current + 1 };
+        while next < self.blocks.len() && self.blocks[next].size < size {
+            next += 1;
+        }
+        if next == self.blocks.len() {
+            let block_size = self.block_size.max(size);
+            let base = self.alloc_block(block_size)?;
+            self.blocks.push(ArenaBlock { base, size: block_size });
+        }
+        // Blocks skipped over stay unused until the next reset
+        self.current = next;
+        self.used = size;
+        Ok(self.blocks[next].base)
+    }
+
+    /// Bytes consumed since the last reset, counting the unused tails of filled blocks
+    fn used_bytes(&self) -> usize {
+        self.blocks[..self.current.min(self.blocks.len())].iter().map(|b| b.size).sum::<usize>() + self.used
+    }
+
+    /// Copy `tensor` into a fresh arena slice of exactly its element count.
+    fn copy_tensor<T: candle::WithDType>(&mut self, tensor: &Tensor) -> Result<(*const T, usize), String> {
+        let len = tensor.elem_count();
+        let bytes = len.checked_mul(std::mem::size_of::<T>())
+            .ok_or_else(|| format!("Output too large: {len} elements"))?;
+        let base = self.alloc(bytes)? as *mut T;
+        let out = unsafe { std::slice::from_raw_parts_mut(base, len) };
+        let written = copy_into(tensor, out)?;
+        Ok((base as *const T, written))
+    }
+}
+
+impl Drop for MoshiArena {
+    fn drop(&mut self) {
+        for block in &self.blocks {
+            self.free_block(block);
+        }
+    }
+}
+
+/// Create an arena. block_size 0 picks 1 MiB; allocator may be null (global
+/// heap) and is copied. Returns null if allocator has no alloc callback.
+#[no_mangle]
+pub unsafe extern "C" fn moshi_arena_create(block_size: usize, allocator: *const MoshiAllocator) -> *mut MoshiArena {
+    let allocator = allocator.as_ref().copied();
+    if let Some(a) = allocator {
+        if a.alloc.is_none() {
+            return std::ptr::null_mut();
+        }
+    }
+    Box::into_raw(Box::new(MoshiArena {
+        allocator,
+        block_size: if block_size == 0 { ARENA_DEFAULT_BLOCK } else { block_size },
+        blocks: Vec::new(),
+        current: 0,
+        used: 0,
+    }))
+}
+
+/// Invalidate every output allocated from the arena; keeps its blocks.
+#[no_mangle]
+pub unsafe extern "C" fn moshi_arena_reset(arena: *mut MoshiArena) {
+    if let Some(arena) = arena.as_mut() {
+        arena.current = 0;
+        arena.used = 0;
+    }
+}
+
+/// Bytes used since the last reset, for sizing block_size.
+#[no_mangle]
+pub unsafe extern "C" fn moshi_arena_used(arena: *const MoshiArena) -> usize {
+    arena.as_ref().map_or(0, |a| a.used_bytes())
+}
+
+/// Return the arena's blocks to its allocator.
+#[no_mangle]
+pub unsafe extern "C" fn moshi_arena_destroy(arena: *mut MoshiArena) {
+    if !arena.is_null() {
+        drop(Box::from_raw(arena));
+    }
 }
 
 /// Initialize the Moshi library. Call once at startup.
@@ -240,21 +897,35 @@ pub extern "C" fn moshi_init() -> i32 {
 pub extern "C" fn mimi_load(
     model_path: *const c_char,
     num_codebooks: u32,
+) -> *mut MimiCodec {
+    mimi_load_ex(model_path, num_codebooks, std::ptr::null())
+}
+
+/// mimi_load with load options. options may be null. Only the progress callback
+/// applies: Mimi runs in f32 because its PCM inputs and outputs are f32.
+#[no_mangle]
+pub extern "C" fn mimi_load_ex(
+    model_path: *const c_char,
+    num_codebooks: u32,
+    options: *const MoshiLoadOptions,
 ) -> *mut MimiCodec {
     clear_error();
-    let path = match unsafe { CStr::from_ptr(model_path) }.to_str() {
-        Ok(s) => s,
-        Err(_) => {
-            set_error("Invalid UTF-8 in model path".into());
-            return std::ptr::null_mut();
-        }
-    };
-    let device = get_device();
-    let ncb = if num_codebooks == 0 { None } else { Some(num_codebooks as usize) };
-    match mimi::load(path, ncb, &device) {
-        Ok(mimi) => Box::into_raw(Box::new(MimiCodec { mimi, device })),
+    let options = unsafe { options.as_ref() };
+    let result = (|| -> Result<MimiCodec, String> {
+        let path = path_from_c(model_path)?;
+        let device = get_device();
+        let ncb = if num_codebooks == 0 { None } else { Some(num_codebooks as usize) };
+        let backend = ProgressBackend::new(path, options)
+            .map_err(|e| format!("Failed to map Mimi model: {e}"))?;
+        let vb = candle_nn::VarBuilder::from_backend(Box::new(backend), DType::F32, device.clone());
+        let mimi = mimi::Mimi::new(mimi::Config::v0_1(ncb), vb)
+            .map_err(|e| format!("Failed to load Mimi model: {e}"))?;
+        Ok(MimiCodec { mimi, device })
+    })();
+    match result {
+        Ok(codec) => Box::into_raw(Box::new(codec)),
         Err(e) => {
-            set_error(format!("Failed to load Mimi model: {e}"));
+            set_error(e);
             std::ptr::null_mut()
         }
     }
@@ -276,6 +947,23 @@ pub extern "C" fn mimi_reset(codec: *mut MimiCodec) {
     codec.mimi.reset_state();
 }
 
+/// Run the non-streaming encoder; returns codes shaped [1, num_codebooks, num_frames].
+fn encode_codes(codec: &mut MimiCodec, pcm: &[f32]) -> Result<Tensor, String> {
+    // Shape: [batch=1, channels=1, samples]
+    let pcm_tensor = Tensor::from_slice(pcm, (1, 1, pcm.len()), &codec.device)
+        .map_err(|e| format!("Failed to create PCM tensor: {e}"))?;
+    codec.mimi.encode(&pcm_tensor).map_err(|e| format!("Encode failed: {e}"))
+}
+
+/// Run the non-streaming decoder; returns f32 PCM shaped [1, 1, num_samples].
+fn decode_pcm(codec: &mut MimiCodec, codes: &[u32], num_codebooks: usize, num_frames: usize) -> Result<Tensor, String> {
+    let codes_tensor = Tensor::from_slice(codes, (1, num_codebooks, num_frames), &codec.device)
+        .map_err(|e| format!("Failed to create codes tensor: {e}"))?;
+    let pcm = codec.mimi.decode(&codes_tensor)
+        .map_err(|e| format!("Decode failed: {e}"))?;
+    pcm.to_dtype(DType::F32).map_err(|e| format!("dtype conversion failed: {e}"))
+}
+
 /// Encode PCM audio (f32, 24kHz, mono) into Mimi audio codes.
 /// pcm_data: pointer to float32 PCM samples.
 /// pcm_len: number of samples.
@@ -302,34 +990,16 @@ pub extern "C" fn mimi_encode(
     let pcm_slice = unsafe { std::slice::from_raw_parts(pcm_data, pcm_len) };
 
     let result = (|| -> Result<i32, String> {
-        // Shape: [batch=1, channels=1, samples]
-        let pcm_tensor = Tensor::from_slice(pcm_slice, (1, 1, pcm_len), &codec.device)
-            .map_err(|e| format!("Failed to create PCM tensor: {e}"))?;
-        // Returns shape [batch=1, num_codebooks, num_frames]
-        let codes = codec.mimi.encode(&pcm_tensor)
-            .map_err(|e| format!("Encode failed: {e}"))?;
-        let codes_vec = codes.to_vec3::<u32>()
+        let codes = encode_codes(codec, pcm_slice)?;
+        let (_, num_codebooks, num_frames) = codes.dims3()
             .map_err(|e| format!("Failed to extract codes: {e}"))?;
-
-        if codes_vec.is_empty() || codes_vec[0].is_empty() {
+        if num_codebooks == 0 || num_frames == 0 {
             return Ok(0);
         }
-        let num_codebooks = codes_vec[0].len();
-        let num_frames = codes_vec[0][0].len();
-        let total = num_codebooks * num_frames;
-
-        if total > codes_capacity {
-            return Err(format!(
-                "Output buffer too small: need {total}, have {codes_capacity}"
-            ));
-        }
 
-        let out_slice = unsafe { std::slice::from_raw_parts_mut(codes_out, total) };
-        for (cb_idx, cb) in codes_vec[0].iter().enumerate() {
-            for (frame_idx, &code) in cb.iter().enumerate() {
-                out_slice[cb_idx * num_frames + frame_idx] = code;
-            }
-        }
+        // Row-major [1, num_codebooks, num_frames] is the documented codes_out layout
+        let out_slice = unsafe { std::slice::from_raw_parts_mut(codes_out, codes_capacity) };
+        copy_into(&codes, out_slice).map_err(|e| format!("Failed to extract codes: {e}"))?;
 
         if !out_num_codebooks.is_null() {
             unsafe { *out_num_codebooks = num_codebooks as u32 };
@@ -359,6 +1029,7 @@ pub extern "C" fn mimi_encode_step(
     codes_capacity: usize,
 ) -> i32 {
     clear_error();
+    let _span = TraceSpan::new(c"mimi_encode_step");
     if codec.is_null() || pcm_data.is_null() || codes_out.is_null() {
         set_error("Null pointer argument".into());
         return -1;
@@ -377,23 +1048,11 @@ pub extern "C" fn mimi_encode_step(
             None => Ok(0), // still buffering
             Some(codes_t) => {
                 // Shape: [1, num_codebooks, 1]
-                let codes_vec = codes_t.to_vec3::<u32>()
-                    .map_err(|e| format!("Failed to extract codes: {e}"))?;
-                if codes_vec.is_empty() || codes_vec[0].is_empty() {
-                    return Ok(0);
-                }
-                let num_codebooks = codes_vec[0].len();
-                if num_codebooks > codes_capacity {
-                    return Err(format!(
-                        "Output buffer too small: need {num_codebooks}, have {codes_capacity}"
-                    ));
-                }
                 let out_slice = unsafe {
-                    std::slice::from_raw_parts_mut(codes_out, num_codebooks)
+                    std::slice::from_raw_parts_mut(codes_out, codes_capacity)
                 };
-                for (i, cb) in codes_vec[0].iter().enumerate() {
-                    out_slice[i] = cb[0];
-                }
+                let num_codebooks = copy_into(codes_t, out_slice)
+                    .map_err(|e| format!("Failed to extract codes: {e}"))?;
                 Ok(num_codebooks as i32)
             }
         }
@@ -431,34 +1090,85 @@ pub extern "C" fn mimi_decode(
     let codes_slice = unsafe { std::slice::from_raw_parts(codes, total_codes) };
 
     let result = (|| -> Result<i32, String> {
-        // Build [1, num_codebooks, num_frames] tensor
-        let mut codes_vec = vec![0u32; total_codes];
-        codes_vec.copy_from_slice(codes_slice);
-        let codes_tensor = Tensor::from_vec(
-            codes_vec, (1, num_codebooks, num_frames), &codec.device
-        ).map_err(|e| format!("Failed to create codes tensor: {e}"))?;
+        let pcm = decode_pcm(codec, codes_slice, num_codebooks, num_frames)?;
+        let out_slice = unsafe { std::slice::from_raw_parts_mut(pcm_out, pcm_capacity) };
+        let samples = copy_into(&pcm, out_slice).map_err(|e| format!("PCM output: {e}"))?;
+        Ok(samples as i32)
+    })();
 
-        let pcm = codec.mimi.decode(&codes_tensor)
-            .map_err(|e| format!("Decode failed: {e}"))?;
-        let pcm = pcm.to_dtype(DType::F32)
-            .map_err(|e| format!("dtype conversion failed: {e}"))?;
-        // Shape: [1, 1, num_samples]
-        let pcm_vec = pcm.to_vec3::<f32>()
-            .map_err(|e| format!("Failed to extract PCM: {e}"))?;
+    match result {
+        Ok(n) => n,
+        Err(e) => { set_error(e); -1 }
+    }
+}
 
-        if pcm_vec.is_empty() || pcm_vec[0].is_empty() {
-            return Ok(0);
-        }
-        let samples = &pcm_vec[0][0];
-        if samples.len() > pcm_capacity {
-            return Err(format!(
-                "PCM output buffer too small: need {}, have {pcm_capacity}",
-                samples.len()
-            ));
+/// mimi_encode with the codes in `arena` instead of a caller buffer: *codes_out
+/// points at exactly num_codebooks * frames codes, valid until the arena is reset.
+/// Returns the number of frames, or -1 on error.
+#[no_mangle]
+pub extern "C" fn mimi_encode_arena(
+    codec: *mut MimiCodec,
+    arena: *mut MoshiArena,
+    pcm_data: *const f32,
+    pcm_len: usize,
+    codes_out: *mut *const u32,
+    out_num_codebooks: *mut u32,
+) -> i32 {
+    clear_error();
+    if codec.is_null() || arena.is_null() || pcm_data.is_null() || codes_out.is_null() {
+        set_error("Null pointer argument".into());
+        return -1;
+    }
+    let codec = unsafe { &mut *codec };
+    let arena = unsafe { &mut *arena };
+    let pcm_slice = unsafe { std::slice::from_raw_parts(pcm_data, pcm_len) };
+
+    let result = (|| -> Result<i32, String> {
+        let codes = encode_codes(codec, pcm_slice)?;
+        let (_, num_codebooks, num_frames) = codes.dims3()
+            .map_err(|e| format!("Failed to extract codes: {e}"))?;
+        let (ptr, _) = arena.copy_tensor::<u32>(&codes)
+            .map_err(|e| format!("Failed to extract codes: {e}"))?;
+        unsafe { *codes_out = ptr };
+        if !out_num_codebooks.is_null() {
+            unsafe { *out_num_codebooks = num_codebooks as u32 };
         }
-        let out_slice = unsafe { std::slice::from_raw_parts_mut(pcm_out, samples.len()) };
-        out_slice.copy_from_slice(samples);
-        Ok(samples.len() as i32)
+        Ok(num_frames as i32)
+    })();
+
+    match result {
+        Ok(n) => n,
+        Err(e) => { set_error(e); -1 }
+    }
+}
+
+/// mimi_decode with the PCM in `arena` instead of a caller buffer: *pcm_out points
+/// at exactly the returned number of samples, valid until the arena is reset.
+/// Returns the number of PCM samples, or -1 on error.
+#[no_mangle]
+pub extern "C" fn mimi_decode_arena(
+    codec: *mut MimiCodec,
+    arena: *mut MoshiArena,
+    codes: *const u32,
+    num_codebooks: usize,
+    num_frames: usize,
+    pcm_out: *mut *const f32,
+) -> i32 {
+    clear_error();
+    if codec.is_null() || arena.is_null() || codes.is_null() || pcm_out.is_null() {
+        set_error("Null pointer argument".into());
+        return -1;
+    }
+    let codec = unsafe { &mut *codec };
+    let arena = unsafe { &mut *arena };
+    let codes_slice = unsafe { std::slice::from_raw_parts(codes, num_codebooks * num_frames) };
+
+    let result = (|| -> Result<i32, String> {
+        let pcm = decode_pcm(codec, codes_slice, num_codebooks, num_frames)?;
+        let (ptr, samples) = arena.copy_tensor::<f32>(&pcm)
+            .map_err(|e| format!("PCM output: {e}"))?;
+        unsafe { *pcm_out = ptr };
+        Ok(samples as i32)
     })();
 
     match result {
@@ -482,6 +1192,7 @@ pub extern "C" fn mimi_decode_step(
     pcm_capacity: usize,
 ) -> i32 {
     clear_error();
+    let _span = TraceSpan::new(c"mimi_decode_step");
     if codec.is_null() || codes.is_null() || pcm_out.is_null() {
         set_error("Null pointer argument".into());
         return -1;
@@ -491,9 +1202,8 @@ pub extern "C" fn mimi_decode_step(
 
     let result = (|| -> Result<i32, String> {
         // Build codes tensor with shape [1, num_codebooks, 1] (batch, codebooks, frames)
-        let codes_vec: Vec<u32> = codes_slice.to_vec();
-        let codes_tensor = Tensor::from_vec(
-            codes_vec, (1, num_codebooks, 1), &codec.device
+        let codes_tensor = Tensor::from_slice(
+            codes_slice, (1, num_codebooks, 1), &codec.device
         ).map_err(|e| format!("Failed to create codes tensor: {e}"))?;
         let stream_tensor: moshi::StreamTensor = codes_tensor.into();
         let pcm = codec.mimi.decode_step(&stream_tensor, &().into())
@@ -504,23 +1214,12 @@ pub extern "C" fn mimi_decode_step(
             Some(pcm_t) => {
                 let pcm_t = pcm_t.to_dtype(DType::F32)
                     .map_err(|e| format!("dtype conversion failed: {e}"))?;
-                let pcm_vec = pcm_t.to_vec3::<f32>()
-                    .map_err(|e| format!("Failed to extract PCM: {e}"))?;
-                if pcm_vec.is_empty() || pcm_vec[0].is_empty() {
-                    return Ok(0);
-                }
-                let samples = &pcm_vec[0][0];
-                if samples.len() > pcm_capacity {
-                    return Err(format!(
-                        "PCM output buffer too small: need {}, have {pcm_capacity}",
-                        samples.len()
-                    ));
-                }
                 let out_slice = unsafe {
-                    std::slice::from_raw_parts_mut(pcm_out, samples.len())
+                    std::slice::from_raw_parts_mut(pcm_out, pcm_capacity)
                 };
-                out_slice.copy_from_slice(samples);
-                Ok(samples.len() as i32)
+                let samples = copy_into(&pcm_t, out_slice)
+                    .map_err(|e| format!("PCM output: {e}"))?;
+                Ok(samples as i32)
             }
         }
     })();
@@ -535,19 +1234,21 @@ pub extern "C" fn mimi_decode_step(
 /// Returns null on failure.
 #[no_mangle]
 pub extern "C" fn moshi_load(model_path: *const c_char) -> *mut MoshiModel {
+    moshi_load_ex(model_path, std::ptr::null())
+}
+
+/// moshi_load with load options (dtype, progress callback). options may be null.
+#[no_mangle]
+pub extern "C" fn moshi_load_ex(
+    model_path: *const c_char,
+    options: *const MoshiLoadOptions,
+) -> *mut MoshiModel {
     clear_error();
-    let path = match unsafe { CStr::from_ptr(model_path) }.to_str() {
-        Ok(s) => s,
-        Err(_) => {
-            set_error("Invalid UTF-8 in model path".into());
-            return std::ptr::null_mut();
-        }
-    };
-    let device = get_device();
-    match lm::load(path, DType::F32, &device) {
-        Ok(model) => Box::into_raw(Box::new(MoshiModel { model, device })),
+    let options = unsafe { options.as_ref() };
+    match path_from_c(model_path).and_then(|path| load_lm(path, options)) {
+        Ok((model, device)) => Box::into_raw(Box::new(MoshiModel::new(model, device))),
         Err(e) => {
-            set_error(format!("Failed to load Moshi model: {e}"));
+            set_error(e);
             std::ptr::null_mut()
         }
     }
@@ -567,6 +1268,111 @@ pub extern "C" fn moshi_reset(model: *mut MoshiModel) {
     if model.is_null() { return; }
     let model = unsafe { &mut *model };
     model.model.reset_state();
+    model.reset_step_state();
+}
+
+/// Load Moshi LM weights once for sharing between sessions and batches.
+/// options may be null (f32, no progress). Returns null on failure.
+#[no_mangle]
+pub extern "C" fn moshi_weights_load(
+    model_path: *const c_char,
+    options: *const MoshiLoadOptions,
+) -> *mut MoshiWeights {
+    clear_error();
+    let options = unsafe { options.as_ref() };
+    match path_from_c(model_path).and_then(|path| load_lm(path, options)) {
+        Ok((model, device)) => Box::into_raw(Box::new(MoshiWeights { model, device })),
+        Err(e) => {
+            set_error(e);
+            std::ptr::null_mut()
+        }
+    }
+}
+
+/// Free loaded weights. Sessions and batches created from them keep their own
+/// references to the weight tensors and stay valid.
+#[no_mangle]
+pub extern "C" fn moshi_weights_free(weights: *mut MoshiWeights) {
+    if !weights.is_null() {
+        unsafe { drop(Box::from_raw(weights)) };
+    }
+}
+
+/// Create a conversation session on shared weights. The result is an ordinary
+/// MoshiModel handle (moshi_step, moshi_forward, moshi_reset, ...) freed with
+/// moshi_free; only its streaming state is allocated per session.
+#[no_mangle]
+pub extern "C" fn moshi_session_create(weights: *const MoshiWeights) -> *mut MoshiModel {
+    clear_error();
+    if weights.is_null() {
+        set_error("Null pointer argument".into());
+        return std::ptr::null_mut();
+    }
+    let weights = unsafe { &*weights };
+    let mut model = weights.model.clone();
+    // The clone shares tensors with the prototype; start from fresh caches so
+    // sessions never write into each other's state.
+    model.reset_state();
+    Box::into_raw(Box::new(MoshiModel::new(model, weights.device.clone())))
+}
+
+/// Create a batch of batch_size conversation slots on shared weights.
+/// Returns null on failure.
+#[no_mangle]
+pub extern "C" fn moshi_batch_create(weights: *const MoshiWeights, batch_size: usize) -> *mut MoshiBatch {
+    clear_error();
+    if weights.is_null() {
+        set_error("Null pointer argument".into());
+        return std::ptr::null_mut();
+    }
+    if batch_size == 0 {
+        set_error("batch_size must be at least 1".into());
+        return std::ptr::null_mut();
+    }
+    let weights = unsafe { &*weights };
+    let mut model = weights.model.clone();
+    model.reset_state();
+    let in_codebooks = model.in_audio_codebooks();
+    let generated = model.generated_audio_codebooks();
+    let mut batch = MoshiBatch {
+        step_ids: Vec::with_capacity(batch_size * (1 + in_codebooks)),
+        last_text_tokens: vec![0; batch_size],
+        delays: (0..batch_size)
+            .map(|_| DelayLines::new(generated, in_codebooks.saturating_sub(generated), model.audio_pad_token()))
+            .collect(),
+        audio_lps: Vec::with_capacity(batch_size),
+        audio_lp_params: None,
+        model,
+        device: weights.device.clone(),
+        batch_size,
+    };
+    batch.reset();
+    Box::into_raw(Box::new(batch))
+}
+
+/// Free a batch.
+#[no_mangle]
+pub extern "C" fn moshi_batch_free(batch: *mut MoshiBatch) {
+    if !batch.is_null() {
+        unsafe { drop(Box::from_raw(batch)) };
+    }
+}
+
+/// Reset every slot of a batch. The batched KV cache cannot be cleared per
+/// slot, so a new conversation starts either after a reset or in a fresh batch.
+#[no_mangle]
+pub extern "C" fn moshi_batch_reset(batch: *mut MoshiBatch) {
+    if batch.is_null() { return; }
+    unsafe { &mut *batch }.reset();
+}
+
+/// Get the number of audio codebooks moshi_step generates per frame (the
+/// depformer output), i.e. the codebook count to pass to mimi_decode_step.
+#[no_mangle]
+pub extern "C" fn moshi_generated_codebooks(model: *const MoshiModel) -> u32 {
+    if model.is_null() { return 0; }
+    let model = unsafe { &*model };
+    model.model.generated_audio_codebooks() as u32
 }
 
 /// Get the number of input audio codebooks expected by the model.
@@ -577,6 +1383,14 @@ pub extern "C" fn moshi_audio_codebooks(model: *const MoshiModel) -> u32 {
     model.model.in_audio_codebooks() as u32
 }
 
+/// Get the acoustic delay in frames: moshi_step's audio codes trail its text
+/// tokens by this many steps, and the first this-many steps return no audio.
+/// The same for every model and batch.
+#[no_mangle]
+pub extern "C" fn moshi_acoustic_delay() -> u32 {
+    ACOUSTIC_DELAY as u32
+}
+
 /// Get the audio pad token value.
 #[no_mangle]
 pub extern "C" fn moshi_audio_pad_token(model: *const MoshiModel) -> u32 {
@@ -600,6 +1414,8 @@ pub extern "C" fn moshi_text_start_token(model: *const MoshiModel) -> u32 {
 /// text_logits_out: output buffer for text logits.
 /// text_logits_capacity: capacity of text_logits_out.
 /// out_text_logits_len: receives actual number of text logits written.
+/// Inputs are uploaded as one tensor and logits are copied straight into
+/// text_logits_out, so a streaming loop does no per-step host allocation.
 /// Returns 0 on success, -1 on error.
 #[no_mangle]
 pub extern "C" fn moshi_forward(
@@ -612,59 +1428,691 @@ pub extern "C" fn moshi_forward(
     out_text_logits_len: *mut u32,
 ) -> i32 {
     clear_error();
+    let _span = TraceSpan::new(c"moshi_forward");
     if model.is_null() || audio_codes.is_null() || text_logits_out.is_null() {
         set_error("Null pointer argument".into());
         return -1;
     }
     let model = unsafe { &mut *model };
     let audio_slice = unsafe { std::slice::from_raw_parts(audio_codes, num_codebooks) };
+    let out_slice = unsafe { std::slice::from_raw_parts_mut(text_logits_out, text_logits_capacity) };
 
     let result = (|| -> Result<(), String> {
-        let text_ids = Tensor::from_vec(
-            vec![text_token], (1, 1), &model.device
-        ).map_err(|e| format!("text tensor: {e}"))?;
+        let (text_ids, audio_ids) = model.step_inputs(text_token, audio_slice)
+            .map_err(|e| format!("input tensors: {e}"))?;
 
-        let audio_ids: Vec<Option<Tensor>> = audio_slice.iter().map(|&code| {
-            Tensor::from_vec(vec![code], (1, 1), &model.device).ok()
-        }).collect();
+        let mask: moshi::StreamMask = ().into();
+        let (text_logits, _audio_logits) = model.model.forward(
+            Some(text_ids), audio_ids, &mask
+        ).map_err(|e| format!("Forward failed: {e}"))?;
+
+        // text_logits shape: [1, 1, vocab_size]
+        let len = copy_into(&text_logits, out_slice)
+            .map_err(|e| format!("Text logits: {e}"))?;
+        if !out_text_logits_len.is_null() {
+            unsafe { *out_text_logits_len = len as u32 };
+        }
+        Ok(())
+    })();
+
+    match result {
+        Ok(()) => 0,
+        Err(e) => { set_error(e); -1 }
+    }
+}
+
+/// Run one forward pass and return only the k highest text logits.
+/// The selection runs on the model's device (top_k_rows); only k ids and k
+/// logits are read back instead of the whole vocabulary.
+/// ids_out / logits_out: k elements each, highest logit first.
+/// Returns the number of entries written (min(k, vocab)), or -1 on error.
+#[no_mangle]
+pub extern "C" fn moshi_forward_topk(
+    model: *mut MoshiModel,
+    text_token: u32,
+    audio_codes: *const u32,
+    num_codebooks: usize,
+    k: usize,
+    ids_out: *mut u32,
+    logits_out: *mut f32,
+) -> i32 {
+    clear_error();
+    let _span = TraceSpan::new(c"moshi_forward_topk");
+    if model.is_null() || audio_codes.is_null() || ids_out.is_null() || logits_out.is_null() {
+        set_error("Null pointer argument".into());
+        return -1;
+    }
+    let model = unsafe { &mut *model };
+    let audio_slice = unsafe { std::slice::from_raw_parts(audio_codes, num_codebooks) };
+
+    let result = (|| -> Result<i32, String> {
+        let (text_ids, audio_ids) = model.step_inputs(text_token, audio_slice)
+            .map_err(|e| format!("input tensors: {e}"))?;
 
         let mask: moshi::StreamMask = ().into();
         let (text_logits, _audio_logits) = model.model.forward(
             Some(text_ids), audio_ids, &mask
         ).map_err(|e| format!("Forward failed: {e}"))?;
 
-        // text_logits shape: [1, 1, vocab_size] -> flatten
-        let logits_vec = text_logits.to_vec3::<f32>()
-            .map_err(|e| format!("Failed to extract logits: {e}"))?;
-        if logits_vec.is_empty() || logits_vec[0].is_empty() {
-            if !out_text_logits_len.is_null() {
-                unsafe { *out_text_logits_len = 0 };
-            }
-            return Ok(());
+        let logits = text_logits.flatten_all()
+            .and_then(|t| t.to_dtype(DType::F32))
+            .map_err(|e| format!("Text logits: {e}"))?;
+        let vocab = logits.elem_count();
+        let k = k.min(vocab);
+        if k == 0 {
+            return Ok(0);
+        }
+        let (top_logits, top_ids) = logits.reshape((1, vocab))
+            .and_then(|l| top_k_rows(&l, k))
+            .map_err(|e| format!("Top-k: {e}"))?;
+
+        let ids = top_ids.flatten_all()
+            .and_then(|t| t.to_vec1::<u32>())
+            .map_err(|e| format!("Top-k ids: {e}"))?;
+        unsafe { std::slice::from_raw_parts_mut(ids_out, k) }.copy_from_slice(&ids);
+        copy_into(&top_logits, unsafe { std::slice::from_raw_parts_mut(logits_out, k) })
+            .map_err(|e| format!("Top-k logits: {e}"))?;
+        Ok(k as i32)
+    })();
+
+    match result {
+        Ok(n) => n,
+        Err(e) => { set_error(e); -1 }
+    }
+}
+
+/// Run one full-duplex step: feed the user's Mimi codes for one 80 ms frame,
+/// sample the next text token on the model's device and generate the model's
+/// audio codes with the depformer. Only the sampled tokens cross to the host;
+/// no logits are returned.
+///
+/// The model's own streams (previous text token and generated audio codes) are
+/// fed back internally, so the caller only supplies the other speaker's codes:
+/// num_user_codebooks = moshi_audio_codebooks() - moshi_generated_codebooks().
+/// The acoustic delays between codebooks are applied here (DelayLines): user
+/// codes go in undelayed, and the returned codes are one aligned Mimi frame,
+/// ACOUSTIC_DELAY frames behind the text token of the same step.
+///
+/// params: sampling parameters (NULL = greedy).
+/// out_text_token: receives the sampled text token.
+/// audio_codes_out: receives moshi_generated_codebooks() codes, ready for
+///                  mimi_decode_step.
+/// Returns the number of audio codes written: 0 for the first ACOUSTIC_DELAY
+/// steps after a load or reset (and always 0 without a depformer), or -1 on error.
+#[no_mangle]
+pub extern "C" fn moshi_step(
+    model: *mut MoshiModel,
+    params: *const MoshiSamplingParams,
+    user_codes: *const u32,
+    num_user_codebooks: usize,
+    out_text_token: *mut u32,
+    audio_codes_out: *mut u32,
+    audio_codes_capacity: usize,
+) -> i32 {
+    clear_error();
+    let _span = TraceSpan::new(c"moshi_step");
+    if model.is_null() || user_codes.is_null() || out_text_token.is_null() || audio_codes_out.is_null() {
+        set_error("Null pointer argument".into());
+        return -1;
+    }
+    let model = unsafe { &mut *model };
+    let user_slice = unsafe { std::slice::from_raw_parts(user_codes, num_user_codebooks) };
+    let params = if params.is_null() {
+        MoshiSamplingParams {
+            text_temperature: 0.0,
+            text_top_k: 0,
+            audio_temperature: 0.0,
+            audio_top_k: 0,
+            seed: 0,
+        }
+    } else {
+        unsafe { *params }
+    };
+
+    let result = (|| -> Result<i32, String> {
+        let generated = model.delays.generated;
+        let expected = model.delays.user;
+        if num_user_codebooks != expected {
+            return Err(format!("Expected {expected} user codebooks, got {num_user_codebooks}"));
+        }
+        if generated > audio_codes_capacity {
+            return Err(format!(
+                "Audio codes buffer too small: need {generated}, have {audio_codes_capacity}"
+            ));
+        }
+
+        // (Re)seed the device RNG and depformer sampler when parameters change
+        if model.audio_lp.as_ref().map_or(true, |(p, _)| *p != params) {
+            model.device.set_seed(params.seed).map_err(|e| format!("seed: {e}"))?;
+            let lp = LogitsProcessor::from_sampling(
+                params.seed, sampling_for(params.audio_temperature, params.audio_top_k)
+            );
+            model.audio_lp = Some((params, lp));
+        }
+
+        // Input audio streams, delayed: the model's own previous codes, then the user's
+        let mut audio_in = std::mem::take(&mut model.audio_in);
+        audio_in.clear();
+        model.delays.inputs(user_slice, &mut audio_in);
+        let text_in = model.last_text_token;
+        let inputs = model.step_inputs(text_in, &audio_in);
+        model.audio_in = audio_in;
+        let (text_ids, audio_ids) = inputs.map_err(|e| format!("input tensors: {e}"))?;
+
+        let mask: moshi::StreamMask = ().into();
+        let (text_logits, hidden) = model.model.forward(
+            Some(text_ids), audio_ids, &mask
+        ).map_err(|e| format!("Forward failed: {e}"))?;
+
+        let text_token = sample_on_device(&text_logits, params.text_temperature, params.text_top_k)
+            .map_err(|e| format!("Text sampling failed: {e}"))?;
+
+        let (_, audio_lp) = model.audio_lp.as_mut().expect("sampler initialized above");
+        let audio_tokens = model.model
+            .depformer_sample(&hidden, Some(text_token), &[], audio_lp)
+            .map_err(|e| format!("Depformer failed: {e}"))?;
+
+        model.last_text_token = text_token;
+        unsafe { *out_text_token = text_token };
+
+        let frame = unsafe { std::slice::from_raw_parts_mut(audio_codes_out, generated) };
+        let ready = model.delays.push(audio_tokens.as_deref().unwrap_or(&[]), frame);
+        let written = if ready && audio_tokens.is_some() { generated } else { 0 };
+        Ok(written as i32)
+    })();
+
+    match result {
+        Ok(n) => n,
+        Err(e) => { set_error(e); -1 }
+    }
+}
+
+/// Run moshi_step for every slot of a batch in a single forward pass.
+///
+/// user_codes: batch_size * num_user_codebooks codes, slot-major.
+/// active: batch_size flags (NULL = all active). Inactive slots are masked out
+///         of the forward pass, keep their state (delay lines included) and get
+///         no outputs written.
+/// text_tokens_out: batch_size sampled text tokens.
+/// audio_codes_out: batch_size * moshi_batch_generated_codebooks() codes, slot-major,
+///         one aligned frame per slot as from moshi_step. Slots still filling
+///         their delay lines (their first ACOUSTIC_DELAY active steps) get
+///         moshi_audio_pad_token() in every codebook instead; do not decode those.
+/// Returns the number of audio codes written per slot (0 without a depformer),
+/// or -1 on error.
+#[no_mangle]
+pub extern "C" fn moshi_batch_step(
+    batch: *mut MoshiBatch,
+    params: *const MoshiSamplingParams,
+    user_codes: *const u32,
+    num_user_codebooks: usize,
+    active: *const u8,
+    text_tokens_out: *mut u32,
+    audio_codes_out: *mut u32,
+    audio_codes_capacity: usize,
+) -> i32 {
+    clear_error();
+    let _span = TraceSpan::new(c"moshi_batch_step");
+    if batch.is_null() || user_codes.is_null() || text_tokens_out.is_null() || audio_codes_out.is_null() {
+        set_error("Null pointer argument".into());
+        return -1;
+    }
+    let batch = unsafe { &mut *batch };
+    let b_size = batch.batch_size;
+    let user_slice = unsafe { std::slice::from_raw_parts(user_codes, b_size * num_user_codebooks) };
+    let active_slice = if active.is_null() {
+        None
+    } else {
+        Some(unsafe { std::slice::from_raw_parts(active, b_size) })
+    };
+    let params = if params.is_null() {
+        MoshiSamplingParams {
+            text_temperature: 0.0,
+            text_top_k: 0,
+            audio_temperature: 0.0,
+            audio_top_k: 0,
+            seed: 0,
         }
-        let logits = &logits_vec[0][0];
-        if logits.len() > text_logits_capacity {
+    } else {
+        unsafe { *params }
+    };
+
+    let result = (|| -> Result<i32, String> {
+        let in_codebooks = batch.model.in_audio_codebooks();
+        let generated = batch.model.generated_audio_codebooks();
+        let expected = in_codebooks.saturating_sub(generated);
+        if num_user_codebooks != expected {
+            return Err(format!("Expected {expected} user codebooks, got {num_user_codebooks}"));
+        }
+        if b_size * generated > audio_codes_capacity {
             return Err(format!(
-                "Text logits buffer too small: need {}, have {text_logits_capacity}",
-                logits.len()
+                "Audio codes buffer too small: need {}, have {audio_codes_capacity}",
+                b_size * generated
             ));
         }
-        let out_slice = unsafe {
-            std::slice::from_raw_parts_mut(text_logits_out, logits.len())
+        let is_active = |b: usize| active_slice.map_or(true, |a| a[b] != 0);
+
+        if batch.audio_lp_params != Some(params) {
+            batch.device.set_seed(params.seed).map_err(|e| format!("seed: {e}"))?;
+            batch.audio_lps.clear();
+            for b in 0..b_size {
+                batch.audio_lps.push(LogitsProcessor::from_sampling(
+                    params.seed.wrapping_add(b as u64),
+                    sampling_for(params.audio_temperature, params.audio_top_k),
+                ));
+            }
+            batch.audio_lp_params = Some(params);
+        }
+
+        // One [B, 1 + in_codebooks] upload: text, then each slot's delayed own and user codes
+        batch.step_ids.clear();
+        let pad = batch.model.audio_pad_token();
+        for b in 0..b_size {
+            batch.step_ids.push(batch.last_text_tokens[b]);
+            if is_active(b) {
+                batch.delays[b].inputs(&user_slice[b * expected..(b + 1) * expected], &mut batch.step_ids);
+            } else {
+                // Masked out of the forward pass; the delay lines stay where they are
+                batch.step_ids.extend(std::iter::repeat(pad).take(in_codebooks));
+            }
+        }
+        let inputs = (|| -> candle::Result<(Tensor, Vec<Option<Tensor>>)> {
+            let ids = Tensor::from_slice(&batch.step_ids, (b_size, 1 + in_codebooks), &batch.device)?;
+            let text_ids = ids.narrow(1, 0, 1)?;
+            let mut audio_ids = Vec::with_capacity(in_codebooks);
+            for i in 0..in_codebooks {
+                audio_ids.push(Some(ids.narrow(1, 1 + i, 1)?));
+            }
+            Ok((text_ids, audio_ids))
+        })();
+        let (text_ids, audio_ids) = inputs.map_err(|e| format!("input tensors: {e}"))?;
+
+        let mask = match active_slice {
+            None => ().into(),
+            Some(a) => moshi::StreamMask::new(a.iter().map(|&x| x != 0).collect(), &batch.device)
+                .map_err(|e| format!("stream mask: {e}"))?,
         };
-        out_slice.copy_from_slice(logits);
-        if !out_text_logits_len.is_null() {
-            unsafe { *out_text_logits_len = logits.len() as u32 };
+        let (text_logits, hidden) = batch.model.forward(
+            Some(text_ids), audio_ids, &mask
+        ).map_err(|e| format!("Forward failed: {e}"))?;
+
+        let text_logits = text_logits.flatten_to(1).map_err(|e| format!("logits: {e}"))?;
+        let text_tokens = sample_rows_on_device(&text_logits, params.text_temperature, params.text_top_k)
+            .map_err(|e| format!("Text sampling failed: {e}"))?;
+
+        let out_text = unsafe { std::slice::from_raw_parts_mut(text_tokens_out, b_size) };
+        let out_audio = unsafe { std::slice::from_raw_parts_mut(audio_codes_out, b_size * generated) };
+        let mut written = 0;
+        for b in 0..b_size {
+            if !is_active(b) {
+                continue;
+            }
+            let text_token = text_tokens[b];
+            batch.last_text_tokens[b] = text_token;
+            out_text[b] = text_token;
+
+            // The depformer samples one stream at a time
+            let row = hidden.narrow(0, b, 1).map_err(|e| format!("hidden: {e}"))?;
+            let tokens = batch.model
+                .depformer_sample(&row, Some(text_token), &[], &mut batch.audio_lps[b])
+                .map_err(|e| format!("Depformer failed: {e}"))?;
+            let frame = &mut out_audio[b * generated..(b + 1) * generated];
+            if !batch.delays[b].push(tokens.as_deref().unwrap_or(&[]), frame) {
+                frame.iter_mut().for_each(|t| *t = pad);
+            }
+            if tokens.is_some() {
+                written = generated;
+            }
         }
-        Ok(())
+        Ok(written as i32)
     })();
 
     match result {
-        Ok(()) => 0,
+        Ok(n) => n,
         Err(e) => { set_error(e); -1 }
     }
 }
 
+/// Get the number of audio codebooks moshi_batch_step generates per slot.
+#[no_mangle]
+pub extern "C" fn moshi_batch_generated_codebooks(batch: *const MoshiBatch) -> u32 {
+    if batch.is_null() { return 0; }
+    unsafe { &*batch }.model.generated_audio_codebooks() as u32
+}
+
+/// Mimi frame: 1920 samples at 24 kHz (80 ms).
+const STREAM_FRAME_SAMPLES: usize = 1920;
+const STREAM_SAMPLE_RATE: f64 = 24000.0;
+
+#[repr(align(64))]
+struct CachePadded<T>(T);
+
+/// Lock-free single-producer single-consumer ring of f32 samples. Indices grow
+/// monotonically and are masked into a power-of-two buffer; the producer only
+/// stores `write` and the consumer only stores `read`, so neither side blocks.
+struct SpscRing {
+    buf: Box<[UnsafeCell<f32>]>,
+    mask: usize,
+    write: CachePadded<AtomicUsize>,
+    read: CachePadded<AtomicUsize>,
+}
+
+// Safety: each slot is written by the producer only before `write` is published
+// and read by the consumer only after observing it.
+unsafe impl Sync for SpscRing {}
+
+impl SpscRing {
+    fn new(min_capacity: usize) -> Self {
+        let capacity = min_capacity.next_power_of_two();
+        SpscRing {
+            buf: (0..capacity).map(|_| UnsafeCell::new(0.0)).collect(),
+            mask: capacity - 1,
+            write: CachePadded(AtomicUsize::new(0)),
+            read: CachePadded(AtomicUsize::new(0)),
+        }
+    }
+
+    fn len(&self) -> usize {
+        self.write.0.load(Ordering::Acquire).wrapping_sub(self.read.0.load(Ordering::Acquire))
+    }
+
+    /// Producer side. Returns the number of samples accepted (less than
+    /// data.len() when the ring is full).
+    fn push(&self, data: &[f32]) -> usize {
+        let w = self.write.0.load(Ordering::Relaxed);
+        let r = self.read.0.load(Ordering::Acquire);
+        let free = self.buf.len() - w.wrapping_sub(r);
+        let n = free.min(data.len());
+        for (i, &x) in data[..n].iter().enumerate() {
+            unsafe { *self.buf[w.wrapping_add(i) & self.mask].get() = x };
+        }
+        self.write.0.store(w.wrapping_add(n), Ordering::Release);
+        n
+    }
+
+    /// Consumer side. Returns the number of samples copied into `out`.
+    fn pop(&self, out: &mut [f32]) -> usize {
+        let r = self.read.0.load(Ordering::Relaxed);
+        let w = self.write.0.load(Ordering::Acquire);
+        let n = w.wrapping_sub(r).min(out.len());
+        for (i, x) in out[..n].iter_mut().enumerate() {
+            *x = unsafe { *self.buf[r.wrapping_add(i) & self.mask].get() };
+        }
+        self.read.0.store(r.wrapping_add(n), Ordering::Release);
+        n
+    }
+}
+
+/// Options for moshi_stream_create (mirrors MoshiStreamOptions in moshi.h).
+#[repr(C)]
+pub struct MoshiStreamOptions {
+    pub sampling: MoshiSamplingParams,
+    /// Capacity of each ring in 80 ms frames (0 = 8).
+    pub ring_frames: u32,
+}
+
+/// Pipeline statistics (mirrors MoshiStreamStats in moshi.h).
+#[repr(C)]
+pub struct MoshiStreamStats {
+    pub frames_processed: u64,
+    pub underruns: u64,
+    pub underrun_samples: u64,
+    pub dropped_input_samples: u64,
+    pub dropped_output_samples: u64,
+    pub latency_ms_last: f64,
+    pub latency_ms_mean: f64,
+    pub latency_ms_max: f64,
+}
+
+/// State shared between the audio thread (push/pull), the worker and stats readers.
+struct StreamShared {
+    input: SpscRing,
+    output: SpscRing,
+    stop: AtomicBool,
+    output_started: AtomicBool,
+    frames_processed: AtomicU64,
+    underruns: AtomicU64,
+    underrun_samples: AtomicU64,
+    dropped_input_samples: AtomicU64,
+    dropped_output_samples: AtomicU64,
+    latency_us_last: AtomicU64,
+    latency_us_sum: AtomicU64,
+    latency_us_max: AtomicU64,
+    /// Written once by the worker when it stops on an error; never touched by
+    /// the audio thread.
+    error: Mutex<Option<String>>,
+}
+
+/// Opaque handle to a real-time streaming pipeline.
+pub struct MoshiStream {
+    shared: Arc<StreamShared>,
+    worker: Option<std::thread::JoinHandle<()>>,
+}
+
+struct SendPtr<T>(*mut T);
+unsafe impl<T> Send for SendPtr<T> {}
+
+fn stream_worker(
+    shared: Arc<StreamShared>,
+    codec: SendPtr<MimiCodec>,
+    model: SendPtr<MoshiModel>,
+    params: MoshiSamplingParams,
+) {
+    let codec = codec.0;
+    let model = model.0;
+    let generated = moshi_generated_codebooks(model) as usize;
+    let num_user = (moshi_audio_codebooks(model) as usize).saturating_sub(generated);
+
+    // All worker buffers are allocated once, up front
+    let mut frame = vec![0f32; STREAM_FRAME_SAMPLES];
+    let mut user_codes = vec![0u32; 64];
+    let mut audio_codes = vec![0u32; generated.max(1)];
+    let mut pcm = vec![0f32; 2 * STREAM_FRAME_SAMPLES];
+    let mut text_token = 0u32;
+
+    let fail = |what: &str| {
+        let err = LAST_ERROR.with(|e| e.borrow().as_ref().map(|s| s.to_string_lossy().into_owned()));
+        *shared.error.lock().unwrap() = Some(format!("{what}: {}", err.unwrap_or_default()));
+    };
+
+    while !shared.stop.load(Ordering::Acquire) {
+        if shared.input.len() < STREAM_FRAME_SAMPLES {
+            // A frame takes 80 ms to arrive; polling keeps the audio thread free
+            // of wake-up syscalls.
+            std::thread::park_timeout(Duration::from_millis(2));
+            continue;
+        }
+        let t_pop = Instant::now();
+        shared.input.pop(&mut frame);
+        // Samples queued behind this frame arrived after it was complete
+        let input_backlog = shared.input.len();
+
+        let n_codes = mimi_encode_step(codec, frame.as_ptr(), frame.len(),
+                                       user_codes.as_mut_ptr(), user_codes.len());
+        if n_codes < 0 { fail("mimi_encode_step"); return; }
+        if n_codes == 0 { continue; }
+        if (n_codes as usize) < num_user {
+            *shared.error.lock().unwrap() = Some(format!(
+                "Mimi produced {n_codes} codebooks, model needs {num_user}"
+            ));
+            return;
+        }
+
+        let n_audio = moshi_step(model, &params, user_codes.as_ptr(), num_user,
+                                 &mut text_token, audio_codes.as_mut_ptr(), audio_codes.len());
+        if n_audio < 0 { fail("moshi_step"); return; }
+
+        let mut n_pcm = 0;
+        if n_audio > 0 {
+            n_pcm = mimi_decode_step(codec, audio_codes.as_ptr(), n_audio as usize,
+                                     pcm.as_mut_ptr(), pcm.len());
+            if n_pcm < 0 { fail("mimi_decode_step"); return; }
+        }
+
+        let queued_ahead = shared.output.len();
+        let n_pcm = n_pcm as usize;
+        let accepted = shared.output.push(&pcm[..n_pcm]);
+        if accepted < n_pcm {
+            shared.dropped_output_samples.fetch_add((n_pcm - accepted) as u64, Ordering::Relaxed);
+        }
+        if accepted > 0 {
+            shared.output_started.store(true, Ordering::Release);
+        }
+
+        // Latency from the frame's last input sample to its first output sample
+        // playing: queued input ahead of the worker, processing, queued output.
+        let processing = t_pop.elapsed().as_secs_f64();
+        let latency = processing + (input_backlog + queued_ahead) as f64 / STREAM_SAMPLE_RATE;
+        let latency_us = (latency * 1e6) as u64;
+        shared.latency_us_last.store(latency_us, Ordering::Relaxed);
+        shared.latency_us_sum.fetch_add(latency_us, Ordering::Relaxed);
+        shared.latency_us_max.fetch_max(latency_us, Ordering::Relaxed);
+        shared.frames_processed.fetch_add(1, Ordering::Release);
+    }
+}
+
+/// Start a streaming pipeline: PCM pushed from an audio callback is sliced into
+/// 80 ms frames on a worker thread, run through mimi_encode_step, moshi_step and
+/// mimi_decode_step, and the model's speech is queued for moshi_stream_pull.
+/// codec and model are borrowed, must outlive the stream and must not be used
+/// elsewhere while it runs. options may be null (greedy, 8-frame rings).
+/// Returns null on failure.
+#[no_mangle]
+pub extern "C" fn moshi_stream_create(
+    codec: *mut MimiCodec,
+    model: *mut MoshiModel,
+    options: *const MoshiStreamOptions,
+) -> *mut MoshiStream {
+    clear_error();
+    if codec.is_null() || model.is_null() {
+        set_error("Null pointer argument".into());
+        return std::ptr::null_mut();
+    }
+    let options = unsafe { options.as_ref() };
+    let params = options.map_or(
+        MoshiSamplingParams {
+            text_temperature: 0.0,
+            text_top_k: 0,
+            audio_temperature: 0.0,
+            audio_top_k: 0,
+            seed: 0,
+        },
+        |o| o.sampling,
+    );
+    let ring_frames = options.map_or(0, |o| o.ring_frames as usize);
+    let ring_samples = STREAM_FRAME_SAMPLES * if ring_frames == 0 { 8 } else { ring_frames };
+
+    let shared = Arc::new(StreamShared {
+        input: SpscRing::new(ring_samples),
+        output: SpscRing::new(ring_samples),
+        stop: AtomicBool::new(false),
+        output_started: AtomicBool::new(false),
+        frames_processed: AtomicU64::new(0),
+        underruns: AtomicU64::new(0),
+        underrun_samples: AtomicU64::new(0),
+        dropped_input_samples: AtomicU64::new(0),
+        dropped_output_samples: AtomicU64::new(0),
+        latency_us_last: AtomicU64::new(0),
+        latency_us_sum: AtomicU64::new(0),
+        latency_us_max: AtomicU64::new(0),
+        error: Mutex::new(None),
+    });
+
+    let worker_shared = shared.clone();
+    let (codec, model) = (SendPtr(codec), SendPtr(model));
+    let worker = std::thread::Builder::new()
+        .name("moshi-stream".into())
+        .spawn(move || stream_worker(worker_shared, codec, model, params));
+    match worker {
+        Ok(handle) => Box::into_raw(Box::new(MoshiStream { shared, worker: Some(handle) })),
+        Err(e) => {
+            set_error(format!("Failed to start stream worker: {e}"));
+            std::ptr::null_mut()
+        }
+    }
+}
+
+/// Push captured PCM (f32, 24 kHz, mono) of any length. Real-time safe: no
+/// allocation, locking or syscalls. Returns the number of samples accepted;
+/// the rest is dropped (and counted) when the input ring is full.
+#[no_mangle]
+pub extern "C" fn moshi_stream_push(stream: *mut MoshiStream, pcm: *const f32, len: usize) -> usize {
+    if stream.is_null() || pcm.is_null() { return 0; }
+    let shared = &unsafe { &*stream }.shared;
+    let data = unsafe { std::slice::from_raw_parts(pcm, len) };
+    let accepted = shared.input.push(data);
+    if accepted < len {
+        shared.dropped_input_samples.fetch_add((len - accepted) as u64, Ordering::Relaxed);
+    }
+    accepted
+}
+
+/// Fill `out` with `len` samples of generated speech. Real-time safe. Missing
+/// samples are zero-filled and, once output has started, counted as an underrun.
+/// Returns the number of generated samples copied.
+#[no_mangle]
+pub extern "C" fn moshi_stream_pull(stream: *mut MoshiStream, out: *mut f32, len: usize) -> usize {
+    if stream.is_null() || out.is_null() { return 0; }
+    let shared = &unsafe { &*stream }.shared;
+    let out = unsafe { std::slice::from_raw_parts_mut(out, len) };
+    let n = shared.output.pop(out);
+    if n < len {
+        out[n..].iter_mut().for_each(|x| *x = 0.0);
+        if shared.output_started.load(Ordering::Acquire) {
+            shared.underruns.fetch_add(1, Ordering::Relaxed);
+            shared.underrun_samples.fetch_add((len - n) as u64, Ordering::Relaxed);
+        }
+    }
+    n
+}
+
+/// Read pipeline statistics. Not for the audio thread.
+/// Returns 0, or -1 if the worker stopped on an error (see moshi_last_error).
+#[no_mangle]
+pub extern "C" fn moshi_stream_stats(stream: *const MoshiStream, out: *mut MoshiStreamStats) -> i32 {
+    clear_error();
+    if stream.is_null() || out.is_null() {
+        set_error("Null pointer argument".into());
+        return -1;
+    }
+    let shared = &unsafe { &*stream }.shared;
+    let frames = shared.frames_processed.load(Ordering::Acquire);
+    let us_to_ms = |us: u64| us as f64 / 1000.0;
+    unsafe {
+        *out = MoshiStreamStats {
+            frames_processed: frames,
+            underruns: shared.underruns.load(Ordering::Relaxed),
+            underrun_samples: shared.underrun_samples.load(Ordering::Relaxed),
+            dropped_input_samples: shared.dropped_input_samples.load(Ordering::Relaxed),
+            dropped_output_samples: shared.dropped_output_samples.load(Ordering::Relaxed),
+            latency_ms_last: us_to_ms(shared.latency_us_last.load(Ordering::Relaxed)),
+            latency_ms_mean: if frames > 0 {
+                us_to_ms(shared.latency_us_sum.load(Ordering::Relaxed)) / frames as f64
+            } else {
+                0.0
+            },
+            latency_ms_max: us_to_ms(shared.latency_us_max.load(Ordering::Relaxed)),
+        };
+    }
+    match shared.error.lock().unwrap().as_ref() {
+        Some(e) => { set_error(e.clone()); -1 }
+        None => 0,
+    }
+}
+
+/// Stop the worker and free the stream. The codec and model can be used again
+/// afterwards.
+#[no_mangle]
+pub extern "C" fn moshi_stream_destroy(stream: *mut MoshiStream) {
+    if stream.is_null() { return; }
+    let mut stream = unsafe { Box::from_raw(stream) };
+    stream.shared.stop.store(true, Ordering::Release);
+    if let Some(worker) = stream.worker.take() {
+        worker.thread().unpark();
+        let _ = worker.join();
+    }
+}
+
 /// Get the last error message. Returns null if no error.
 /// The returned string is valid until the next FFI call.
 #[no_mangle]
@@ -709,15 +2157,48 @@ def write_c_header(output_dir):
 extern "C" {
 #endif
 
+/* Allocation contract (the same as swc.h): no function returns memory for the
+ * caller to free (except the handles, released with their *_free / *_destroy).
+ * Every output is either
+ *   - written into a caller buffer sized by its *_capacity argument, or
+ *   - allocated in a MoshiArena the caller owns (the *_arena functions below),
+ *     valid until moshi_arena_reset or moshi_arena_destroy and never freed
+ *     individually.
+ * On the CPU device results are copied straight from tensor storage, without
+ * host staging copies; other devices read back once per call. The steady-state
+ * host allocations on the step paths are the input tensor upload and candle's
+ * own intermediates, which come from the Rust global allocator. */
+
 /* Opaque handles */
 typedef struct MimiCodec MimiCodec;
 typedef struct MoshiModel MoshiModel;
+typedef struct MoshiWeights MoshiWeights;
+typedef struct MoshiBatch MoshiBatch;
 
 /* Library initialization */
 int32_t moshi_init(void);
 
+/* Load options. Weights are read from a memory mapping in the requested dtype
+ * (no f32 staging copy) and the mapping is released after load. Pass a .gguf
+ * file to moshi_load_ex / moshi_weights_load for q8/q4 quantized weights. */
+#define MOSHI_DTYPE_AUTO 0  /* bf16 on GPU, f32 on CPU; only when requested */
+#define MOSHI_DTYPE_F32  1
+#define MOSHI_DTYPE_F16  2
+#define MOSHI_DTYPE_BF16 3
+
+typedef void (*MoshiProgressFn)(void* user_data, uint64_t loaded_bytes, uint64_t total_bytes);
+
+typedef struct MoshiLoadOptions {
+    uint32_t dtype;            /* MOSHI_DTYPE_*; NULL options and functions without options use F32 */
+    MoshiProgressFn progress;  /* may be NULL; called on the loading thread */
+    void* progress_user_data;
+} MoshiLoadOptions;
+
 /* Mimi codec (neural audio codec, 24kHz mono, 12.5Hz frame rate) */
 MimiCodec* mimi_load(const char* model_path, uint32_t num_codebooks);
+/* Only options->progress applies to Mimi; it always runs in f32 */
+MimiCodec* mimi_load_ex(const char* model_path, uint32_t num_codebooks,
+                        const MoshiLoadOptions* options);
 void mimi_free(MimiCodec* codec);
 void mimi_reset(MimiCodec* codec);
 
@@ -729,6 +2210,36 @@ int32_t mimi_decode(MimiCodec* codec, const uint32_t* codes,
                     size_t num_codebooks, size_t num_frames,
                     float* pcm_out, size_t pcm_capacity);
 
+/* Memory source for an arena's blocks. alloc must return size bytes aligned to
+ * align (16) or NULL; free receives the same size and may be NULL if the caller
+ * reclaims the memory itself (e.g. a frame allocator). */
+typedef struct MoshiAllocator {
+    void* (*alloc)(void* user_data, size_t size, size_t align);
+    void (*free)(void* user_data, void* ptr, size_t size);
+    void* user_data;
+} MoshiAllocator;
+
+/* Not thread-safe; use one arena per thread. */
+typedef struct MoshiArena MoshiArena;
+
+/* block_size 0 picks 1 MiB; outputs larger than a block get a block of their
+ * own. allocator NULL uses the global heap; the struct is copied. */
+MoshiArena* moshi_arena_create(size_t block_size, const MoshiAllocator* allocator);
+/* Invalidates every output allocated from the arena; keeps its blocks. */
+void moshi_arena_reset(MoshiArena* arena);
+/* Bytes used since the last reset (including unused tails of filled blocks). */
+size_t moshi_arena_used(const MoshiArena* arena);
+void moshi_arena_destroy(MoshiArena* arena);
+
+/* mimi_encode / mimi_decode with the output in arena, sized exactly, so the
+ * caller does not have to bound it up front. Same return values. */
+int32_t mimi_encode_arena(MimiCodec* codec, MoshiArena* arena,
+                          const float* pcm_data, size_t pcm_len,
+                          const uint32_t** codes_out, uint32_t* out_num_codebooks);
+int32_t mimi_decode_arena(MimiCodec* codec, MoshiArena* arena,
+                          const uint32_t* codes, size_t num_codebooks, size_t num_frames,
+                          const float** pcm_out);
+
 /* Streaming encode/decode (one frame at a time) */
 int32_t mimi_encode_step(MimiCodec* codec, const float* pcm_data, size_t pcm_len,
                          uint32_t* codes_out, size_t codes_capacity);
@@ -738,21 +2249,126 @@ int32_t mimi_decode_step(MimiCodec* codec, const uint32_t* codes,
 
 /* Moshi model (speech-to-speech LLM) */
 MoshiModel* moshi_load(const char* model_path);
+MoshiModel* moshi_load_ex(const char* model_path, const MoshiLoadOptions* options);
 void moshi_free(MoshiModel* model);
 void moshi_reset(MoshiModel* model);
 
+/* Shared weights: load once, then create any number of sessions or batches.
+ * A session is a MoshiModel with its own streaming state (free with moshi_free);
+ * weights may be freed while sessions created from them are still alive. */
+MoshiWeights* moshi_weights_load(const char* model_path, const MoshiLoadOptions* options);
+void moshi_weights_free(MoshiWeights* weights);
+MoshiModel* moshi_session_create(const MoshiWeights* weights);
+
 /* Model properties */
 uint32_t moshi_audio_codebooks(const MoshiModel* model);
+uint32_t moshi_generated_codebooks(const MoshiModel* model);
 uint32_t moshi_audio_pad_token(const MoshiModel* model);
+/* Frames the generated audio trails the text stream (acoustic codebook delay) */
+uint32_t moshi_acoustic_delay(void);
 uint32_t moshi_text_start_token(const MoshiModel* model);
 
-/* Forward pass - returns text logits */
+/* Forward pass - returns text logits. Logits are written straight into
+ * text_logits_out; no per-step host allocation. */
 int32_t moshi_forward(MoshiModel* model,
                       uint32_t text_token,
                       const uint32_t* audio_codes, size_t num_codebooks,
                       float* text_logits_out, size_t text_logits_capacity,
                       uint32_t* out_text_logits_len);
 
+/* Forward pass returning only the k best text logits (selected on the device,
+ * highest first). Returns the number of entries written, or -1 on error. */
+int32_t moshi_forward_topk(MoshiModel* model,
+                           uint32_t text_token,
+                           const uint32_t* audio_codes, size_t num_codebooks,
+                           size_t k, uint32_t* ids_out, float* logits_out);
+
+/* Sampling parameters for moshi_step. temperature <= 0 is greedy argmax;
+ * top_k == 0 samples the full vocabulary. */
+typedef struct MoshiSamplingParams {
+    float text_temperature;
+    uint32_t text_top_k;
+    float audio_temperature;
+    uint32_t audio_top_k;
+    uint64_t seed;
+} MoshiSamplingParams;
+
+/* Full-duplex step: user Mimi codes in, sampled text token and generated audio
+ * codes out (sampling happens on the model's device; no logits are copied).
+ * num_user_codebooks = moshi_audio_codebooks() - moshi_generated_codebooks().
+ * The per-codebook acoustic delays are kept in the model state: pass each Mimi
+ * frame as encoded, and audio_codes_out receives one aligned frame of
+ * moshi_generated_codebooks() codes for mimi_decode_step, moshi_acoustic_delay()
+ * frames behind the text token. params may be NULL for greedy decoding.
+ * Returns the number of audio codes written (0 for the first
+ * moshi_acoustic_delay() steps after a load or reset), or -1 on error. */
+int32_t moshi_step(MoshiModel* model, const MoshiSamplingParams* params,
+                   const uint32_t* user_codes, size_t num_user_codebooks,
+                   uint32_t* out_text_token,
+                   uint32_t* audio_codes_out, size_t audio_codes_capacity);
+
+/* Batched serving: batch_size conversation slots stepped in one forward pass.
+ * user_codes and audio_codes_out are slot-major; active (NULL = all) pauses
+ * slots without advancing them. Slots cannot be reset individually. Each slot
+ * gets the same codes moshi_step would produce; while a slot's delay lines fill
+ * (its first moshi_acoustic_delay() active steps) its codes are all
+ * moshi_audio_pad_token() and should not be decoded.
+ * Returns the number of audio codes written per slot, or -1 on error. */
+MoshiBatch* moshi_batch_create(const MoshiWeights* weights, size_t batch_size);
+void moshi_batch_free(MoshiBatch* batch);
+void moshi_batch_reset(MoshiBatch* batch);
+uint32_t moshi_batch_generated_codebooks(const MoshiBatch* batch);
+int32_t moshi_batch_step(MoshiBatch* batch, const MoshiSamplingParams* params,
+                         const uint32_t* user_codes, size_t num_user_codebooks,
+                         const uint8_t* active,
+                         uint32_t* text_tokens_out,
+                         uint32_t* audio_codes_out, size_t audio_codes_capacity);
+
+/* Real-time streaming pipeline. A worker thread slices pushed PCM into 80 ms
+ * frames, runs mimi_encode_step -> moshi_step -> mimi_decode_step and queues
+ * the model's speech. push/pull are lock-free and allocation-free, for use
+ * from an audio callback (one pushing and one pulling thread). codec and model
+ * are borrowed and must not be used elsewhere while the stream exists. */
+typedef struct MoshiStream MoshiStream;
+
+typedef struct MoshiStreamOptions {
+    MoshiSamplingParams sampling;
+    uint32_t ring_frames;          /* ring capacity in 80 ms frames, 0 = 8 */
+} MoshiStreamOptions;
+
+typedef struct MoshiStreamStats {
+    uint64_t frames_processed;
+    uint64_t underruns;            /* pulls that came up short after output started */
+    uint64_t underrun_samples;
+    uint64_t dropped_input_samples;
+    uint64_t dropped_output_samples;
+    double latency_ms_last;        /* frame complete -> first output sample plays */
+    double latency_ms_mean;
+    double latency_ms_max;
+} MoshiStreamStats;
+
+MoshiStream* moshi_stream_create(MimiCodec* codec, MoshiModel* model,
+                                 const MoshiStreamOptions* options);
+size_t moshi_stream_push(MoshiStream* stream, const float* pcm, size_t len);
+size_t moshi_stream_pull(MoshiStream* stream, float* out, size_t len);
+/* Returns -1 if the worker stopped on an error (see moshi_last_error). */
+int32_t moshi_stream_stats(const MoshiStream* stream, MoshiStreamStats* out);
+void moshi_stream_destroy(MoshiStream* stream);
+
+/* Tracing: begin/end are called around each moshi_forward*, moshi_step,
+ * moshi_batch_step and mimi_*_step call, on the calling thread, with the
+ * function name (static storage). The struct is copied; set hooks once, before
+ * the first call (replaced hooks are never freed). NULL removes them. The trace
+ * shim (build-skia.py -variant traced) provides matching functions:
+ *   MoshiTraceHooks hooks = { trace_shim_hook_begin, trace_shim_hook_end, (void*)"moshi" }; */
+typedef struct MoshiTraceHooks {
+    void (*begin)(void* user_data, const char* name);
+    void (*end)(void* user_data, const char* name);
+    void* user_data;
+} MoshiTraceHooks;
+
+void moshi_set_trace_hooks(const MoshiTraceHooks* hooks);
+
 /* Error handling */
 const char* moshi_last_error(void);
 
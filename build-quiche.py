@@ -10,6 +10,11 @@ feature, after applying a small patch that exposes
 `quiche_h3_config_set_additional_settings` to the C FFI (needed to advertise
 the WebTransport HTTP/3 SETTINGS that upstream quiche does not handle natively).
 
+Desktop builds also produce libquiche_udp (third_party/quiche-udp), the UDP
+send/recv loop for quiche on libuv: sendmmsg/recvmmsg batching, UDP GSO/GRO on
+Linux and pacing by send_info.at. It needs the libuv headers from
+build-libuv.py (-libuv, defaults to the -out dir) and is skipped without them.
+
 quiche bundles BoringSSL (a git submodule), so building requires:
   - a Rust toolchain (cargo/rustup)
   - cmake
@@ -57,6 +62,8 @@ def parse_args():
     parser.add_argument("-config", choices=["Release", "Debug"], default="Release")
     parser.add_argument("-out", help="Output directory", default="build")
     parser.add_argument("-version", help="quiche version (git tag)", default=QUICHE_VERSION)
+    parser.add_argument("-libuv", help="build-libuv.py output dir with include/uv.h, for "
+                        "libquiche_udp (default: the -out dir)", default=None)
     return parser.parse_args()
 
 
@@ -219,6 +226,43 @@ def dest_lib_dir(build_dir, platform, arch, multi):
     return build_dir / f"quiche-{platform}" / "lib"
 
 
+def build_quiche_udp(root_dir, src_dir, build_dir, platform, arch, libuv_include, config):
+    """Build libquiche_udp for one desktop arch; returns the built lib path."""
+    cmake_build_dir = build_dir / f"cmake-build-quiche-udp-{platform}-{arch}"
+    cmake_build_dir.mkdir(parents=True, exist_ok=True)
+
+    cmake_args = [
+        "cmake",
+        str(root_dir / "third_party" / "quiche-udp"),
+        f"-DCMAKE_BUILD_TYPE={config}",
+        f"-DLIBUV_INCLUDE_DIR={libuv_include}",
+        f"-DQUICHE_INCLUDE_DIR={src_dir / 'quiche' / 'include'}",
+    ]
+    if platform == "win":
+        # Static MSVC runtime, matching quiche (crt-static) and libuv
+        cmake_args.extend([
+            "-DCMAKE_MSVC_RUNTIME_LIBRARY=MultiThreaded",
+            "-DCMAKE_POLICY_DEFAULT_CMP0091=NEW",
+        ])
+    else:
+        cmake_args.extend(["-G", "Ninja", "-DCMAKE_POSITION_INDEPENDENT_CODE=ON"])
+    if platform == "mac":
+        osx_arch = "arm64" if arch == "arm64" else "x86_64"
+        cmake_args.extend([f"-DCMAKE_OSX_ARCHITECTURES={osx_arch}",
+                           "-DCMAKE_OSX_DEPLOYMENT_TARGET=10.15"])
+    run_command(cmake_args, cwd=cmake_build_dir)
+    run_command(["cmake", "--build", ".", "--config", config], cwd=cmake_build_dir)
+
+    lib_name = "quiche_udp.lib" if platform == "win" else "libquiche_udp.a"
+    lib_path = cmake_build_dir / config / lib_name
+    if not lib_path.exists():
+        lib_path = cmake_build_dir / lib_name
+    if not lib_path.exists():
+        print(f"Error: expected build artifact not found: {lib_path}")
+        sys.exit(1)
+    return lib_path, lib_name
+
+
 def main():
     args = parse_args()
 
@@ -245,6 +289,13 @@ def main():
 
     archs = [a.strip() for a in args.archs.split(",")]
 
+    # libquiche_udp sits on libuv, which build-libuv.py only builds for desktop
+    libuv_include = Path(args.libuv or args.out).absolute() / "include"
+    build_udp = args.platform in ("mac", "linux", "win")
+    if build_udp and not (libuv_include / "uv.h").exists():
+        print(f"Skipping libquiche_udp: {libuv_include / 'uv.h'} not found (run build-libuv.py first)")
+        build_udp = False
+
     for arch in archs:
         target = get_rust_target(args.platform, arch)
         print(f"Building quiche for {args.platform} {arch} ({target})...")
@@ -257,12 +308,24 @@ def main():
         print(f"Copying {src_lib} -> {dest_lib}")
         shutil.copy2(src_lib, dest_lib)
 
+        if build_udp:
+            print(f"Building libquiche_udp for {args.platform} {arch}...")
+            udp_lib, udp_lib_name = build_quiche_udp(
+                root_dir, src_dir, build_dir.absolute(), args.platform, arch, libuv_include,
+                args.config)
+            print(f"Copying {udp_lib} -> {dest_dir / udp_lib_name}")
+            shutil.copy2(udp_lib, dest_dir / udp_lib_name)
+
     # Copy the (patched) C header.
     header_src = src_dir / "quiche" / "include" / "quiche.h"
     header_dest = build_dir / "include" / "quiche.h"
     header_dest.parent.mkdir(parents=True, exist_ok=True)
     print(f"Copying {header_src} -> {header_dest}")
     shutil.copy2(header_src, header_dest)
+    if build_udp:
+        udp_header = root_dir / "third_party" / "quiche-udp" / "include" / "quiche_udp.h"
+        print(f"Copying {udp_header} -> {header_dest.parent / 'quiche_udp.h'}")
+        shutil.copy2(udp_header, header_dest.parent / "quiche_udp.h")
 
     print("Build complete.")
 
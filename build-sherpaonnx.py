@@ -5,11 +5,23 @@ Build sherpa-onnx static libraries for multiple platforms.
 sherpa-onnx provides speech synthesis (TTS) and recognition in C/C++.
 Used for KittenTTS voice synthesis without Python dependencies.
 
+Execution providers come from the ONNX Runtime sherpa-onnx links: CoreML on
+Apple, NNAPI / XNNPACK on Android (-ort-dir with the onnxruntime-android AAR
+contents), XNNPACK where the ORT build has it. -providers lists the ones the
+build must have. On the host this is checked with sherpa_onnx_ep_check; cross
+builds (and -shared-runtime off) inspect the ORT libraries statically.
+
+By default the build also compiles third_party/sherpa-onnx-shared into
+sherpa-onnx-core: SherpaOnnxInitSharedRuntime creates one ORT environment whose
+intra-op / inter-op pools every recognizer and TTS session shares, instead of
+each session starting its own num_threads threads.
+
 Source: https://github.com/k2-fsa/sherpa-onnx
 """
 
 import argparse
 import os
+import platform as host_platform
 import shutil
 import subprocess
 import sys
@@ -18,6 +30,23 @@ from pathlib import Path
 SHERPAONNX_VERSION = "v1.12.30"
 SHERPAONNX_REPO = "https://github.com/k2-fsa/sherpa-onnx.git"
 
+SHARED_RUNTIME_DIR = Path(__file__).parent.absolute() / "third_party" / "sherpa-onnx-shared"
+
+# Execution providers `-providers auto` expects per platform (ORT names); on
+# desktop the prebuilt static ORT may lack XNNPACK, so auto only warns
+DEFAULT_PROVIDERS = {
+    "mac": ["coreml"],
+    "ios": ["coreml"],
+    "android": ["nnapi", "xnnpack"],
+    "linux": ["xnnpack"],
+    "win": ["xnnpack"],
+}
+PROVIDER_NAMES = {
+    "coreml": "CoreMLExecutionProvider",
+    "nnapi": "NnapiExecutionProvider",
+    "xnnpack": "XnnpackExecutionProvider",
+}
+
 
 def parse_args():
     parser = argparse.ArgumentParser(description="Build sherpa-onnx static libraries")
@@ -28,6 +57,17 @@ def parse_args():
     parser.add_argument("-out", help="Output directory", default="build")
     parser.add_argument("-version", help="sherpa-onnx version/tag", default=SHERPAONNX_VERSION)
     parser.add_argument("-ndk", help="Android NDK path", default=None)
+    parser.add_argument("-providers", default="auto",
+                        help="Execution providers the build must have, comma separated "
+                             "(coreml, nnapi, xnnpack), 'auto' for the platform defaults "
+                             "(warn only) or 'none'")
+    parser.add_argument("-ort-dir", default=None,
+                        help="Prebuilt ONNX Runtime to link instead of sherpa-onnx's download: "
+                             "lib/ + include/, or an unpacked onnxruntime-android AAR "
+                             "(jni/<abi>/ + headers/). Required for android and ios")
+    parser.add_argument("-shared-runtime", choices=["on", "off"], default="on",
+                        help="Compile the shared ORT environment / thread pool API into "
+                             "sherpa-onnx-core (default: on)")
     return parser.parse_args()
 
 
@@ -83,6 +123,75 @@ def get_ndk_path(args_ndk):
     sys.exit(1)
 
 
+def resolve_providers(platform, providers_arg):
+    """Return (providers, required) for -providers."""
+    if providers_arg == "auto":
+        return DEFAULT_PROVIDERS[platform], False
+    if providers_arg == "none":
+        return [], True
+    providers = [p.strip().lower() for p in providers_arg.split(",") if p.strip()]
+    for p in providers:
+        if p not in PROVIDER_NAMES:
+            print(f"Error: unknown execution provider '{p}' (expected {', '.join(PROVIDER_NAMES)})")
+            sys.exit(1)
+        if p == "coreml" and platform not in ("mac", "ios"):
+            print("Error: the CoreML provider only exists on mac / ios")
+            sys.exit(1)
+        if p == "nnapi" and platform != "android":
+            print("Error: the NNAPI provider only exists on android")
+            sys.exit(1)
+    return providers, True
+
+
+def resolve_ort_dir(ort_dir, platform, arch):
+    """Return (lib_dir, include_dir) for a prebuilt ONNX Runtime."""
+    root = Path(ort_dir).absolute()
+    abi = {"arm64": "arm64-v8a", "arm": "armeabi-v7a", "x64": "x86_64", "x86": "x86"}.get(arch, arch)
+    if platform == "android" and (root / "jni" / abi).exists():
+        return root / "jni" / abi, root / "headers"
+    if (root / "lib").exists() and (root / "include").exists():
+        return root / "lib", root / "include"
+    print(f"Error: {root} has neither lib/ + include/ nor jni/{abi}/ + headers/")
+    sys.exit(1)
+
+
+def add_shared_runtime(source_dir):
+    """Compile sherpa-onnx-shared into sherpa-onnx-core (idempotent)."""
+    csrc = source_dir / "sherpa-onnx" / "csrc"
+    for src in [SHARED_RUNTIME_DIR / "src" / "shared-runtime.h",
+                SHARED_RUNTIME_DIR / "src" / "shared-runtime.cc",
+                SHARED_RUNTIME_DIR / "include" / "sherpa-onnx-shared.h"]:
+        shutil.copy2(src, csrc / src.name)
+
+    # Every ORT session sherpa-onnx creates gets its options from GetSessionOptionsImpl
+    session_cc = csrc / "session.cc"
+    content = session_cc.read_text()
+    if "ApplySharedRuntime" not in content:
+        include_anchor = '#include "sherpa-onnx/csrc/session.h"\n'
+        options_anchor = "Ort::SessionOptions sess_opts;\n"
+        if include_anchor not in content or options_anchor not in content:
+            print(f"Error: {session_cc} no longer matches the shared-runtime hook; "
+                  "update add_shared_runtime() or build with -shared-runtime off")
+            sys.exit(1)
+        content = content.replace(
+            include_anchor, include_anchor + '#include "sherpa-onnx/csrc/shared-runtime.h"\n', 1)
+        content = content.replace(
+            options_anchor, options_anchor + "  ApplySharedRuntime(&sess_opts);\n", 1)
+        session_cc.write_text(content)
+
+    cmake_lists = csrc / "CMakeLists.txt"
+    content = cmake_lists.read_text()
+    if "shared-runtime.cc" not in content:
+        anchor = "add_library(sherpa-onnx-core ${sources})"
+        if anchor not in content:
+            print(f"Error: {cmake_lists} has no '{anchor}'; update add_shared_runtime()")
+            sys.exit(1)
+        content = content.replace(anchor, "list(APPEND sources shared-runtime.cc)\n" + anchor, 1)
+        cmake_lists.write_text(content)
+
+    print("Added shared ORT runtime (sherpa-onnx-shared) to sherpa-onnx-core")
+
+
 def get_cmake_flags(platform, arch, config, ndk_path=None):
     """Get CMake configure flags for the target."""
     flags = [
@@ -157,7 +266,7 @@ def get_cmake_flags(platform, arch, config, ndk_path=None):
     return flags
 
 
-def build_sherpaonnx(source_dir, build_dir, platform, arch, config, ndk_path=None):
+def build_sherpaonnx(source_dir, build_dir, platform, arch, config, ndk_path=None, ort_dir=None):
     """Build sherpa-onnx using CMake."""
     cmake_build_dir = build_dir / f"cmake-build-sherpaonnx-{platform}-{arch}"
     cmake_build_dir.mkdir(parents=True, exist_ok=True)
@@ -165,14 +274,21 @@ def build_sherpaonnx(source_dir, build_dir, platform, arch, config, ndk_path=Non
     cmake_args = ["cmake", str(source_dir)]
     cmake_args.extend(get_cmake_flags(platform, arch, config, ndk_path))
 
+    env = os.environ.copy()
+    if ort_dir:
+        # sherpa-onnx's cmake/onnxruntime.cmake links these instead of downloading ORT
+        ort_lib_dir, ort_include_dir = resolve_ort_dir(ort_dir, platform, arch)
+        env["SHERPA_ONNXRUNTIME_LIB_DIR"] = str(ort_lib_dir)
+        env["SHERPA_ONNXRUNTIME_INCLUDE_DIR"] = str(ort_include_dir)
+
     # Configure
-    run_command(cmake_args, cwd=cmake_build_dir)
+    run_command(cmake_args, cwd=cmake_build_dir, env=env)
 
     # Build
     build_cmd = ["cmake", "--build", ".", "--config", config]
     if platform != "win":
         build_cmd.extend(["--parallel"])
-    run_command(build_cmd, cwd=cmake_build_dir)
+    run_command(build_cmd, cwd=cmake_build_dir, env=env)
 
     return cmake_build_dir
 
@@ -206,9 +322,16 @@ def find_libraries(cmake_build_dir, platform):
     return libs
 
 
-def copy_outputs(cmake_build_dir, output_dir, platform, arch, config):
+def copy_outputs(cmake_build_dir, output_dir, platform, arch, config, ort_dir=None):
     """Copy built libraries to output directory."""
     libs = find_libraries(cmake_build_dir, platform)
+    if ort_dir:
+        # A prebuilt ORT may be shared (the Android AAR ships libonnxruntime.so)
+        ort_lib_dir, _ = resolve_ort_dir(ort_dir, platform, arch)
+        for pattern in ("*onnxruntime*.a", "*onnxruntime*.so", "*onnxruntime*.dylib",
+                        "*onnxruntime*.lib", "*onnxruntime*.dll"):
+            for f in ort_lib_dir.glob(pattern):
+                libs[f.name] = f
 
     if not libs:
         print(f"Error: No libraries found in {cmake_build_dir}")
@@ -245,6 +368,110 @@ def copy_headers(source_dir, output_dir):
         print(f"Warning: C API header not found at {header}")
 
 
+def copy_shared_runtime_header(output_dir):
+    include_dest = output_dir / "include" / "sherpaonnx"
+    include_dest.mkdir(parents=True, exist_ok=True)
+    print("Copying header: sherpa-onnx-shared.h")
+    shutil.copy2(SHARED_RUNTIME_DIR / "include" / "sherpa-onnx-shared.h", include_dest)
+
+
+def is_host_target(platform, arch):
+    host = {"darwin": "mac", "linux": "linux", "win32": "win"}.get(sys.platform)
+    machine = host_platform.machine().lower()
+    host_arch = {"x86_64": "x64", "amd64": "x64", "aarch64": "arm64"}.get(machine, machine)
+    return platform == host and {"x86_64": "x64"}.get(arch, arch) == host_arch
+
+
+def scan_ort_providers(lib_dir):
+    """Execution providers compiled into the ONNX Runtime libraries in lib_dir (the
+    ORT libs copy_outputs placed there, e.g. the AAR's libonnxruntime.so), found from
+    the provider classes' mangled names: symbols in static libs, RTTI type names in
+    stripped shared libs. Returns None if not even the CPU provider shows up, i.e.
+    the libraries can't be inspected this way."""
+    names = ["CPUExecutionProvider"] + list(PROVIDER_NAMES.values())
+    # Itanium (clang/gcc) and MSVC spellings of onnxruntime::<name>
+    markers = {name: [f"{len(name)}{name}".encode(), f"{name}@onnxruntime@@".encode()] for name in names}
+    overlap = max(len(m) for ms in markers.values() for m in ms)
+    found = set()
+    for lib in sorted(lib_dir.glob("*onnxruntime*")):
+        if not lib.is_file():
+            continue
+        with open(lib, "rb") as f:
+            tail = b""
+            while chunk := f.read(1 << 23):
+                data = tail + chunk
+                found.update(name for name, ms in markers.items() if any(m in data for m in ms))
+                tail = data[-overlap:]
+    if "CPUExecutionProvider" not in found:
+        return None
+    return [name for name in names if name in found]
+
+
+def run_ep_check(build_dir, lib_dir, platform, arch, config):
+    """Build and run sherpa_onnx_ep_check on the host; returns its key=value output."""
+    cmake_build_dir = build_dir / f"cmake-build-sherpaonnx-check-{platform}-{arch}"
+    cmake_build_dir.mkdir(parents=True, exist_ok=True)
+    cmake_args = ["cmake", str(SHARED_RUNTIME_DIR), f"-DCMAKE_BUILD_TYPE={config}",
+                  f"-DSHERPA_LIB_DIR={lib_dir}"]
+    if platform == "win":
+        # Same static CRT as the libs
+        cmake_args.extend(["-A", "x64", "-DCMAKE_MSVC_RUNTIME_LIBRARY=MultiThreaded",
+                           "-DCMAKE_POLICY_DEFAULT_CMP0091=NEW"])
+    else:
+        cmake_args.extend(["-G", "Ninja"])
+    run_command(cmake_args, cwd=cmake_build_dir)
+    run_command(["cmake", "--build", ".", "--config", config], cwd=cmake_build_dir)
+
+    exe = "sherpa_onnx_ep_check.exe" if platform == "win" else "sherpa_onnx_ep_check"
+    check_bin = cmake_build_dir / config / exe
+    if not check_bin.exists():
+        check_bin = cmake_build_dir / exe
+    print(f"Running: {check_bin}")
+    result = subprocess.run([str(check_bin)], capture_output=True, text=True)
+    print(result.stdout, end="")
+    if result.returncode != 0:
+        print(result.stderr, end="")
+        print("Error: could not create the shared ORT runtime")
+        sys.exit(1)
+    return dict(line.split("=", 1) for line in result.stdout.splitlines() if "=" in line)
+
+
+def check_providers(build_dir, lib_dir, platform, arch, config, providers, required, shared_runtime):
+    """Check that ONNX Runtime has `providers` and record what was found next to the
+    libs. On the host with the shared runtime, sherpa_onnx_ep_check asks ORT; anywhere
+    else the ORT libraries are inspected statically."""
+    if shared_runtime and is_host_target(platform, arch):
+        values = run_ep_check(build_dir, lib_dir, platform, arch, config)
+        values["provider_check"] = "runtime"
+    else:
+        print(f"Checking execution providers of the ONNX Runtime in {lib_dir} statically")
+        available = scan_ort_providers(lib_dir)
+        if available is None:
+            message = f"cannot tell which execution providers ONNX Runtime has: no ORT library in {lib_dir} " \
+                      "carries provider symbols or RTTI"
+            if required and providers:
+                print(f"Error: {message} (use -providers auto to only warn)")
+                sys.exit(1)
+            print(f"WARNING: {message}")
+        values = {"providers": ",".join(available) if available is not None else "unknown",
+                  "preferred": "unknown", "shared_runtime": "1" if shared_runtime else "0",
+                  "provider_check": "static"}
+        print(f"providers={values['providers']}")
+
+    available = values.get("providers", "").split(",")
+    missing = [] if available == ["unknown"] else [p for p in providers if PROVIDER_NAMES[p] not in available]
+    if missing:
+        message = f"ONNX Runtime lacks execution provider(s): {', '.join(missing)}"
+        if required:
+            print(f"Error: {message}")
+            sys.exit(1)
+        print(f"WARNING: {message}")
+
+    with open(lib_dir / "build_config.txt", "w") as f:
+        for key in ["providers", "preferred", "shared_runtime", "provider_check"]:
+            f.write(f"{key}={values.get(key, 'unknown')}\n")
+
+
 def main():
     args = parse_args()
 
@@ -252,8 +479,16 @@ def main():
     third_party_dir = root_dir / "third_party"
     build_dir = Path(args.out).absolute()
 
+    shared_runtime = args.shared_runtime == "on"
+    providers, providers_required = resolve_providers(args.platform, args.providers)
+    if args.platform in ("android", "ios") and not args.ort_dir:
+        print(f"Error: sherpa-onnx has no prebuilt ONNX Runtime for {args.platform}; pass -ort-dir")
+        sys.exit(1)
+
     # Download source
     source_dir = download_source(args.version, third_party_dir)
+    if shared_runtime:
+        add_shared_runtime(source_dir)
 
     arch = args.archs or get_default_arch(args.platform)
     archs = [a.strip() for a in arch.split(",")]
@@ -265,13 +500,18 @@ def main():
 
         cmake_build_dir = build_sherpaonnx(
             source_dir, build_dir, args.platform, arch, args.config,
-            ndk_path=args.ndk,
+            ndk_path=args.ndk, ort_dir=args.ort_dir,
         )
 
-        copy_outputs(cmake_build_dir, build_dir, args.platform, arch, args.config)
+        lib_dir = copy_outputs(cmake_build_dir, build_dir, args.platform, arch, args.config,
+                               ort_dir=args.ort_dir)
+        check_providers(build_dir, lib_dir, args.platform, arch, args.config,
+                        providers, providers_required, shared_runtime)
 
     # Copy headers once
     copy_headers(source_dir, build_dir)
+    if shared_runtime:
+        copy_shared_runtime_header(build_dir)
 
     print(f"\n{'='*60}")
     print("Build complete!")
@@ -41,6 +41,7 @@ import os
 import shutil
 import subprocess
 import sys
+import time
 from pathlib import Path
 
 # Define ANSI color codes
@@ -66,6 +67,8 @@ SKIA_GIT_URL = "https://github.com/google/skia.git"
 SKIA_SRC_DIR = BASE_DIR / "src" / "skia"
 TMP_DIR = BASE_DIR / "tmp" / "skia"
 ACTIVATE_EMSDK_PATH = SKIA_SRC_DIR / "bin" / "activate-emsdk"
+EXAMPLE_DIR = Path(__file__).resolve().parent / "example"
+PGO_DIR = BASE_DIR / "tmp" / "skia-pgo"
 
 # Platform-specific library directories
 MAC_LIB_DIR = BASE_DIR / "mac" / "lib"
@@ -80,6 +83,47 @@ IOS_MIN_VERSION = "14.0"  # Dawn requires iOS 14.0+ for C++ atomic wait/notify
 VISIONOS_MIN_VERSION = "1.0"
 ANDROID_MIN_API = "24"  # Android 7.0 (Nougat) - minimum for Vulkan support
 
+# Profile-guided optimization (-variant gpu-pgo)
+# Training runs the offscreen tools from example/ against an instrumented build:
+# the Graphite benchmark for the GPU recording path, and the raster batch and
+# tiled modes for the CPU raster/path code.
+PGO_PLATFORMS = ["mac", "linux"]
+PGO_TRAINING_RUNS = [
+    ["graphite-bench", "--frames=300", "--warmup=20", "--scene=immediate"],
+    ["graphite-bench", "--frames=300", "--warmup=20", "--scene=retained"],
+    ["batch-render", "--batch=200"],
+    ["batch-render", "--tiled", "--size=2048x2048"],
+]
+PGO_USE_CFLAGS = [
+    "-flto=thin",
+    "-Wno-profile-instr-unprofiled",
+    "-Wno-profile-instr-out-of-date",
+]
+
+# WebAssembly SIMD + threads (-variant simd-mt): the CPU build compiled for wasm
+# SIMD128 and shared-memory threads. Every object linked into a threaded module
+# needs the atomics/bulk-memory features, so the flags go on all of Skia's sources;
+# the example links it with -pthread and needs a cross-origin isolated page
+# (COOP/COEP headers, see example/serve-wasm.py) for SharedArrayBuffer.
+WASM_SIMD_MT_CFLAGS = ["-msimd128", "-pthread"]
+
+# Split libraries (--split-libs): one section per function and data object so the
+# consumer's linker can drop what it never references (--gc-sections, -dead_strip,
+# /OPT:REF), and per-module archives instead of a combined libSkia.a
+SECTION_CFLAGS = ["-ffunction-sections", "-fdata-sections"]
+SECTION_CFLAGS_WIN = ["/Gy", "/Gw"]
+
+# --link-report links example/ (target example) against the fresh libraries, with and
+# without dead stripping, and records the binary size and relink time
+LINK_REPORT_PLATFORMS = ["mac", "linux"]
+
+# Tracing (-variant traced): the gpu build with Skia's TRACE_EVENT macros compiled in
+# (official builds strip them), plus third_party/trace-shim built against the fresh
+# headers. The shim routes Skia's SkEventTracer, Dawn's platform trace events and
+# the FFIs' trace hooks into one JSON trace (ui.perfetto.dev) or a Tracy session.
+TRACED_PLATFORMS = ["mac", "linux", "win"]
+TRACE_SHIM_DIR = Path(__file__).resolve().parent / "third_party" / "trace-shim"
+
 # Unicode backend configuration
 USE_LIBGRAPHEME = False  # Set to True to use libgrapheme instead of ICU
 
@@ -486,6 +530,15 @@ class SkiaBuildScript:
         self.target = "all"  # device, simulator, or all
         self.crt = "static"  # Windows CRT: static (/MT) or dynamic (/MD)
         self.ndk_path = None  # Android NDK path
+        self.pgo_profile = None  # Merged .profdata for gpu-pgo (trained if not given)
+        self.pgo_phase = None  # None, "instrument" or "use" while building gpu-pgo
+        self.jobs = None  # Ninja job budget for the whole run (None: ninja's default)
+        self.parallel_archs = False  # Build archs concurrently, sharing self.jobs
+        self.cc_wrapper = None  # ccache/sccache prefix for compiler invocations
+        self.split_libs = False  # Section-per-function archives, no combined libSkia.a
+        self.icu_data = "common"  # Prebuilt ICU data subset packaged as share/icudtl.dat
+        self.link_report = False  # Link example/ and report size and link time
+        self.tracy_dir = None  # Tracy checkout for the trace shim (-variant traced)
 
     def parse_arguments(self):
         parser = argparse.ArgumentParser(description="Build Skia for macOS, iOS, visionOS, Android, Windows, Linux and WebAssembly")
@@ -495,16 +548,44 @@ class SkiaBuildScript:
         parser.add_argument("-archs", help="Target architectures (comma-separated)")
         parser.add_argument("-branch", help="Skia Git branch to checkout", default="main")
         parser.add_argument("-commit", help="Specific Skia Git commit SHA to checkout (after cloning branch)")
-        parser.add_argument("-variant", choices=["cpu", "gpu"], default="gpu",
-                           help="Build variant: cpu (no GPU) or gpu (with Graphite/Dawn)")
+        parser.add_argument("-variant", choices=["cpu", "gpu", "gpu-pgo", "simd-mt", "traced"], default="gpu",
+                           help="Build variant: cpu (no GPU), gpu (with Graphite/Dawn), gpu-pgo "
+                                "(gpu trained with PGO and emitted as ThinLTO bitcode; mac and linux), "
+                                "simd-mt (cpu with wasm SIMD128 and pthreads; wasm only), "
+                                "or traced (gpu with trace events and the trace shim; mac, linux, win)")
+        parser.add_argument("-profile", help="Existing .profdata for -variant gpu-pgo (skips the "
+                                             "instrumented build and training run)")
         parser.add_argument("-target", choices=["device", "simulator", "all"], default="all",
                            help="Build target for iOS/visionOS: device, simulator, or all")
         parser.add_argument("-crt", choices=["static", "dynamic"], default="static",
                            help="Windows CRT linkage: static (/MT) or dynamic (/MD)")
+        parser.add_argument("-tracy", help="Tracy checkout for -variant traced: adds the Tracy "
+                                           "backend to the trace shim (default: JSON only)")
         parser.add_argument("-ndk", help="Path to Android NDK (or set ANDROID_NDK_HOME env var)")
         parser.add_argument("--shallow", action="store_true", help="Perform a shallow clone of the Skia repository")
         parser.add_argument("--zip-all", action="store_true",
                            help="Create a zip archive containing all platform libraries")
+        parser.add_argument("-jobs", type=int, help="Ninja job budget for the whole run (default: ninja's)")
+        parser.add_argument("--parallel-archs", action="store_true",
+                           help="Build architectures concurrently, splitting -jobs between them")
+        parser.add_argument("-cc-wrapper", help="Compiler launcher, e.g. ccache or sccache")
+        parser.add_argument("--sync-only", action="store_true",
+                           help="Only set up the Skia checkout, deps and patches, then exit")
+        parser.add_argument("--no-sync", action="store_true",
+                           help="Build from the existing checkout without fetching or patching "
+                                "(after a --sync-only run)")
+        parser.add_argument("--print-gn-args", action="store_true",
+                           help="Print the GN args for each architecture and exit")
+        parser.add_argument("--split-libs", action="store_true",
+                           help="Compile with function/data sections and ship per-module archives "
+                                "(no combined libSkia.a except for the xcframework)")
+        parser.add_argument("-icu-data", default="common",
+                           help="ICU data subset to package as share/icudtl.dat: a directory of "
+                                "Skia's ICU checkout holding an icudtl.dat, e.g. flutter or ios "
+                                "(default: common, the full data)")
+        parser.add_argument("--link-report", action="store_true",
+                           help="Link example/ against the built libraries with and without dead "
+                                "stripping and write link_report.txt (mac, linux)")
         args = parser.parse_args()
 
         if args.platform == "xcframework":
@@ -528,7 +609,25 @@ class SkiaBuildScript:
         self.ndk_path = args.ndk or os.environ.get("ANDROID_NDK_HOME") or os.environ.get("ANDROID_NDK_ROOT")
         self.shallow_clone = args.shallow
         self.create_zip_all = args.zip_all
+        self.pgo_profile = Path(args.profile).resolve() if args.profile else None
+        self.jobs = args.jobs
+        self.parallel_archs = args.parallel_archs
+        self.cc_wrapper = args.cc_wrapper
+        self.sync_only = args.sync_only
+        self.no_sync = args.no_sync
+        self.print_gn_args = args.print_gn_args
+        self.split_libs = args.split_libs
+        self.icu_data = args.icu_data
+        self.link_report = args.link_report
+        self.tracy_dir = Path(args.tracy).resolve() if args.tracy else None
+        if self.jobs is not None and self.jobs < 1:
+            colored_print("-jobs must be at least 1", Colors.FAIL)
+            sys.exit(1)
         self.validate_archs()
+        self.validate_pgo()
+        self.validate_simd_mt()
+        self.validate_traced()
+        self.validate_link_report()
 
     def get_default_archs(self):
         if self.platform == "mac":
@@ -561,6 +660,76 @@ class SkiaBuildScript:
                 colored_print(f"Invalid architecture for {self.platform}: {arch}", Colors.FAIL)
                 sys.exit(1)
 
+    def validate_pgo(self):
+        if self.pgo_profile and self.variant != "gpu-pgo":
+            colored_print("-profile is only used with -variant gpu-pgo", Colors.FAIL)
+            sys.exit(1)
+        if self.variant != "gpu-pgo":
+            return
+        if self.xcframework or self.platform not in PGO_PLATFORMS:
+            colored_print(f"-variant gpu-pgo supports {', '.join(PGO_PLATFORMS)} "
+                          "(training runs on the build machine)", Colors.FAIL)
+            sys.exit(1)
+        if self.config != "Release":
+            colored_print("-variant gpu-pgo requires -config Release", Colors.FAIL)
+            sys.exit(1)
+        if self.pgo_profile and not self.pgo_profile.is_file():
+            colored_print(f"Profile not found: {self.pgo_profile}", Colors.FAIL)
+            sys.exit(1)
+
+    def validate_simd_mt(self):
+        if self.variant == "simd-mt" and (self.xcframework or self.platform != "wasm"):
+            colored_print("-variant simd-mt is only for wasm", Colors.FAIL)
+            sys.exit(1)
+
+    def validate_traced(self):
+        if self.tracy_dir and self.variant != "traced":
+            colored_print("-tracy is only used with -variant traced", Colors.FAIL)
+            sys.exit(1)
+        if self.variant != "traced":
+            return
+        if self.xcframework or self.platform not in TRACED_PLATFORMS:
+            colored_print(f"-variant traced supports {', '.join(TRACED_PLATFORMS)}", Colors.FAIL)
+            sys.exit(1)
+        if self.platform == "linux" and self.archs != [self.get_host_arch()]:
+            colored_print(f"-variant traced on linux builds the trace shim for the host "
+                          f"architecture only (-archs {self.get_host_arch()})", Colors.FAIL)
+            sys.exit(1)
+        if self.tracy_dir and not (self.tracy_dir / "public" / "TracyClient.cpp").is_file():
+            colored_print(f"Not a Tracy checkout (no public/TracyClient.cpp): {self.tracy_dir}", Colors.FAIL)
+            sys.exit(1)
+
+    def validate_link_report(self):
+        if not self.link_report:
+            return
+        if self.xcframework or self.platform not in LINK_REPORT_PLATFORMS:
+            colored_print(f"--link-report supports {', '.join(LINK_REPORT_PLATFORMS)} "
+                          "(the example is linked on the build machine)", Colors.FAIL)
+            sys.exit(1)
+        if self.get_host_arch() not in self.archs and self.archs != ["universal"]:
+            colored_print(f"--link-report needs the host architecture ({self.get_host_arch()}) "
+                          "in -archs", Colors.FAIL)
+            sys.exit(1)
+
+    def is_cpu_variant(self):
+        """Variants built from the CPU-only GN args (no Ganesh/Graphite backends)."""
+        return self.variant in ("cpu", "simd-mt")
+
+    def is_gpu_variant(self):
+        return self.variant in ("gpu", "gpu-pgo", "traced")
+
+    def get_host_arch(self):
+        import platform
+        machine = platform.machine().lower()
+        if self.platform == "mac":
+            return "arm64" if machine in ("arm64", "aarch64") else "x86_64"
+        return "arm64" if machine in ("arm64", "aarch64") else "x64"
+
+    def get_build_dir(self, arch):
+        """GN output directory; the instrumented gpu-pgo build gets its own."""
+        phase_suffix = "_instrumented" if self.pgo_phase == "instrument" else ""
+        return TMP_DIR / f"{self.platform}_{self.config}_{arch}_{self.variant}{phase_suffix}"
+
     def get_lib_dir(self, platform):
         """Get the library directory for a platform, including variant suffix."""
         variant_suffix = f"-{self.variant}"
@@ -629,15 +798,15 @@ class SkiaBuildScript:
         colored_print("Syncing Deps...", Colors.OKBLUE)
         subprocess.run([sys.executable, "tools/git-sync-deps"], check=True)
 
-    def generate_gn_args(self, arch: str):
-        output_dir = TMP_DIR / f"{self.platform}_{self.config}_{arch}_{self.variant}"
+    def compose_gn_args(self, arch: str):
+        """GN args that determine the build output (also what --print-gn-args prints)."""
         gn_args = BASIC_GN_ARGS
 
         # Add shared release args first, then platform-specific args can override
         gn_args += RELEASE_GN_ARGS
 
         # Use CPU or GPU platform-specific args based on variant
-        if self.variant == "cpu":
+        if self.is_cpu_variant():
             gn_args += PLATFORM_GN_ARGS_CPU[self.platform]
             gn_args += CPU_ONLY_GN_ARGS
         else:
@@ -772,14 +941,60 @@ extra_ldflags = ["-mmacosx-version-min={mac_min_version}"]
             gn_args += f"target_cpu = \"{'arm64' if arch == 'arm64' else 'x64'}\"\n"
         elif self.platform == "wasm":
             gn_args += "target_cpu = \"wasm\"\n"
+            if self.variant == "simd-mt":
+                quoted = ", ".join(f'"{flag}"' for flag in WASM_SIMD_MT_CFLAGS)
+                gn_args += f"extra_cflags = [{quoted}]\n"
+                gn_args += "extra_ldflags = [\"-pthread\"]\n"
+
+        if self.variant == "traced":
+            gn_args += "skia_disable_tracing = false\n"
+
+        gn_args += self.generate_extra_cflags_gn_args()
+        return gn_args
+
+    def generate_gn_args(self, arch: str):
+        output_dir = self.get_build_dir(arch)
+        gn_args = self.compose_gn_args(arch)
+        if self.cc_wrapper:
+            gn_args += f'cc_wrapper = "{self.cc_wrapper}"\n'
 
         colored_print(f"Generating gn args for {self.platform} {arch} ({self.variant}) settings:", Colors.OKBLUE)
         colored_print(f"{gn_args}", Colors.OKGREEN)
 
         subprocess.run(["./bin/gn", "gen", str(output_dir), f"--args={gn_args}"], check=True)
 
-    def build_skia(self, arch: str):
-        output_dir = TMP_DIR / f"{self.platform}_{self.config}_{arch}_{self.variant}"
+    def get_pgo_cflags(self):
+        if self.pgo_phase == "instrument":
+            return ["-fprofile-instr-generate"]
+        if self.pgo_phase == "use":
+            return [f"-fprofile-instr-use={self.pgo_profile}"] + PGO_USE_CFLAGS
+        return []
+
+    def get_section_cflags(self):
+        if not self.split_libs:
+            return []
+        return SECTION_CFLAGS_WIN if self.platform == "win" else SECTION_CFLAGS
+
+    def generate_extra_cflags_gn_args(self):
+        """Build-mode flags applied to both C and C++ sources: PGO/ThinLTO for
+        gpu-pgo and function/data sections for --split-libs.
+
+        These reassign extra_cflags_c (keeping the platform's -Wno-error) and
+        extra_cflags_cc; extra_cflags stays free for the per-platform target flags.
+        """
+        cflags = self.get_pgo_cflags() + self.get_section_cflags()
+        if not cflags:
+            return ""
+        quoted = ", ".join(f'"{flag}"' for flag in cflags)
+        gn_args = f'extra_cflags_c = ["-Wno-error", {quoted}]\n'
+        gn_args += f"extra_cflags_cc = [{quoted}]\n"
+        if self.pgo_phase == "use" and self.platform != "mac":
+            # Archives of ThinLTO bitcode need an LTO-aware symbol index
+            gn_args += 'ar = "llvm-ar"\n'
+        return gn_args
+
+    def build_skia(self, arch: str, jobs=None):
+        output_dir = self.get_build_dir(arch)
         
         # Get the list of libraries for the current platform
         libs_to_build = LIBS[self.platform]
@@ -801,7 +1016,11 @@ extra_ldflags = ["-mmacosx-version-min={mac_min_version}"]
             libs_to_build = [to_gn_label(lib) for lib in libs_to_build]
         
         # Construct the ninja command with all library targets
-        ninja_command = ["ninja", "-C", str(output_dir)] + libs_to_build
+        ninja_command = ["ninja", "-C", str(output_dir)]
+        jobs = jobs or self.jobs
+        if jobs:
+            ninja_command += ["-j", str(jobs)]
+        ninja_command += libs_to_build
 
         # Run the ninja command
         try:
@@ -813,10 +1032,12 @@ extra_ldflags = ["-mmacosx-version-min={mac_min_version}"]
             print(f"Error details: {e}")
             sys.exit(1)
 
-    def move_libs(self, arch: str):
-        src_dir = TMP_DIR / f"{self.platform}_{self.config}_{arch}_{self.variant}"
+    def move_libs(self, arch: str, dest_dir=None):
+        src_dir = self.get_build_dir(arch)
         lib_dir = self.get_lib_dir(self.platform)
-        if self.platform == "mac":
+        if dest_dir is not None:
+            pass  # Explicit destination (instrumented gpu-pgo libraries for training)
+        elif self.platform == "mac":
             dest_dir = lib_dir / self.config / (arch if arch != "universal" else "")
         elif self.platform == "ios":
             # Include target (device/simulator) in path
@@ -858,7 +1079,7 @@ extra_ldflags = ["-mmacosx-version-min={mac_min_version}"]
                 colored_print(f"Warning: {lib} not found in {src_dir}", Colors.WARNING)
 
         # Copy GPU-specific libraries (Dawn) for GPU variant
-        if self.variant == "gpu" and self.platform in GPU_LIBS:
+        if self.is_gpu_variant() and self.platform in GPU_LIBS:
             for lib in GPU_LIBS[self.platform]:
                 # Dawn combined library is in cmake_dawn subdirectory
                 src_file = src_dir / "cmake_dawn" / lib
@@ -873,7 +1094,7 @@ extra_ldflags = ["-mmacosx-version-min={mac_min_version}"]
                     colored_print(f"Warning: Dawn library {lib} not found", Colors.WARNING)
 
         # Copy ANGLE libraries for WebGL/GLES compatibility (macOS, Windows, Linux only)
-        if self.variant == "gpu" and self.platform in ANGLE_LIBS:
+        if self.is_gpu_variant() and self.platform in ANGLE_LIBS:
             for lib in ANGLE_LIBS[self.platform]:
                 src_file = src_dir / lib
                 dest_file = dest_dir / lib
@@ -898,7 +1119,7 @@ extra_ldflags = ["-mmacosx-version-min={mac_min_version}"]
             colored_print(f"Created universal file: {lib}", Colors.OKGREEN)
 
         # Combine Dawn libraries for GPU variant
-        if self.variant == "gpu" and "mac" in GPU_LIBS:
+        if self.is_gpu_variant() and "mac" in GPU_LIBS:
             for lib in GPU_LIBS["mac"]:
                 input_libs = []
                 for arch in ["x86_64", "arm64"]:
@@ -915,7 +1136,7 @@ extra_ldflags = ["-mmacosx-version-min={mac_min_version}"]
                     colored_print(f"Copied single-arch file: {lib} (Dawn)", Colors.WARNING)
 
         # Combine ANGLE libraries for GPU variant
-        if self.variant == "gpu" and "mac" in ANGLE_LIBS:
+        if self.is_gpu_variant() and "mac" in ANGLE_LIBS:
             for lib in ANGLE_LIBS["mac"]:
                 input_libs = []
                 for arch in ["x86_64", "arm64"]:
@@ -951,10 +1172,19 @@ extra_ldflags = ["-mmacosx-version-min={mac_min_version}"]
         output_lib = lib_dir / "libSkia.a"
         input_libs = [str(lib_dir / lib) for lib in LIBS[platform] if (lib_dir / lib).exists()]
 
-        if input_libs:
+        if input_libs and platform in ["mac", "ios", "visionos"]:
+            # Apple libtool indexes ThinLTO bitcode members through libLTO
             libtool_command = ["libtool", "-static", "-o", str(output_lib)] + input_libs
             subprocess.run(libtool_command, check=True)
             colored_print(f"Created combined library: {output_lib}", Colors.OKGREEN)
+        elif input_libs:
+            # llvm-ar keeps bitcode members and writes an LTO-aware symbol index;
+            # an MRI script merges the members rather than nesting the archives
+            mri_script = f"create {output_lib}\n"
+            mri_script += "".join(f"addlib {lib}\n" for lib in input_libs)
+            mri_script += "save\nend\n"
+            subprocess.run(["llvm-ar", "-M"], input=mri_script, text=True, check=True)
+            colored_print(f"Created combined library: {output_lib}", Colors.OKGREEN)
         else:
             colored_print(f"No libraries found to combine for {platform} {arch}", Colors.WARNING)
 
@@ -1046,15 +1276,28 @@ extra_ldflags = ["-mmacosx-version-min={mac_min_version}"]
                                 # print(f"Copied {rel_path} to {dest_file}")
 
     def package_icu_data(self, dest_dir):
-        """Copy ICU data file (icudtl.dat) to package directory."""
+        """Copy ICU data file (icudtl.dat) to package directory.
+
+        -icu-data picks one of the prebuilt subsets in Skia's ICU checkout (Chromium's
+        ICU fork) instead of the full common/ data: flutter/ keeps the break
+        iterator and normalization data SkParagraph and SkShaper use, at a fraction
+        of the size. Only the packaged file changes; Skia's non-Windows builds embed
+        common/icudtl.dat in libskunicode_icu regardless.
+        """
         if USE_LIBGRAPHEME:
             colored_print("Skipping ICU data packaging (using libgrapheme)", Colors.OKBLUE)
             return
 
         # ICU data file location in Skia's third_party
-        icu_data_src = SKIA_SRC_DIR / "third_party" / "externals" / "icu" / "common" / "icudtl.dat"
+        icu_dir = SKIA_SRC_DIR / "third_party" / "externals" / "icu"
+        icu_data_src = icu_dir / self.icu_data / "icudtl.dat"
 
         if not icu_data_src.exists():
+            if self.icu_data != "common":
+                subsets = sorted(path.parent.name for path in icu_dir.glob("*/icudtl.dat"))
+                colored_print(f"Error: no ICU data subset '{self.icu_data}' "
+                              f"(available: {', '.join(subsets) or 'none'})", Colors.FAIL)
+                sys.exit(1)
             colored_print(f"Warning: ICU data file not found at {icu_data_src}", Colors.WARNING)
             return
 
@@ -1063,6 +1306,14 @@ extra_ldflags = ["-mmacosx-version-min={mac_min_version}"]
         shutil.copy2(icu_data_src, icu_data_dest)
         colored_print(f"Copied ICU data file to {icu_data_dest}", Colors.OKGREEN)
 
+        full_data = icu_dir / "common" / "icudtl.dat"
+        if self.icu_data != "common" and full_data.exists():
+            full_size = full_data.stat().st_size
+            size = icu_data_src.stat().st_size
+            colored_print(f"ICU data '{self.icu_data}': {size / 1024:.0f} KB "
+                          f"(full data {full_size / 1024:.0f} KB, {100.0 * size / full_size:.0f}%)",
+                          Colors.OKGREEN)
+
     def package_generated_dawn_headers(self, build_dir, dest_dir):
         """Copy generated Dawn headers from build output to package."""
         gen_include_dir = build_dir / "gen" / "third_party" / "dawn" / "include"
@@ -1204,7 +1455,7 @@ extra_ldflags = ["-mmacosx-version-min={mac_min_version}"]
 
     def cleanup(self):
         for arch in self.archs:
-            shutil.rmtree(TMP_DIR / f"{self.platform}_{self.config}_{arch}_{self.variant}", ignore_errors=True)
+            shutil.rmtree(self.get_build_dir(arch), ignore_errors=True)
         colored_print("Cleaned up temporary directories", Colors.OKBLUE)
 
     def setup_skia_repo(self):
@@ -1269,7 +1520,7 @@ extra_ldflags = ["-mmacosx-version-min={mac_min_version}"]
             colored_print(f"Warning: Failed to download GN: {e}", Colors.WARNING)
 
     def generate_gn_args_summary(self, arch: str):
-        if self.variant == "cpu":
+        if self.is_cpu_variant():
             gn_args = BASIC_GN_ARGS + PLATFORM_GN_ARGS_CPU[self.platform] + CPU_ONLY_GN_ARGS
         else:
             gn_args = BASIC_GN_ARGS + PLATFORM_GN_ARGS[self.platform]
@@ -1280,6 +1531,10 @@ extra_ldflags = ["-mmacosx-version-min={mac_min_version}"]
         target_cpu = "{arch}"
         variant = "{self.variant}"
         """
+        if self.variant == "gpu-pgo":
+            gn_args += f"""pgo_profile = "{self.pgo_profile}"
+        thin_lto = true
+        """
         return gn_args.strip()
 
     def write_gn_args_summary(self):
@@ -1295,7 +1550,23 @@ extra_ldflags = ["-mmacosx-version-min={mac_min_version}"]
             f.write(f"Skia Build Summary for {self.platform} ({self.variant})\n")
             f.write(f"Configuration: {self.config}\n")
             f.write(f"Variant: {self.variant}\n")
-            f.write(f"Architectures: {', '.join(self.archs)}\n\n")
+            f.write(f"Architectures: {', '.join(self.archs)}\n")
+            if self.split_libs:
+                f.write("Linking: per-module archives with function/data sections; link with "
+                        "--gc-sections (-dead_strip on Apple, /OPT:REF on Windows)\n")
+            if self.icu_data != "common":
+                f.write(f"ICU data: {self.icu_data} subset (share/icudtl.dat)\n")
+            if self.variant == "simd-mt":
+                f.write("Linking: wasm SIMD128 + shared-memory threads; link with -pthread and serve "
+                        "with COOP/COEP headers (make serve-wasm WASM_VARIANT=simd-mt)\n")
+            if self.variant == "traced":
+                backends = "JSON and Tracy" if self.tracy_dir else "JSON"
+                f.write(f"Tracing: trace events compiled in; trace_shim library ({backends}) next to "
+                        "the Skia libraries, headers in include/trace_shim\n")
+            if self.variant == "gpu-pgo":
+                f.write("Linking: ThinLTO bitcode archives; link with clang and an LTO-capable linker "
+                        "(lld or ld64) from the same LLVM release that built them\n")
+            f.write("\n")
             f.write("GN Arguments:\n")
             for arch in self.archs:
                 f.write(f"\nFor {arch}:\n")
@@ -1303,6 +1574,123 @@ extra_ldflags = ["-mmacosx-version-min={mac_min_version}"]
                 f.write("\n")
         colored_print(f"GN args summary written to {summary_file}", Colors.OKGREEN)
 
+    def build_trace_shim(self):
+        """-variant traced: build third_party/trace-shim against the packaged Skia and
+        Dawn headers and install it next to the Skia libraries."""
+        include_dir = BASE_DIR / "include"
+        dawn_include_dirs = [include_dir / "third_party" / "externals" / "dawn" / "include",
+                             include_dir]  # generated dawn/webgpu.h
+        lib_dir = self.get_lib_dir(self.platform)
+        lib_name = "trace_shim.lib" if self.platform == "win" else "libtrace_shim.a"
+
+        if self.platform == "mac":
+            # One (fat) build per lib directory, like move_libs/create_universal_binary
+            universal = self.archs == ["x86_64", "arm64"]
+            builds = [(";".join(self.archs), lib_dir / self.config)] if universal else \
+                     [(arch, lib_dir / self.config / arch) for arch in self.archs]
+        else:
+            builds = [(arch, lib_dir / self.config / arch) for arch in self.archs]
+
+        for arch, dest_dir in builds:
+            build_dir = TMP_DIR / f"trace_shim_{self.platform}_{self.config}_{arch.replace(';', '_')}"
+            colored_print(f"Building trace shim for {self.platform} {arch}...", Colors.OKBLUE)
+            cmake_command = [
+                "cmake", "-S", str(TRACE_SHIM_DIR), "-B", str(build_dir),
+                f"-DSKIA_INCLUDE_DIR={include_dir}",
+                f"-DDAWN_INCLUDE_DIR={';'.join(str(d) for d in dawn_include_dirs)}",
+            ]
+            if self.tracy_dir:
+                cmake_command.append(f"-DTRACY_DIR={self.tracy_dir}")
+            if self.platform == "mac":
+                cmake_command += [f"-DCMAKE_OSX_ARCHITECTURES={arch}",
+                                  f"-DCMAKE_OSX_DEPLOYMENT_TARGET={MAC_MIN_VERSION}"]
+            elif self.platform == "win":
+                cmake_command += ["-A", {"x64": "x64", "arm64": "ARM64", "Win32": "Win32"}[arch]]
+                if self.crt == "dynamic":
+                    cmake_command.append("-DTRACE_SHIM_DYNAMIC_CRT=ON")
+            else:
+                cmake_command += ["-G", "Ninja", f"-DCMAKE_BUILD_TYPE={self.config}",
+                                  "-DCMAKE_C_COMPILER=clang", "-DCMAKE_CXX_COMPILER=clang++"]
+            subprocess.run(cmake_command, check=True)
+            subprocess.run(["cmake", "--build", str(build_dir), "--config", self.config], check=True)
+
+            built = next(build_dir.rglob(lib_name), None)
+            if built is None:
+                colored_print(f"Error: {lib_name} not found in {build_dir}", Colors.FAIL)
+                sys.exit(1)
+            dest_dir.mkdir(parents=True, exist_ok=True)
+            shutil.copy2(built, dest_dir / lib_name)
+            colored_print(f"Copied {lib_name} to {dest_dir}", Colors.OKGREEN)
+
+        dest_include = include_dir / "trace_shim"
+        dest_include.mkdir(parents=True, exist_ok=True)
+        for header in (TRACE_SHIM_DIR / "include").glob("*.h"):
+            shutil.copy2(header, dest_include / header.name)
+
+    def link_example(self, build_dir, lib_dir, dead_strip):
+        """Configure and build example/ (target example) against lib_dir, then delete
+        the binary and time the relink on its own. Returns (seconds, size, stripped size)."""
+        shutil.rmtree(build_dir, ignore_errors=True)
+        cmake_command = [
+            "cmake", "-S", str(EXAMPLE_DIR), "-B", str(build_dir), "-G", "Ninja",
+            f"-DCMAKE_BUILD_TYPE={self.config}",
+            "-DCMAKE_C_COMPILER=clang", "-DCMAKE_CXX_COMPILER=clang++",
+            f"-DSKIA_VARIANT={self.variant}",
+            f"-DSKIA_LIB_DIR={lib_dir}",
+            f"-DSKIA_DEAD_STRIP={'ON' if dead_strip else 'OFF'}",
+        ]
+        if self.variant == "gpu-pgo" and self.platform != "mac":
+            cmake_command.append("-DCMAKE_EXE_LINKER_FLAGS=-fuse-ld=lld")
+        subprocess.run(cmake_command, check=True)
+
+        build_command = ["cmake", "--build", str(build_dir), "--target", "example"]
+        subprocess.run(build_command, check=True)
+        binary = build_dir / "example"
+        binary.unlink()
+        start = time.perf_counter()
+        subprocess.run(build_command, check=True)
+        seconds = time.perf_counter() - start
+
+        stripped = build_dir / "example.stripped"
+        shutil.copy2(binary, stripped)
+        subprocess.run(["strip", str(stripped)], check=True)
+        return seconds, binary.stat().st_size, stripped.stat().st_size
+
+    def write_link_report(self):
+        """--link-report: archive sizes, plus the example's relink time and binary
+        size with and without dead stripping, in <lib dir>/link_report.txt. Compare
+        reports from builds with and without --split-libs for the effect of sections."""
+        base_lib_dir = self.get_lib_dir(self.platform)
+        if self.platform == "mac" and self.archs == ["x86_64", "arm64"]:
+            lib_dir = base_lib_dir / self.config
+        else:
+            lib_dir = base_lib_dir / self.config / self.get_host_arch()
+
+        lines = [f"Link report for {self.platform} {self.get_host_arch()} ({self.variant}, "
+                 f"split libs: {'yes' if self.split_libs else 'no'})", "", "Archives:"]
+        total = 0
+        for lib in LIBS[self.platform] + GPU_LIBS.get(self.platform, []):
+            path = lib_dir / lib
+            if path.exists():
+                size = path.stat().st_size
+                total += size
+                lines.append(f"  {lib:<32} {size / 1e6:8.1f} MB")
+        lines.append(f"  {'total':<32} {total / 1e6:8.1f} MB")
+        lines += ["", f"example:    {'relink':>9} {'binary':>10} {'stripped':>10}"]
+
+        for dead_strip in (False, True):
+            mode = "dead-strip" if dead_strip else "default"
+            colored_print(f"Link report: linking example ({mode})...", Colors.OKBLUE)
+            build_dir = TMP_DIR / f"link_report_{self.platform}_{self.variant}_{mode}"
+            seconds, size, stripped = self.link_example(build_dir, lib_dir, dead_strip)
+            lines.append(f"{mode:<11} {seconds:8.2f}s {size / 1e6:7.2f} MB {stripped / 1e6:7.2f} MB")
+
+        report = "\n".join(lines) + "\n"
+        report_file = base_lib_dir / "link_report.txt"
+        report_file.write_text(report)
+        print(report)
+        colored_print(f"Link report written to {report_file}", Colors.OKGREEN)
+
     def modify_deps(self):
         deps_path = SKIA_SRC_DIR / "DEPS"
         if not deps_path.exists():
@@ -1379,31 +1767,149 @@ extra_ldflags = ["-mmacosx-version-min={mac_min_version}"]
             except subprocess.CalledProcessError as e:
                 colored_print(f"  Warning: Failed to apply {patch_file.name}: {e}", Colors.WARNING)
 
+    def find_llvm_profdata(self):
+        if self.platform == "mac":
+            result = subprocess.run(["xcrun", "--find", "llvm-profdata"], capture_output=True, text=True)
+            if result.returncode == 0:
+                return result.stdout.strip()
+        profdata = shutil.which("llvm-profdata")
+        if not profdata:
+            colored_print("Error: llvm-profdata not found (install the LLVM tools matching clang)", Colors.FAIL)
+            sys.exit(1)
+        return profdata
+
+    def train_pgo_profile(self):
+        """Build instrumented Skia for the host arch, run PGO_TRAINING_RUNS against it
+        and merge the raw profiles. Returns the path of the merged .profdata."""
+        host_arch = self.get_host_arch()
+        profile_dir = PGO_DIR / self.platform
+        train_lib_dir = profile_dir / "lib"
+        raw_dir = profile_dir / "profraw"
+        tools_dir = profile_dir / "example"
+        shutil.rmtree(train_lib_dir, ignore_errors=True)
+        shutil.rmtree(raw_dir, ignore_errors=True)
+        raw_dir.mkdir(parents=True)
+
+        colored_print(f"PGO: building instrumented Skia for {self.platform} {host_arch}...", Colors.OKBLUE)
+        self.pgo_phase = "instrument"
+        self.generate_gn_args(host_arch)
+        self.build_skia(host_arch)
+        self.move_libs(host_arch, train_lib_dir)
+
+        # The training tools compile against the packaged and generated Dawn headers
+        self.package_headers(BASE_DIR / "include")
+        self.package_generated_dawn_headers(self.get_build_dir(host_arch), BASE_DIR / "include")
+        self.pgo_phase = None
+
+        colored_print("PGO: building training tools...", Colors.OKBLUE)
+        subprocess.run([
+            "cmake", "-S", str(EXAMPLE_DIR), "-B", str(tools_dir), "-G", "Ninja",
+            "-DCMAKE_BUILD_TYPE=Release",
+            "-DCMAKE_C_COMPILER=clang", "-DCMAKE_CXX_COMPILER=clang++",
+            "-DCMAKE_EXE_LINKER_FLAGS=-fprofile-instr-generate",
+            "-DUSE_NATIVE_GRAPHITE=ON",
+            f"-DSKIA_LIB_DIR={train_lib_dir}",
+        ], check=True)
+        subprocess.run(["cmake", "--build", str(tools_dir), "--target", "graphite-bench", "batch-render"],
+                       check=True)
+
+        # %p keeps concurrent processes apart, %m keeps profiles from differently built binaries apart
+        env = dict(os.environ, LLVM_PROFILE_FILE=str(raw_dir / "%p-%m.profraw"))
+        for training_run in PGO_TRAINING_RUNS:
+            command = [str(tools_dir / training_run[0])] + training_run[1:]
+            colored_print(f"PGO: training with {' '.join(training_run)}", Colors.OKBLUE)
+            result = subprocess.run(command, cwd=str(profile_dir), env=env)
+            if result.returncode != 0:
+                # No usable GPU adapter on this machine: the raster runs still train the CPU paths
+                colored_print(f"Warning: training run failed with exit code {result.returncode}: "
+                              f"{' '.join(training_run)}", Colors.WARNING)
+
+        raw_profiles = sorted(raw_dir.glob("*.profraw"))
+        if not raw_profiles:
+            colored_print("Error: PGO training produced no profiles", Colors.FAIL)
+            sys.exit(1)
+        profile = profile_dir / "skia.profdata"
+        subprocess.run([self.find_llvm_profdata(), "merge", "-o", str(profile)] +
+                       [str(raw) for raw in raw_profiles], check=True)
+        colored_print(f"PGO: merged {len(raw_profiles)} raw profiles into {profile}", Colors.OKGREEN)
+        return profile
+
+    def build_pgo(self):
+        """gpu-pgo: train a profile (unless -profile was given), then build every arch
+        with it as ThinLTO bitcode. Other archs than the host reuse the host profile;
+        functions whose IR differs (per-CPU SIMD paths) are built without profile data."""
+        if not self.pgo_profile:
+            self.pgo_profile = self.train_pgo_profile()
+        colored_print(f"PGO: building with profile {self.pgo_profile}", Colors.OKBLUE)
+        self.pgo_phase = "use"
+        self.build_archs(self.archs)
+
+    def build_archs(self, archs):
+        """generate_gn_args -> build_skia -> move_libs for each arch. With
+        --parallel-archs the ninja builds run concurrently and split -jobs."""
+        for arch in archs:
+            self.generate_gn_args(arch)
+        if self.parallel_archs and len(archs) > 1:
+            from concurrent.futures import ThreadPoolExecutor
+            jobs = max(1, self.jobs // len(archs)) if self.jobs else None
+            with ThreadPoolExecutor(max_workers=len(archs)) as pool:
+                builds = [pool.submit(self.build_skia, arch, jobs) for arch in archs]
+                for build in builds:
+                    build.result()
+        else:
+            for arch in archs:
+                self.build_skia(arch)
+        for arch in archs:
+            self.move_libs(arch)
+
     def run(self):
         self.parse_arguments()
+
+        if "universal" in self.archs or self.xcframework:
+            self.archs = ["x86_64", "arm64"]
+
+        if self.print_gn_args:
+            for arch in self.archs:
+                print(f"# {self.platform} {arch} ({self.variant})")
+                print(self.compose_gn_args(arch))
+            return
+
         self.setup_depot_tools()
-        self.setup_skia_repo()
-        self.setup_gn_for_windows_arm64()
+        if self.no_sync:
+            os.chdir(SKIA_SRC_DIR)
+        else:
+            self.setup_skia_repo()
+            self.setup_gn_for_windows_arm64()
 
-        # if self.config == "Release":
-        #     self.modify_deps()
+            # if self.config == "Release":
+            #     self.modify_deps()
 
-        # self.patch_activate_emsdk()
+            # self.patch_activate_emsdk()
 
-        self.sync_deps()
-        self.apply_patches()
+            self.sync_deps()
+            self.apply_patches()
 
-        if "universal" in self.archs or self.xcframework:
-            self.archs = ["x86_64", "arm64"]
+        if self.sync_only:
+            colored_print("Skia checkout, deps and patches are ready.", Colors.OKGREEN)
+            return
 
-        for arch in self.archs:
-            self.generate_gn_args(arch)
-            self.build_skia(arch)
-            self.move_libs(arch)
+        if self.variant == "gpu-pgo":
+            self.build_pgo()
+        else:
+            self.build_archs(self.archs)
 
         if self.platform == "mac" and self.archs == ["x86_64", "arm64"]:
             self.create_universal_binary()
 
+        # One bitcode archive per arch, so the consumer's LTO link sees all of Skia at once
+        # (--split-libs keeps the per-module archives instead)
+        if self.variant == "gpu-pgo" and not self.split_libs:
+            if self.platform == "mac" and self.archs == ["x86_64", "arm64"]:
+                self.combine_libraries("mac", "universal")
+            else:
+                for arch in self.archs:
+                    self.combine_libraries(self.platform, arch)
+
         if self.xcframework:
             # Build for macOS
             self.combine_libraries("mac", "universal")
@@ -1425,13 +1931,18 @@ extra_ldflags = ["-mmacosx-version-min={mac_min_version}"]
             self.package_icu_data(BASE_DIR / "share")
 
         # Copy generated Dawn headers (for Graphite WebGPU backend)
-        if self.variant == "gpu":
+        if self.is_gpu_variant():
             # Use the first arch's build dir for generated headers (they're the same across archs)
             first_arch = self.archs[0]
-            build_dir = TMP_DIR / f"{self.platform}_{self.config}_{first_arch}_{self.variant}"
+            build_dir = self.get_build_dir(first_arch)
             self.package_generated_dawn_headers(build_dir, BASE_DIR / "include")
 
+        if self.variant == "traced":
+            self.build_trace_shim()
+
         self.write_gn_args_summary()
+        if self.link_report:
+            self.write_link_report()
 
         colored_print(f"Build completed successfully for {self.platform} {self.config} configuration with architectures: {', '.join(self.archs)}", Colors.OKGREEN)
         if hasattr(self, 'create_zip_all') and self.create_zip_all:
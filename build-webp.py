@@ -18,6 +18,8 @@ For detailed usage instructions, run:
 
 import argparse
 import os
+import platform
+import re
 import shutil
 import subprocess
 import sys
@@ -42,6 +44,7 @@ BASE_DIR = Path(__file__).resolve().parent / "build"
 WEBP_GIT_URL = "https://chromium.googlesource.com/webm/libwebp.git"
 WEBP_SRC_DIR = BASE_DIR / "src" / "libwebp"
 TMP_DIR = BASE_DIR / "tmp" / "webp"
+BENCH_SOURCE = Path(__file__).resolve().parent / "tests" / "bench_webp.c"
 
 # Platform-specific constants
 MAC_MIN_VERSION = "10.15"
@@ -66,6 +69,42 @@ HEADER_DIRS = [
     "sharpyuv",
 ]
 
+# SIMD paths libwebp should compile per architecture (WEBP_HAVE_<name> in the
+# generated config.h). x86 paths beyond SSE2 are selected at runtime by cpuid, so
+# they are always compiled; wasm gets SIMD128 through Emscripten's SSE2 intrinsics.
+EXPECTED_SIMD = {
+    "x86_64": ["SSE2", "SSE41", "AVX2"],
+    "x64": ["SSE2", "SSE41", "AVX2"],
+    "x86": ["SSE2", "SSE41", "AVX2"],
+    "arm64": ["NEON"],
+    "arm": ["NEON"],
+    "wasm32": ["SSE2"],
+}
+
+# bench_webp is built next to the libs where a plain executable makes sense
+# (iOS/visionOS need an app bundle; bench_common.h needs POSIX headers)
+BENCH_PLATFORMS = ["mac", "linux", "android", "wasm"]
+
+BENCH_CMAKE = """cmake_minimum_required(VERSION 3.16)
+project(bench_webp C)
+
+set(CMAKE_C_STANDARD 11)
+add_executable(bench_webp ${BENCH_SOURCE})
+target_compile_definitions(bench_webp PRIVATE BENCH_WEBP_SIMD="${BENCH_WEBP_SIMD}")
+target_link_libraries(bench_webp PRIVATE ${WEBP_LIB_DIR}/libwebp.a ${WEBP_LIB_DIR}/libsharpyuv.a m)
+if(BENCH_WEBP_THREADS)
+  find_package(Threads REQUIRED)
+  target_link_libraries(bench_webp PRIVATE Threads::Threads)
+endif()
+if(EMSCRIPTEN)
+  set_target_properties(bench_webp PROPERTIES SUFFIX ".js")
+  target_link_options(bench_webp PRIVATE -sALLOW_MEMORY_GROWTH=1)
+  if(BENCH_WEBP_THREADS)
+    target_link_options(bench_webp PRIVATE -sPTHREAD_POOL_SIZE=4)
+  endif()
+endif()
+"""
+
 
 class WebPBuildScript:
     def __init__(self):
@@ -77,6 +116,10 @@ class WebPBuildScript:
         self.crt = "static"
         self.ndk_path = None
         self.shallow_clone = False
+        self.simd = True
+        self.threads = True
+        self.bench = True
+        self.simd_compiled = {}
 
     def parse_arguments(self):
         parser = argparse.ArgumentParser(description="Build libwebp for multiple platforms")
@@ -91,6 +134,14 @@ class WebPBuildScript:
                            help="Windows CRT linkage: static (/MT) or dynamic (/MD)")
         parser.add_argument("-ndk", help="Path to Android NDK")
         parser.add_argument("--shallow", action="store_true", help="Perform a shallow clone")
+        parser.add_argument("-simd", choices=["on", "off"], default="on",
+                           help="Compile the SIMD paths (SSE2/SSE4.1/AVX2 on x86, NEON on ARM, "
+                                "SIMD128 on wasm) and fail if they are missing")
+        parser.add_argument("-threads", choices=["on", "off"],
+                           help="Multithreaded encode/decode (WEBP_USE_THREAD); default on, off for wasm "
+                                "(wasm threads need a cross-origin isolated page)")
+        parser.add_argument("--no-bench", action="store_true",
+                           help="Skip building and running bench_webp")
         args = parser.parse_args()
 
         self.platform = args.platform
@@ -100,6 +151,12 @@ class WebPBuildScript:
         self.crt = args.crt
         self.ndk_path = args.ndk or os.environ.get("ANDROID_NDK_HOME") or os.environ.get("ANDROID_NDK_ROOT")
         self.shallow_clone = args.shallow
+        self.simd = args.simd == "on"
+        if args.threads:
+            self.threads = args.threads == "on"
+        else:
+            self.threads = self.platform != "wasm"
+        self.bench = not args.no_bench
 
         if args.archs:
             self.archs = args.archs.split(',')
@@ -139,6 +196,20 @@ class WebPBuildScript:
         crt_suffix = "-md" if self.platform == "win" and self.crt == "dynamic" else ""
         return BASE_DIR / f"webp-{self.platform}{crt_suffix}" / "lib"
 
+    def get_build_dir(self, arch):
+        return TMP_DIR / f"{self.platform}_{self.config}_{arch}"
+
+    def get_arch_lib_dir(self, arch):
+        """Output directory for one architecture's libraries."""
+        lib_dir = self.get_lib_dir()
+        if self.platform in ["ios", "visionos"]:
+            is_simulator = (arch == "x86_64") or (self.target == "simulator")
+            target_prefix = "simulator" if is_simulator else "device"
+            return lib_dir / self.config / f"{target_prefix}-{arch}"
+        if self.platform == "mac" and arch == "universal":
+            return lib_dir / self.config
+        return lib_dir / self.config / arch
+
     def setup_repo(self):
         colored_print(f"Setting up libwebp repository (branch: {self.branch})...", Colors.OKBLUE)
         if not WEBP_SRC_DIR.exists():
@@ -172,6 +243,8 @@ class WebPBuildScript:
             "-DWEBP_BUILD_WEBPMUX=OFF",
             "-DWEBP_BUILD_EXTRAS=OFF",
             "-DBUILD_SHARED_LIBS=OFF",
+            f"-DWEBP_ENABLE_SIMD={'ON' if self.simd else 'OFF'}",
+            f"-DWEBP_USE_THREAD={'ON' if self.threads else 'OFF'}",
         ]
 
         if self.platform == "mac":
@@ -251,12 +324,21 @@ class WebPBuildScript:
                 "-G", "Ninja",
                 "-DCMAKE_SYSTEM_NAME=Emscripten",
             ])
+            # libwebp's SSE2 paths compile to wasm SIMD128 through Emscripten's
+            # intrinsics headers; pthreads must match between the libs and the app
+            wasm_flags = []
+            if self.simd:
+                wasm_flags.append("-msimd128")
+            if self.threads:
+                wasm_flags.append("-pthread")
+            if wasm_flags:
+                args.append(f"-DCMAKE_C_FLAGS={' '.join(wasm_flags)}")
 
         return args
 
     def build(self, arch):
         """Build libwebp for a specific architecture."""
-        build_dir = TMP_DIR / f"{self.platform}_{self.config}_{arch}"
+        build_dir = self.get_build_dir(arch)
         build_dir.mkdir(parents=True, exist_ok=True)
 
         colored_print(f"Building libwebp for {self.platform} {arch}...", Colors.OKBLUE)
@@ -266,6 +348,7 @@ class WebPBuildScript:
 
         colored_print(f"CMake command: {' '.join(cmake_cmd)}", Colors.OKCYAN)
         subprocess.run(cmake_cmd, check=True)
+        self.verify_simd(arch)
 
         # Build
         build_cmd = ["cmake", "--build", str(build_dir), "--config", self.config, "-j"]
@@ -273,20 +356,109 @@ class WebPBuildScript:
 
         colored_print(f"Successfully built libwebp for {self.platform} {arch}", Colors.OKGREEN)
 
-    def move_libs(self, arch):
-        """Move built libraries to output directory."""
-        build_dir = TMP_DIR / f"{self.platform}_{self.config}_{arch}"
-        lib_dir = self.get_lib_dir()
+    def verify_simd(self, arch):
+        """Check the configured config.h enables the SIMD paths expected for arch.
+
+        libwebp probes compiler support at configure time and silently drops any
+        path the toolchain cannot build, so a missing flag would otherwise only
+        show up as slower encodes.
+        """
+        build_dir = self.get_build_dir(arch)
+        config_h = build_dir / "src" / "webp" / "config.h"
+        if not config_h.exists():
+            config_h = next(build_dir.rglob("config.h"), None)
+        if config_h is None:
+            colored_print(f"Error: config.h not found in {build_dir}", Colors.FAIL)
+            sys.exit(1)
+
+        defined = set(re.findall(r"^#define WEBP_HAVE_(\w+)", config_h.read_text(), re.MULTILINE))
+        self.simd_compiled[arch] = [f for f in EXPECTED_SIMD[arch] if f in defined]
+        if not self.simd:
+            return
+
+        # Only require the paths this libwebp revision knows about (AVX2 is recent)
+        template_path = WEBP_SRC_DIR / "cmake" / "config.h.in"
+        template = template_path.read_text() if template_path.exists() else None
+        missing = []
+        for feature in EXPECTED_SIMD[arch]:
+            if feature in defined:
+                continue
+            if template is None or f"WEBP_HAVE_{feature}" in template:
+                missing.append(feature)
+            else:
+                colored_print(f"Note: this libwebp revision has no {feature} paths", Colors.WARNING)
+        if missing:
+            colored_print(f"Error: SIMD paths not compiled for {self.platform} {arch}: {', '.join(missing)} "
+                          f"(see {config_h})", Colors.FAIL)
+            sys.exit(1)
+        colored_print(f"SIMD paths for {arch}: {', '.join(self.simd_compiled[arch]) or 'none'}", Colors.OKGREEN)
+
+    def write_build_config(self):
+        """Record the SIMD paths and threading each arch was built with."""
+        config_file = self.get_lib_dir() / self.config / "build_config.txt"
+        config_file.parent.mkdir(parents=True, exist_ok=True)
+        with open(config_file, "w") as f:
+            f.write(f"simd={'on' if self.simd else 'off'}\n")
+            f.write(f"threads={'on' if self.threads else 'off'}\n")
+            for arch, features in self.simd_compiled.items():
+                f.write(f"simd_compiled.{arch}={','.join(features) or 'none'}\n")
+
+    def can_run_on_host(self, arch):
+        if self.platform == "wasm":
+            return shutil.which("node") is not None
+        machine = platform.machine().lower()
+        if self.platform == "linux":
+            host_arch = {"x86_64": "x64", "amd64": "x64", "aarch64": "arm64"}.get(machine, machine)
+            return sys.platform.startswith("linux") and arch == host_arch
+        if self.platform == "mac":
+            return sys.platform == "darwin" and arch == machine
+        return False
+
+    def build_and_run_bench(self, arch, universal):
+        """Build bench_webp against the packaged libs and run it when the host can."""
+        lib_dir = self.get_arch_lib_dir("universal" if universal else arch)
+        bench_dir = TMP_DIR / "bench" / f"{self.platform}_{self.config}_{arch}"
+        bench_dir.mkdir(parents=True, exist_ok=True)
+        (bench_dir / "CMakeLists.txt").write_text(BENCH_CMAKE)
+
+        colored_print(f"Building bench_webp for {self.platform} {arch}...", Colors.OKBLUE)
+        features = ",".join(self.simd_compiled.get(arch, [])) or "none"
+        build_dir = bench_dir / "build"
+        cmake_cmd = ["cmake", "-S", str(bench_dir), "-B", str(build_dir), "--no-warn-unused-cli"]
+        cmake_cmd += self.get_cmake_args(arch)
+        cmake_cmd += [
+            f"-DBENCH_SOURCE={BENCH_SOURCE}",
+            f"-DWEBP_LIB_DIR={lib_dir}",
+            f"-DBENCH_WEBP_SIMD={features}",
+            f"-DBENCH_WEBP_THREADS={'ON' if self.threads else 'OFF'}",
+        ]
+        subprocess.run(cmake_cmd, check=True)
+        subprocess.run(["cmake", "--build", str(build_dir), "--config", self.config], check=True)
 
-        if self.platform in ["ios", "visionos"]:
-            is_simulator = (arch == "x86_64") or (self.target == "simulator")
-            target_prefix = "simulator" if is_simulator else "device"
-            dest_dir = lib_dir / self.config / f"{target_prefix}-{arch}"
-        elif self.platform == "mac" and arch == "universal":
-            dest_dir = lib_dir / self.config
-        else:
-            dest_dir = lib_dir / self.config / arch
+        binary = build_dir / ("bench_webp.js" if self.platform == "wasm" else "bench_webp")
+        dest_dir = self.get_lib_dir().parent / "bench" / arch
+        dest_dir.mkdir(parents=True, exist_ok=True)
+        for artifact in build_dir.glob("bench_webp*"):
+            if artifact.is_file():
+                shutil.copy2(str(artifact), str(dest_dir / artifact.name))
+
+        if not self.can_run_on_host(arch):
+            colored_print(f"bench_webp for {arch} copied to {dest_dir} (not runnable on this host)", Colors.OKCYAN)
+            return
+
+        # The report goes to stdout so wasm needs no filesystem access
+        cmd = ["node", str(binary)] if self.platform == "wasm" else [str(binary)]
+        cmd += ["--threads", "1" if self.threads else "0"]
+        report = self.get_lib_dir().parent / f"bench_webp-{arch}.json"
+        colored_print(f"Running bench_webp: {' '.join(cmd)}", Colors.OKCYAN)
+        with open(report, "w") as f:
+            subprocess.run(cmd, stdout=f, check=True)
+        colored_print(f"Benchmark report: {report}", Colors.OKGREEN)
 
+    def move_libs(self, arch):
+        """Move built libraries to output directory."""
+        build_dir = self.get_build_dir(arch)
+        dest_dir = self.get_arch_lib_dir(arch)
         dest_dir.mkdir(parents=True, exist_ok=True)
 
         # Find and copy libraries
@@ -393,6 +565,12 @@ class WebPBuildScript:
             self.create_universal_binary()
 
         self.package_headers()
+        self.write_build_config()
+
+        # bench_webp includes the packaged headers, so it builds after them
+        if self.bench and self.platform in BENCH_PLATFORMS:
+            for arch in self.archs:
+                self.build_and_run_bench(arch, build_universal)
 
         colored_print(f"Build completed for {self.platform} {self.config}", Colors.OKGREEN)
 
@@ -0,0 +1,47 @@
+/**
+ * Timing and reporting helpers shared by the examples and offscreen benchmarks
+ *
+ * Header-only so the CPU, WebAssembly and Graphite builds can all use it without
+ * another source file in their targets.
+ */
+
+#ifndef BENCH_UTIL_H
+#define BENCH_UTIL_H
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+/** Milliseconds elapsed since `t` on the steady clock. */
+inline double msSince(std::chrono::steady_clock::time_point t) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t).count();
+}
+
+/** Nearest-rank percentile (p in [0, 1]) of non-empty, ascending `sorted`. */
+inline double nearestRank(const std::vector<double>& sorted, double p) {
+    size_t index = static_cast<size_t>(std::ceil(p * sorted.size()));
+    return sorted[std::min(std::max<size_t>(index, 1), sorted.size()) - 1];
+}
+
+/** `value` as a quoted JSON string; minimal escaping for adapter names and paths. */
+inline std::string jsonString(const std::string& value) {
+    std::string out = "\"";
+    for (char c : value) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char escaped[8];
+            snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            out += escaped;
+        } else {
+            out += c;
+        }
+    }
+    return out + "\"";
+}
+
+#endif // BENCH_UTIL_H
@@ -0,0 +1,304 @@
+/**
+ * Headless Skia Graphite benchmark
+ *
+ * Renders the example scene into an offscreen Graphite SkSurface for a fixed
+ * number of frames, with no window, swapchain or vsync, and reports per-frame
+ * CPU record time, CPU submit time and GPU time as p50/p95/p99. GPU time comes
+ * from Graphite's per-Recording elapsed-time stats, which the Dawn backend
+ * implements with timestamp queries (requires the TimestampQuery feature).
+ *
+ * Build with: cmake -DUSE_NATIVE_GRAPHITE=ON (target: graphite-bench)
+ *
+ * Usage: graphite-bench [--frames=N] [--warmup=N] [--size=WxH]
+ *                       [--scene=immediate|retained] [--json=FILE]
+ *
+ *   --frames=N     Measured frames (default 500)
+ *   --warmup=N     Unmeasured frames rendered first to fill atlases and
+ *                  pipeline caches (default 20)
+ *   --size=WxH     Offscreen surface size (default 800x600)
+ *   --scene=MODE   Scene variant, see scene.h (default immediate)
+ *   --json=FILE    Where to write results (default graphite-bench.json)
+ *
+ * The scene clock advances by a fixed 16 ms per frame so every run draws the same
+ * sequence of frames and results are comparable across Skia builds.
+ */
+
+#include "bench_util.h"
+#include "headless_graphite.h"
+#include "scene.h"
+
+#include "include/core/SkCanvas.h"
+#include "include/core/SkSurface.h"
+#include "include/gpu/graphite/GraphiteTypes.h"
+#include "include/gpu/graphite/Recording.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Skia revision the libraries were built from (set by CMake)
+#ifndef EXAMPLE_SKIA_REVISION
+#define EXAMPLE_SKIA_REVISION "unknown"
+#endif
+
+// Recordings the GPU may have outstanding before the CPU waits
+static const int kMaxFramesInFlight = 3;
+
+static int g_frames = 500;
+static int g_warmupFrames = 20;
+static int g_width = 800;
+static int g_height = 600;
+static bool g_useRetainedScene = false;
+static std::string g_jsonPath = "graphite-bench.json";
+
+// Per-frame timings; gpuMs stays negative when no GPU time was reported
+struct FrameTimes {
+    std::vector<double> recordMs;
+    std::vector<double> submitMs;
+    std::vector<double> gpuMs;
+};
+
+// Summary of one series of per-frame times
+struct Percentiles {
+    double mean = 0.0;
+    double p50 = 0.0;
+    double p95 = 0.0;
+    double p99 = 0.0;
+    double max = 0.0;
+    size_t count = 0;
+};
+
+// Nearest-rank percentiles over the non-negative samples in `values`
+static Percentiles computePercentiles(const std::vector<double>& values) {
+    std::vector<double> sorted;
+    sorted.reserve(values.size());
+    for (double value : values) {
+        if (value >= 0.0) {
+            sorted.push_back(value);
+        }
+    }
+
+    Percentiles result;
+    result.count = sorted.size();
+    if (sorted.empty()) {
+        return result;
+    }
+    std::sort(sorted.begin(), sorted.end());
+
+    double sum = 0.0;
+    for (double value : sorted) {
+        sum += value;
+    }
+    result.mean = sum / sorted.size();
+    result.p50 = nearestRank(sorted, 0.50);
+    result.p95 = nearestRank(sorted, 0.95);
+    result.p99 = nearestRank(sorted, 0.99);
+    result.max = sorted.back();
+    return result;
+}
+
+// Graphite reports elapsed GPU time (ns) when the Recording's work completes
+static void gpuFinishedProc(skgpu::graphite::GpuFinishedContext context,
+                            skgpu::CallbackResult result,
+                            const skgpu::graphite::GpuStats& stats) {
+    double* gpuMs = static_cast<double*>(context);
+    if (gpuMs && result == skgpu::CallbackResult::kSuccess && stats.elapsedTime > 0) {
+        *gpuMs = stats.elapsedTime / 1.0e6;
+    }
+}
+
+// Render one frame. When `times` is non-null the frame's timings are stored at `index`.
+static bool renderFrame(HeadlessGraphite* graphite, SkSurface* surface, const RetainedScene* retained,
+                        float time, FrameTimes* times, size_t index) {
+    skgpu::graphite::Context* context = graphite->context();
+
+    // Bound the number of outstanding frames so GPU time is not hidden by queueing
+    graphite->waitForFrameSlot(kMaxFramesInFlight);
+
+    auto recordStart = std::chrono::steady_clock::now();
+    SceneParams params;
+    params.width = g_width;
+    params.height = g_height;
+    params.time = time;
+    params.backendLabel = "Backend: Offscreen";
+
+    SkCanvas* canvas = surface->getCanvas();
+    if (retained) {
+        retained->draw(canvas, params);
+    } else {
+        drawSceneImmediate(canvas, params);
+    }
+    std::unique_ptr<skgpu::graphite::Recording> recording = graphite->recorder()->snap();
+    double recordMs = msSince(recordStart);
+    if (!recording) {
+        fprintf(stderr, "Failed to snap recording\n");
+        return false;
+    }
+
+    auto submitStart = std::chrono::steady_clock::now();
+    skgpu::graphite::InsertRecordingInfo info;
+    info.fRecording = recording.get();
+    info.fFinishedWithStatsProc = gpuFinishedProc;
+    if (times && graphite->hasTimestamps()) {
+        info.fFinishedContext = &times->gpuMs[index];
+        info.fGpuStatsFlags = skgpu::graphite::GpuStatsFlags::kElapsedTime;
+    }
+    if (!context->insertRecording(info)) {
+        fprintf(stderr, "Failed to insert recording\n");
+        return false;
+    }
+    context->submit(skgpu::graphite::SyncToCpu::kNo);
+    double submitMs = msSince(submitStart);
+    graphite->frameSubmitted();
+
+    if (times) {
+        times->recordMs[index] = recordMs;
+        times->submitMs[index] = submitMs;
+    }
+    return true;
+}
+
+static void writePercentiles(FILE* f, const char* name, const Percentiles& p, bool last) {
+    if (p.count == 0) {
+        fprintf(f, "  \"%s\": null%s\n", name, last ? "" : ",");
+        return;
+    }
+    fprintf(f, "  \"%s\": {\"mean\": %.4f, \"p50\": %.4f, \"p95\": %.4f, \"p99\": %.4f, \"max\": %.4f, \"samples\": %zu}%s\n",
+            name, p.mean, p.p50, p.p95, p.p99, p.max, p.count, last ? "" : ",");
+}
+
+static bool writeJson(const std::string& path, const std::string& adapterName, const FrameTimes& times,
+                      double wallMs) {
+    FILE* f = fopen(path.c_str(), "w");
+    if (!f) {
+        fprintf(stderr, "Failed to open %s for writing\n", path.c_str());
+        return false;
+    }
+    fprintf(f, "{\n");
+    fprintf(f, "  \"skia_revision\": %s,\n", jsonString(EXAMPLE_SKIA_REVISION).c_str());
+    fprintf(f, "  \"adapter\": %s,\n", jsonString(adapterName).c_str());
+    fprintf(f, "  \"scene\": \"%s\",\n", g_useRetainedScene ? "retained" : "immediate");
+    fprintf(f, "  \"width\": %d,\n", g_width);
+    fprintf(f, "  \"height\": %d,\n", g_height);
+    fprintf(f, "  \"frames\": %d,\n", g_frames);
+    fprintf(f, "  \"warmup_frames\": %d,\n", g_warmupFrames);
+    fprintf(f, "  \"fps\": %.2f,\n", g_frames / (wallMs / 1000.0));
+    writePercentiles(f, "record_ms", computePercentiles(times.recordMs), false);
+    writePercentiles(f, "submit_ms", computePercentiles(times.submitMs), false);
+    writePercentiles(f, "gpu_ms", computePercentiles(times.gpuMs), true);
+    fprintf(f, "}\n");
+    fclose(f);
+    return true;
+}
+
+static void printPercentiles(const char* name, const Percentiles& p) {
+    if (p.count == 0) {
+        printf("  %-7s  n/a\n", name);
+        return;
+    }
+    printf("  %-7s  p50 %.3f ms  p95 %.3f ms  p99 %.3f ms  max %.3f ms\n", name, p.p50, p.p95, p.p99, p.max);
+}
+
+// Parse command line flags (see usage at the top of this file)
+static bool parseArgs(int argc, char** argv) {
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--frames=", 9) == 0) {
+            g_frames = atoi(argv[i] + 9);
+            if (g_frames < 1) {
+                fprintf(stderr, "--frames must be at least 1\n");
+                return false;
+            }
+        } else if (strncmp(argv[i], "--warmup=", 9) == 0) {
+            g_warmupFrames = std::max(0, atoi(argv[i] + 9));
+        } else if (strncmp(argv[i], "--size=", 7) == 0) {
+            if (sscanf(argv[i] + 7, "%dx%d", &g_width, &g_height) != 2 || g_width < 1 || g_height < 1) {
+                fprintf(stderr, "--size must look like 1920x1080\n");
+                return false;
+            }
+        } else if (strcmp(argv[i], "--scene=immediate") == 0) {
+            g_useRetainedScene = false;
+        } else if (strcmp(argv[i], "--scene=retained") == 0) {
+            g_useRetainedScene = true;
+        } else if (strncmp(argv[i], "--json=", 7) == 0) {
+            g_jsonPath = argv[i] + 7;
+        } else {
+            fprintf(stderr, "Unknown argument: %s\n", argv[i]);
+            fprintf(stderr, "Usage: %s [--frames=N] [--warmup=N] [--size=WxH]\n"
+                            "          [--scene=immediate|retained] [--json=FILE]\n", argv[0]);
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    printf("Skia Graphite Headless Benchmark\n");
+    printf("================================\n");
+
+    if (!parseArgs(argc, argv)) {
+        return 1;
+    }
+
+    HeadlessGraphite graphite;
+    HeadlessGraphite::Options options;
+    options.requestTimestamps = true;
+    if (!graphite.init(options)) {
+        return 1;
+    }
+    printf("Adapter: %s\n", graphite.adapterName().c_str());
+    printf("Skia revision: %s\n", EXAMPLE_SKIA_REVISION);
+
+    sk_sp<SkSurface> surface = graphite.makeSurface(g_width, g_height);
+    if (!surface) {
+        return 1;
+    }
+
+    std::unique_ptr<RetainedScene> retained;
+    if (g_useRetainedScene) {
+        retained = std::make_unique<RetainedScene>();
+    }
+
+    FrameTimes times;
+    times.recordMs.assign(g_frames, -1.0);
+    times.submitMs.assign(g_frames, -1.0);
+    times.gpuMs.assign(g_frames, -1.0);
+
+    float time = 0.0f;
+    for (int i = 0; i < g_warmupFrames; i++, time += 0.016f) {
+        if (!renderFrame(&graphite, surface.get(), retained.get(), time, nullptr, 0)) {
+            return 1;
+        }
+    }
+    graphite.context()->submit(skgpu::graphite::SyncToCpu::kYes);
+
+    printf("Rendering %d frames at %dx%d (%s scene)...\n", g_frames, g_width, g_height,
+           g_useRetainedScene ? "retained" : "immediate");
+    auto wallStart = std::chrono::steady_clock::now();
+    for (int i = 0; i < g_frames; i++, time += 0.016f) {
+        if (!renderFrame(&graphite, surface.get(), retained.get(), time, &times, i)) {
+            return 1;
+        }
+    }
+    graphite.context()->submit(skgpu::graphite::SyncToCpu::kYes);
+    double wallMs = msSince(wallStart);
+
+    printf("Results (%.1f fps):\n", g_frames / (wallMs / 1000.0));
+    printPercentiles("record", computePercentiles(times.recordMs));
+    printPercentiles("submit", computePercentiles(times.submitMs));
+    printPercentiles("gpu", computePercentiles(times.gpuMs));
+
+    if (!writeJson(g_jsonPath, graphite.adapterName(), times, wallMs)) {
+        return 1;
+    }
+    printf("Wrote %s\n", g_jsonPath.c_str());
+
+    // Release the surface before the context goes away
+    surface.reset();
+    return 0;
+}
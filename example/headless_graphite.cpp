@@ -0,0 +1,160 @@
+/**
+ * Headless Dawn + Graphite setup for the offscreen examples
+ * See headless_graphite.h.
+ */
+
+#include "headless_graphite.h"
+
+#include "dawn/dawn_proc.h"
+#include "include/core/SkColorSpace.h"
+#include "include/core/SkImageInfo.h"
+#include "include/core/SkSurface.h"
+#include "include/gpu/graphite/ContextOptions.h"
+#include "include/gpu/graphite/Surface.h"
+#include "include/gpu/graphite/dawn/DawnBackendContext.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+namespace {
+
+const char* backendName(wgpu::BackendType type) {
+    switch (type) {
+        case wgpu::BackendType::Metal: return "Metal";
+        case wgpu::BackendType::Vulkan: return "Vulkan";
+        case wgpu::BackendType::D3D12: return "D3D12";
+        case wgpu::BackendType::D3D11: return "D3D11";
+        case wgpu::BackendType::OpenGL: return "OpenGL";
+        case wgpu::BackendType::OpenGLES: return "OpenGLES";
+        default: return "Unknown";
+    }
+}
+
+}  // namespace
+
+HeadlessGraphite::~HeadlessGraphite() {
+    // Graphite objects must go before the device they were created on
+    fFrameFutures.clear();
+    fRecorder.reset();
+    fContext.reset();
+    fDevice = nullptr;
+    fAdapter = nullptr;
+    fInstance = nullptr;
+    fDawnInstance.reset();
+}
+
+bool HeadlessGraphite::init(const Options& options) {
+    dawnProcSetProcs(&dawn::native::GetProcs());
+
+    wgpu::InstanceDescriptor instanceDesc = {};
+    static const wgpu::InstanceFeatureName instanceFeatures[] = {
+        wgpu::InstanceFeatureName::TimedWaitAny
+    };
+    instanceDesc.requiredFeatureCount = 1;
+    instanceDesc.requiredFeatures = instanceFeatures;
+
+    fDawnInstance = std::make_unique<dawn::native::Instance>(&instanceDesc);
+    fInstance = wgpu::Instance(fDawnInstance->Get());
+    if (!fInstance) {
+        fprintf(stderr, "Failed to create Dawn instance\n");
+        return false;
+    }
+
+    wgpu::RequestAdapterOptions adapterOptions = {};
+    adapterOptions.powerPreference = wgpu::PowerPreference::HighPerformance;
+    std::vector<dawn::native::Adapter> adapters = fDawnInstance->EnumerateAdapters(&adapterOptions);
+    if (adapters.empty()) {
+        fprintf(stderr, "No suitable GPU adapter found\n");
+        return false;
+    }
+    fAdapter = wgpu::Adapter(adapters[0].Get());
+
+    wgpu::AdapterInfo adapterInfo;
+    fAdapter.GetInfo(&adapterInfo);
+    std::string deviceName = adapterInfo.device.data
+            ? std::string(adapterInfo.device.data, adapterInfo.device.length)
+            : std::string("Unknown");
+    fAdapterName = deviceName + " (" + backendName(adapterInfo.backendType) + ")";
+
+    std::vector<wgpu::FeatureName> features;
+    if (options.requestTimestamps) {
+        fHasTimestamps = fAdapter.HasFeature(wgpu::FeatureName::TimestampQuery);
+        if (fHasTimestamps) {
+            features.push_back(wgpu::FeatureName::TimestampQuery);
+        } else {
+            fprintf(stderr, "Adapter lacks TimestampQuery; GPU time will not be reported\n");
+        }
+    }
+    if (options.threadSafeDevice) {
+        if (!fAdapter.HasFeature(wgpu::FeatureName::ImplicitDeviceSynchronization)) {
+            fprintf(stderr, "Adapter lacks ImplicitDeviceSynchronization; multi-threaded rendering unavailable\n");
+            return false;
+        }
+        features.push_back(wgpu::FeatureName::ImplicitDeviceSynchronization);
+    }
+
+    wgpu::DeviceDescriptor deviceDesc = {};
+    deviceDesc.requiredFeatureCount = features.size();
+    deviceDesc.requiredFeatures = features.data();
+    deviceDesc.SetDeviceLostCallback(
+        wgpu::CallbackMode::AllowSpontaneous,
+        [](const wgpu::Device& device, wgpu::DeviceLostReason reason, wgpu::StringView message) {
+            fprintf(stderr, "Device lost: %s\n", std::string(message).c_str());
+        }
+    );
+    deviceDesc.SetUncapturedErrorCallback(
+        [](const wgpu::Device& device, wgpu::ErrorType type, wgpu::StringView message) {
+            fprintf(stderr, "Dawn error (%d): %s\n", static_cast<int>(type), std::string(message).c_str());
+        }
+    );
+
+    fDevice = fAdapter.CreateDevice(&deviceDesc);
+    if (!fDevice) {
+        fprintf(stderr, "Failed to create Dawn device\n");
+        return false;
+    }
+
+    skgpu::graphite::DawnBackendContext backendContext;
+    backendContext.fInstance = fInstance;
+    backendContext.fDevice = fDevice;
+    backendContext.fQueue = fDevice.GetQueue();
+    backendContext.fTick = skgpu::graphite::DawnNativeProcessEventsFunction;
+
+    skgpu::graphite::ContextOptions contextOptions;
+    fContext = skgpu::graphite::ContextFactory::MakeDawn(backendContext, contextOptions);
+    if (!fContext) {
+        fprintf(stderr, "Failed to create Graphite context\n");
+        return false;
+    }
+
+    fRecorder = fContext->makeRecorder();
+    if (!fRecorder) {
+        fprintf(stderr, "Failed to create recorder\n");
+        return false;
+    }
+    return true;
+}
+
+sk_sp<SkSurface> HeadlessGraphite::makeSurface(int width, int height) const {
+    SkImageInfo info = SkImageInfo::MakeN32Premul(width, height, SkColorSpace::MakeSRGB());
+    sk_sp<SkSurface> surface = SkSurfaces::RenderTarget(fRecorder.get(), info);
+    if (!surface) {
+        fprintf(stderr, "Failed to create %dx%d offscreen surface\n", width, height);
+    }
+    return surface;
+}
+
+void HeadlessGraphite::waitForFrameSlot(int maxFramesInFlight) {
+    // Frames finish in submission order, so the oldest future is the next to complete
+    while (fFrameFutures.size() >= static_cast<size_t>(maxFramesInFlight)) {
+        fInstance.WaitAny(fFrameFutures.front(), UINT64_MAX);
+        fFrameFutures.pop_front();
+    }
+    fContext->checkAsyncWorkCompletion();
+}
+
+void HeadlessGraphite::frameSubmitted() {
+    fFrameFutures.push_back(fDevice.GetQueue().OnSubmittedWorkDone(
+        wgpu::CallbackMode::WaitAnyOnly, [](wgpu::QueueWorkDoneStatus, wgpu::StringView) {}));
+}
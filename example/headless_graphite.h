@@ -0,0 +1,78 @@
+/**
+ * Headless Dawn + Graphite setup for the offscreen examples
+ *
+ * Creates a Dawn instance, adapter, device, Graphite context and Recorder without
+ * a window or wgpu::Surface. Rendering goes to offscreen SkSurfaces, so nothing
+ * is vsync-limited and the tools can run on CI machines without a display.
+ */
+
+#ifndef HEADLESS_GRAPHITE_H
+#define HEADLESS_GRAPHITE_H
+
+#include "dawn/native/DawnNative.h"
+#include "dawn/webgpu_cpp.h"
+#include "include/core/SkRefCnt.h"
+#include "include/gpu/graphite/Context.h"
+#include "include/gpu/graphite/Recorder.h"
+
+#include <deque>
+#include <memory>
+#include <string>
+
+class SkSurface;
+
+class HeadlessGraphite {
+public:
+    struct Options {
+        // Enable TimestampQuery so Graphite can report GPU elapsed time per Recording
+        bool requestTimestamps = false;
+        // Enable ImplicitDeviceSynchronization for use from several threads
+        bool threadSafeDevice = false;
+    };
+
+    ~HeadlessGraphite();
+
+    /**
+     * Creates the device, Graphite context and one Recorder.
+     * @return false (after printing the reason) if any step fails
+     */
+    bool init(const Options& options);
+
+    /** True if the device was created with TimestampQuery. */
+    bool hasTimestamps() const { return fHasTimestamps; }
+
+    /** Adapter name and backend, e.g. "Apple M2 (Metal)". */
+    const std::string& adapterName() const { return fAdapterName; }
+
+    skgpu::graphite::Context* context() const { return fContext.get(); }
+    skgpu::graphite::Recorder* recorder() const { return fRecorder.get(); }
+    const wgpu::Device& device() const { return fDevice; }
+
+    /** Offscreen sRGB N32 render target owned by recorder(). */
+    sk_sp<SkSurface> makeSurface(int width, int height) const;
+
+    /** Process Dawn events so finished callbacks fire. */
+    void processEvents() { fInstance.ProcessEvents(); }
+
+    /**
+     * Frames-in-flight throttle for a render loop on one thread: call
+     * waitForFrameSlot() before recording a frame and frameSubmitted() after
+     * submitting it. Waiting blocks in WaitAny on the oldest frame's queue future
+     * instead of polling, then runs Graphite's finished procs.
+     */
+    void waitForFrameSlot(int maxFramesInFlight);
+    void frameSubmitted();
+
+private:
+    std::unique_ptr<dawn::native::Instance> fDawnInstance;
+    wgpu::Instance fInstance;
+    wgpu::Adapter fAdapter;
+    wgpu::Device fDevice;
+    std::unique_ptr<skgpu::graphite::Context> fContext;
+    std::unique_ptr<skgpu::graphite::Recorder> fRecorder;
+    std::deque<wgpu::Future> fFrameFutures;  // Submitted frames, oldest first
+    std::string fAdapterName;
+    bool fHasTimestamps = false;
+};
+
+#endif // HEADLESS_GRAPHITE_H
@@ -6,6 +6,38 @@
  * Dawn's native backends (Metal, Vulkan, D3D12) for GPU acceleration.
  *
  * Build with: cmake -DUSE_NATIVE_GRAPHITE=ON
+ *
+ * Usage: example [--frames-in-flight=N] [--recorders=N] [--present-mode=MODE]
+ *                [--scene=MODE] [--benchmark=N] [--trace=FILE] [--tracy]
+ *
+ *   --frames-in-flight=1  Record, submit and present on the main thread (default)
+ *   --frames-in-flight=2  Record on the main thread while a submit thread inserts,
+ *   --frames-in-flight=3  submits and presents; N bounds both the recording queue
+ *                         and the number of frames the GPU may have outstanding
+ *   --recorders=N         Record each frame on N worker threads, one Recorder each,
+ *                         splitting the screen into N horizontal bands (default 1)
+ *   --pipeline-cache=DIR  Persist Dawn blobs and Graphite pipeline keys in DIR
+ *                         (default: ./pipeline-cache)
+ *   --no-pipeline-cache   Start cold every launch
+ *   --precompile=MODE     Replay cached pipeline keys before the first frame ("sync",
+ *                         default) or on a background thread ("background")
+ *   --present-mode=MODE   Swapchain present mode: "fifo" (vsync, default), "fifo-relaxed"
+ *                         (tears only on late frames), "mailbox" (no tearing, newest frame
+ *                         wins), "immediate" (tears), or "low-latency" to pick the first
+ *                         supported of mailbox, immediate, fifo-relaxed. Unsupported
+ *                         modes fall back to fifo
+ *   --scene=MODE          "immediate" rebuilds paths, paints and text each frame (default);
+ *                         "retained" builds them once and only animates transforms/colors
+ *   --benchmark=N         Render N frames in each scene mode, print CPU record time and
+ *                         texture uploads per frame, then exit
+ *   --trace=FILE          Write Skia, Dawn and per-frame trace events to FILE as JSON
+ *                         (open in ui.perfetto.dev); needs -DSKIA_VARIANT=traced
+ *   --trace-categories=L  Comma-separated categories to record, '*' suffix matches a
+ *                         prefix (default: all but disabled-by-default-*)
+ *   --tracy               Stream the same events to a Tracy profiler instead
+ *                         (build-skia.py -variant traced -tracy DIR)
+ *
+ * Time to first frame is printed at startup so cold and warm launches can be compared.
  */
 
 // Include GLFW first
@@ -40,30 +72,50 @@
 
 // Skia includes
 #include "include/core/SkCanvas.h"
-#include "include/core/SkColor.h"
 #include "include/core/SkColorSpace.h"
-#include "include/core/SkFont.h"
-#include "include/core/SkPaint.h"
-#include "include/core/SkPath.h"
-#include "include/core/SkPathBuilder.h"
-#include "include/core/SkRRect.h"
 #include "include/core/SkSurface.h"
-#include "include/effects/SkGradientShader.h"
 
 // Skia Graphite includes
 #include "include/gpu/graphite/BackendTexture.h"
 #include "include/gpu/graphite/Context.h"
 #include "include/gpu/graphite/ContextOptions.h"
 #include "include/gpu/graphite/GraphiteTypes.h"
+#include "include/gpu/graphite/PrecompileContext.h"
 #include "include/gpu/graphite/Recorder.h"
 #include "include/gpu/graphite/Recording.h"
 #include "include/gpu/graphite/Surface.h"
 #include "include/gpu/graphite/dawn/DawnBackendContext.h"
 #include "include/gpu/graphite/dawn/DawnTypes.h"
 
+#include "bench_util.h"
+#include "pipeline_cache.h"
+#include "scene.h"
+
+#if defined(EXAMPLE_TRACING)
+#include "trace_shim.h"
+#include "trace_shim_dawn.h"
+#endif
+
+#include <atomic>
+#include <chrono>
 #include <cmath>
+#include <condition_variable>
+#include <cstdint>
 #include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Skia revision the libraries were built from (set by CMake); part of the pipeline cache key
+#ifndef EXAMPLE_SKIA_REVISION
+#define EXAMPLE_SKIA_REVISION "unknown"
+#endif
 
 // Global state
 static std::unique_ptr<dawn::native::Instance> g_dawnInstance;
@@ -79,11 +131,62 @@ static int g_height = 600;
 static float g_time = 0.0f;
 static GLFWwindow* g_window = nullptr;
 
+// Frames-in-flight pipeline state (only used when g_framesInFlight > 1)
+static int g_framesInFlight = 1;
+static int g_recorderThreads = 1;
+static std::unique_ptr<skgpu::graphite::Recorder> g_presentRecorder;  // Wraps swapchain textures on the submit thread
+static std::atomic<int> g_gpuFramesInFlight{0};
+
+// Swapchain reconfiguration, coalesced to at most once per frame (see reconfigureSurfaceIfNeeded)
+static std::atomic<bool> g_reconfigurePending{false};
+static std::atomic<int> g_pendingWidth{0};
+static std::atomic<int> g_pendingHeight{0};
+
+// Present mode requested with --present-mode; resolved against the surface capabilities
+static wgpu::PresentMode g_requestedPresentMode = wgpu::PresentMode::Fifo;
+static bool g_lowestLatencyPresentMode = false;
+
+// Persistent pipeline cache state
+static bool g_usePipelineCache = true;
+static std::string g_pipelineCacheDir = "pipeline-cache";
+static bool g_precompileInBackground = false;
+static PipelineCache g_pipelineCache;
+static std::unique_ptr<skgpu::graphite::PrecompileContext> g_precompileContext;
+static std::thread g_precompileThread;
+static std::chrono::steady_clock::time_point g_startTime;
+
+// Scene mode: immediate (rebuild everything per frame) unless a retained scene exists
+static bool g_useRetainedScene = false;
+static std::unique_ptr<RetainedScene> g_retainedScene;
+
+// --benchmark=N: N frames immediate, then N frames retained, then print a comparison
+static int g_benchmarkFrames = 0;
+static double g_lastRecordMs = 0.0;
+
+// --trace / --tracy (EXAMPLE_TRACING builds only)
+static const char* g_traceOutput = nullptr;
+static const char* g_traceCategories = nullptr;
+static bool g_traceWithTracy = false;
+
+// Span on the "example" category for the enclosing scope; no-op without tracing
+#if defined(EXAMPLE_TRACING)
+struct ExampleTraceScope {
+    explicit ExampleTraceScope(const char* name) { trace_shim_begin("example", name); }
+    ~ExampleTraceScope() { trace_shim_end(); }
+};
+#define EXAMPLE_TRACE_SCOPE(name) ExampleTraceScope exampleTraceScope(name)
+#define EXAMPLE_TRACE_THREAD(name) trace_shim_thread_name(name)
+#else
+#define EXAMPLE_TRACE_SCOPE(name) do {} while (0)
+#define EXAMPLE_TRACE_THREAD(name) do {} while (0)
+#endif
+
 // Forward declarations
 bool initDawn();
 bool initGraphite();
 wgpu::Surface createSurface(GLFWwindow* window);
 void render();
+void renderPipelined();
 void cleanup();
 
 // Error callback for GLFW
@@ -91,143 +194,70 @@ void glfwErrorCallback(int error, const char* description) {
     fprintf(stderr, "GLFW Error %d: %s\n", error, description);
 }
 
-// Window resize callback
+// Window resize callback. A drag-resize delivers many events per frame, so only
+// record the latest size here; the thread that owns the surface reconfigures once
+// before its next acquire.
 void framebufferSizeCallback(GLFWwindow* window, int width, int height) {
     if (width > 0 && height > 0) {
         g_width = width;
         g_height = height;
-
-        // Reconfigure surface with new size
-        g_surfaceConfig.width = g_width;
-        g_surfaceConfig.height = g_height;
-        g_surface.Configure(&g_surfaceConfig);
-    }
-}
-
-// Draw animated content demonstrating Skia Graphite
-void drawContent(SkCanvas* canvas) {
-    canvas->clear(SK_ColorWHITE);
-
-    // Animated rotation for background
-    canvas->save();
-    canvas->translate(g_width / 2.0f, g_height / 2.0f);
-    canvas->rotate(g_time * 30.0f);
-    canvas->translate(-g_width / 2.0f, -g_height / 2.0f);
-
-    // Draw a gradient background
-    SkPaint bgPaint;
-    bgPaint.setColor(SkColorSetRGB(230, 235, 255));
-    canvas->drawRect(SkRect::MakeWH(g_width, g_height), bgPaint);
-
-    canvas->restore();
-
-    // Draw a simple path using SkPathBuilder
-    SkPathBuilder pathBuilder;
-    pathBuilder.moveTo(75.0f, 0.0f);
-    pathBuilder.lineTo(150.0f, 50.0f);
-    pathBuilder.lineTo(150.0f, 100.0f);
-    pathBuilder.lineTo(75.0f, 50.0f);
-    pathBuilder.close();
-
-    pathBuilder.moveTo(75.0f, 50.0f);
-    pathBuilder.lineTo(150.0f, 100.0f);
-    pathBuilder.lineTo(150.0f, 150.0f);
-    pathBuilder.lineTo(75.0f, 100.0f);
-    pathBuilder.close();
-
-    SkPath path = pathBuilder.detach();
-
-    // Draw multiple shapes with animation
-    for (int i = 0; i < 3; i++) {
-        float offsetX = 100 + i * 200 + sin(g_time + i) * 20;
-        float offsetY = 150 + cos(g_time * 0.5f + i) * 30;
-
-        canvas->save();
-        canvas->translate(offsetX, offsetY);
-        canvas->scale(1.5f, 1.5f);
-
-        // Shadow
-        SkPaint shadowPaint;
-        shadowPaint.setColor(SkColorSetARGB(60, 0, 0, 0));
-        shadowPaint.setAntiAlias(true);
-        canvas->save();
-        canvas->translate(5, 5);
-        canvas->drawPath(path, shadowPaint);
-        canvas->restore();
-
-        // Main shape with solid color
-        SkPaint shapePaint;
-        shapePaint.setAntiAlias(true);
-        shapePaint.setColor(SkColorSetRGB(66, 133, 244));  // Blue
-        canvas->drawPath(path, shapePaint);
-
-        canvas->restore();
-    }
-
-    // Draw animated circles
-    for (int i = 0; i < 5; i++) {
-        float x = 100 + i * 150;
-        float y = 450 + sin(g_time * 2.0f + i * 0.5f) * 50;
-        float radius = 30 + sin(g_time * 3.0f + i) * 10;
-
-        SkPaint circlePaint;
-        circlePaint.setAntiAlias(true);
-        circlePaint.setColor(SkColorSetARGB(
-            180,
-            (int)(128 + 127 * sin(g_time + i)),
-            (int)(128 + 127 * cos(g_time + i * 0.7f)),
-            (int)(128 + 127 * sin(g_time * 0.5f + i))
-        ));
-        canvas->drawCircle(x, y, radius, circlePaint);
-    }
-
-    // Draw rounded rectangles
-    for (int i = 0; i < 4; i++) {
-        float x = 50 + i * 180;
-        float y = 300 + cos(g_time + i * 0.8f) * 30;
-
-        SkPaint rectPaint;
-        rectPaint.setAntiAlias(true);
-        rectPaint.setColor(SkColorSetARGB(200,
-            (int)(128 + 127 * cos(g_time * 0.5f + i)),
-            200,
-            (int)(128 + 127 * sin(g_time * 0.3f + i))
-        ));
-
-        SkRRect rrect = SkRRect::MakeRectXY(
-            SkRect::MakeXYWH(x, y, 120, 60),
-            15, 15
-        );
-        canvas->drawRRect(rrect, rectPaint);
+        g_pendingWidth = width;
+        g_pendingHeight = height;
+        g_reconfigurePending = true;
     }
+}
 
-    // Draw text
-    SkPaint textPaint;
-    textPaint.setColor(SK_ColorBLACK);
-    textPaint.setAntiAlias(true);
-
-    SkFont font;
-    font.setSize(24);
-
-    canvas->drawString("Skia Graphite + Dawn (Native)", 50, 50, font, textPaint);
-
-    char timeStr[64];
-    snprintf(timeStr, sizeof(timeStr), "Time: %.1f  Size: %dx%d", g_time, g_width, g_height);
-    canvas->drawString(timeStr, 50, 80, font, textPaint);
-
+// Backend name shown in the corner of the scene
+static const char* backendLabel() {
 #if defined(__APPLE__)
-    canvas->drawString("Backend: Metal", 50, 110, font, textPaint);
+    return "Backend: Metal";
 #elif defined(_WIN32)
-    canvas->drawString("Backend: D3D12/Vulkan", 50, 110, font, textPaint);
+    return "Backend: D3D12/Vulkan";
 #elif defined(__linux__)
     if (glfwGetPlatform() == GLFW_PLATFORM_WAYLAND) {
-        canvas->drawString("Backend: Vulkan (Wayland)", 50, 110, font, textPaint);
-    } else {
-        canvas->drawString("Backend: Vulkan (X11)", 50, 110, font, textPaint);
+        return "Backend: Vulkan (Wayland)";
     }
+    return "Backend: Vulkan (X11)";
+#else
+    return "Backend: Unknown";
 #endif
 }
 
+// Draw animated content demonstrating Skia Graphite. With a band (device space),
+// only the scene items overlapping it are recorded.
+void drawContent(SkCanvas* canvas, std::optional<SkRect> band = std::nullopt) {
+    SceneParams params;
+    params.width = g_width;
+    params.height = g_height;
+    params.time = g_time;
+    params.backendLabel = backendLabel();
+    params.band = band;
+
+    if (g_retainedScene) {
+        g_retainedScene->draw(canvas, params);
+    } else {
+        drawSceneImmediate(canvas, params);
+    }
+}
+
+// Count texture uploads (atlas pages, image uploads) by interposing on the Dawn
+// proc table. Graphite records every upload as a buffer-to-texture copy or a
+// queue texture write, so the counters cover all of them.
+static std::atomic<uint64_t> g_textureUploads{0};
+static DawnProcTable g_procs;
+
+template <typename... Args>
+static void countedCopyBufferToTexture(Args... args) {
+    g_textureUploads++;
+    dawn::native::GetProcs().commandEncoderCopyBufferToTexture(args...);
+}
+
+template <typename... Args>
+static void countedQueueWriteTexture(Args... args) {
+    g_textureUploads++;
+    dawn::native::GetProcs().queueWriteTexture(args...);
+}
+
 // Create platform-specific surface from GLFW window
 wgpu::Surface createSurface(GLFWwindow* window) {
 #if defined(__APPLE__)
@@ -282,8 +312,11 @@ wgpu::Surface createSurface(GLFWwindow* window) {
 bool initDawn() {
     printf("Initializing Dawn native...\n");
 
-    // Set up Dawn proc table
-    dawnProcSetProcs(&dawn::native::GetProcs());
+    // Set up Dawn proc table, with texture uploads routed through counters
+    g_procs = dawn::native::GetProcs();
+    g_procs.commandEncoderCopyBufferToTexture = countedCopyBufferToTexture;
+    g_procs.queueWriteTexture = countedQueueWriteTexture;
+    dawnProcSetProcs(&g_procs);
 
     // Create Dawn instance with TimedWaitAny feature for proper synchronization
     wgpu::InstanceDescriptor instanceDesc = {};
@@ -295,6 +328,15 @@ bool initDawn() {
     instanceDesc.requiredFeatureCount = 1;
     instanceDesc.requiredFeatures = requiredFeatures;
 
+#if defined(EXAMPLE_TRACING)
+    // Dawn's own trace events (validation, recording, GPU work) go to the trace shim
+    dawn::native::DawnInstanceDescriptor dawnInstanceDesc = {};
+    if (trace_shim_active()) {
+        dawnInstanceDesc.platform = TraceShimDawnPlatform();
+        instanceDesc.nextInChain = &dawnInstanceDesc;
+    }
+#endif
+
     g_dawnInstance = std::make_unique<dawn::native::Instance>(&instanceDesc);
     g_instance = wgpu::Instance(g_dawnInstance->Get());
 
@@ -326,8 +368,27 @@ bool initDawn() {
            static_cast<int>(adapterInfo.description.length),
            adapterInfo.description.data ? adapterInfo.description.data : "Unknown");
 
+    // Open the on-disk pipeline cache for this adapter + Skia revision
+    if (g_usePipelineCache && !g_pipelineCache.open(g_pipelineCacheDir, adapterInfo, EXAMPLE_SKIA_REVISION)) {
+        g_usePipelineCache = false;
+    }
+
     // Create device
     wgpu::DeviceDescriptor deviceDesc = {};
+
+    // The frames-in-flight pipeline and parallel recorders touch the device from
+    // several threads, which requires Dawn to serialize access to it internally
+    static const wgpu::FeatureName threadingFeatures[] = {
+        wgpu::FeatureName::ImplicitDeviceSynchronization
+    };
+    if (g_framesInFlight > 1 || g_recorderThreads > 1) {
+        if (!g_adapter.HasFeature(wgpu::FeatureName::ImplicitDeviceSynchronization)) {
+            fprintf(stderr, "Adapter lacks ImplicitDeviceSynchronization; multi-threaded rendering unavailable\n");
+            return false;
+        }
+        deviceDesc.requiredFeatureCount = 1;
+        deviceDesc.requiredFeatures = threadingFeatures;
+    }
     deviceDesc.SetDeviceLostCallback(
         wgpu::CallbackMode::AllowSpontaneous,
         [](const wgpu::Device& device, wgpu::DeviceLostReason reason, wgpu::StringView message) {
@@ -340,6 +401,12 @@ bool initDawn() {
         }
     );
 
+    // Route Dawn's blob cache (compiled shaders/pipelines) to disk
+    wgpu::DawnCacheDeviceDescriptor cacheDesc = {};
+    if (g_usePipelineCache) {
+        g_pipelineCache.attachToDevice(&deviceDesc, &cacheDesc);
+    }
+
     g_device = g_adapter.CreateDevice(&deviceDesc);
     if (!g_device) {
         fprintf(stderr, "Failed to create Dawn device\n");
@@ -350,6 +417,54 @@ bool initDawn() {
     return true;
 }
 
+static const char* presentModeName(wgpu::PresentMode mode) {
+    switch (mode) {
+        case wgpu::PresentMode::Fifo: return "fifo";
+        case wgpu::PresentMode::FifoRelaxed: return "fifo-relaxed";
+        case wgpu::PresentMode::Mailbox: return "mailbox";
+        case wgpu::PresentMode::Immediate: return "immediate";
+        default: return "unknown";
+    }
+}
+
+// Pick the present mode from the ones the surface supports. Fifo is always
+// available, so it is the fallback for an unsupported request.
+static wgpu::PresentMode choosePresentMode(const wgpu::SurfaceCapabilities& caps) {
+    auto supported = [&](wgpu::PresentMode mode) {
+        for (size_t i = 0; i < caps.presentModeCount; i++) {
+            if (caps.presentModes[i] == mode) {
+                return true;
+            }
+        }
+        return false;
+    };
+
+    printf("Available present modes:");
+    for (size_t i = 0; i < caps.presentModeCount; i++) {
+        printf(" %s", presentModeName(caps.presentModes[i]));
+    }
+    printf("\n");
+
+    // --present-mode=low-latency: no vsync wait without tearing if possible, then
+    // tearing, then late-frame tearing only
+    if (g_lowestLatencyPresentMode) {
+        for (wgpu::PresentMode mode : {wgpu::PresentMode::Mailbox, wgpu::PresentMode::Immediate,
+                                       wgpu::PresentMode::FifoRelaxed}) {
+            if (supported(mode)) {
+                return mode;
+            }
+        }
+        return wgpu::PresentMode::Fifo;
+    }
+
+    if (!supported(g_requestedPresentMode)) {
+        fprintf(stderr, "Present mode %s not supported by this surface, using fifo\n",
+                presentModeName(g_requestedPresentMode));
+        return wgpu::PresentMode::Fifo;
+    }
+    return g_requestedPresentMode;
+}
+
 // Initialize Skia Graphite with Dawn backend
 bool initGraphite() {
     printf("Initializing Skia Graphite...\n");
@@ -383,6 +498,8 @@ bool initGraphite() {
         }
     }
 
+    wgpu::PresentMode presentMode = choosePresentMode(caps);
+
     // Configure surface
     g_surfaceConfig = {};
     g_surfaceConfig.device = g_device;
@@ -390,11 +507,14 @@ bool initGraphite() {
     g_surfaceConfig.usage = wgpu::TextureUsage::RenderAttachment;
     g_surfaceConfig.width = g_width;
     g_surfaceConfig.height = g_height;
-    g_surfaceConfig.presentMode = wgpu::PresentMode::Fifo;
+    g_surfaceConfig.presentMode = presentMode;
     g_surfaceConfig.alphaMode = wgpu::CompositeAlphaMode::Opaque;
 
     g_surface.Configure(&g_surfaceConfig);
-    printf("Configured surface (%dx%d, format=%d)\n", g_width, g_height, static_cast<int>(g_surfaceConfig.format));
+    g_pendingWidth = g_width;
+    g_pendingHeight = g_height;
+    printf("Configured surface (%dx%d, format=%d, present mode=%s)\n", g_width, g_height,
+           static_cast<int>(g_surfaceConfig.format), presentModeName(presentMode));
 
     // Create Graphite backend context
     skgpu::graphite::DawnBackendContext backendContext;
@@ -406,6 +526,9 @@ bool initGraphite() {
 
     // Create Graphite context
     skgpu::graphite::ContextOptions options;
+    if (g_usePipelineCache) {
+        g_pipelineCache.attachToContextOptions(&options);
+    }
     g_context = skgpu::graphite::ContextFactory::MakeDawn(backendContext, options);
     if (!g_context) {
         fprintf(stderr, "Failed to create Graphite context\n");
@@ -413,6 +536,22 @@ bool initGraphite() {
     }
     printf("Created Graphite context\n");
 
+    // Warm up pipelines recorded by earlier runs
+    if (g_usePipelineCache && g_pipelineCache.pipelineKeyCount() > 0) {
+        g_precompileContext = g_context->makePrecompileContext();
+        if (g_precompileInBackground) {
+            g_precompileThread = std::thread([] {
+                auto start = std::chrono::steady_clock::now();
+                int compiled = g_pipelineCache.precompile(g_precompileContext.get());
+                printf("Background precompile: %d pipelines in %.1f ms\n", compiled, msSince(start));
+            });
+        } else {
+            auto start = std::chrono::steady_clock::now();
+            int compiled = g_pipelineCache.precompile(g_precompileContext.get());
+            printf("Precompiled %d pipelines in %.1f ms\n", compiled, msSince(start));
+        }
+    }
+
     // Create recorder
     g_recorder = g_context->makeRecorder();
     if (!g_recorder) {
@@ -425,89 +564,397 @@ bool initGraphite() {
     return true;
 }
 
-// Main rendering function
-void render() {
-    if (!g_context || !g_recorder || !g_surface) {
-        return;
-    }
-
-    // Get the current surface texture
-    wgpu::SurfaceTexture surfaceTexture;
-    g_surface.GetCurrentTexture(&surfaceTexture);
-
-    if (surfaceTexture.status != wgpu::SurfaceGetCurrentTextureStatus::SuccessOptimal &&
-        surfaceTexture.status != wgpu::SurfaceGetCurrentTextureStatus::SuccessSuboptimal) {
-        fprintf(stderr, "Failed to get current texture: %d\n", static_cast<int>(surfaceTexture.status));
+// Apply pending resizes and suboptimal/outdated swapchain reports with a single
+// Configure. Must be called by the thread that owns the surface (the main thread,
+// or the submit thread while the frames-in-flight pipeline runs).
+static void reconfigureSurfaceIfNeeded() {
+    if (!g_reconfigurePending.exchange(false)) {
         return;
     }
+    g_surfaceConfig.width = g_pendingWidth;
+    g_surfaceConfig.height = g_pendingHeight;
+    g_surface.Configure(&g_surfaceConfig);
+}
 
-    // Create a texture view with explicit non-sRGB format if the surface is sRGB
-    // This allows Skia to work with linear color values
+// Texture view format used for rendering. If the surface is sRGB we render through
+// a non-sRGB view so Skia can work with linear color values.
+static wgpu::TextureFormat surfaceViewFormat() {
     wgpu::TextureFormat viewFormat = g_surfaceConfig.format;
     if (viewFormat == wgpu::TextureFormat::BGRA8UnormSrgb) {
         viewFormat = wgpu::TextureFormat::BGRA8Unorm;
     } else if (viewFormat == wgpu::TextureFormat::RGBA8UnormSrgb) {
         viewFormat = wgpu::TextureFormat::RGBA8Unorm;
     }
+    return viewFormat;
+}
 
-    wgpu::TextureViewDescriptor viewDesc = {};
-    viewDesc.format = viewFormat;
-    wgpu::TextureView textureView = surfaceTexture.texture.CreateView(&viewDesc);
-    if (!textureView) {
-        fprintf(stderr, "Failed to create texture view\n");
-        return;
+// Determine SkColorType from surface format
+// Note: sRGB formats still use the same color type, color space handles the gamma
+static SkColorType surfaceColorType() {
+    switch (g_surfaceConfig.format) {
+        case wgpu::TextureFormat::BGRA8Unorm:
+        case wgpu::TextureFormat::BGRA8UnormSrgb:
+            return kBGRA_8888_SkColorType;
+        case wgpu::TextureFormat::RGBA8Unorm:
+        case wgpu::TextureFormat::RGBA8UnormSrgb:
+            return kRGBA_8888_SkColorType;
+        default:
+            return kBGRA_8888_SkColorType;
     }
+}
 
-    // Create TextureInfo for the surface texture using the view format
-    skgpu::graphite::DawnTextureInfo textureInfo(
+// TextureInfo describing the swapchain texture (as seen through its view format)
+static skgpu::graphite::DawnTextureInfo surfaceTextureInfo() {
+    return skgpu::graphite::DawnTextureInfo(
         /*sampleCount=*/1,
         skgpu::Mipmapped::kNo,
-        viewFormat,
+        surfaceViewFormat(),
         wgpu::TextureUsage::RenderAttachment,
         wgpu::TextureAspect::All
     );
+}
+
+// Acquire the current swapchain texture and wrap it in an SkSurface owned by `recorder`.
+// Returns nullptr if no texture could be acquired.
+static sk_sp<SkSurface> acquireSurface(skgpu::graphite::Recorder* recorder) {
+    // Get the current surface texture
+    wgpu::SurfaceTexture surfaceTexture;
+    g_surface.GetCurrentTexture(&surfaceTexture);
+
+    switch (surfaceTexture.status) {
+        case wgpu::SurfaceGetCurrentTextureStatus::SuccessOptimal:
+            break;
+        case wgpu::SurfaceGetCurrentTextureStatus::SuccessSuboptimal:
+            // Still presentable: draw this frame and reconfigure before the next one
+            // instead of stalling now
+            g_reconfigurePending = true;
+            break;
+        case wgpu::SurfaceGetCurrentTextureStatus::Timeout:
+            return nullptr;  // Skip this frame
+        case wgpu::SurfaceGetCurrentTextureStatus::Outdated:
+        case wgpu::SurfaceGetCurrentTextureStatus::Lost:
+            // The swapchain no longer matches the window; drop the frame and reconfigure
+            g_reconfigurePending = true;
+            return nullptr;
+        default:
+            fprintf(stderr, "Failed to get current texture: %d\n", static_cast<int>(surfaceTexture.status));
+            return nullptr;
+    }
+
+    wgpu::TextureViewDescriptor viewDesc = {};
+    viewDesc.format = surfaceViewFormat();
+    wgpu::TextureView textureView = surfaceTexture.texture.CreateView(&viewDesc);
+    if (!textureView) {
+        fprintf(stderr, "Failed to create texture view\n");
+        return nullptr;
+    }
 
     // Wrap the texture view in a BackendTexture
     skgpu::graphite::BackendTexture backendTexture =
         skgpu::graphite::BackendTextures::MakeDawn(
-            SkISize::Make(g_width, g_height),
-            textureInfo,
+            SkISize::Make(g_surfaceConfig.width, g_surfaceConfig.height),
+            surfaceTextureInfo(),
             textureView.Get()
         );
 
     if (!backendTexture.isValid()) {
         fprintf(stderr, "Failed to create backend texture\n");
-        return;
-    }
-
-    // Determine SkColorType from surface format
-    // Note: sRGB formats still use the same color type, color space handles the gamma
-    SkColorType colorType;
-    switch (g_surfaceConfig.format) {
-        case wgpu::TextureFormat::BGRA8Unorm:
-        case wgpu::TextureFormat::BGRA8UnormSrgb:
-            colorType = kBGRA_8888_SkColorType;
-            break;
-        case wgpu::TextureFormat::RGBA8Unorm:
-        case wgpu::TextureFormat::RGBA8UnormSrgb:
-            colorType = kRGBA_8888_SkColorType;
-            break;
-        default:
-            colorType = kBGRA_8888_SkColorType;
-            break;
+        return nullptr;
     }
 
     // Create SkSurface from the backend texture
     sk_sp<SkSurface> surface = SkSurfaces::WrapBackendTexture(
-        g_recorder.get(),
+        recorder,
         backendTexture,
-        colorType,
+        surfaceColorType(),
         SkColorSpace::MakeSRGB(),
         nullptr  // surface props
     );
 
     if (!surface) {
         fprintf(stderr, "Failed to create SkSurface\n");
+    }
+    return surface;
+}
+
+// Rolling frame statistics, printed every couple of seconds
+struct FrameStats {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    int frames = 0;
+    double recordMs = 0.0;
+    double submitMs = 0.0;
+
+    void add(double frameRecordMs, double frameSubmitMs) {
+        frames++;
+        recordMs += frameRecordMs;
+        submitMs += frameSubmitMs;
+
+        auto now = std::chrono::steady_clock::now();
+        double elapsed = std::chrono::duration<double>(now - start).count();
+        if (elapsed >= 2.0) {
+            printf("%.1f fps (%s, frames in flight: %d, recorders: %d, record: %.2f ms, submit+present: %.2f ms)\n",
+                   frames / elapsed, presentModeName(g_surfaceConfig.presentMode), g_framesInFlight, g_recorderThreads, recordMs / frames, submitMs / frames);
+            *this = FrameStats();
+        }
+    }
+};
+
+// One recorded frame that has not been inserted yet. Each tile is a Recording made
+// against a deferred canvas; it is drawn into the swapchain texture at `offset`.
+struct FrameTile {
+    std::unique_ptr<skgpu::graphite::Recording> recording;
+    SkIVector offset = {0, 0};
+};
+
+struct PendingFrame {
+    std::vector<FrameTile> tiles;
+    int width = 0;
+    int height = 0;
+    double recordMs = 0.0;
+};
+
+// Image info of a deferred canvas covering `height` rows of a `width` wide swapchain
+static SkImageInfo deferredImageInfo(int width, int height) {
+    return SkImageInfo::Make(
+        width, height, surfaceColorType(), kPremul_SkAlphaType, SkColorSpace::MakeSRGB());
+}
+
+// Record drawContent() rows [top, top + height) with `recorder` into a deferred canvas.
+// Scene items outside those rows are skipped rather than recorded and clipped.
+static std::unique_ptr<skgpu::graphite::Recording> recordBand(
+        skgpu::graphite::Recorder* recorder, int width, int top, int height) {
+    SkCanvas* canvas = recorder->makeDeferredCanvas(deferredImageInfo(width, height), surfaceTextureInfo());
+    if (!canvas) {
+        fprintf(stderr, "Failed to create deferred canvas\n");
+        return nullptr;
+    }
+    EXAMPLE_TRACE_SCOPE("recordBand");
+    canvas->translate(0, -top);
+    drawContent(canvas, SkRect::MakeXYWH(0, top, width, height));
+    return recorder->snap();
+}
+
+// -----------------------------------------------------------------------------
+// Parallel recording (--recorders=N)
+//
+// Each worker thread owns its own Recorder (Recorders are single-threaded, but
+// independent Recorders from one Context may record concurrently). Every frame
+// the screen is split into N horizontal bands; worker i records band i into its
+// deferred canvas, drawing only the scene items whose bounds overlap the band
+// (the full-screen background and clear go into every band). The resulting
+// Recordings are inserted in band order before a single submit, so output is
+// deterministic regardless of which worker finishes first.
+// -----------------------------------------------------------------------------
+
+class RecorderPool {
+public:
+    bool init(int threadCount) {
+        fSlots.resize(threadCount);
+        for (int i = 0; i < threadCount; i++) {
+            fSlots[i].recorder = g_context->makeRecorder();
+            if (!fSlots[i].recorder) {
+                fprintf(stderr, "Failed to create recorder %d\n", i);
+                return false;
+            }
+        }
+        for (int i = 0; i < threadCount; i++) {
+            fThreads.emplace_back(&RecorderPool::workerMain, this, i);
+        }
+        return true;
+    }
+
+    void shutdown() {
+        {
+            std::lock_guard<std::mutex> lock(fMutex);
+            fQuit = true;
+        }
+        fWorkReady.notify_all();
+        for (std::thread& thread : fThreads) {
+            thread.join();
+        }
+        fThreads.clear();
+        fSlots.clear();
+    }
+
+    // Record one frame across all workers. Blocks until every band has been snapped.
+    void recordFrame(int width, int height, PendingFrame* frame) {
+        {
+            std::lock_guard<std::mutex> lock(fMutex);
+            fWidth = width;
+            fHeight = height;
+            fPending = static_cast<int>(fSlots.size());
+            fGeneration++;
+        }
+        fWorkReady.notify_all();
+        {
+            std::unique_lock<std::mutex> lock(fMutex);
+            fWorkDone.wait(lock, [this] { return fPending == 0; });
+        }
+
+        for (Slot& slot : fSlots) {
+            if (slot.tile.recording) {
+                frame->tiles.push_back(std::move(slot.tile));
+            }
+            slot.tile = FrameTile();
+        }
+        report();
+    }
+
+private:
+    struct Slot {
+        std::unique_ptr<skgpu::graphite::Recorder> recorder;
+        FrameTile tile;
+        double totalMs = 0.0;
+    };
+
+    void workerMain(int index) {
+#if defined(EXAMPLE_TRACING)
+        std::string threadName = "recorder " + std::to_string(index);
+        EXAMPLE_TRACE_THREAD(threadName.c_str());
+#endif
+        uint64_t seenGeneration = 0;
+        for (;;) {
+            int width, height;
+            {
+                std::unique_lock<std::mutex> lock(fMutex);
+                fWorkReady.wait(lock, [&] { return fQuit || fGeneration != seenGeneration; });
+                if (fQuit) {
+                    return;
+                }
+                seenGeneration = fGeneration;
+                width = fWidth;
+                height = fHeight;
+            }
+
+            // Band i covers rows [top, bottom); the last band absorbs the remainder
+            int count = static_cast<int>(fSlots.size());
+            int top = height * index / count;
+            int bottom = height * (index + 1) / count;
+
+            Slot& slot = fSlots[index];
+            auto start = std::chrono::steady_clock::now();
+            if (bottom > top) {
+                slot.tile.recording = recordBand(slot.recorder.get(), width, top, bottom - top);
+                slot.tile.offset = {0, top};
+            }
+            slot.totalMs += msSince(start);
+
+            {
+                std::lock_guard<std::mutex> lock(fMutex);
+                if (--fPending == 0) {
+                    fWorkDone.notify_one();
+                }
+            }
+        }
+    }
+
+    // Print the per-thread average record time every couple of seconds
+    void report() {
+        fFrames++;
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - fReportStart).count();
+        if (elapsed < 2.0) {
+            return;
+        }
+        printf("Per-recorder record time:");
+        for (size_t i = 0; i < fSlots.size(); i++) {
+            printf(" [%zu] %.2f ms", i, fSlots[i].totalMs / fFrames);
+            fSlots[i].totalMs = 0.0;
+        }
+        printf("\n");
+        fFrames = 0;
+        fReportStart = std::chrono::steady_clock::now();
+    }
+
+    std::vector<Slot> fSlots;
+    std::vector<std::thread> fThreads;
+    std::mutex fMutex;
+    std::condition_variable fWorkReady;
+    std::condition_variable fWorkDone;
+    uint64_t fGeneration = 0;
+    int fPending = 0;
+    int fWidth = 0;
+    int fHeight = 0;
+    bool fQuit = false;
+    int fFrames = 0;
+    std::chrono::steady_clock::time_point fReportStart = std::chrono::steady_clock::now();
+};
+
+static RecorderPool g_recorderPool;
+
+// Record the current scene as deferred tiles, either on this thread or across the pool
+static void recordFrame(PendingFrame* frame) {
+    auto recordStart = std::chrono::steady_clock::now();
+    frame->width = g_width;
+    frame->height = g_height;
+    if (g_recorderThreads > 1) {
+        g_recorderPool.recordFrame(g_width, g_height, frame);
+    } else {
+        FrameTile tile;
+        tile.recording = recordBand(g_recorder.get(), g_width, 0, g_height);
+        if (tile.recording) {
+            frame->tiles.push_back(std::move(tile));
+        }
+    }
+    frame->recordMs = msSince(recordStart);
+}
+
+// Insert every tile of `frame` into `surface` in order. Returns the number inserted.
+static int insertFrame(PendingFrame* frame, SkSurface* surface,
+                       skgpu::graphite::GpuFinishedProc finishedProc) {
+    int inserted = 0;
+    for (size_t i = 0; i < frame->tiles.size(); i++) {
+        skgpu::graphite::InsertRecordingInfo info;
+        info.fRecording = frame->tiles[i].recording.get();
+        info.fTargetSurface = surface;
+        info.fTargetTranslation = frame->tiles[i].offset;
+        // Only the last tile signals completion of the whole frame
+        if (i + 1 == frame->tiles.size()) {
+            info.fFinishedProc = finishedProc;
+        }
+        if (!g_context->insertRecording(info)) {
+            fprintf(stderr, "Failed to insert recording for tile %zu\n", i);
+            continue;
+        }
+        inserted++;
+    }
+    return inserted;
+}
+
+// Main rendering function
+void render() {
+    if (!g_context || !g_recorder || !g_surface) {
+        return;
+    }
+    EXAMPLE_TRACE_SCOPE("render");
+
+    static FrameStats stats;
+
+    reconfigureSurfaceIfNeeded();
+
+    // Parallel recording draws into deferred canvases first, then targets the swapchain
+    if (g_recorderThreads > 1) {
+        PendingFrame frame;
+        recordFrame(&frame);
+
+        auto submitStart = std::chrono::steady_clock::now();
+        sk_sp<SkSurface> surface = acquireSurface(g_recorder.get());
+        if (!surface) {
+            return;
+        }
+        insertFrame(&frame, surface.get(), nullptr);
+        g_context->submit(skgpu::graphite::SyncToCpu::kNo);
+        g_surface.Present();
+        g_instance.ProcessEvents();
+
+        stats.add(frame.recordMs, msSince(submitStart));
+        g_lastRecordMs = frame.recordMs;
+        return;
+    }
+
+    auto recordStart = std::chrono::steady_clock::now();
+
+    sk_sp<SkSurface> surface = acquireSurface(g_recorder.get());
+    if (!surface) {
         return;
     }
 
@@ -517,6 +964,9 @@ void render() {
 
     // Snap recording and submit to GPU
     std::unique_ptr<skgpu::graphite::Recording> recording = g_recorder->snap();
+    double recordMs = msSince(recordStart);
+
+    auto submitStart = std::chrono::steady_clock::now();
     if (recording) {
         skgpu::graphite::InsertRecordingInfo info;
         info.fRecording = recording.get();
@@ -529,10 +979,214 @@ void render() {
 
     // Process Dawn events
     g_instance.ProcessEvents();
+
+    stats.add(recordMs, msSince(submitStart));
+    g_lastRecordMs = recordMs;
+}
+
+// -----------------------------------------------------------------------------
+// Frames-in-flight pipeline
+//
+// The main thread records each frame into a deferred canvas (no swapchain texture
+// needed yet), snaps it and pushes the Recording into a bounded queue. A submit
+// thread pops recordings, acquires the swapchain texture, inserts the recording
+// with that texture as its target, submits and presents. Recording of frame N+1
+// therefore overlaps submission and GPU execution of frame N.
+//
+// One budget keeps latency bounded to g_framesInFlight frames: a frame holds a
+// slot from the moment it is queued until the GPU has finished it (fFinishedProc)
+// or the submit thread drops it. The recording thread blocks on a condition
+// variable while every slot is taken. When all of them are on the GPU the submit
+// thread has nothing to pop, so it blocks on the oldest frame's queue future
+// instead and lets Graphite run the finished procs.
+// -----------------------------------------------------------------------------
+
+// Blocking queue handing Recordings from the recording thread to the submit
+// thread. `capacity` bounds queued frames plus popped frames not yet retired.
+class FrameQueue {
+public:
+    explicit FrameQueue(size_t capacity) : fCapacity(capacity) {}
+
+    // Blocks while the budget is used up. Returns false if the queue was closed.
+    bool push(PendingFrame frame) {
+        std::unique_lock<std::mutex> lock(fMutex);
+        fNotFull.wait(lock, [this] { return fClosed || fFrames.size() + fTaken < fCapacity; });
+        if (fClosed) {
+            return false;
+        }
+        fFrames.push_back(std::move(frame));
+        fNotEmpty.notify_one();
+        return true;
+    }
+
+    // Blocks until a frame is available. Returns false once closed and drained.
+    bool pop(PendingFrame* frame) {
+        std::unique_lock<std::mutex> lock(fMutex);
+        fNotEmpty.wait(lock, [this] { return fClosed || !fFrames.empty(); });
+        if (fFrames.empty()) {
+            return false;
+        }
+        *frame = std::move(fFrames.front());
+        fFrames.pop_front();
+        fTaken++;  // Keeps its slot until retire()
+        return true;
+    }
+
+    // Frees the slot of a popped frame: the GPU finished it, or it was dropped
+    void retire() {
+        std::lock_guard<std::mutex> lock(fMutex);
+        fTaken--;
+        fNotFull.notify_one();
+    }
+
+    void close() {
+        std::lock_guard<std::mutex> lock(fMutex);
+        fClosed = true;
+        fNotEmpty.notify_all();
+        fNotFull.notify_all();
+    }
+
+private:
+    const size_t fCapacity;
+    std::mutex fMutex;
+    std::condition_variable fNotEmpty;
+    std::condition_variable fNotFull;
+    std::deque<PendingFrame> fFrames;
+    size_t fTaken = 0;
+    bool fClosed = false;
+};
+
+static std::unique_ptr<FrameQueue> g_frameQueue;
+static std::thread g_submitThread;
+// Queue work-done futures of the frames on the GPU, oldest first (submit thread only)
+static std::deque<wgpu::Future> g_gpuFrameFutures;
+
+// Called by Graphite once the GPU has finished with a submitted frame
+static void frameFinishedProc(skgpu::graphite::GpuFinishedContext, skgpu::CallbackResult) {
+    g_gpuFramesInFlight--;
+    g_frameQueue->retire();
+}
+
+// Run the finished procs of completed frames and forget their futures. Frames
+// finish in submission order, so the oldest futures are the completed ones.
+static void retireGpuFrames() {
+    g_context->checkAsyncWorkCompletion();
+    while (g_gpuFrameFutures.size() > static_cast<size_t>(g_gpuFramesInFlight.load())) {
+        g_gpuFrameFutures.pop_front();
+    }
+}
+
+// Block (without spinning) until the oldest frame on the GPU has finished
+static void waitForOldestGpuFrame() {
+    EXAMPLE_TRACE_SCOPE("waitForGpu");
+    if (g_gpuFrameFutures.empty()) {
+        g_context->submit(skgpu::graphite::SyncToCpu::kYes);
+    } else {
+        g_instance.WaitAny(g_gpuFrameFutures.front(), UINT64_MAX);
+        g_gpuFrameFutures.pop_front();
+    }
+    retireGpuFrames();
+}
+
+// Submit thread: owns g_context and g_surface while the pipeline is running
+static void submitThreadMain() {
+    EXAMPLE_TRACE_THREAD("submit");
+    FrameStats stats;
+    PendingFrame frame;
+    for (;;) {
+        // With every budget slot on the GPU nothing can be queued until one retires
+        retireGpuFrames();
+        while (g_gpuFramesInFlight >= g_framesInFlight) {
+            waitForOldestGpuFrame();
+        }
+        if (!g_frameQueue->pop(&frame)) {
+            break;
+        }
+        EXAMPLE_TRACE_SCOPE("submitFrame");
+        auto submitStart = std::chrono::steady_clock::now();
+
+        // Apply the latest resize before touching the swapchain
+        reconfigureSurfaceIfNeeded();
+
+        // Recordings made at a stale size can't target the new swapchain; drop them
+        if (frame.tiles.empty() ||
+            frame.width != static_cast<int>(g_surfaceConfig.width) ||
+            frame.height != static_cast<int>(g_surfaceConfig.height)) {
+            g_frameQueue->retire();
+            continue;
+        }
+
+        sk_sp<SkSurface> surface = acquireSurface(g_presentRecorder.get());
+        if (!surface) {
+            g_frameQueue->retire();
+            continue;
+        }
+
+        // fFinishedProc is invoked even when insertion fails, which balances the
+        // counter and retires the frame's slot
+        g_gpuFramesInFlight++;
+        insertFrame(&frame, surface.get(), frameFinishedProc);
+        g_context->submit(skgpu::graphite::SyncToCpu::kNo);
+        g_gpuFrameFutures.push_back(g_device.GetQueue().OnSubmittedWorkDone(
+            wgpu::CallbackMode::WaitAnyOnly, [](wgpu::QueueWorkDoneStatus, wgpu::StringView) {}));
+
+        g_surface.Present();
+        g_instance.ProcessEvents();
+
+        stats.add(frame.recordMs, msSince(submitStart));
+    }
+
+    // Drain outstanding GPU work before the context is torn down
+    g_context->submit(skgpu::graphite::SyncToCpu::kYes);
+    g_gpuFrameFutures.clear();
+}
+
+static bool startPipeline() {
+    g_presentRecorder = g_context->makeRecorder();
+    if (!g_presentRecorder) {
+        fprintf(stderr, "Failed to create present recorder\n");
+        return false;
+    }
+    g_frameQueue = std::make_unique<FrameQueue>(g_framesInFlight);
+    g_submitThread = std::thread(submitThreadMain);
+    printf("Started frames-in-flight pipeline (depth %d)\n", g_framesInFlight);
+    return true;
+}
+
+static void stopPipeline() {
+    if (g_frameQueue) {
+        g_frameQueue->close();
+    }
+    if (g_submitThread.joinable()) {
+        g_submitThread.join();
+    }
+    g_frameQueue.reset();
+    g_presentRecorder.reset();
+}
+
+// Record one frame into deferred canvases and hand it to the submit thread
+void renderPipelined() {
+    if (!g_recorder || !g_frameQueue) {
+        return;
+    }
+
+    EXAMPLE_TRACE_SCOPE("recordFrame");
+    PendingFrame frame;
+    recordFrame(&frame);
+    g_lastRecordMs = frame.recordMs;
+    if (!frame.tiles.empty()) {
+        g_frameQueue->push(std::move(frame));
+    }
 }
 
 // Cleanup resources
 void cleanup() {
+    stopPipeline();
+    g_recorderPool.shutdown();
+    if (g_precompileThread.joinable()) {
+        g_precompileThread.join();
+    }
+    g_precompileContext.reset();
     g_recorder.reset();
     g_context.reset();
     g_surface = nullptr;
@@ -546,12 +1200,181 @@ void cleanup() {
         g_window = nullptr;
     }
     glfwTerminate();
+
+#if defined(EXAMPLE_TRACING)
+    if (trace_shim_active()) {
+        trace_shim_shutdown();
+    }
+#endif
+}
+
+// Start the trace shim before Dawn and Graphite so their first events are captured
+static bool startTracing() {
+    if (!g_traceOutput && !g_traceWithTracy) {
+        return true;
+    }
+#if defined(EXAMPLE_TRACING)
+    TraceShimConfig config = {};
+    config.backend = g_traceWithTracy ? TRACE_SHIM_BACKEND_TRACY : TRACE_SHIM_BACKEND_JSON;
+    config.output_path = g_traceOutput;
+    config.categories = g_traceCategories;
+    if (trace_shim_init(&config) != 0) {
+        fprintf(stderr, "Failed to start tracing\n");
+        return false;
+    }
+    if (trace_shim_install_skia() != 0) {
+        fprintf(stderr, "Failed to install the Skia event tracer\n");
+        trace_shim_shutdown();
+        return false;
+    }
+    EXAMPLE_TRACE_THREAD("main");
+    printf("Tracing to %s\n", g_traceWithTracy ? "Tracy" : g_traceOutput);
+    return true;
+#else
+    fprintf(stderr, "--trace and --tracy need the traced Skia build "
+                    "(build-skia.py -variant traced, cmake -DSKIA_VARIANT=traced)\n");
+    return false;
+#endif
+}
+
+// --benchmark: accumulates one scene mode's frames, then switches or finishes
+struct SceneBenchmark {
+    struct Phase {
+        const char* name = "";
+        int frames = 0;
+        double recordMs = 0.0;
+        uint64_t uploads = 0;
+    };
+
+    Phase phases[2];
+    int current = 0;
+    uint64_t uploadsAtPhaseStart = 0;
+    bool warmingUp = true;
+    bool finished = false;
+
+    void start() {
+        phases[0].name = "immediate";
+        phases[1].name = "retained";
+        g_retainedScene.reset();
+        printf("Benchmark: %d frames per scene mode\n", g_benchmarkFrames);
+    }
+
+    // Called after each rendered frame; returns false once both phases are done.
+    // The first frame of each phase is a warm-up that fills atlases and pipelines.
+    bool addFrame() {
+        if (warmingUp) {
+            warmingUp = false;
+            uploadsAtPhaseStart = g_textureUploads.load();
+            return true;
+        }
+
+        Phase& phase = phases[current];
+        phase.frames++;
+        phase.recordMs += g_lastRecordMs;
+        if (phase.frames < g_benchmarkFrames) {
+            return true;
+        }
+
+        phase.uploads = g_textureUploads.load() - uploadsAtPhaseStart;
+        if (current == 0) {
+            current = 1;
+            warmingUp = true;
+            g_retainedScene = std::make_unique<RetainedScene>();
+            return true;
+        }
+
+        report();
+        finished = true;
+        return false;
+    }
+
+    void report() const {
+        printf("Benchmark results (%dx%d, %d frames each):\n", g_width, g_height, g_benchmarkFrames);
+        for (const Phase& phase : phases) {
+            printf("  %-9s  CPU record %.3f ms/frame  texture uploads %.2f/frame\n", phase.name,
+                   phase.recordMs / phase.frames, static_cast<double>(phase.uploads) / phase.frames);
+        }
+    }
+};
+
+// Parse command line flags (see usage at the top of this file)
+bool parseArgs(int argc, char** argv) {
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--frames-in-flight=", 19) == 0) {
+            g_framesInFlight = atoi(argv[i] + 19);
+            if (g_framesInFlight < 1 || g_framesInFlight > 3) {
+                fprintf(stderr, "--frames-in-flight must be 1, 2 or 3\n");
+                return false;
+            }
+        } else if (strncmp(argv[i], "--recorders=", 12) == 0) {
+            g_recorderThreads = atoi(argv[i] + 12);
+            if (g_recorderThreads < 1 || g_recorderThreads > 64) {
+                fprintf(stderr, "--recorders must be between 1 and 64\n");
+                return false;
+            }
+        } else if (strncmp(argv[i], "--pipeline-cache=", 17) == 0) {
+            g_pipelineCacheDir = argv[i] + 17;
+        } else if (strcmp(argv[i], "--no-pipeline-cache") == 0) {
+            g_usePipelineCache = false;
+        } else if (strcmp(argv[i], "--precompile=sync") == 0) {
+            g_precompileInBackground = false;
+        } else if (strcmp(argv[i], "--precompile=background") == 0) {
+            g_precompileInBackground = true;
+        } else if (strncmp(argv[i], "--present-mode=", 15) == 0) {
+            const char* mode = argv[i] + 15;
+            g_lowestLatencyPresentMode = false;
+            if (strcmp(mode, "fifo") == 0) {
+                g_requestedPresentMode = wgpu::PresentMode::Fifo;
+            } else if (strcmp(mode, "fifo-relaxed") == 0) {
+                g_requestedPresentMode = wgpu::PresentMode::FifoRelaxed;
+            } else if (strcmp(mode, "mailbox") == 0) {
+                g_requestedPresentMode = wgpu::PresentMode::Mailbox;
+            } else if (strcmp(mode, "immediate") == 0) {
+                g_requestedPresentMode = wgpu::PresentMode::Immediate;
+            } else if (strcmp(mode, "low-latency") == 0) {
+                g_lowestLatencyPresentMode = true;
+            } else {
+                fprintf(stderr, "--present-mode must be fifo, fifo-relaxed, mailbox, immediate or low-latency\n");
+                return false;
+            }
+        } else if (strcmp(argv[i], "--scene=immediate") == 0) {
+            g_useRetainedScene = false;
+        } else if (strcmp(argv[i], "--scene=retained") == 0) {
+            g_useRetainedScene = true;
+        } else if (strncmp(argv[i], "--benchmark=", 12) == 0) {
+            g_benchmarkFrames = atoi(argv[i] + 12);
+            if (g_benchmarkFrames < 1) {
+                fprintf(stderr, "--benchmark must be at least 1 frame\n");
+                return false;
+            }
+        } else if (strncmp(argv[i], "--trace=", 8) == 0) {
+            g_traceOutput = argv[i] + 8;
+        } else if (strncmp(argv[i], "--trace-categories=", 19) == 0) {
+            g_traceCategories = argv[i] + 19;
+        } else if (strcmp(argv[i], "--tracy") == 0) {
+            g_traceWithTracy = true;
+        } else {
+            fprintf(stderr, "Unknown argument: %s\n", argv[i]);
+            fprintf(stderr, "Usage: %s [--frames-in-flight=N] [--recorders=N] [--pipeline-cache=DIR]\n"
+                            "          [--no-pipeline-cache] [--precompile=sync|background]\n"
+                            "          [--scene=immediate|retained] [--benchmark=N]\n"
+                            "          [--trace=FILE] [--trace-categories=LIST] [--tracy]\n"
+                            "          [--present-mode=fifo|fifo-relaxed|mailbox|immediate|low-latency]\n", argv[0]);
+            return false;
+        }
+    }
+    return true;
 }
 
-int main() {
+int main(int argc, char** argv) {
+    g_startTime = std::chrono::steady_clock::now();
     printf("Skia Graphite Native Example\n");
     printf("============================\n");
 
+    if (!parseArgs(argc, argv) || !startTracing()) {
+        return 1;
+    }
+
     // Initialize GLFW
     glfwSetErrorCallback(glfwErrorCallback);
     if (!glfwInit()) {
@@ -591,12 +1414,51 @@ int main() {
         return 1;
     }
 
+    if (g_recorderThreads > 1) {
+        if (!g_recorderPool.init(g_recorderThreads)) {
+            cleanup();
+            return 1;
+        }
+        printf("Recording with %d parallel recorders\n", g_recorderThreads);
+    }
+
+    if (g_framesInFlight > 1 && !startPipeline()) {
+        cleanup();
+        return 1;
+    }
+
+    if (g_useRetainedScene) {
+        g_retainedScene = std::make_unique<RetainedScene>();
+    }
+
+    SceneBenchmark benchmark;
+    if (g_benchmarkFrames > 0) {
+        benchmark.start();
+    }
+
     // Main loop
     printf("Starting main loop...\n");
+    bool firstFrame = true;
     while (!glfwWindowShouldClose(g_window)) {
+        EXAMPLE_TRACE_SCOPE("frame");
         glfwPollEvents();
 
-        render();
+        if (g_framesInFlight > 1) {
+            renderPipelined();
+        } else {
+            render();
+        }
+
+        // With frames in flight this measures the first frame handed to the submit thread
+        if (firstFrame) {
+            firstFrame = false;
+            printf("Time to first frame: %.1f ms (pipeline cache: %s)\n", msSince(g_startTime),
+                   !g_usePipelineCache ? "disabled" : g_pipelineCache.isWarm() ? "warm" : "cold");
+        }
+
+        if (g_benchmarkFrames > 0 && !benchmark.finished && !benchmark.addFrame()) {
+            glfwSetWindowShouldClose(g_window, GLFW_TRUE);
+        }
 
         // Update animation time (~60fps)
         g_time += 0.016f;
@@ -1,3 +1,36 @@
+/**
+ * Skia CPU Example
+ *
+ * Draws the Skia logo with the raster backend and writes it as a PNG.
+ *
+ * Usage: example [--batch=N] [--gpu] [--out=DIR] [--zlib-level=N]
+ *                [--tiled[=THREADS]] [--size=WxH] [--tile=N] [--frames=N]
+ *
+ *   (no arguments)   Render once and write output.png
+ *   --batch=N        Thumbnail-server style batch: render N jobs into one
+ *                    preallocated pixel buffer and encode each PNG straight into
+ *                    an SkWStream (no intermediate SkData); reports images/second
+ *   --gpu            Render batch jobs with Graphite and read back with
+ *                    asyncRescaleAndReadPixels, encoding from the mapped readback
+ *                    buffer (only in builds with SK_GRAPHITE, target batch-render)
+ *   --out=DIR        Write batch results to DIR/job_NNNNN.png; by default every job
+ *                    is encoded into the same preallocated output buffer
+ *   --zlib-level=N   PNG compression level 0-9 (default 6)
+ *   --tiled[=N]      Record the logo once into an SkPicture and play it back on N
+ *                    threads (default: all cores), one tile per task, each drawing
+ *                    straight into its region of one shared pixmap. The result is
+ *                    checked bit-for-bit against a single-threaded render and
+ *                    written to output.png
+ *   --size=WxH       Output size for --tiled; the logo is scaled to fit
+ *                    (default 816x464)
+ *   --tile=N         Square tile size in pixels for --tiled (default 256)
+ *   --frames=N       Render N frames at --size (with --tiled: record and play back
+ *                    tiled every frame) and report frame-time percentiles instead
+ *                    of writing output.png. Used to compare WebAssembly builds
+ *                    (make bench-wasm)
+ */
+
+#include "bench_util.h"
 #include "include/core/SkCanvas.h"
 #include "include/core/SkBitmap.h"
 #include "include/core/SkColor.h"
@@ -5,11 +38,29 @@
 #include "include/core/SkPath.h"
 #include "include/core/SkRRect.h"
 #include "include/core/SkImage.h"
-#include "include/core/SkData.h"
 #include "include/effects/SkGradientShader.h"
+#include "include/core/SkPicture.h"
+#include "include/core/SkPictureRecorder.h"
+#include "include/core/SkStream.h"
 #include "include/encode/SkPngEncoder.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
-#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(SK_GRAPHITE)
+#include "headless_graphite.h"
+#include "include/core/SkSurface.h"
+#include "include/gpu/graphite/Context.h"
+#include "include/gpu/graphite/Recording.h"
+#endif
 
 void draw(SkCanvas* canvas) {
     canvas->scale(4.0f, 4.0f);
@@ -107,10 +158,414 @@ void draw(SkCanvas* canvas) {
     }
 }
 
-int main() {
+static const int kWidth = 816;
+static const int kHeight = 464;
+
+// SkWStream over caller-owned memory (a preallocated response buffer or an mmap'd
+// output file). Writing past the end fails instead of allocating.
+class FixedBufferWStream : public SkWStream {
+public:
+    FixedBufferWStream(void* buffer, size_t size)
+        : fBuffer(static_cast<uint8_t*>(buffer)), fSize(size) {}
+
+    bool write(const void* data, size_t size) override {
+        if (size > fSize - fOffset) {
+            return false;
+        }
+        memcpy(fBuffer + fOffset, data, size);
+        fOffset += size;
+        return true;
+    }
+
+    size_t bytesWritten() const override { return fOffset; }
+
+    void reset() { fOffset = 0; }
+
+private:
+    uint8_t* fBuffer;
+    size_t fSize;
+    size_t fOffset = 0;
+};
+
+// Destination for encoded batch jobs: one reused memory buffer, or a file per job
+class JobOutput {
+public:
+    JobOutput(const std::string& dir, size_t bufferSize, const SkPngEncoder::Options& options)
+        : fDir(dir), fBuffer(dir.empty() ? bufferSize : 0), fMemory(fBuffer.data(), fBuffer.size()),
+          fOptions(options) {}
+
+    // Encode `pixmap` as the PNG for `job`
+    bool encode(int job, const SkPixmap& pixmap) {
+        if (fDir.empty()) {
+            fMemory.reset();
+            bool ok = SkPngEncoder::Encode(&fMemory, pixmap, fOptions);
+            fTotalBytes += fMemory.bytesWritten();
+            return ok;
+        }
+
+        char name[32];
+        snprintf(name, sizeof(name), "/job_%05d.png", job);
+        SkFILEWStream file((fDir + name).c_str());
+        if (!file.isValid()) {
+            std::cerr << "Failed to open " << fDir << name << std::endl;
+            return false;
+        }
+        bool ok = SkPngEncoder::Encode(&file, pixmap, fOptions);
+        fTotalBytes += file.bytesWritten();
+        return ok;
+    }
+
+    size_t totalBytes() const { return fTotalBytes; }
+
+private:
+    std::string fDir;
+    std::vector<uint8_t> fBuffer;
+    FixedBufferWStream fMemory;
+    SkPngEncoder::Options fOptions;
+    size_t fTotalBytes = 0;
+};
+
+static void reportBatch(const char* path, int jobs, double ms, const JobOutput& output) {
+    printf("%s: %d images in %.1f ms (%.1f images/s, %.1f KB/image)\n", path, jobs, ms,
+           jobs / (ms / 1000.0), output.totalBytes() / 1024.0 / jobs);
+}
+
+// Raster batch: one pixel buffer and one canvas for every job
+static bool runRasterBatch(int jobs, JobOutput* output) {
+    SkBitmap bitmap;
+    bitmap.allocN32Pixels(kWidth, kHeight);
+    SkCanvas canvas(bitmap);
+
+    auto start = std::chrono::steady_clock::now();
+    for (int job = 0; job < jobs; job++) {
+        canvas.save();
+        draw(&canvas);
+        canvas.restore();
+        if (!output->encode(job, bitmap.pixmap())) {
+            std::cerr << "Failed to encode job " << job << std::endl;
+            return false;
+        }
+    }
+    reportBatch("Raster", jobs, msSince(start), *output);
+    return true;
+}
+
+#if defined(SK_GRAPHITE)
+// A GPU job whose readback is outstanding. The readback callback encodes directly
+// from Graphite's mapped transfer buffer, so pixels are never copied on the CPU.
+struct GpuJob {
+    sk_sp<SkSurface> surface;
+    JobOutput* output = nullptr;
+    int job = 0;
+    bool pending = false;
+    bool ok = true;
+};
+
+static void readbackFinished(SkImage::ReadPixelsContext context,
+                             std::unique_ptr<const SkImage::AsyncReadResult> result) {
+    GpuJob* gpuJob = static_cast<GpuJob*>(context);
+    gpuJob->pending = false;
+    if (!result) {
+        gpuJob->ok = false;
+        return;
+    }
+    SkPixmap pixmap(gpuJob->surface->imageInfo(), result->data(0), result->rowBytes(0));
+    gpuJob->ok = gpuJob->output->encode(gpuJob->job, pixmap);
+}
+
+// Graphite batch: a few surfaces in rotation so drawing job N overlaps the
+// readback and encode of the jobs before it
+static bool runGpuBatch(int jobs, JobOutput* output) {
+    const int kJobsInFlight = 3;
+
+    HeadlessGraphite graphite;
+    if (!graphite.init(HeadlessGraphite::Options())) {
+        return false;
+    }
+    printf("Adapter: %s\n", graphite.adapterName().c_str());
+    skgpu::graphite::Context* context = graphite.context();
+
+    GpuJob slots[kJobsInFlight];
+    for (GpuJob& slot : slots) {
+        slot.surface = graphite.makeSurface(kWidth, kHeight);
+        slot.output = output;
+        if (!slot.surface) {
+            return false;
+        }
+    }
+
+    // Run the slot's readback callback once its GPU work is done. The map of the
+    // transfer buffer resolves on the next event pass; if it has not, a blocking
+    // submit waits for it rather than polling.
+    auto finishReadback = [&](const GpuJob& slot) {
+        if (slot.pending) {
+            graphite.processEvents();
+            context->checkAsyncWorkCompletion();
+        }
+        if (slot.pending) {
+            context->submit(skgpu::graphite::SyncToCpu::kYes);
+        }
+    };
+
+    bool ok = true;
+    auto start = std::chrono::steady_clock::now();
+    for (int job = 0; job < jobs && ok; job++) {
+        GpuJob& slot = slots[job % kJobsInFlight];
+        // Slots rotate in submission order, so the oldest job in flight is this slot's
+        graphite.waitForFrameSlot(kJobsInFlight);
+        finishReadback(slot);
+        ok = slot.ok;
+
+        SkCanvas* canvas = slot.surface->getCanvas();
+        canvas->save();
+        draw(canvas);
+        canvas->restore();
+
+        std::unique_ptr<skgpu::graphite::Recording> recording = graphite.recorder()->snap();
+        skgpu::graphite::InsertRecordingInfo info;
+        info.fRecording = recording.get();
+        if (!recording || !context->insertRecording(info)) {
+            std::cerr << "Failed to insert recording for job " << job << std::endl;
+            ok = false;
+            break;
+        }
+
+        slot.job = job;
+        slot.pending = true;
+        context->asyncRescaleAndReadPixels(slot.surface.get(), slot.surface->imageInfo(),
+                                           SkIRect::MakeWH(kWidth, kHeight),
+                                           SkImage::RescaleGamma::kSrc, SkImage::RescaleMode::kNearest,
+                                           readbackFinished, &slot);
+        context->submit(skgpu::graphite::SyncToCpu::kNo);
+        graphite.frameSubmitted();
+    }
+
+    graphite.waitForFrameSlot(1);
+    for (GpuJob& slot : slots) {
+        finishReadback(slot);
+        ok = ok && slot.ok;
+    }
+    if (!ok) {
+        std::cerr << "GPU batch failed" << std::endl;
+        return false;
+    }
+    reportBatch("Graphite", jobs, msSince(start), *output);
+    return true;
+}
+#endif
+
+// Draw the logo scaled from its native 816x464 to width x height
+static void drawScaled(SkCanvas* canvas, int width, int height) {
+    canvas->save();
+    canvas->scale(width / static_cast<float>(kWidth), height / static_cast<float>(kHeight));
+    draw(canvas);
+    canvas->restore();
+}
+
+// Play `picture` back into `pixels` on `threadCount` threads. Tiles are handed out
+// through an atomic counter; each task wraps its sub-rectangle of the shared pixmap
+// in a raster canvas (no per-tile buffers or copies), translates so the tile's
+// origin maps to (0, 0) and clips to the tile.
+static void playbackTiled(const SkPicture* picture, const SkPixmap& pixels, int tileSize, int threadCount) {
+    int tilesX = (pixels.width() + tileSize - 1) / tileSize;
+    int tilesY = (pixels.height() + tileSize - 1) / tileSize;
+    int tileCount = tilesX * tilesY;
+    std::atomic<int> nextTile{0};
+
+    auto worker = [&] {
+        for (int tile = nextTile++; tile < tileCount; tile = nextTile++) {
+            SkIRect bounds = SkIRect::MakeXYWH((tile % tilesX) * tileSize, (tile / tilesX) * tileSize,
+                                               tileSize, tileSize);
+            SkPixmap region;
+            if (!pixels.extractSubset(&region, bounds)) {
+                continue;
+            }
+            std::unique_ptr<SkCanvas> canvas =
+                    SkCanvas::MakeRasterDirect(region.info(), region.writable_addr(), region.rowBytes());
+            canvas->translate(-bounds.x(), -bounds.y());
+            canvas->clipRect(SkRect::Make(bounds));
+            canvas->drawPicture(picture);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (int i = 1; i < threadCount; i++) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+}
+
+// Tiled multithreaded render, verified against the single-threaded output
+static bool runTiled(int width, int height, int tileSize, int threadCount, const SkPngEncoder::Options& options) {
+    SkImageInfo info = SkImageInfo::MakeN32Premul(width, height);
+
+    // Reference: the plain single-threaded draw
+    SkBitmap reference;
+    reference.allocPixels(info);
+    auto singleStart = std::chrono::steady_clock::now();
+    {
+        SkCanvas canvas(reference);
+        drawScaled(&canvas, width, height);
+    }
+    double singleMs = msSince(singleStart);
+
+    // Record once; playback is thread-safe on an immutable SkPicture
+    auto recordStart = std::chrono::steady_clock::now();
+    SkPictureRecorder recorder;
+    drawScaled(recorder.beginRecording(SkRect::MakeIWH(width, height)), width, height);
+    sk_sp<SkPicture> picture = recorder.finishRecordingAsPicture();
+    double recordMs = msSince(recordStart);
+
+    SkBitmap tiled;
+    tiled.allocPixels(info);
+    auto tiledStart = std::chrono::steady_clock::now();
+    playbackTiled(picture.get(), tiled.pixmap(), tileSize, threadCount);
+    double tiledMs = msSince(tiledStart);
+
+    printf("Single-threaded: %.2f ms\n", singleMs);
+    printf("Tiled (%d threads, %dpx tiles): %.2f ms playback + %.2f ms record (%.2fx)\n",
+           threadCount, tileSize, tiledMs, recordMs, singleMs / tiledMs);
+
+    for (int y = 0; y < height; y++) {
+        if (memcmp(reference.getAddr32(0, y), tiled.getAddr32(0, y), width * sizeof(uint32_t)) != 0) {
+            std::cerr << "Tiled output differs from single-threaded output at row " << y << std::endl;
+            return false;
+        }
+    }
+    printf("Tiled output is bit-identical to single-threaded output\n");
+
+    SkFILEWStream out("output.png");
+    if (!out.isValid() || !SkPngEncoder::Encode(&out, tiled.pixmap(), options)) {
+        std::cerr << "Failed to write output.png" << std::endl;
+        return false;
+    }
+    std::cout << "Image saved as output.png" << std::endl;
+    return true;
+}
+
+// Frame-time mode: the same render as --tiled (or the single-threaded draw) run
+// `frames` times after a short warm-up, with per-frame p50/p95/max
+static bool runFrames(int frames, int width, int height, int tileSize, int threadCount) {
+    const int kWarmupFrames = 10;
+
+    SkBitmap bitmap;
+    bitmap.allocPixels(SkImageInfo::MakeN32Premul(width, height));
+
+    std::vector<double> times;
+    times.reserve(frames);
+    for (int frame = -kWarmupFrames; frame < frames; frame++) {
+        auto start = std::chrono::steady_clock::now();
+        if (threadCount > 0) {
+            SkPictureRecorder recorder;
+            drawScaled(recorder.beginRecording(SkRect::MakeIWH(width, height)), width, height);
+            sk_sp<SkPicture> picture = recorder.finishRecordingAsPicture();
+            playbackTiled(picture.get(), bitmap.pixmap(), tileSize, threadCount);
+        } else {
+            SkCanvas canvas(bitmap);
+            drawScaled(&canvas, width, height);
+        }
+        if (frame >= 0) {
+            times.push_back(msSince(start));
+        }
+    }
+
+    std::sort(times.begin(), times.end());
+    double total = 0.0;
+    for (double t : times) {
+        total += t;
+    }
+
+    // What the WebAssembly build was compiled with (-variant simd-mt sets both)
+#if defined(__wasm_simd128__)
+    const char* simd = "simd128";
+#else
+    const char* simd = "scalar";
+#endif
+#if defined(__EMSCRIPTEN__) && !defined(__EMSCRIPTEN_PTHREADS__)
+    const char* threads = "no threads";
+#else
+    const char* threads = "threads";
+#endif
+    printf("Build: %s, %s\n", simd, threads);
+    if (threadCount > 0) {
+        printf("Mode: tiled, %d threads, %dpx tiles\n", threadCount, tileSize);
+    } else {
+        printf("Mode: single-threaded\n");
+    }
+    printf("Frames: %d at %dx%d: mean %.2f ms, p50 %.2f ms, p95 %.2f ms, max %.2f ms\n", frames, width,
+           height, total / frames, nearestRank(times, 0.50), nearestRank(times, 0.95), times.back());
+    return true;
+}
+
+int main(int argc, char** argv) {
+    int batchJobs = 0;
+    bool useGpu = false;
+    std::string outDir;
+    SkPngEncoder::Options options;
+    int tiledThreads = 0;
+    int tiledWidth = kWidth;
+    int tiledHeight = kHeight;
+    int tileSize = 256;
+    int frames = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--batch=", 8) == 0) {
+            batchJobs = atoi(argv[i] + 8);
+        } else if (strcmp(argv[i], "--gpu") == 0) {
+            useGpu = true;
+        } else if (strncmp(argv[i], "--out=", 6) == 0) {
+            outDir = argv[i] + 6;
+        } else if (strncmp(argv[i], "--zlib-level=", 13) == 0) {
+            options.fZLibLevel = atoi(argv[i] + 13);
+        } else if (strcmp(argv[i], "--tiled") == 0) {
+            tiledThreads = std::max(1u, std::thread::hardware_concurrency());
+        } else if (strncmp(argv[i], "--tiled=", 8) == 0) {
+            tiledThreads = std::max(1, atoi(argv[i] + 8));
+        } else if (strncmp(argv[i], "--size=", 7) == 0) {
+            if (sscanf(argv[i] + 7, "%dx%d", &tiledWidth, &tiledHeight) != 2 || tiledWidth < 1 || tiledHeight < 1) {
+                std::cerr << "--size must look like 8160x4640" << std::endl;
+                return 1;
+            }
+        } else if (strncmp(argv[i], "--tile=", 7) == 0) {
+            tileSize = std::max(16, atoi(argv[i] + 7));
+        } else if (strncmp(argv[i], "--frames=", 9) == 0) {
+            frames = std::max(1, atoi(argv[i] + 9));
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--batch=N] [--gpu] [--out=DIR] [--zlib-level=N]\n"
+                      << "       [--tiled[=THREADS]] [--size=WxH] [--tile=N] [--frames=N]" << std::endl;
+            return 1;
+        }
+    }
+
+    if (frames > 0) {
+        return runFrames(frames, tiledWidth, tiledHeight, tileSize, tiledThreads) ? 0 : 1;
+    }
+
+    if (tiledThreads > 0) {
+        return runTiled(tiledWidth, tiledHeight, tileSize, tiledThreads, options) ? 0 : 1;
+    }
+
+    if (batchJobs > 0) {
+        // Worst case PNG size is a little over the raw pixel size
+        JobOutput output(outDir, 2 * SkImageInfo::MakeN32Premul(kWidth, kHeight).computeMinByteSize() + 64 * 1024,
+                         options);
+        if (useGpu) {
+#if defined(SK_GRAPHITE)
+            return runGpuBatch(batchJobs, &output) ? 0 : 1;
+#else
+            std::cerr << "--gpu needs a Graphite build (target batch-render)" << std::endl;
+            return 1;
+#endif
+        }
+        return runRasterBatch(batchJobs, &output) ? 0 : 1;
+    }
+
     // Create a bitmap
     SkBitmap bitmap;
-    bitmap.allocN32Pixels(816, 464);
+    bitmap.allocN32Pixels(kWidth, kHeight);
 
     // Create a canvas from the bitmap
     SkCanvas canvas(bitmap);
@@ -118,22 +573,16 @@ int main() {
     // Draw the skia logo
     draw(&canvas);
 
-    // Encode the bitmap as a PNG
-    sk_sp<SkData> png_data = SkPngEncoder::Encode(nullptr, bitmap.asImage().get(), SkPngEncoder::Options());
-
-    if (!png_data) {
-        std::cerr << "Failed to encode image" << std::endl;
+    // Encode the bitmap as a PNG straight into the output file
+    SkFILEWStream out("output.png");
+    if (!out.isValid()) {
+        std::cerr << "Failed to open output file" << std::endl;
         return 1;
     }
-
-    // Save the PNG data to a file
-    std::ofstream out("output.png", std::ios::binary);
-    if (!out) {
-        std::cerr << "Failed to open output file" << std::endl;
+    if (!SkPngEncoder::Encode(&out, bitmap.pixmap(), options)) {
+        std::cerr << "Failed to encode image" << std::endl;
         return 1;
     }
-    out.write(reinterpret_cast<const char*>(png_data->data()), png_data->size());
-    out.close();
 
     std::cout << "Image saved as output.png" << std::endl;
     return 0;
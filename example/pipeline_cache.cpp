@@ -0,0 +1,217 @@
+/**
+ * Persistent pipeline cache for the native Graphite example
+ * See pipeline_cache.h for the on-disk layout.
+ */
+
+#include "pipeline_cache.h"
+
+#include "include/gpu/graphite/PrecompileContext.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+
+#if defined(_WIN32)
+#include <process.h>
+#define getpid _getpid
+#else
+#include <unistd.h>
+#endif
+
+namespace {
+
+const char kPipelineKeysFile[] = "graphite_pipelines.bin";
+
+// FNV-1a, used for file names and key de-duplication (not for integrity)
+uint64_t hashBytes(const void* data, size_t size, uint64_t hash = 0xcbf29ce484222325ull) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+std::string toString(wgpu::StringView view) {
+    return view.data ? std::string(view.data, view.length) : std::string();
+}
+
+}  // namespace
+
+bool PipelineCache::open(const std::string& rootDir, const wgpu::AdapterInfo& adapterInfo,
+                         const char* skiaRevision) {
+    fCacheKey = toString(adapterInfo.vendor) + "|" +
+                toString(adapterInfo.architecture) + "|" +
+                toString(adapterInfo.device) + "|" +
+                toString(adapterInfo.description) + "|" +
+                std::to_string(static_cast<int>(adapterInfo.backendType)) + "|" +
+                std::to_string(adapterInfo.vendorID) + ":" + std::to_string(adapterInfo.deviceID) + "|" +
+                skiaRevision;
+
+    char dirName[32];
+    snprintf(dirName, sizeof(dirName), "%016llx",
+             static_cast<unsigned long long>(hashBytes(fCacheKey.data(), fCacheKey.size())));
+    fDir = (std::filesystem::path(rootDir) / dirName).string();
+
+    std::error_code ec;
+    std::filesystem::create_directories(std::filesystem::path(fDir) / "dawn", ec);
+    if (ec) {
+        fprintf(stderr, "Failed to create pipeline cache directory %s: %s\n", fDir.c_str(), ec.message().c_str());
+        return false;
+    }
+
+    // Load Graphite pipeline keys: a sequence of [uint32 size][size bytes] records
+    std::string keysPath = (std::filesystem::path(fDir) / kPipelineKeysFile).string();
+    if (FILE* f = fopen(keysPath.c_str(), "rb")) {
+        uintmax_t fileSize = std::filesystem::file_size(keysPath, ec);
+        uintmax_t validBytes = 0;
+        uint32_t size = 0;
+        while (!ec && fread(&size, sizeof(size), 1, f) == 1) {
+            // A size past the end of the file means a corrupt or truncated record;
+            // check before allocating so garbage cannot force a huge allocation
+            if (size > fileSize - validBytes - sizeof(size)) {
+                break;
+            }
+            sk_sp<SkData> key = SkData::MakeUninitialized(size);
+            if (fread(key->writable_data(), 1, size, f) != size) {
+                break;
+            }
+            validBytes += sizeof(size) + size;
+            if (fKnownKeyHashes.insert(hashBytes(key->data(), key->size())).second) {
+                fLoadedKeys.push_back(std::move(key));
+            }
+        }
+        fclose(f);
+        // Drop whatever follows the last good record so new keys append after it
+        if (!ec && validBytes < fileSize) {
+            std::filesystem::resize_file(keysPath, validBytes, ec);
+        }
+        ec.clear();
+    }
+
+    fWarm = !fLoadedKeys.empty() ||
+            !std::filesystem::is_empty(std::filesystem::path(fDir) / "dawn", ec);
+
+    printf("Pipeline cache: %s (%s, %zu Graphite pipeline keys)\n",
+           fDir.c_str(), fWarm ? "warm" : "cold", fLoadedKeys.size());
+    return true;
+}
+
+void PipelineCache::attachToDevice(wgpu::DeviceDescriptor* deviceDesc,
+                                   wgpu::DawnCacheDeviceDescriptor* cacheDesc) {
+    cacheDesc->isolationKey = fCacheKey.c_str();
+    cacheDesc->loadDataFunction = LoadDawnData;
+    cacheDesc->storeDataFunction = StoreDawnData;
+    cacheDesc->functionUserdata = this;
+    cacheDesc->nextInChain = deviceDesc->nextInChain;
+    deviceDesc->nextInChain = cacheDesc;
+}
+
+void PipelineCache::attachToContextOptions(skgpu::graphite::ContextOptions* options) {
+    options->fPipelineCallbackContext = this;
+    options->fPipelineCallback = OnNewPipeline;
+}
+
+int PipelineCache::precompile(skgpu::graphite::PrecompileContext* precompileContext) {
+    int compiled = 0;
+    for (const sk_sp<SkData>& key : fLoadedKeys) {
+        if (precompileContext->precompile(key)) {
+            compiled++;
+        }
+    }
+    return compiled;
+}
+
+std::string PipelineCache::blobPath(const void* key, size_t keySize) const {
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.bin", static_cast<unsigned long long>(hashBytes(key, keySize)));
+    return (std::filesystem::path(fDir) / "dawn" / name).string();
+}
+
+// Dawn load contract: with a null/too small `value`, return the stored size;
+// otherwise copy the blob and return its size. Return 0 on a miss.
+size_t PipelineCache::LoadDawnData(const void* key, size_t keySize, void* value, size_t valueSize,
+                                   void* userdata) {
+    PipelineCache* cache = static_cast<PipelineCache*>(userdata);
+    std::string path = cache->blobPath(key, keySize);
+
+    FILE* f = fopen(path.c_str(), "rb");
+    if (!f) {
+        return 0;
+    }
+
+    // Blob files are [uint32 key size][key][value]; the stored key guards against hash collisions
+    size_t result = 0;
+    uint32_t storedKeySize = 0;
+    if (fread(&storedKeySize, sizeof(storedKeySize), 1, f) == 1 && storedKeySize == keySize) {
+        std::vector<uint8_t> storedKey(keySize);
+        if (fread(storedKey.data(), 1, keySize, f) == keySize &&
+            memcmp(storedKey.data(), key, keySize) == 0) {
+            long dataStart = ftell(f);
+            fseek(f, 0, SEEK_END);
+            size_t storedSize = static_cast<size_t>(ftell(f) - dataStart);
+            if (value == nullptr || valueSize < storedSize) {
+                result = storedSize;
+            } else {
+                fseek(f, dataStart, SEEK_SET);
+                result = fread(value, 1, storedSize, f) == storedSize ? storedSize : 0;
+            }
+        }
+    }
+    fclose(f);
+    return result;
+}
+
+void PipelineCache::StoreDawnData(const void* key, size_t keySize, const void* value, size_t valueSize,
+                                  void* userdata) {
+    PipelineCache* cache = static_cast<PipelineCache*>(userdata);
+    std::string path = cache->blobPath(key, keySize);
+
+    // Write to a temp file and rename so a concurrent load never sees a partial blob.
+    // Dawn may store from several threads (and other processes may share the cache),
+    // so each store gets its own temp name.
+    static std::atomic<uint32_t> sTmpCounter{0};
+    char tmpSuffix[48];
+    snprintf(tmpSuffix, sizeof(tmpSuffix), ".%d.%u.tmp", static_cast<int>(getpid()), sTmpCounter++);
+    std::string tmpPath = path + tmpSuffix;
+    FILE* f = fopen(tmpPath.c_str(), "wb");
+    if (!f) {
+        return;
+    }
+    uint32_t storedKeySize = static_cast<uint32_t>(keySize);
+    bool ok = fwrite(&storedKeySize, sizeof(storedKeySize), 1, f) == 1 &&
+              fwrite(key, 1, keySize, f) == keySize &&
+              fwrite(value, 1, valueSize, f) == valueSize;
+    fclose(f);
+
+    std::error_code ec;
+    if (ok) {
+        std::filesystem::rename(tmpPath, path, ec);
+    }
+    if (!ok || ec) {
+        std::filesystem::remove(tmpPath, ec);
+    }
+}
+
+// Graphite may create pipelines from any Recorder or precompile thread
+void PipelineCache::OnNewPipeline(void* context, sk_sp<SkData> pipelineData) {
+    PipelineCache* cache = static_cast<PipelineCache*>(context);
+    if (!pipelineData) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(cache->fMutex);
+    if (!cache->fKnownKeyHashes.insert(hashBytes(pipelineData->data(), pipelineData->size())).second) {
+        return;
+    }
+
+    // Append immediately so keys survive a crash or a killed process
+    std::string keysPath = (std::filesystem::path(cache->fDir) / kPipelineKeysFile).string();
+    if (FILE* f = fopen(keysPath.c_str(), "ab")) {
+        uint32_t size = static_cast<uint32_t>(pipelineData->size());
+        fwrite(&size, sizeof(size), 1, f);
+        fwrite(pipelineData->data(), 1, size, f);
+        fclose(f);
+    }
+}
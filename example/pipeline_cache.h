@@ -0,0 +1,79 @@
+/**
+ * Persistent pipeline cache for the native Graphite example
+ *
+ * Two layers are persisted under <root>/<cache key hash>/:
+ *   - dawn/      Dawn's blob cache (compiled shaders and pipeline objects), wired
+ *                up through wgpu::DawnCacheDeviceDescriptor load/store callbacks
+ *   - graphite_pipelines.bin
+ *                Serialized Graphite pipeline keys reported by
+ *                ContextOptions::fPipelineCallback; replayed through a
+ *                PrecompileContext at startup so pipelines exist before first use
+ *
+ * The cache key combines the adapter identity with the Skia revision, so a driver
+ * update, a different GPU or a new Skia build starts from an empty cache.
+ */
+
+#ifndef PIPELINE_CACHE_H
+#define PIPELINE_CACHE_H
+
+#include "dawn/webgpu_cpp.h"
+#include "include/core/SkData.h"
+#include "include/gpu/graphite/ContextOptions.h"
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace skgpu::graphite {
+class PrecompileContext;
+}
+
+class PipelineCache {
+public:
+    /**
+     * Opens (creating if needed) the cache directory for this adapter and Skia revision.
+     * Loads previously recorded Graphite pipeline keys.
+     * @return false if the cache directory could not be created
+     */
+    bool open(const std::string& rootDir, const wgpu::AdapterInfo& adapterInfo, const char* skiaRevision);
+
+    /** True if an earlier run left pipeline keys or Dawn blobs behind. */
+    bool isWarm() const { return fWarm; }
+
+    /** Number of Graphite pipeline keys loaded from disk. */
+    size_t pipelineKeyCount() const { return fLoadedKeys.size(); }
+
+    /**
+     * Chains Dawn blob cache callbacks into `deviceDesc`. `cacheDesc` must outlive
+     * device creation.
+     */
+    void attachToDevice(wgpu::DeviceDescriptor* deviceDesc, wgpu::DawnCacheDeviceDescriptor* cacheDesc);
+
+    /** Installs the pipeline callback that records new Graphite pipeline keys. */
+    void attachToContextOptions(skgpu::graphite::ContextOptions* options);
+
+    /**
+     * Compiles every pipeline key loaded by open(). Safe to call from a background
+     * thread; the PrecompileContext must outlive the call.
+     * @return the number of pipelines successfully precompiled
+     */
+    int precompile(skgpu::graphite::PrecompileContext* precompileContext);
+
+private:
+    static size_t LoadDawnData(const void* key, size_t keySize, void* value, size_t valueSize, void* userdata);
+    static void StoreDawnData(const void* key, size_t keySize, const void* value, size_t valueSize, void* userdata);
+    static void OnNewPipeline(void* context, sk_sp<SkData> pipelineData);
+
+    std::string blobPath(const void* key, size_t keySize) const;
+
+    std::string fDir;
+    std::string fCacheKey;
+    bool fWarm = false;
+    std::mutex fMutex;
+    std::vector<sk_sp<SkData>> fLoadedKeys;
+    std::unordered_set<uint64_t> fKnownKeyHashes;
+};
+
+#endif // PIPELINE_CACHE_H
@@ -0,0 +1,274 @@
+/**
+ * Animated demo scene shared by the Graphite examples
+ * See scene.h for the immediate vs. retained variants.
+ */
+
+#include "scene.h"
+
+#include "include/core/SkCanvas.h"
+#include "include/core/SkColor.h"
+#include "include/core/SkPathBuilder.h"
+
+#include <cmath>
+#include <cstdio>
+
+// The two arrow-like quads drawn three times per frame
+static SkPath makeShapePath() {
+    SkPathBuilder pathBuilder;
+    pathBuilder.moveTo(75.0f, 0.0f);
+    pathBuilder.lineTo(150.0f, 50.0f);
+    pathBuilder.lineTo(150.0f, 100.0f);
+    pathBuilder.lineTo(75.0f, 50.0f);
+    pathBuilder.close();
+
+    pathBuilder.moveTo(75.0f, 50.0f);
+    pathBuilder.lineTo(150.0f, 100.0f);
+    pathBuilder.lineTo(150.0f, 150.0f);
+    pathBuilder.lineTo(75.0f, 100.0f);
+    pathBuilder.close();
+
+    return pathBuilder.detach();
+}
+
+// Conservative device bounds of each item, for skipping the ones outside
+// params.band. Outset by a pixel for anti-aliasing.
+static bool inBand(const SceneParams& params, SkRect bounds) {
+    return !params.band || params.band->intersects(bounds.makeOutset(1.0f, 1.0f));
+}
+
+// A shape and its shadow, drawn at (x, y) scaled by 1.5
+static SkRect shapeBounds(const SkPath& path, float x, float y) {
+    SkRect local = path.getBounds();
+    local.join(local.makeOffset(5.0f, 5.0f));
+    return SkRect::MakeLTRB(x + local.left() * 1.5f, y + local.top() * 1.5f,
+                            x + local.right() * 1.5f, y + local.bottom() * 1.5f);
+}
+
+// A line of text with its baseline at y; the width is taken as the whole frame
+static SkRect textLineBounds(const SceneParams& params, const SkFont& font, float y) {
+    return SkRect::MakeLTRB(0.0f, y - font.getSize(), params.width, y + font.getSize() * 0.5f);
+}
+
+// Draw animated content demonstrating Skia Graphite
+void drawSceneImmediate(SkCanvas* canvas, const SceneParams& params) {
+    canvas->clear(SK_ColorWHITE);
+
+    // Animated rotation for background
+    canvas->save();
+    canvas->translate(params.width / 2.0f, params.height / 2.0f);
+    canvas->rotate(params.time * 30.0f);
+    canvas->translate(-params.width / 2.0f, -params.height / 2.0f);
+
+    // Draw a gradient background
+    SkPaint bgPaint;
+    bgPaint.setColor(SkColorSetRGB(230, 235, 255));
+    canvas->drawRect(SkRect::MakeWH(params.width, params.height), bgPaint);
+
+    canvas->restore();
+
+    // Rebuilt every frame, so each frame sees a path with a new generation ID
+    SkPath path = makeShapePath();
+
+    // Draw multiple shapes with animation
+    for (int i = 0; i < 3; i++) {
+        float offsetX = 100 + i * 200 + sin(params.time + i) * 20;
+        float offsetY = 150 + cos(params.time * 0.5f + i) * 30;
+        if (!inBand(params, shapeBounds(path, offsetX, offsetY))) {
+            continue;
+        }
+
+        canvas->save();
+        canvas->translate(offsetX, offsetY);
+        canvas->scale(1.5f, 1.5f);
+
+        // Shadow
+        SkPaint shadowPaint;
+        shadowPaint.setColor(SkColorSetARGB(60, 0, 0, 0));
+        shadowPaint.setAntiAlias(true);
+        canvas->save();
+        canvas->translate(5, 5);
+        canvas->drawPath(path, shadowPaint);
+        canvas->restore();
+
+        // Main shape with solid color
+        SkPaint shapePaint;
+        shapePaint.setAntiAlias(true);
+        shapePaint.setColor(SkColorSetRGB(66, 133, 244));  // Blue
+        canvas->drawPath(path, shapePaint);
+
+        canvas->restore();
+    }
+
+    // Draw animated circles
+    for (int i = 0; i < 5; i++) {
+        float x = 100 + i * 150;
+        float y = 450 + sin(params.time * 2.0f + i * 0.5f) * 50;
+        float radius = 30 + sin(params.time * 3.0f + i) * 10;
+        if (!inBand(params, SkRect::MakeLTRB(x - radius, y - radius, x + radius, y + radius))) {
+            continue;
+        }
+
+        SkPaint circlePaint;
+        circlePaint.setAntiAlias(true);
+        circlePaint.setColor(SkColorSetARGB(
+            180,
+            (int)(128 + 127 * sin(params.time + i)),
+            (int)(128 + 127 * cos(params.time + i * 0.7f)),
+            (int)(128 + 127 * sin(params.time * 0.5f + i))
+        ));
+        canvas->drawCircle(x, y, radius, circlePaint);
+    }
+
+    // Draw rounded rectangles
+    for (int i = 0; i < 4; i++) {
+        float x = 50 + i * 180;
+        float y = 300 + cos(params.time + i * 0.8f) * 30;
+        if (!inBand(params, SkRect::MakeXYWH(x, y, 120, 60))) {
+            continue;
+        }
+
+        SkPaint rectPaint;
+        rectPaint.setAntiAlias(true);
+        rectPaint.setColor(SkColorSetARGB(200,
+            (int)(128 + 127 * cos(params.time * 0.5f + i)),
+            200,
+            (int)(128 + 127 * sin(params.time * 0.3f + i))
+        ));
+
+        SkRRect rrect = SkRRect::MakeRectXY(
+            SkRect::MakeXYWH(x, y, 120, 60),
+            15, 15
+        );
+        canvas->drawRRect(rrect, rectPaint);
+    }
+
+    // Draw text
+    SkPaint textPaint;
+    textPaint.setColor(SK_ColorBLACK);
+    textPaint.setAntiAlias(true);
+
+    SkFont font;
+    font.setSize(24);
+
+    if (inBand(params, textLineBounds(params, font, 50))) {
+        canvas->drawString("Skia Graphite + Dawn (Native)", 50, 50, font, textPaint);
+    }
+
+    if (inBand(params, textLineBounds(params, font, 80))) {
+        char timeStr[64];
+        snprintf(timeStr, sizeof(timeStr), "Time: %.1f  Size: %dx%d", params.time, params.width, params.height);
+        canvas->drawString(timeStr, 50, 80, font, textPaint);
+    }
+
+    if (inBand(params, textLineBounds(params, font, 110))) {
+        canvas->drawString(params.backendLabel, 50, 110, font, textPaint);
+    }
+}
+
+RetainedScene::RetainedScene() {
+    fShape = makeShapePath();
+    fRoundRect = SkRRect::MakeRectXY(SkRect::MakeWH(120, 60), 15, 15);
+
+    fBackgroundPaint.setColor(SkColorSetRGB(230, 235, 255));
+
+    fShadowPaint.setColor(SkColorSetARGB(60, 0, 0, 0));
+    fShadowPaint.setAntiAlias(true);
+
+    fShapePaint.setAntiAlias(true);
+    fShapePaint.setColor(SkColorSetRGB(66, 133, 244));  // Blue
+
+    fCirclePaint.setAntiAlias(true);
+    fRectPaint.setAntiAlias(true);
+
+    fTextPaint.setColor(SK_ColorBLACK);
+    fTextPaint.setAntiAlias(true);
+
+    fFont.setSize(24);
+    fTitle = SkTextBlob::MakeFromString("Skia Graphite + Dawn (Native)", fFont);
+}
+
+void RetainedScene::draw(SkCanvas* canvas, const SceneParams& params) const {
+    canvas->clear(SK_ColorWHITE);
+
+    // Animated rotation for background
+    canvas->save();
+    canvas->translate(params.width / 2.0f, params.height / 2.0f);
+    canvas->rotate(params.time * 30.0f);
+    canvas->translate(-params.width / 2.0f, -params.height / 2.0f);
+    canvas->drawRect(SkRect::MakeWH(params.width, params.height), fBackgroundPaint);
+    canvas->restore();
+
+    // Same SkPath every frame: the generation ID never changes
+    for (int i = 0; i < 3; i++) {
+        float offsetX = 100 + i * 200 + sin(params.time + i) * 20;
+        float offsetY = 150 + cos(params.time * 0.5f + i) * 30;
+        if (!inBand(params, shapeBounds(fShape, offsetX, offsetY))) {
+            continue;
+        }
+
+        canvas->save();
+        canvas->translate(offsetX, offsetY);
+        canvas->scale(1.5f, 1.5f);
+
+        canvas->save();
+        canvas->translate(5, 5);
+        canvas->drawPath(fShape, fShadowPaint);
+        canvas->restore();
+
+        canvas->drawPath(fShape, fShapePaint);
+        canvas->restore();
+    }
+
+    // Only the color is per-frame; copying a pre-built paint keeps draw() thread-safe
+    SkPaint circlePaint = fCirclePaint;
+    for (int i = 0; i < 5; i++) {
+        float x = 100 + i * 150;
+        float y = 450 + sin(params.time * 2.0f + i * 0.5f) * 50;
+        float radius = 30 + sin(params.time * 3.0f + i) * 10;
+        if (!inBand(params, SkRect::MakeLTRB(x - radius, y - radius, x + radius, y + radius))) {
+            continue;
+        }
+
+        circlePaint.setColor(SkColorSetARGB(
+            180,
+            (int)(128 + 127 * sin(params.time + i)),
+            (int)(128 + 127 * cos(params.time + i * 0.7f)),
+            (int)(128 + 127 * sin(params.time * 0.5f + i))
+        ));
+        canvas->drawCircle(x, y, radius, circlePaint);
+    }
+
+    SkPaint rectPaint = fRectPaint;
+    for (int i = 0; i < 4; i++) {
+        float x = 50 + i * 180;
+        float y = 300 + cos(params.time + i * 0.8f) * 30;
+        if (!inBand(params, fRoundRect.rect().makeOffset(x, y))) {
+            continue;
+        }
+
+        rectPaint.setColor(SkColorSetARGB(200,
+            (int)(128 + 127 * cos(params.time * 0.5f + i)),
+            200,
+            (int)(128 + 127 * sin(params.time * 0.3f + i))
+        ));
+
+        canvas->save();
+        canvas->translate(x, y);
+        canvas->drawRRect(fRoundRect, rectPaint);
+        canvas->restore();
+    }
+
+    // Static text is shaped once into a blob; only the status line changes per frame
+    if (inBand(params, fTitle->bounds().makeOffset(50, 50))) {
+        canvas->drawTextBlob(fTitle, 50, 50, fTextPaint);
+    }
+
+    if (inBand(params, textLineBounds(params, fFont, 80))) {
+        char timeStr[64];
+        snprintf(timeStr, sizeof(timeStr), "Time: %.1f  Size: %dx%d", params.time, params.width, params.height);
+        canvas->drawString(timeStr, 50, 80, fFont, fTextPaint);
+    }
+    if (inBand(params, textLineBounds(params, fFont, 110))) {
+        canvas->drawString(params.backendLabel, 50, 110, fFont, fTextPaint);
+    }
+}
@@ -0,0 +1,63 @@
+/**
+ * Animated demo scene shared by the Graphite examples
+ *
+ * Two ways of drawing the same frame:
+ *   - drawSceneImmediate() rebuilds every path, paint, font and rrect each frame
+ *   - RetainedScene builds them once; per frame only transforms and colors change.
+ *     Reusing the same SkPath keeps its generation ID stable, which lets
+ *     Graphite's path atlas reuse the rasterized mask instead of re-uploading it.
+ *
+ * Both skip items whose device bounds miss SceneParams::band, so a recorder that
+ * owns one horizontal band of the screen records only the draws that reach it.
+ */
+
+#ifndef SCENE_H
+#define SCENE_H
+
+#include "include/core/SkFont.h"
+#include "include/core/SkPaint.h"
+#include "include/core/SkPath.h"
+#include "include/core/SkRRect.h"
+#include "include/core/SkRefCnt.h"
+#include "include/core/SkTextBlob.h"
+
+#include <optional>
+
+class SkCanvas;
+
+// Per-frame inputs to the scene
+struct SceneParams {
+    int width = 0;
+    int height = 0;
+    float time = 0.0f;
+    const char* backendLabel = "";
+    // Device-space area being recorded; items entirely outside it are not drawn.
+    // Unset draws everything.
+    std::optional<SkRect> band;
+};
+
+// Draw one frame, creating every drawing object from scratch
+void drawSceneImmediate(SkCanvas* canvas, const SceneParams& params);
+
+// Scene whose geometry and paints are built once and reused across frames.
+// draw() is const and may be called concurrently from several recording threads.
+class RetainedScene {
+public:
+    RetainedScene();
+
+    void draw(SkCanvas* canvas, const SceneParams& params) const;
+
+private:
+    SkPath fShape;
+    SkRRect fRoundRect;  // At the origin; positioned with a translate per frame
+    SkPaint fBackgroundPaint;
+    SkPaint fShadowPaint;
+    SkPaint fShapePaint;
+    SkPaint fCirclePaint;
+    SkPaint fRectPaint;
+    SkPaint fTextPaint;
+    SkFont fFont;
+    sk_sp<SkTextBlob> fTitle;
+};
+
+#endif // SCENE_H
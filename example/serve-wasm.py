@@ -0,0 +1,65 @@
+#!/usr/bin/env python3
+"""Serve the WebAssembly example with the headers threaded builds need.
+
+SharedArrayBuffer (and so wasm pthreads in the -variant simd-mt build) is only
+available on cross-origin isolated pages, which takes two response headers:
+
+    Cross-Origin-Opener-Policy: same-origin
+    Cross-Origin-Embedder-Policy: require-corp
+
+Every file is served same-origin, so require-corp needs no CORP headers.
+
+Usage: serve-wasm.py [-dir DIR] [-port N] [-page example.html] [--open]
+"""
+
+import argparse
+import http.server
+import sys
+import webbrowser
+from functools import partial
+from pathlib import Path
+
+
+class IsolatedRequestHandler(http.server.SimpleHTTPRequestHandler):
+    extensions_map = {
+        **http.server.SimpleHTTPRequestHandler.extensions_map,
+        ".wasm": "application/wasm",
+        ".js": "text/javascript",
+    }
+
+    def end_headers(self):
+        self.send_header("Cross-Origin-Opener-Policy", "same-origin")
+        self.send_header("Cross-Origin-Embedder-Policy", "require-corp")
+        # Rebuilds replace the .wasm under the same name
+        self.send_header("Cache-Control", "no-store")
+        super().end_headers()
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Serve the wasm example cross-origin isolated")
+    parser.add_argument("-dir", default=".", help="Directory to serve (the example build dir)")
+    parser.add_argument("-port", type=int, default=8080, help="HTTP port")
+    parser.add_argument("-page", default="example.html", help="Page to open with --open")
+    parser.add_argument("--open", action="store_true", help="Open the page in the default browser")
+    args = parser.parse_args()
+
+    root = Path(args.dir).resolve()
+    if not (root / args.page).is_file():
+        print(f"{root / args.page} not found (build it with make example-wasm)", file=sys.stderr)
+        sys.exit(1)
+
+    handler = partial(IsolatedRequestHandler, directory=str(root))
+    server = http.server.ThreadingHTTPServer(("127.0.0.1", args.port), handler)
+    url = f"http://localhost:{args.port}/{args.page}"
+    print(f"Serving {root} at {url} (COOP/COEP on)")
+    print(f"Frame times: {url}?args=--frames=200+--tiled")
+    if args.open:
+        webbrowser.open(url)
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        pass
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,643 @@
+/**
+ * Graphite texture streaming stress test
+ *
+ * Streams a few thousand decoded images into an offscreen Graphite surface and
+ * reports the render thread's frame times, the longest frame in particular.
+ * Images are decoded on a worker pool, then reach the GPU one of two ways:
+ *
+ *   sync   The render thread uploads each image the first frame it is drawn
+ *          (SkImages::TextureFromImage on the main Recorder), the way a
+ *          RasterFromData image gets uploaded during its first draw. Every
+ *          upload's staging copy and texture creation lands in that frame.
+ *   async  An upload thread owns a second Recorder. It turns decoded images into
+ *          textures (TextureFromImage on its Recorder, which fills the staging
+ *          buffers and creates the textures there) and snaps upload Recordings.
+ *          The render thread only inserts those Recordings ahead of its own frame
+ *          and draws the finished textures; no pixel data passes through it.
+ *
+ * A texture made by one Recorder may be drawn by another from the same Context
+ * once the Recording that uploads it has been inserted, which is what the async
+ * path relies on.
+ *
+ * Build with: cmake -DUSE_NATIVE_GRAPHITE=ON (target: texture-stream); add
+ * -DWEBP_LIB_DIR=<build/webp-<platform>/lib/...> to decode real WebP data
+ * (build-webp.py) instead of synthesizing the pixels on the decode threads.
+ *
+ * Usage: texture-stream [--textures=N] [--mode=sync|async|both] [--decoders=N]
+ *                       [--texture-size=WxH] [--size=WxH] [--json=FILE]
+ *
+ *   --textures=N      Images to stream per mode (default 1200)
+ *   --mode=MODE       Upload path to run; "both" runs sync, then async (default)
+ *   --decoders=N      Decode threads (default 4)
+ *   --texture-size=WxH  Decoded image size (default 256x256)
+ *   --size=WxH        Offscreen surface size (default 1280x720)
+ *   --json=FILE       Where to write results (default texture-stream.json)
+ */
+
+#include "bench_util.h"
+#include "headless_graphite.h"
+
+#include "include/core/SkCanvas.h"
+#include "include/core/SkColor.h"
+#include "include/core/SkData.h"
+#include "include/core/SkImage.h"
+#include "include/core/SkImageInfo.h"
+#include "include/core/SkRect.h"
+#include "include/core/SkSamplingOptions.h"
+#include "include/core/SkSurface.h"
+#include "include/gpu/graphite/GraphiteTypes.h"
+#include "include/gpu/graphite/Image.h"
+#include "include/gpu/graphite/Recording.h"
+
+#if defined(TEXTURE_STREAM_WEBP)
+#include "webp/decode.h"
+#include "webp/encode.h"
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Skia revision the libraries were built from (set by CMake)
+#ifndef EXAMPLE_SKIA_REVISION
+#define EXAMPLE_SKIA_REVISION "unknown"
+#endif
+
+// Recordings the GPU may have outstanding before the render thread waits
+static const int kMaxFramesInFlight = 3;
+// Decoded images waiting for upload; bounds the decoders' memory use
+static const size_t kDecodeQueueCapacity = 64;
+// Images per upload Recording at most; smaller batches reach the screen sooner
+static const size_t kUploadBatch = 16;
+// Most recent textures kept and drawn each frame
+static const size_t kResidentTextures = 256;
+static const int kGridColumns = 16;
+
+static int g_textures = 1200;
+static bool g_runSync = true;
+static bool g_runAsync = true;
+static int g_decoders = 4;
+static int g_textureWidth = 256;
+static int g_textureHeight = 256;
+static int g_width = 1280;
+static int g_height = 720;
+static std::string g_jsonPath = "texture-stream.json";
+
+// Unbounded unless a capacity is given; pop() returns false once closed and drained
+template <typename T>
+class BlockingQueue {
+public:
+    explicit BlockingQueue(size_t capacity = SIZE_MAX) : fCapacity(capacity) {}
+
+    void push(T item) {
+        std::unique_lock<std::mutex> lock(fMutex);
+        fNotFull.wait(lock, [this] { return fItems.size() < fCapacity; });
+        fItems.push_back(std::move(item));
+        fNotEmpty.notify_one();
+    }
+
+    bool pop(T* item) {
+        std::unique_lock<std::mutex> lock(fMutex);
+        fNotEmpty.wait(lock, [this] { return fClosed || !fItems.empty(); });
+        return takeLocked(item);
+    }
+
+    // Non-blocking, for the render thread
+    bool tryPop(T* item) {
+        std::lock_guard<std::mutex> lock(fMutex);
+        return takeLocked(item);
+    }
+
+    void close() {
+        std::lock_guard<std::mutex> lock(fMutex);
+        fClosed = true;
+        fNotEmpty.notify_all();
+    }
+
+private:
+    bool takeLocked(T* item) {
+        if (fItems.empty()) {
+            return false;
+        }
+        *item = std::move(fItems.front());
+        fItems.pop_front();
+        fNotFull.notify_one();
+        return true;
+    }
+
+    std::mutex fMutex;
+    std::condition_variable fNotEmpty;
+    std::condition_variable fNotFull;
+    std::deque<T> fItems;
+    size_t fCapacity;
+    bool fClosed = false;
+};
+
+// -----------------------------------------------------------------------------
+// Decoding
+// -----------------------------------------------------------------------------
+
+// Opaque pattern that differs per image, so no two uploads are alike
+static void synthesizePixels(int index, int width, int height, uint8_t* rgba, size_t rowBytes) {
+    const SkScalar hsv[3] = {static_cast<SkScalar>((index * 37) % 360), 0.6f, 0.9f};
+    SkColor base = SkHSVToColor(255, hsv);
+    for (int y = 0; y < height; y++) {
+        uint8_t* row = rgba + y * rowBytes;
+        for (int x = 0; x < width; x++) {
+            bool check = ((x / 32) + (y / 32) + index) & 1;
+            float shade = check ? 1.0f : 0.55f + 0.45f * static_cast<float>(y) / height;
+            row[4 * x + 0] = static_cast<uint8_t>(SkColorGetR(base) * shade);
+            row[4 * x + 1] = static_cast<uint8_t>(SkColorGetG(base) * shade);
+            row[4 * x + 2] = static_cast<uint8_t>(SkColorGetB(base) * shade);
+            row[4 * x + 3] = 255;
+        }
+    }
+}
+
+#if defined(TEXTURE_STREAM_WEBP)
+// A handful of distinct WebP files, encoded once; the decoders cycle through them
+static std::vector<std::vector<uint8_t>> g_webpSources;
+static const int kWebpSources = 8;
+
+static bool encodeWebpSources() {
+    size_t rowBytes = static_cast<size_t>(g_textureWidth) * 4;
+    std::vector<uint8_t> pixels(rowBytes * g_textureHeight);
+    for (int i = 0; i < kWebpSources; i++) {
+        synthesizePixels(i, g_textureWidth, g_textureHeight, pixels.data(), rowBytes);
+        uint8_t* encoded = nullptr;
+        size_t size = WebPEncodeRGBA(pixels.data(), g_textureWidth, g_textureHeight,
+                                     static_cast<int>(rowBytes), 80.0f, &encoded);
+        if (size == 0) {
+            fprintf(stderr, "WebP encode failed\n");
+            return false;
+        }
+        g_webpSources.emplace_back(encoded, encoded + size);
+        WebPFree(encoded);
+    }
+    return true;
+}
+#endif
+
+// Decode image `index` into a raster SkImage, as an asset streaming thread would
+static sk_sp<SkImage> decodeImage(int index) {
+    SkImageInfo info = SkImageInfo::Make(g_textureWidth, g_textureHeight, kRGBA_8888_SkColorType,
+                                         kOpaque_SkAlphaType);
+    size_t rowBytes = info.minRowBytes();
+    sk_sp<SkData> pixels = SkData::MakeUninitialized(info.computeByteSize(rowBytes));
+    uint8_t* rgba = static_cast<uint8_t*>(pixels->writable_data());
+#if defined(TEXTURE_STREAM_WEBP)
+    const std::vector<uint8_t>& source = g_webpSources[index % g_webpSources.size()];
+    if (!WebPDecodeRGBAInto(source.data(), source.size(), rgba, pixels->size(), static_cast<int>(rowBytes))) {
+        fprintf(stderr, "WebP decode failed for image %d\n", index);
+        return nullptr;
+    }
+#else
+    synthesizePixels(index, g_textureWidth, g_textureHeight, rgba, rowBytes);
+#endif
+    return SkImages::RasterFromData(info, std::move(pixels), rowBytes);
+}
+
+// Decode threads share an index counter; the last one out closes the queue
+class DecodePool {
+public:
+    void start(int threads, BlockingQueue<sk_sp<SkImage>>* output, std::atomic<int>* failed) {
+        fOutput = output;
+        fFailed = failed;
+        fRunning = threads;
+        for (int i = 0; i < threads; i++) {
+            fThreads.emplace_back(&DecodePool::workerMain, this);
+        }
+    }
+
+    void join() {
+        for (std::thread& thread : fThreads) {
+            thread.join();
+        }
+        fThreads.clear();
+    }
+
+private:
+    void workerMain() {
+        for (int index = fNext++; index < g_textures; index = fNext++) {
+            if (sk_sp<SkImage> image = decodeImage(index)) {
+                fOutput->push(std::move(image));
+            } else {
+                (*fFailed)++;
+            }
+        }
+        if (--fRunning == 0) {
+            fOutput->close();
+        }
+    }
+
+    BlockingQueue<sk_sp<SkImage>>* fOutput = nullptr;
+    std::atomic<int>* fFailed = nullptr;
+    std::vector<std::thread> fThreads;
+    std::atomic<int> fNext{0};
+    std::atomic<int> fRunning{0};
+};
+
+// -----------------------------------------------------------------------------
+// Async upload thread
+// -----------------------------------------------------------------------------
+
+// One upload Recording and the textures that are ready once it is inserted
+struct UploadBatch {
+    std::unique_ptr<skgpu::graphite::Recording> recording;
+    std::vector<sk_sp<SkImage>> textures;
+};
+
+class UploadThread {
+public:
+    bool start(skgpu::graphite::Context* context, BlockingQueue<sk_sp<SkImage>>* input,
+               BlockingQueue<UploadBatch>* output, std::atomic<int>* failed) {
+        fRecorder = context->makeRecorder();
+        if (!fRecorder) {
+            fprintf(stderr, "Failed to create upload recorder\n");
+            return false;
+        }
+        fInput = input;
+        fOutput = output;
+        fFailed = failed;
+        fThread = std::thread(&UploadThread::threadMain, this);
+        return true;
+    }
+
+    // The Recorder goes first: it must not outlive the Context
+    void join() {
+        if (fThread.joinable()) {
+            fThread.join();
+        }
+        fRecorder.reset();
+    }
+
+private:
+    void threadMain() {
+        sk_sp<SkImage> raster;
+        while (fInput->pop(&raster)) {
+            UploadBatch batch;
+            upload(&batch, std::move(raster));
+            // Batch whatever is already decoded, but never wait for more: a slow
+            // trickle of images should not be held back
+            while (batch.textures.size() < kUploadBatch && fInput->tryPop(&raster)) {
+                upload(&batch, std::move(raster));
+            }
+            flush(&batch);
+        }
+        fOutput->close();
+    }
+
+    // Copies the pixels into a staging buffer recorded on fRecorder
+    void upload(UploadBatch* batch, sk_sp<SkImage> raster) {
+        if (sk_sp<SkImage> texture = SkImages::TextureFromImage(fRecorder.get(), raster.get())) {
+            batch->textures.push_back(std::move(texture));
+        } else {
+            (*fFailed)++;
+        }
+    }
+
+    void flush(UploadBatch* batch) {
+        if (batch->textures.empty()) {
+            return;
+        }
+        // Texture creation and staging buffer allocation happen here, on this thread
+        batch->recording = fRecorder->snap();
+        if (!batch->recording) {
+            fprintf(stderr, "Failed to snap upload recording\n");
+            *fFailed += static_cast<int>(batch->textures.size());
+            return;
+        }
+        fOutput->push(std::move(*batch));
+    }
+
+    std::unique_ptr<skgpu::graphite::Recorder> fRecorder;
+    BlockingQueue<sk_sp<SkImage>>* fInput = nullptr;
+    BlockingQueue<UploadBatch>* fOutput = nullptr;
+    std::atomic<int>* fFailed = nullptr;
+    std::thread fThread;
+};
+
+// -----------------------------------------------------------------------------
+// Render loop
+// -----------------------------------------------------------------------------
+
+struct RunResult {
+    const char* mode = "";
+    std::vector<double> frameMs;
+    std::vector<int> uploadsPerFrame;  // textures that became drawable in each frame
+    double wallMs = 0.0;
+    int streamed = 0;
+};
+
+// Draw the most recent textures as a grid of tiles
+static void drawResident(SkCanvas* canvas, const std::deque<sk_sp<SkImage>>& resident) {
+    canvas->clear(SK_ColorBLACK);
+    int rows = static_cast<int>((kResidentTextures + kGridColumns - 1) / kGridColumns);
+    float tileWidth = static_cast<float>(g_width) / kGridColumns;
+    float tileHeight = static_cast<float>(g_height) / rows;
+    SkSamplingOptions sampling(SkFilterMode::kLinear);
+    int slot = 0;
+    for (auto it = resident.rbegin(); it != resident.rend(); ++it, ++slot) {
+        SkRect dst = SkRect::MakeXYWH((slot % kGridColumns) * tileWidth, (slot / kGridColumns) * tileHeight,
+                                      tileWidth, tileHeight);
+        canvas->drawImageRect(*it, dst, sampling);
+    }
+}
+
+static bool runMode(HeadlessGraphite* graphite, SkSurface* surface, bool async, RunResult* result) {
+    skgpu::graphite::Context* context = graphite->context();
+    skgpu::graphite::Recorder* recorder = graphite->recorder();
+    result->mode = async ? "async" : "sync";
+
+    BlockingQueue<sk_sp<SkImage>> decoded(kDecodeQueueCapacity);
+    BlockingQueue<UploadBatch> uploaded;
+    std::atomic<int> failed{0};
+    DecodePool decoders;
+    UploadThread uploader;
+    if (async && !uploader.start(context, &decoded, &uploaded, &failed)) {
+        return false;
+    }
+
+    std::deque<sk_sp<SkImage>> resident;
+    auto makeResident = [&](sk_sp<SkImage> texture) {
+        resident.push_back(std::move(texture));
+        if (resident.size() > kResidentTextures) {
+            resident.pop_front();
+        }
+        result->streamed++;
+    };
+
+    auto wallStart = std::chrono::steady_clock::now();
+    decoders.start(g_decoders, &decoded, &failed);
+    bool ok = true;
+    while (result->streamed + failed < g_textures) {
+        auto frameStart = std::chrono::steady_clock::now();
+        graphite->waitForFrameSlot(kMaxFramesInFlight);
+
+        int arrived = 0;
+        if (async) {
+            // Upload Recordings go in ahead of this frame's, which draws their textures
+            UploadBatch batch;
+            while (uploaded.tryPop(&batch)) {
+                skgpu::graphite::InsertRecordingInfo info;
+                info.fRecording = batch.recording.get();
+                if (!context->insertRecording(info)) {
+                    fprintf(stderr, "Failed to insert upload recording\n");
+                    ok = false;
+                    break;
+                }
+                for (sk_sp<SkImage>& texture : batch.textures) {
+                    makeResident(std::move(texture));
+                    arrived++;
+                }
+            }
+        } else {
+            // First use on the render thread: staging copy and texture creation happen now
+            sk_sp<SkImage> raster;
+            while (decoded.tryPop(&raster)) {
+                if (sk_sp<SkImage> texture = SkImages::TextureFromImage(recorder, raster.get())) {
+                    makeResident(std::move(texture));
+                    arrived++;
+                } else {
+                    failed++;
+                }
+            }
+        }
+        if (!ok) {
+            break;
+        }
+
+        drawResident(surface->getCanvas(), resident);
+        std::unique_ptr<skgpu::graphite::Recording> recording = recorder->snap();
+        if (!recording) {
+            fprintf(stderr, "Failed to snap recording\n");
+            ok = false;
+            break;
+        }
+        skgpu::graphite::InsertRecordingInfo info;
+        info.fRecording = recording.get();
+        if (!context->insertRecording(info)) {
+            fprintf(stderr, "Failed to insert recording\n");
+            ok = false;
+            break;
+        }
+        context->submit(skgpu::graphite::SyncToCpu::kNo);
+        graphite->frameSubmitted();
+
+        result->frameMs.push_back(msSince(frameStart));
+        result->uploadsPerFrame.push_back(arrived);
+    }
+
+    // If the loop bailed out early, decoders may be blocked on the full queue
+    if (!ok) {
+        sk_sp<SkImage> discard;
+        while (decoded.pop(&discard)) {
+        }
+    }
+    decoders.join();
+    uploader.join();
+    context->submit(skgpu::graphite::SyncToCpu::kYes);
+    result->wallMs = msSince(wallStart);
+    return ok;
+}
+
+// -----------------------------------------------------------------------------
+// Reporting
+// -----------------------------------------------------------------------------
+
+struct FrameSummary {
+    double p50 = 0.0;
+    double p99 = 0.0;
+    double max = 0.0;
+    size_t maxFrame = 0;
+    int maxUploads = 0;  // textures arriving in the longest frame
+    int peakUploads = 0;  // most textures arriving in any frame
+};
+
+// Nearest-rank percentiles, plus which frame was the longest
+static FrameSummary summarize(const RunResult& run) {
+    FrameSummary summary;
+    if (run.frameMs.empty()) {
+        return summary;
+    }
+    std::vector<double> sorted = run.frameMs;
+    std::sort(sorted.begin(), sorted.end());
+    summary.p50 = nearestRank(sorted, 0.50);
+    summary.p99 = nearestRank(sorted, 0.99);
+    auto longest = std::max_element(run.frameMs.begin(), run.frameMs.end());
+    summary.max = *longest;
+    summary.maxFrame = static_cast<size_t>(longest - run.frameMs.begin());
+    summary.maxUploads = run.uploadsPerFrame[summary.maxFrame];
+    summary.peakUploads = *std::max_element(run.uploadsPerFrame.begin(), run.uploadsPerFrame.end());
+    return summary;
+}
+
+static void printRun(const RunResult& run) {
+    FrameSummary s = summarize(run);
+    printf("  %-5s  %d textures in %zu frames, %.0f ms  frame p50 %.3f ms  p99 %.3f ms  "
+           "longest %.3f ms (frame %zu, %d textures)  peak %d textures/frame\n",
+           run.mode, run.streamed, run.frameMs.size(), run.wallMs, s.p50, s.p99, s.max, s.maxFrame,
+           s.maxUploads, s.peakUploads);
+}
+
+static bool writeJson(const std::string& path, const std::string& adapterName, const std::vector<RunResult>& runs) {
+    FILE* f = fopen(path.c_str(), "w");
+    if (!f) {
+        fprintf(stderr, "Failed to open %s for writing\n", path.c_str());
+        return false;
+    }
+    fprintf(f, "{\n");
+    fprintf(f, "  \"skia_revision\": %s,\n", jsonString(EXAMPLE_SKIA_REVISION).c_str());
+    fprintf(f, "  \"adapter\": %s,\n", jsonString(adapterName).c_str());
+#if defined(TEXTURE_STREAM_WEBP)
+    fprintf(f, "  \"decoder\": \"webp\",\n");
+#else
+    fprintf(f, "  \"decoder\": \"synthesized\",\n");
+#endif
+    fprintf(f, "  \"textures\": %d,\n", g_textures);
+    fprintf(f, "  \"texture_width\": %d,\n", g_textureWidth);
+    fprintf(f, "  \"texture_height\": %d,\n", g_textureHeight);
+    fprintf(f, "  \"width\": %d,\n", g_width);
+    fprintf(f, "  \"height\": %d,\n", g_height);
+    fprintf(f, "  \"decoders\": %d,\n", g_decoders);
+    fprintf(f, "  \"runs\": {\n");
+    for (size_t i = 0; i < runs.size(); i++) {
+        const RunResult& run = runs[i];
+        FrameSummary s = summarize(run);
+        fprintf(f, "    \"%s\": {\"streamed\": %d, \"frames\": %zu, \"wall_ms\": %.1f, \"frame_p50_ms\": %.4f, "
+                   "\"frame_p99_ms\": %.4f, \"longest_frame_ms\": %.4f, \"longest_frame\": %zu, "
+                   "\"longest_frame_textures\": %d, \"peak_textures_per_frame\": %d}%s\n",
+                run.mode, run.streamed, run.frameMs.size(), run.wallMs, s.p50, s.p99, s.max, s.maxFrame,
+                s.maxUploads, s.peakUploads, i + 1 < runs.size() ? "," : "");
+    }
+    fprintf(f, "  }\n");
+    fprintf(f, "}\n");
+    fclose(f);
+    return true;
+}
+
+static bool parseSize(const char* value, const char* flag, int* width, int* height) {
+    if (sscanf(value, "%dx%d", width, height) != 2 || *width < 1 || *height < 1) {
+        fprintf(stderr, "%s must look like 256x256\n", flag);
+        return false;
+    }
+    return true;
+}
+
+// Parse command line flags (see usage at the top of this file)
+static bool parseArgs(int argc, char** argv) {
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--textures=", 11) == 0) {
+            g_textures = atoi(argv[i] + 11);
+            if (g_textures < 1) {
+                fprintf(stderr, "--textures must be at least 1\n");
+                return false;
+            }
+        } else if (strcmp(argv[i], "--mode=sync") == 0) {
+            g_runSync = true;
+            g_runAsync = false;
+        } else if (strcmp(argv[i], "--mode=async") == 0) {
+            g_runSync = false;
+            g_runAsync = true;
+        } else if (strcmp(argv[i], "--mode=both") == 0) {
+            g_runSync = true;
+            g_runAsync = true;
+        } else if (strncmp(argv[i], "--decoders=", 11) == 0) {
+            g_decoders = atoi(argv[i] + 11);
+            if (g_decoders < 1 || g_decoders > 64) {
+                fprintf(stderr, "--decoders must be between 1 and 64\n");
+                return false;
+            }
+        } else if (strncmp(argv[i], "--texture-size=", 15) == 0) {
+            if (!parseSize(argv[i] + 15, "--texture-size", &g_textureWidth, &g_textureHeight)) {
+                return false;
+            }
+        } else if (strncmp(argv[i], "--size=", 7) == 0) {
+            if (!parseSize(argv[i] + 7, "--size", &g_width, &g_height)) {
+                return false;
+            }
+        } else if (strncmp(argv[i], "--json=", 7) == 0) {
+            g_jsonPath = argv[i] + 7;
+        } else {
+            fprintf(stderr, "Unknown argument: %s\n", argv[i]);
+            fprintf(stderr, "Usage: %s [--textures=N] [--mode=sync|async|both] [--decoders=N]\n"
+                            "          [--texture-size=WxH] [--size=WxH] [--json=FILE]\n", argv[0]);
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    printf("Skia Graphite Texture Streaming Test\n");
+    printf("====================================\n");
+
+    if (!parseArgs(argc, argv)) {
+        return 1;
+    }
+#if defined(TEXTURE_STREAM_WEBP)
+    if (!encodeWebpSources()) {
+        return 1;
+    }
+#endif
+
+    // The upload thread creates textures and buffers alongside the render thread
+    HeadlessGraphite graphite;
+    HeadlessGraphite::Options options;
+    options.threadSafeDevice = true;
+    if (!graphite.init(options)) {
+        return 1;
+    }
+    printf("Adapter: %s\n", graphite.adapterName().c_str());
+    printf("Skia revision: %s\n", EXAMPLE_SKIA_REVISION);
+
+    sk_sp<SkSurface> surface = graphite.makeSurface(g_width, g_height);
+    if (!surface) {
+        return 1;
+    }
+
+    printf("Streaming %d %dx%d textures (%s, %d decoders) into %dx%d...\n", g_textures, g_textureWidth,
+           g_textureHeight,
+#if defined(TEXTURE_STREAM_WEBP)
+           "WebP",
+#else
+           "synthesized",
+#endif
+           g_decoders, g_width, g_height);
+
+    std::vector<RunResult> runs;
+    for (bool async : {false, true}) {
+        if ((async && !g_runAsync) || (!async && !g_runSync)) {
+            continue;
+        }
+        runs.emplace_back();
+        if (!runMode(&graphite, surface.get(), async, &runs.back())) {
+            return 1;
+        }
+    }
+
+    printf("Results:\n");
+    for (const RunResult& run : runs) {
+        printRun(run);
+    }
+
+    if (!writeJson(g_jsonPath, graphite.adapterName(), runs)) {
+        return 1;
+    }
+    printf("Wrote %s\n", g_jsonPath.c_str());
+
+    // Release the surface before the context goes away
+    surface.reset();
+    return 0;
+}
@@ -0,0 +1,253 @@
+/**
+ * Shared harness for the library benchmarks (bench_*.c).
+ *
+ * Each benchmark records latency samples into BenchSeries, then writes one JSON
+ * document with the same layout for every library so weekly builds can be
+ * compared per device class:
+ *
+ *   {
+ *     "schema": 1,
+ *     "library": "moshi",
+ *     "device_class": "...",      (BENCH_DEVICE_CLASS, else "<os>-<arch>")
+ *     "os": "Linux", "arch": "x86_64",
+ *     "timestamp": "2025-01-01T00:00:00Z",
+ *     "model": "model.safetensors",
+ *     "load_ms": 1234.5,
+ *     "real_time_factor": 0.42,   (processing time / audio time; < 1 is faster
+ *                                  than real time; null when not applicable)
+ *     "peak_rss_mb": 4321.0,
+ *     ...extra_json members, if the benchmark sets any...
+ *     "metrics": {
+ *       "<name>": {"unit": "ms", "count": N, "mean": .., "p50": .., "p90": ..,
+ *                  "p99": .., "min": .., "max": ..},
+ *       ...
+ *     }
+ *   }
+ *
+ * Header-only; include from exactly one translation unit per benchmark.
+ */
+
+#ifndef BENCH_COMMON_H
+#define BENCH_COMMON_H
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/resource.h>
+#include <sys/utsname.h>
+
+#define BENCH_MAX_SERIES 16
+
+static inline double bench_now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+/* Peak resident set size in MB (ru_maxrss is bytes on macOS, KB on Linux) */
+static inline double bench_peak_rss_mb(void) {
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0.0;
+#ifdef __APPLE__
+    return usage.ru_maxrss / (1024.0 * 1024.0);
+#else
+    return usage.ru_maxrss / 1024.0;
+#endif
+}
+
+/**
+ * Growable list of samples: latencies in milliseconds unless `unit` says otherwise
+ * (e.g. "MB/s" for throughput).
+ */
+typedef struct BenchSeries {
+    const char* name;
+    double* values;
+    size_t count;
+    size_t capacity;
+    const char* unit;   /* NULL means "ms" */
+} BenchSeries;
+
+static inline const char* bench_series_unit(const BenchSeries* s) {
+    return s->unit ? s->unit : "ms";
+}
+
+static inline void bench_series_add(BenchSeries* s, double value) {
+    if (s->count == s->capacity) {
+        size_t capacity = s->capacity ? s->capacity * 2 : 256;
+        double* values = (double*)realloc(s->values, capacity * sizeof(double));
+        if (!values) return;
+        s->values = values;
+        s->capacity = capacity;
+    }
+    s->values[s->count++] = value;
+}
+
+static inline void bench_series_free(BenchSeries* s) {
+    free(s->values);
+    s->values = NULL;
+    s->count = s->capacity = 0;
+}
+
+static inline int bench_compare_doubles(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+/* Nearest-rank percentile of sorted values */
+static inline double bench_percentile(const double* sorted, size_t count, double p) {
+    if (count == 0) return 0.0;
+    size_t rank = (size_t)(p / 100.0 * (double)(count - 1) + 0.5);
+    return sorted[rank < count ? rank : count - 1];
+}
+
+/**
+ * One benchmark run: metadata plus up to BENCH_MAX_SERIES latency series.
+ */
+typedef struct BenchReport {
+    const char* library;
+    const char* model_path;
+    double load_ms;
+    double processing_ms;   /* total time spent producing `media_ms` of output/input */
+    double media_ms;        /* audio duration covered; 0 if RTF does not apply */
+    BenchSeries* series[BENCH_MAX_SERIES];
+    int num_series;
+    const char* extra_json; /* extra top-level members, e.g. "\"simd\": \"sse2\"", or NULL */
+} BenchReport;
+
+static inline void bench_report_add_series(BenchReport* r, BenchSeries* s) {
+    if (r->num_series < BENCH_MAX_SERIES) r->series[r->num_series++] = s;
+}
+
+static inline void bench_write_series(FILE* f, const BenchSeries* s) {
+    double* sorted = NULL;
+    double sum = 0.0;
+    if (s->count > 0) {
+        sorted = (double*)malloc(s->count * sizeof(double));
+        if (sorted) {
+            memcpy(sorted, s->values, s->count * sizeof(double));
+            qsort(sorted, s->count, sizeof(double), bench_compare_doubles);
+        }
+        for (size_t i = 0; i < s->count; i++) sum += s->values[i];
+    }
+    fprintf(f, "    \"%s\": {\"unit\": \"%s\", \"count\": %zu", s->name, bench_series_unit(s), s->count);
+    if (sorted) {
+        fprintf(f, ", \"mean\": %.3f, \"p50\": %.3f, \"p90\": %.3f, \"p99\": %.3f"
+                   ", \"min\": %.3f, \"max\": %.3f",
+                sum / (double)s->count,
+                bench_percentile(sorted, s->count, 50.0),
+                bench_percentile(sorted, s->count, 90.0),
+                bench_percentile(sorted, s->count, 99.0),
+                sorted[0], sorted[s->count - 1]);
+    }
+    fprintf(f, "}");
+    free(sorted);
+}
+
+/* Write a JSON string value, escaping quotes and backslashes */
+static inline void bench_write_string(FILE* f, const char* str) {
+    fputc('"', f);
+    for (; str && *str; str++) {
+        if (*str == '"' || *str == '\\') fputc('\\', f);
+        if ((unsigned char)*str >= 0x20) fputc(*str, f);
+    }
+    fputc('"', f);
+}
+
+static inline const char* bench_basename(const char* path) {
+    const char* slash = path ? strrchr(path, '/') : NULL;
+    return slash ? slash + 1 : (path ? path : "");
+}
+
+/**
+ * Write the report as JSON to `path` (or stdout when path is NULL or "-") and
+ * print a one-line summary per series to stderr.
+ * Returns 0 on success, -1 if the file cannot be written.
+ */
+static inline int bench_report_write(const BenchReport* r, const char* path) {
+    FILE* f = (!path || strcmp(path, "-") == 0) ? stdout : fopen(path, "w");
+    if (!f) {
+        fprintf(stderr, "Error: cannot open %s for writing\n", path);
+        return -1;
+    }
+
+    struct utsname uts;
+    if (uname(&uts) != 0) {
+        strcpy(uts.sysname, "unknown");
+        strcpy(uts.machine, "unknown");
+    }
+    char device_class[160];
+    const char* env_class = getenv("BENCH_DEVICE_CLASS");
+    if (env_class && *env_class) {
+        snprintf(device_class, sizeof(device_class), "%s", env_class);
+    } else {
+        snprintf(device_class, sizeof(device_class), "%s-%s", uts.sysname, uts.machine);
+    }
+
+    char timestamp[32];
+    time_t now = time(NULL);
+    strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%SZ", gmtime(&now));
+
+    fprintf(f, "{\n  \"schema\": 1,\n  \"library\": ");
+    bench_write_string(f, r->library);
+    fprintf(f, ",\n  \"device_class\": ");
+    bench_write_string(f, device_class);
+    fprintf(f, ",\n  \"os\": ");
+    bench_write_string(f, uts.sysname);
+    fprintf(f, ",\n  \"arch\": ");
+    bench_write_string(f, uts.machine);
+    fprintf(f, ",\n  \"timestamp\": \"%s\",\n  \"model\": ", timestamp);
+    bench_write_string(f, bench_basename(r->model_path));
+    fprintf(f, ",\n  \"load_ms\": %.3f", r->load_ms);
+    if (r->media_ms > 0.0) {
+        fprintf(f, ",\n  \"real_time_factor\": %.4f", r->processing_ms / r->media_ms);
+    } else {
+        fprintf(f, ",\n  \"real_time_factor\": null");
+    }
+    fprintf(f, ",\n  \"peak_rss_mb\": %.1f", bench_peak_rss_mb());
+    if (r->extra_json && *r->extra_json) {
+        fprintf(f, ",\n  %s", r->extra_json);
+    }
+    fprintf(f, ",\n  \"metrics\": {\n");
+    for (int i = 0; i < r->num_series; i++) {
+        bench_write_series(f, r->series[i]);
+        fprintf(f, i + 1 < r->num_series ? ",\n" : "\n");
+    }
+    fprintf(f, "  }\n}\n");
+    if (f != stdout) fclose(f);
+
+    for (int i = 0; i < r->num_series; i++) {
+        const BenchSeries* s = r->series[i];
+        double sum = 0.0, max = 0.0;
+        for (size_t j = 0; j < s->count; j++) {
+            sum += s->values[j];
+            if (s->values[j] > max) max = s->values[j];
+        }
+        const char* unit = bench_series_unit(s);
+        fprintf(stderr, "  %-24s n=%-6zu mean=%8.2f %s  max=%8.2f %s\n",
+                s->name, s->count, s->count ? sum / (double)s->count : 0.0, unit, max, unit);
+    }
+    if (r->media_ms > 0.0) {
+        fprintf(stderr, "  real-time factor: %.3f\n", r->processing_ms / r->media_ms);
+    }
+    fprintf(stderr, "  peak RSS: %.0f MB\n", bench_peak_rss_mb());
+    return 0;
+}
+
+/**
+ * Deterministic test speech stand-in: a gliding two-tone signal at 0.3 amplitude
+ * (24 kHz for Mimi, 16 kHz for whisper), so runs are comparable across builds.
+ */
+static inline void bench_fill_signal(float* pcm, size_t len, int sample_rate) {
+    double phase1 = 0.0, phase2 = 0.0;
+    for (size_t i = 0; i < len; i++) {
+        double t = (double)i / sample_rate;
+        double f1 = 220.0 + 110.0 * (0.5 + 0.5 * sin(2.0 * M_PI * 0.5 * t));
+        phase1 += 2.0 * M_PI * f1 / sample_rate;
+        phase2 += 2.0 * M_PI * (f1 * 2.5) / sample_rate;
+        pcm[i] = (float)(0.2 * sin(phase1) + 0.1 * sin(phase2));
+    }
+}
+
+#endif /* BENCH_COMMON_H */
@@ -0,0 +1,160 @@
+/**
+ * Benchmark for the Draco C API (libdraco_c): scene load time for a batch of
+ * Draco-compressed meshes decoded straight into interleaved vertex/index buffers,
+ * single-mesh decode latency, and peak memory.
+ *
+ * A "scene" is --meshes copies of one .drc file (e.g. a primitive extracted from a
+ * KHR_draco_mesh_compression glTF), decoded with draco_decode_batch on a pool of
+ * --threads workers into buffers sized up front, the way a glTF loader does.
+ *
+ * Usage:
+ *   ./bench_draco <mesh.drc> [--meshes N] [--threads N] [--runs N] [--json out.json]
+ *
+ * Writes the JSON report described in bench_common.h (stdout by default).
+ */
+
+#include "../build/include/draco/draco_c.h"
+#include "bench_common.h"
+
+/* Position (float3) + first normal (float3) if the mesh has one */
+static DracoVertexElement kElements[] = {
+    { -1, DRACO_POSITION, 0, DRACO_FLOAT32, 3, 0 },
+    { -1, DRACO_NORMAL, 0, DRACO_FLOAT32, 3, 12 },
+};
+
+static unsigned char* read_file(const char* path, size_t* out_size) {
+    FILE* f = fopen(path, "rb");
+    if (!f) return NULL;
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    unsigned char* data = size > 0 ? (unsigned char*)malloc((size_t)size) : NULL;
+    if (data && fread(data, 1, (size_t)size, f) != (size_t)size) {
+        free(data);
+        data = NULL;
+    }
+    fclose(f);
+    *out_size = (size_t)size;
+    return data;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <mesh.drc> [--meshes N] [--threads N] [--runs N] [--json out.json]\n",
+                argv[0]);
+        return 1;
+    }
+    const char* mesh_path = argv[1];
+    int meshes = 64;
+    int threads = 0;
+    int runs = 10;
+    const char* json_path = NULL;
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "--meshes") == 0 && i + 1 < argc) {
+            meshes = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--runs") == 0 && i + 1 < argc) {
+            runs = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            json_path = argv[++i];
+        } else {
+            fprintf(stderr, "Unknown argument: %s\n", argv[i]);
+            return 1;
+        }
+    }
+    if (meshes <= 0 || runs <= 0 || threads < 0) {
+        fprintf(stderr, "--meshes and --runs must be positive, --threads non-negative (0 = per core)\n");
+        return 1;
+    }
+
+    size_t size = 0;
+    unsigned char* data = read_file(mesh_path, &size);
+    if (!data) {
+        fprintf(stderr, "Failed to read %s\n", mesh_path);
+        return 1;
+    }
+
+    /* First decode: learn the counts and which attributes exist (a glTF loader
+       gets these from the accessors instead) */
+    double t_load = bench_now_ms();
+    DracoMesh* probe = NULL;
+    DracoStatus status = draco_mesh_decode(data, size, &probe);
+    if (status != DRACO_OK) {
+        fprintf(stderr, "draco_mesh_decode failed: %s\n", draco_status_string(status));
+        free(data);
+        return 1;
+    }
+    double load_ms = bench_now_ms() - t_load;
+    uint32_t num_vertices = draco_mesh_num_vertices(probe);
+    uint32_t num_indices = draco_mesh_num_indices(probe);
+    DracoVertexLayout layout = { kElements, 2, 24 };
+    void* scratch = malloc((size_t)num_vertices * layout.stride + 1);
+    if (scratch && draco_mesh_write_vertices(probe, &layout, scratch, (size_t)num_vertices * layout.stride)
+                       == DRACO_MISSING_ATTRIBUTE) {
+        layout.num_elements = 1;
+        layout.stride = 12;
+    }
+    free(scratch);
+    draco_mesh_destroy(probe);
+
+    size_t vertices_size = (size_t)num_vertices * layout.stride;
+    size_t indices_size = (size_t)num_indices * sizeof(uint32_t);
+    DracoDecodeJob* jobs = (DracoDecodeJob*)calloc((size_t)meshes, sizeof(DracoDecodeJob));
+    unsigned char* vertices = (unsigned char*)malloc(vertices_size * meshes + 1);
+    unsigned char* indices = (unsigned char*)malloc(indices_size * meshes + 1);
+    if (!jobs || !vertices || !indices) {
+        fprintf(stderr, "malloc failed\n");
+        return 1;
+    }
+    for (int i = 0; i < meshes; i++) {
+        jobs[i].data = data;
+        jobs[i].size = size;
+        jobs[i].layout = &layout;
+        jobs[i].vertices = vertices + vertices_size * i;
+        jobs[i].vertices_size = vertices_size;
+        jobs[i].indices = num_indices ? indices + indices_size * i : NULL;
+        jobs[i].indices_size = indices_size;
+        jobs[i].index_format = DRACO_INDEX_U32;
+    }
+
+    DracoPool* pool = draco_pool_create((uint32_t)threads);
+    BenchSeries scene = { "scene_load_ms" };
+    BenchSeries mesh = { "mesh_decode_ms" };
+    int rc = 0;
+
+    fprintf(stderr, "Benchmarking Draco C API: %d runs of %d meshes (%u vertices, %u indices, stride %u) "
+                    "(+1 warm-up)\n", runs, meshes, num_vertices, num_indices, layout.stride);
+    for (int run = 0; run <= runs; run++) {
+        double t0 = bench_now_ms();
+        status = draco_decode_batch(pool, jobs, (size_t)meshes);
+        double t1 = bench_now_ms();
+        if (status == DRACO_OK) status = draco_decode_into(&jobs[0]);
+        double t2 = bench_now_ms();
+        if (status != DRACO_OK) {
+            fprintf(stderr, "Draco decode failed: %s\n", draco_status_string(status));
+            rc = 1;
+            break;
+        }
+
+        if (run == 0) continue; /* warm-up */
+        bench_series_add(&scene, t1 - t0);
+        bench_series_add(&mesh, t2 - t1);
+    }
+
+    if (rc == 0) {
+        BenchReport report = { "draco", mesh_path, load_ms, 0.0, 0.0 };
+        bench_report_add_series(&report, &scene);
+        bench_report_add_series(&report, &mesh);
+        rc = bench_report_write(&report, json_path) != 0;
+    }
+
+    bench_series_free(&scene);
+    bench_series_free(&mesh);
+    draco_pool_destroy(pool);
+    free(jobs);
+    free(vertices);
+    free(indices);
+    free(data);
+    return rc;
+}
@@ -0,0 +1,144 @@
+/**
+ * Benchmark for the llama.cpp static libs: prompt evaluation, time to first token
+ * and per-token generation latency, plus peak memory.
+ *
+ * Each run clears the KV cache, evaluates a fixed prompt in one batch and
+ * generates --tokens tokens greedily.
+ *
+ * Usage:
+ *   ./bench_llama <model.gguf> [--runs N] [--tokens N] [--ctx N] [--json out.json]
+ *
+ * Writes the JSON report described in bench_common.h (stdout by default).
+ * real_time_factor is null: there is no media duration to compare against.
+ */
+
+#include "../build/include/llamacpp/llama.h"
+#include "bench_common.h"
+
+#define MAX_PROMPT_TOKENS 512
+
+static const char* kPrompt =
+    "You are a helpful assistant running on a mobile device. Summarize in two "
+    "sentences why on-device inference matters for latency and privacy.";
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <model.gguf> [--runs N] [--tokens N] [--ctx N] [--json out.json]\n",
+                argv[0]);
+        return 1;
+    }
+    const char* model_path = argv[1];
+    int runs = 5;
+    int gen_tokens = 64;
+    int n_ctx = 2048;
+    const char* json_path = NULL;
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "--runs") == 0 && i + 1 < argc) {
+            runs = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--tokens") == 0 && i + 1 < argc) {
+            gen_tokens = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--ctx") == 0 && i + 1 < argc) {
+            n_ctx = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            json_path = argv[++i];
+        } else {
+            fprintf(stderr, "Unknown argument: %s\n", argv[i]);
+            return 1;
+        }
+    }
+    if (runs <= 0 || gen_tokens <= 0 || n_ctx <= 0) {
+        fprintf(stderr, "--runs, --tokens and --ctx must be positive\n");
+        return 1;
+    }
+
+    llama_backend_init();
+
+    double t_load = bench_now_ms();
+    struct llama_model* model = llama_model_load_from_file(model_path, llama_model_default_params());
+    if (!model) {
+        fprintf(stderr, "Failed to load llama model: %s\n", model_path);
+        llama_backend_free();
+        return 1;
+    }
+    struct llama_context_params ctx_params = llama_context_default_params();
+    ctx_params.n_ctx = (uint32_t)n_ctx;
+    ctx_params.n_batch = MAX_PROMPT_TOKENS;
+    struct llama_context* ctx = llama_init_from_model(model, ctx_params);
+    if (!ctx) {
+        fprintf(stderr, "Failed to create llama context\n");
+        llama_model_free(model);
+        llama_backend_free();
+        return 1;
+    }
+    double load_ms = bench_now_ms() - t_load;
+
+    const struct llama_vocab* vocab = llama_model_get_vocab(model);
+    llama_token prompt[MAX_PROMPT_TOKENS];
+    int n_prompt = llama_tokenize(vocab, kPrompt, (int32_t)strlen(kPrompt),
+                                  prompt, MAX_PROMPT_TOKENS, true, true);
+    if (n_prompt <= 0 || n_prompt + gen_tokens > n_ctx) {
+        fprintf(stderr, "Prompt tokenization failed or does not fit the context (%d tokens)\n", n_prompt);
+        llama_free(ctx);
+        llama_model_free(model);
+        llama_backend_free();
+        return 1;
+    }
+
+    struct llama_sampler* sampler = llama_sampler_chain_init(llama_sampler_chain_default_params());
+    llama_sampler_chain_add(sampler, llama_sampler_init_greedy());
+
+    BenchSeries prompt_eval = { "prompt_eval_ms" };
+    BenchSeries ttft = { "ttft_ms" };
+    BenchSeries token = { "token_ms" };
+    int rc = 0;
+
+    fprintf(stderr, "Benchmarking llama.cpp: %d runs, %d prompt + %d generated tokens (+1 warm-up)\n",
+            runs, n_prompt, gen_tokens);
+    for (int run = 0; run <= runs && rc == 0; run++) {
+        llama_kv_self_clear(ctx);
+        llama_sampler_reset(sampler);
+
+        double t0 = bench_now_ms();
+        if (llama_decode(ctx, llama_batch_get_one(prompt, n_prompt)) != 0) {
+            fprintf(stderr, "llama_decode failed on the prompt\n");
+            rc = 1;
+            break;
+        }
+        double t1 = bench_now_ms();
+        llama_token next = llama_sampler_sample(sampler, ctx, -1);
+        double t2 = bench_now_ms();
+        if (run > 0) {
+            bench_series_add(&prompt_eval, t1 - t0);
+            bench_series_add(&ttft, t2 - t0);
+        }
+
+        for (int i = 1; i < gen_tokens; i++) {
+            if (llama_vocab_is_eog(vocab, next)) break;
+            double ts = bench_now_ms();
+            if (llama_decode(ctx, llama_batch_get_one(&next, 1)) != 0) {
+                fprintf(stderr, "llama_decode failed at token %d\n", i);
+                rc = 1;
+                break;
+            }
+            next = llama_sampler_sample(sampler, ctx, -1);
+            if (run > 0) bench_series_add(&token, bench_now_ms() - ts);
+        }
+    }
+
+    if (rc == 0) {
+        BenchReport report = { "llamacpp", model_path, load_ms, 0.0, 0.0 };
+        bench_report_add_series(&report, &prompt_eval);
+        bench_report_add_series(&report, &ttft);
+        bench_report_add_series(&report, &token);
+        rc = bench_report_write(&report, json_path) != 0;
+    }
+
+    bench_series_free(&prompt_eval);
+    bench_series_free(&ttft);
+    bench_series_free(&token);
+    llama_sampler_free(sampler);
+    llama_free(ctx);
+    llama_model_free(model);
+    llama_backend_free();
+    return rc;
+}
@@ -0,0 +1,171 @@
+/**
+ * Benchmark for libmoshi_ffi: per-frame Mimi encode, Moshi LM step and Mimi decode
+ * latency, real-time factor and peak memory.
+ *
+ * Each 80 ms frame runs the full-duplex streaming path an app would run:
+ * mimi_encode_step -> moshi_step (LM + depformer) -> mimi_decode_step.
+ *
+ * Usage:
+ *   ./bench_moshi <mimi_model_path> <moshi_model_path>
+ *                 [--frames N] [--warmup N] [--dtype f32|f16|bf16|auto] [--json out.json]
+ *
+ * Writes the JSON report described in bench_common.h (stdout by default).
+ */
+
+#include <stdint.h>
+
+#include "../build/include/moshi/moshi.h"
+#include "bench_common.h"
+
+#define MIMI_SAMPLE_RATE 24000
+#define MIMI_FRAME_SAMPLES 1920
+#define MIMI_FRAME_MS 80.0
+#define MAX_CODEBOOKS 32
+
+static const char* check_error(void) {
+    const char* err = moshi_last_error();
+    return err ? err : "unknown error";
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        fprintf(stderr, "Usage: %s <mimi_model_path> <moshi_model_path> "
+                        "[--frames N] [--warmup N] [--dtype f32|f16|bf16|auto] [--json out.json]\n",
+                argv[0]);
+        return 1;
+    }
+    const char* mimi_path = argv[1];
+    const char* moshi_path = argv[2];
+    int frames = 125; /* 10 s of audio */
+    int warmup = 5;
+    uint32_t dtype = MOSHI_DTYPE_F32;
+    const char* json_path = NULL;
+    for (int i = 3; i < argc; i++) {
+        if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+            frames = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--warmup") == 0 && i + 1 < argc) {
+            warmup = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--dtype") == 0 && i + 1 < argc) {
+            const char* name = argv[++i];
+            if (strcmp(name, "f32") == 0) dtype = MOSHI_DTYPE_F32;
+            else if (strcmp(name, "f16") == 0) dtype = MOSHI_DTYPE_F16;
+            else if (strcmp(name, "bf16") == 0) dtype = MOSHI_DTYPE_BF16;
+            else if (strcmp(name, "auto") == 0) dtype = MOSHI_DTYPE_AUTO;
+            else {
+                fprintf(stderr, "Unknown dtype '%s'\n", name);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            json_path = argv[++i];
+        } else {
+            fprintf(stderr, "Unknown argument: %s\n", argv[i]);
+            return 1;
+        }
+    }
+    if (frames <= 0 || warmup < 0) {
+        fprintf(stderr, "--frames must be positive and --warmup non-negative\n");
+        return 1;
+    }
+
+    if (moshi_init() != 0) {
+        fprintf(stderr, "moshi_init failed: %s\n", check_error());
+        return 1;
+    }
+
+    double t_load = bench_now_ms();
+    MimiCodec* codec = mimi_load(mimi_path, 0);
+    if (!codec) {
+        fprintf(stderr, "mimi_load failed: %s\n", check_error());
+        return 1;
+    }
+    MoshiLoadOptions options = { dtype, NULL, NULL };
+    MoshiModel* model = moshi_load_ex(moshi_path, &options);
+    if (!model) {
+        fprintf(stderr, "moshi_load failed: %s\n", check_error());
+        mimi_free(codec);
+        return 1;
+    }
+    double load_ms = bench_now_ms() - t_load;
+
+    uint32_t generated = moshi_generated_codebooks(model);
+    size_t num_user = moshi_audio_codebooks(model) - generated;
+
+    int total = warmup + frames;
+    float* pcm_in = (float*)malloc((size_t)total * MIMI_FRAME_SAMPLES * sizeof(float));
+    float pcm_out[2 * MIMI_FRAME_SAMPLES];
+    if (!pcm_in) {
+        fprintf(stderr, "malloc failed\n");
+        moshi_free(model);
+        mimi_free(codec);
+        return 1;
+    }
+    bench_fill_signal(pcm_in, (size_t)total * MIMI_FRAME_SAMPLES, MIMI_SAMPLE_RATE);
+
+    BenchSeries encode = { "encode_ms" };
+    BenchSeries lm = { "lm_step_ms" };
+    BenchSeries decode = { "decode_ms" };
+    BenchSeries frame = { "frame_ms" };
+    double processing_ms = 0.0;
+    int rc = 0;
+
+    fprintf(stderr, "Benchmarking Moshi: %d frames (+%d warm-up)\n", frames, warmup);
+    for (int i = 0; i < total; i++) {
+        uint32_t codes[MAX_CODEBOOKS];
+        uint32_t audio_codes[MAX_CODEBOOKS];
+        uint32_t text_token = 0;
+
+        double t0 = bench_now_ms();
+        int32_t n_codes = mimi_encode_step(codec, pcm_in + (size_t)i * MIMI_FRAME_SAMPLES,
+                                           MIMI_FRAME_SAMPLES, codes, MAX_CODEBOOKS);
+        double t1 = bench_now_ms();
+        if (n_codes < 0) {
+            fprintf(stderr, "mimi_encode_step failed at frame %d: %s\n", i, check_error());
+            rc = 1;
+            break;
+        }
+        if (n_codes == 0) continue; /* codec still buffering */
+
+        int32_t n_audio = moshi_step(model, NULL, codes, num_user,
+                                     &text_token, audio_codes, MAX_CODEBOOKS);
+        double t2 = bench_now_ms();
+        if (n_audio < 0) {
+            fprintf(stderr, "moshi_step failed at frame %d: %s\n", i, check_error());
+            rc = 1;
+            break;
+        }
+
+        if (n_audio > 0 && mimi_decode_step(codec, audio_codes, (size_t)n_audio,
+                                            pcm_out, 2 * MIMI_FRAME_SAMPLES) < 0) {
+            fprintf(stderr, "mimi_decode_step failed at frame %d: %s\n", i, check_error());
+            rc = 1;
+            break;
+        }
+        double t3 = bench_now_ms();
+
+        if (i < warmup) continue;
+        bench_series_add(&encode, t1 - t0);
+        bench_series_add(&lm, t2 - t1);
+        bench_series_add(&decode, t3 - t2);
+        bench_series_add(&frame, t3 - t0);
+        processing_ms += t3 - t0;
+    }
+
+    if (rc == 0) {
+        BenchReport report = { "moshi", moshi_path, load_ms, processing_ms,
+                               frame.count * MIMI_FRAME_MS };
+        bench_report_add_series(&report, &encode);
+        bench_report_add_series(&report, &lm);
+        bench_report_add_series(&report, &decode);
+        bench_report_add_series(&report, &frame);
+        rc = bench_report_write(&report, json_path) != 0;
+    }
+
+    bench_series_free(&encode);
+    bench_series_free(&lm);
+    bench_series_free(&decode);
+    bench_series_free(&frame);
+    free(pcm_in);
+    moshi_free(model);
+    mimi_free(codec);
+    return rc;
+}
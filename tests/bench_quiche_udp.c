@@ -0,0 +1,317 @@
+/**
+ * Benchmark for libquiche_udp: UDP throughput and round-trip latency between two
+ * local endpoints on one libuv loop, per I/O mode:
+ *
+ *   sendto  one syscall per datagram (batch 1, no offloads) -- the baseline
+ *   mmsg    sendmmsg / recvmmsg batches of 32
+ *   gso     batches plus UDP GSO on send and GRO on receive (Linux)
+ *
+ * Throughput streams --datagrams QUIC-sized datagrams with at most --window in
+ * flight (a stand-in for a congestion window); datagrams the kernel drops are
+ * counted as lost after a 20 ms stall. Latency ping-pongs one datagram --pings
+ * times. Off Linux every mode runs the sendto path.
+ *
+ * Usage:
+ *   ./bench_quiche_udp [--modes sendto,mmsg,gso] [--datagrams N] [--size N]
+ *                      [--window N] [--pings N] [--runs N] [--json out.json]
+ *
+ * Writes the JSON report described in bench_common.h (stdout by default).
+ */
+
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include "../build/include/quiche_udp.h"
+#include "bench_common.h"
+
+#define STALL_MS 20
+
+typedef struct Mode {
+    const char* name;
+    uint32_t batch_size;
+    int offloads;
+} Mode;
+
+static const Mode kModes[] = {
+    { "sendto", 1, 0 },
+    { "mmsg", 32, 0 },
+    { "gso", 32, 1 },
+};
+
+typedef struct Bench {
+    uv_loop_t* loop;
+    QuicheUdpSocket* sender;
+    QuicheUdpSocket* receiver;
+    struct sockaddr_storage receiver_addr;
+    socklen_t receiver_addr_len;
+    uint8_t* payload;
+    size_t size;
+
+    /* Throughput phase */
+    uint64_t target;
+    uint64_t queued;
+    uint64_t received;
+    uint64_t lost;
+    uint64_t received_at_tick;
+    uint32_t window;
+    uv_timer_t stall_timer;
+
+    /* Latency phase */
+    int pinging;
+    int pings_left;
+    double ping_sent_ms;
+    BenchSeries* rtt;
+} Bench;
+
+static uint64_t in_flight(const Bench* b) {
+    return b->queued - b->received - b->lost;
+}
+
+/* Top the window up and flush, like a QUIC sender after an ACK */
+static void pump(Bench* b) {
+    while (b->queued < b->target && in_flight(b) < b->window) {
+        memcpy(b->payload, &b->queued, sizeof(b->queued));
+        if (quiche_udp_send(b->sender, b->payload, b->size, (struct sockaddr*)&b->receiver_addr,
+                            b->receiver_addr_len, NULL) != 0) {
+            break;  /* queue full: on_writable resumes */
+        }
+        b->queued++;
+    }
+    quiche_udp_flush(b->sender);
+}
+
+static void check_done(Bench* b) {
+    if (b->received + b->lost >= b->target) uv_stop(b->loop);
+}
+
+static void on_sender_writable(QuicheUdpSocket* sock, void* user_data) {
+    (void)sock;
+    pump((Bench*)user_data);
+}
+
+static void send_ping(Bench* b);
+
+static void on_stall(uv_timer_t* timer) {
+    Bench* b = (Bench*)timer->data;
+    if (b->pinging) {
+        if (bench_now_ms() - b->ping_sent_ms >= STALL_MS) send_ping(b);  /* ping or echo lost */
+        return;
+    }
+    if (b->received == b->received_at_tick && in_flight(b) > 0 && quiche_udp_queued(b->sender) == 0) {
+        b->lost += in_flight(b);  /* dropped by a full socket buffer */
+        check_done(b);
+        pump(b);
+    }
+    b->received_at_tick = b->received;
+}
+
+static void on_receiver_recv(QuicheUdpSocket* sock, uint8_t* data, size_t len,
+                             const struct sockaddr* from, socklen_t from_len,
+                             const struct sockaddr* to, socklen_t to_len, void* user_data) {
+    Bench* b = (Bench*)user_data;
+    (void)to;
+    (void)to_len;
+    if (b->pinging) {
+        quiche_udp_send(sock, data, len, from, from_len, NULL);
+        quiche_udp_flush(sock);
+        return;
+    }
+    b->received++;
+    check_done(b);
+    if (in_flight(b) <= b->window / 2) pump(b);
+}
+
+static void send_ping(Bench* b) {
+    b->ping_sent_ms = bench_now_ms();
+    quiche_udp_send(b->sender, b->payload, b->size, (struct sockaddr*)&b->receiver_addr,
+                    b->receiver_addr_len, NULL);
+    quiche_udp_flush(b->sender);
+}
+
+static void on_sender_recv(QuicheUdpSocket* sock, uint8_t* data, size_t len,
+                           const struct sockaddr* from, socklen_t from_len,
+                           const struct sockaddr* to, socklen_t to_len, void* user_data) {
+    Bench* b = (Bench*)user_data;
+    (void)sock;
+    (void)data;
+    (void)len;
+    (void)from;
+    (void)from_len;
+    (void)to;
+    (void)to_len;
+    if (!b->pinging) return;
+    bench_series_add(b->rtt, (bench_now_ms() - b->ping_sent_ms) * 1000.0);
+    if (--b->pings_left > 0) {
+        send_ping(b);
+    } else {
+        uv_stop(b->loop);
+    }
+}
+
+static int open_pair(Bench* b, const Mode* mode) {
+    QuicheUdpConfig config;
+    quiche_udp_config_default(&config);
+    config.batch_size = mode->batch_size;
+    config.gso = mode->offloads;
+    config.gro = mode->offloads;
+
+    struct sockaddr_in addr;
+    uv_ip4_addr("127.0.0.1", 0, &addr);
+    int rc = quiche_udp_open(b->loop, (struct sockaddr*)&addr, &config, on_sender_recv, b, &b->sender);
+    if (rc == 0) {
+        rc = quiche_udp_open(b->loop, (struct sockaddr*)&addr, &config, on_receiver_recv, b,
+                             &b->receiver);
+    }
+    if (rc != 0) {
+        fprintf(stderr, "quiche_udp_open failed: %s\n", uv_strerror(rc));
+        return rc;
+    }
+    quiche_udp_on_writable(b->sender, on_sender_writable);
+    quiche_udp_local_addr(b->receiver, &b->receiver_addr, &b->receiver_addr_len);
+    return 0;
+}
+
+static void close_pair(Bench* b) {
+    quiche_udp_close(b->sender);
+    quiche_udp_close(b->receiver);
+    uv_run(b->loop, UV_RUN_NOWAIT);
+}
+
+int main(int argc, char** argv) {
+    const char* modes = "sendto,mmsg,gso";
+    uint64_t datagrams = 200000;
+    int size = 1350;
+    int window = 256;
+    int pings = 2000;
+    int runs = 5;
+    const char* json_path = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--modes") == 0 && i + 1 < argc) {
+            modes = argv[++i];
+        } else if (strcmp(argv[i], "--datagrams") == 0 && i + 1 < argc) {
+            datagrams = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--size") == 0 && i + 1 < argc) {
+            size = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--window") == 0 && i + 1 < argc) {
+            window = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--pings") == 0 && i + 1 < argc) {
+            pings = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--runs") == 0 && i + 1 < argc) {
+            runs = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            json_path = argv[++i];
+        } else {
+            fprintf(stderr, "Unknown argument: %s\n", argv[i]);
+            return 1;
+        }
+    }
+    if (datagrams == 0 || size < 8 || size > 1500 || window <= 0 || pings <= 0 || runs <= 0) {
+        fprintf(stderr, "--datagrams, --window, --pings and --runs must be positive, --size 8-1500\n");
+        return 1;
+    }
+
+    Bench b;
+    memset(&b, 0, sizeof(b));
+    b.loop = uv_default_loop();
+    b.size = (size_t)size;
+    b.window = (uint32_t)window;
+    b.payload = (uint8_t*)calloc(1, b.size);
+    uv_timer_init(b.loop, &b.stall_timer);
+    b.stall_timer.data = &b;
+
+    /* Two series per mode plus the extra_json summary */
+    static BenchSeries series[2 * (sizeof(kModes) / sizeof(kModes[0]))];
+    static char names[2 * (sizeof(kModes) / sizeof(kModes[0]))][48];
+    char extra[1024];
+    size_t extra_len = (size_t)snprintf(extra, sizeof(extra),
+                                        "\"datagram_size\": %d, \"window\": %d, \"modes\": {", size, window);
+    BenchReport report = { "quiche_udp", "loopback", 0.0, 0.0, 0.0 };
+    int rc = 0;
+    int num_modes = 0;
+
+    for (size_t m = 0; m < sizeof(kModes) / sizeof(kModes[0]) && rc == 0; m++) {
+        const Mode* mode = &kModes[m];
+        if (!strstr(modes, mode->name)) continue;
+        if (open_pair(&b, mode) != 0) {
+            rc = 1;
+            break;
+        }
+
+        BenchSeries* throughput = &series[2 * m];
+        BenchSeries* rtt = &series[2 * m + 1];
+        snprintf(names[2 * m], sizeof(names[0]), "throughput_%s", mode->name);
+        snprintf(names[2 * m + 1], sizeof(names[0]), "rtt_%s", mode->name);
+        throughput->name = names[2 * m];
+        throughput->unit = "MB/s";
+        rtt->name = names[2 * m + 1];
+        rtt->unit = "us";
+
+        fprintf(stderr, "Benchmarking %s: %d runs of %llu x %d-byte datagrams (gso %d, gro %d) "
+                        "(+1 warm-up)\n", mode->name, runs, (unsigned long long)datagrams, size,
+                quiche_udp_gso_enabled(b.sender), quiche_udp_gro_enabled(b.receiver));
+        QuicheUdpStats send_start;
+        QuicheUdpStats recv_start;
+        uint64_t lost_total = 0;
+        for (int run = 0; run <= runs; run++) {
+            if (run == 1) {
+                quiche_udp_stats(b.sender, &send_start);
+                quiche_udp_stats(b.receiver, &recv_start);
+            }
+            b.target = datagrams;
+            b.queued = b.received = b.lost = b.received_at_tick = 0;
+            uv_timer_start(&b.stall_timer, on_stall, STALL_MS, STALL_MS);
+            double t0 = bench_now_ms();
+            pump(&b);
+            uv_run(b.loop, UV_RUN_DEFAULT);
+            double elapsed_ms = bench_now_ms() - t0;
+            uv_timer_stop(&b.stall_timer);
+
+            if (run == 0) continue; /* warm-up */
+            bench_series_add(throughput, (double)b.received * b.size / 1e6 / (elapsed_ms / 1000.0));
+            lost_total += b.lost;
+        }
+
+        QuicheUdpStats send_end;
+        QuicheUdpStats recv_end;
+        quiche_udp_stats(b.sender, &send_end);
+        quiche_udp_stats(b.receiver, &recv_end);
+        double sent = (double)(send_end.datagrams_sent - send_start.datagrams_sent);
+        double received = (double)(recv_end.datagrams_received - recv_start.datagrams_received);
+
+        /* Latency: one datagram in flight, echoed back by the receiver */
+        b.pinging = 1;
+        b.pings_left = pings;
+        b.rtt = rtt;
+        uv_timer_start(&b.stall_timer, on_stall, STALL_MS, STALL_MS);
+        send_ping(&b);
+        uv_run(b.loop, UV_RUN_DEFAULT);
+        uv_timer_stop(&b.stall_timer);
+        b.pinging = 0;
+
+        extra_len += (size_t)snprintf(extra + extra_len, sizeof(extra) - extra_len,
+                                      "%s\"%s\": {\"send_syscalls_per_datagram\": %.4f, "
+                                      "\"recv_syscalls_per_datagram\": %.4f, \"loss\": %.5f, "
+                                      "\"gso\": %d, \"gro\": %d}",
+                                      num_modes ? ", " : "", mode->name,
+                                      sent ? (send_end.send_syscalls - send_start.send_syscalls) / sent : 0.0,
+                                      received ? (recv_end.recv_syscalls - recv_start.recv_syscalls) / received : 0.0,
+                                      sent ? lost_total / sent : 0.0,
+                                      quiche_udp_gso_enabled(b.sender), quiche_udp_gro_enabled(b.receiver));
+        num_modes++;
+        bench_report_add_series(&report, throughput);
+        bench_report_add_series(&report, rtt);
+        close_pair(&b);
+    }
+    snprintf(extra + extra_len, sizeof(extra) - extra_len, "}");
+
+    if (rc == 0) {
+        report.extra_json = extra;
+        rc = bench_report_write(&report, json_path) != 0;
+    }
+
+    for (size_t i = 0; i < sizeof(series) / sizeof(series[0]); i++) bench_series_free(&series[i]);
+    uv_close((uv_handle_t*)&b.stall_timer, NULL);
+    uv_run(b.loop, UV_RUN_NOWAIT);
+    free(b.payload);
+    return rc;
+}
@@ -0,0 +1,196 @@
+/**
+ * Benchmark for the sherpa-onnx static libs (TTS build): per-utterance synthesis
+ * latency, real-time factor and peak memory.
+ *
+ * --sessions N runs N TTS instances at once, one thread each, the way ASR and
+ * TTS overlap in an app; latency then covers every session's utterances.
+ * --shared-runtime puts all of them on one ORT thread pool of --threads threads
+ * (SherpaOnnxInitSharedRuntime) instead of --threads per session. --provider
+ * picks the execution provider ("auto": the best one the ORT build has).
+ *
+ * Usage:
+ *   ./bench_sherpa <vits_model.onnx> <tokens.txt> <espeak-ng-data dir>
+ *                  [--runs N] [--threads N] [--sessions N] [--provider P]
+ *                  [--shared-runtime] [--json out.json]
+ *
+ * Writes the JSON report described in bench_common.h (stdout by default).
+ */
+
+#include <pthread.h>
+
+#include "../build/include/sherpaonnx/c-api.h"
+#if __has_include("../build/include/sherpaonnx/sherpa-onnx-shared.h")
+#include "../build/include/sherpaonnx/sherpa-onnx-shared.h"
+#define BENCH_SHERPA_SHARED 1
+#endif
+#include "bench_common.h"
+
+static const char* kSentences[] = {
+    "The quick brown fox jumps over the lazy dog.",
+    "On-device speech synthesis keeps latency low and audio private.",
+    "Please confirm the meeting for Tuesday at three in the afternoon.",
+};
+#define NUM_SENTENCES (sizeof(kSentences) / sizeof(kSentences[0]))
+
+/* One TTS instance and the samples it produced */
+typedef struct Session {
+    const SherpaOnnxOfflineTts* tts;
+    int index;
+    int runs;
+    BenchSeries synth;
+    BenchSeries per_audio_sec;
+    double processing_ms;
+    double media_ms;
+    int rc;
+} Session;
+
+static void* run_session(void* arg) {
+    Session* s = (Session*)arg;
+    for (int i = 0; i <= s->runs; i++) {
+        const char* text = kSentences[(i + s->index) % NUM_SENTENCES];
+        double t0 = bench_now_ms();
+        const SherpaOnnxGeneratedAudio* audio = SherpaOnnxOfflineTtsGenerate(s->tts, text, 0, 1.0f);
+        double elapsed = bench_now_ms() - t0;
+        if (!audio || audio->n <= 0 || audio->sample_rate <= 0) {
+            fprintf(stderr, "SherpaOnnxOfflineTtsGenerate failed\n");
+            if (audio) SherpaOnnxDestroyOfflineTtsGeneratedAudio(audio);
+            s->rc = 1;
+            break;
+        }
+        double audio_ms = 1000.0 * audio->n / audio->sample_rate;
+        SherpaOnnxDestroyOfflineTtsGeneratedAudio(audio);
+
+        if (i == 0) continue; /* warm-up */
+        bench_series_add(&s->synth, elapsed);
+        bench_series_add(&s->per_audio_sec, elapsed * 1000.0 / audio_ms);
+        s->processing_ms += elapsed;
+        s->media_ms += audio_ms;
+    }
+    return NULL;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 4) {
+        fprintf(stderr, "Usage: %s <vits_model.onnx> <tokens.txt> <espeak-ng-data dir> "
+                        "[--runs N] [--threads N] [--sessions N] [--provider P] [--shared-runtime] "
+                        "[--json out.json]\n", argv[0]);
+        return 1;
+    }
+    const char* model_path = argv[1];
+    const char* tokens_path = argv[2];
+    const char* data_dir = argv[3];
+    int runs = 10;
+    int threads = 2;
+    int sessions = 1;
+    const char* provider = "cpu";
+    int shared_runtime = 0;
+    const char* json_path = NULL;
+    for (int i = 4; i < argc; i++) {
+        if (strcmp(argv[i], "--runs") == 0 && i + 1 < argc) {
+            runs = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--sessions") == 0 && i + 1 < argc) {
+            sessions = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--provider") == 0 && i + 1 < argc) {
+            provider = argv[++i];
+        } else if (strcmp(argv[i], "--shared-runtime") == 0) {
+            shared_runtime = 1;
+        } else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            json_path = argv[++i];
+        } else {
+            fprintf(stderr, "Unknown argument: %s\n", argv[i]);
+            return 1;
+        }
+    }
+    if (runs <= 0 || threads <= 0 || sessions <= 0) {
+        fprintf(stderr, "--runs, --threads and --sessions must be positive\n");
+        return 1;
+    }
+
+#ifdef BENCH_SHERPA_SHARED
+    if (strcmp(provider, "auto") == 0) provider = SherpaOnnxPreferredProvider();
+    if (shared_runtime) {
+        SherpaOnnxSharedRuntimeConfig shared = { threads, 1, 0 };
+        if (SherpaOnnxInitSharedRuntime(&shared) != 0) return 1;
+    }
+#else
+    if (shared_runtime || strcmp(provider, "auto") == 0) {
+        fprintf(stderr, "--shared-runtime / --provider auto need a build with -shared-runtime on\n");
+        return 1;
+    }
+#endif
+
+    SherpaOnnxOfflineTtsConfig config;
+    memset(&config, 0, sizeof(config));
+    config.model.vits.model = model_path;
+    config.model.vits.tokens = tokens_path;
+    config.model.vits.data_dir = data_dir;
+    config.model.num_threads = threads;
+    config.model.provider = provider;
+
+    Session* all = (Session*)calloc((size_t)sessions, sizeof(Session));
+    pthread_t* workers = (pthread_t*)calloc((size_t)sessions, sizeof(pthread_t));
+    if (!all || !workers) {
+        fprintf(stderr, "calloc failed\n");
+        return 1;
+    }
+    int rc = 0;
+    double t_load = bench_now_ms();
+    for (int i = 0; i < sessions; i++) {
+        all[i].tts = SherpaOnnxCreateOfflineTts(&config);
+        all[i].index = i;
+        all[i].runs = runs;
+        if (!all[i].tts) {
+            fprintf(stderr, "Failed to create sherpa-onnx TTS from %s\n", model_path);
+            rc = 1;
+            sessions = i;
+            break;
+        }
+    }
+    double load_ms = bench_now_ms() - t_load;
+
+    BenchSeries synth = { "synthesize_ms" };
+    BenchSeries per_audio_sec = { "ms_per_audio_sec" };
+    double processing_ms = 0.0;
+    double media_ms = 0.0;
+
+    if (rc == 0) {
+        fprintf(stderr, "Benchmarking sherpa-onnx TTS: %d session(s) x %d utterances (+1 warm-up), "
+                        "provider %s, %s runtime\n", sessions, runs, provider,
+                shared_runtime ? "shared" : "per-session");
+        for (int i = 0; i < sessions; i++) pthread_create(&workers[i], NULL, run_session, &all[i]);
+        for (int i = 0; i < sessions; i++) pthread_join(workers[i], NULL);
+    }
+    for (int i = 0; i < sessions; i++) {
+        Session* s = &all[i];
+        rc |= s->rc;
+        for (size_t j = 0; j < s->synth.count; j++) bench_series_add(&synth, s->synth.values[j]);
+        for (size_t j = 0; j < s->per_audio_sec.count; j++) {
+            bench_series_add(&per_audio_sec, s->per_audio_sec.values[j]);
+        }
+        processing_ms += s->processing_ms;
+        media_ms += s->media_ms;
+        bench_series_free(&s->synth);
+        bench_series_free(&s->per_audio_sec);
+        SherpaOnnxDestroyOfflineTts(s->tts);
+    }
+
+    if (rc == 0) {
+        char extra[256];
+        snprintf(extra, sizeof(extra),
+                 "\"sessions\": %d, \"threads\": %d, \"provider\": \"%s\", \"shared_runtime\": %s",
+                 sessions, threads, provider, shared_runtime ? "true" : "false");
+        BenchReport report = { "sherpaonnx", model_path, load_ms, processing_ms, media_ms };
+        report.extra_json = extra;
+        bench_report_add_series(&report, &synth);
+        bench_report_add_series(&report, &per_audio_sec);
+        rc = bench_report_write(&report, json_path) != 0;
+    }
+
+    bench_series_free(&synth);
+    bench_series_free(&per_audio_sec);
+    free(all);
+    free(workers);
+    return rc;
+}
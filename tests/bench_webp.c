@@ -0,0 +1,221 @@
+/**
+ * Benchmark for the libwebp static libs: encode and decode throughput (MB/s of RGBA
+ * pixels) at several quality/method settings over a fixed corpus, plus peak memory.
+ *
+ * The corpus is generated in-process so every build and device measures the same
+ * pixels: "photo" (smooth gradients with fine noise) and "ui" (flat fills, hard edges
+ * and an alpha ramp), both --size x --size.
+ *
+ * Usage:
+ *   ./bench_webp [--runs N] [--size N] [--threads 0|1] [--json out.json]
+ *
+ * Writes the JSON report described in bench_common.h (stdout by default), plus
+ * "simd" (the SIMD paths build-webp.py verified were compiled into the library) and
+ * "threads" (whether encoding used WebPConfig.thread_level).
+ */
+
+#include <stdint.h>
+
+#include "../build/include/webp/decode.h"
+#include "../build/include/webp/encode.h"
+#include "bench_common.h"
+
+/* Set by build-webp.py from the library's generated config.h */
+#ifndef BENCH_WEBP_SIMD
+#define BENCH_WEBP_SIMD "unknown"
+#endif
+
+typedef struct {
+    const char* label;
+    int lossless;
+    float quality;
+    int method;
+} WebpSetting;
+
+static const WebpSetting kSettings[] = {
+    { "lossy_q75_m0", 0, 75.0f, 0 },
+    { "lossy_q75_m4", 0, 75.0f, 4 },
+    { "lossy_q90_m6", 0, 90.0f, 6 },
+    { "lossless_q75_m4", 1, 75.0f, 4 },
+};
+#define NUM_SETTINGS (sizeof(kSettings) / sizeof(kSettings[0]))
+#define NUM_IMAGES 2
+
+static uint32_t lcg_next(uint32_t* state) {
+    *state = *state * 1664525u + 1013904223u;
+    return *state >> 8;
+}
+
+/* Smooth colour gradients with +/-12 of per-pixel noise, opaque */
+static void fill_photo(uint8_t* rgba, int size) {
+    uint32_t seed = 12345;
+    for (int y = 0; y < size; y++) {
+        for (int x = 0; x < size; x++) {
+            uint8_t* p = rgba + ((size_t)y * size + x) * 4;
+            double r = 128.0 + 100.0 * sin(x * 0.013 + y * 0.007);
+            double g = 128.0 + 90.0 * sin(x * 0.005 - y * 0.011 + 1.0);
+            double b = 128.0 + 80.0 * cos((x + y) * 0.009);
+            int noise = (int)(lcg_next(&seed) % 25) - 12;
+            p[0] = (uint8_t)fmin(255.0, fmax(0.0, r + noise));
+            p[1] = (uint8_t)fmin(255.0, fmax(0.0, g + noise));
+            p[2] = (uint8_t)fmin(255.0, fmax(0.0, b + noise));
+            p[3] = 255;
+        }
+    }
+}
+
+/* Flat panels on a 64 px grid, text-like 1 px strokes, alpha ramp on the right quarter */
+static void fill_ui(uint8_t* rgba, int size) {
+    static const uint8_t kPalette[4][3] = {
+        { 245, 245, 247 }, { 30, 120, 220 }, { 255, 255, 255 }, { 52, 199, 89 },
+    };
+    for (int y = 0; y < size; y++) {
+        for (int x = 0; x < size; x++) {
+            uint8_t* p = rgba + ((size_t)y * size + x) * 4;
+            const uint8_t* c = kPalette[((x / 64) + 3 * (y / 64)) % 4];
+            int stroke = (y % 16 == 8) && (x % 64 > 8) && (x % 64 < 56) && ((x / 3) % 5 != 0);
+            p[0] = stroke ? 20 : c[0];
+            p[1] = stroke ? 20 : c[1];
+            p[2] = stroke ? 20 : c[2];
+            p[3] = x < size * 3 / 4 ? 255 : (uint8_t)(255 - 255 * (x - size * 3 / 4) / (size / 4));
+        }
+    }
+}
+
+static double mb_per_sec(size_t bytes, double ms) {
+    return ms > 0.0 ? (bytes / 1e6) / (ms / 1000.0) : 0.0;
+}
+
+/* Encode one image; returns the encoded size (0 on failure) and the elapsed ms */
+static size_t encode_image(const WebpSetting* setting, int threads, const uint8_t* rgba, int size,
+                           WebPMemoryWriter* writer, double* elapsed_ms) {
+    WebPConfig config;
+    WebPPicture picture;
+    if (!WebPConfigInit(&config) || !WebPPictureInit(&picture)) return 0;
+    config.lossless = setting->lossless;
+    config.quality = setting->quality;
+    config.method = setting->method;
+    config.thread_level = threads;
+    picture.width = size;
+    picture.height = size;
+    picture.use_argb = setting->lossless;
+    WebPMemoryWriterInit(writer);
+    picture.writer = WebPMemoryWrite;
+    picture.custom_ptr = writer;
+
+    /* RGBA import (colour conversion for lossy) is part of the encode cost */
+    double t0 = bench_now_ms();
+    int ok = WebPPictureImportRGBA(&picture, rgba, size * 4) && WebPEncode(&config, &picture);
+    *elapsed_ms = bench_now_ms() - t0;
+    WebPPictureFree(&picture);
+    return ok ? writer->size : 0;
+}
+
+int main(int argc, char** argv) {
+    int runs = 5;
+    int size = 1024;
+    int threads = 1;
+    const char* json_path = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--runs") == 0 && i + 1 < argc) {
+            runs = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--size") == 0 && i + 1 < argc) {
+            size = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = atoi(argv[++i]) != 0;
+        } else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            json_path = argv[++i];
+        } else {
+            fprintf(stderr, "Usage: %s [--runs N] [--size N] [--threads 0|1] [--json out.json]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (runs <= 0 || size < 64) {
+        fprintf(stderr, "--runs must be positive and --size at least 64\n");
+        return 1;
+    }
+
+    size_t image_bytes = (size_t)size * size * 4;
+    uint8_t* images[NUM_IMAGES];
+    uint8_t* decoded = (uint8_t*)malloc(image_bytes);
+    images[0] = (uint8_t*)malloc(image_bytes);
+    images[1] = (uint8_t*)malloc(image_bytes);
+    if (!decoded || !images[0] || !images[1]) {
+        fprintf(stderr, "malloc failed\n");
+        return 1;
+    }
+    fill_photo(images[0], size);
+    fill_ui(images[1], size);
+
+    char names[NUM_SETTINGS][2][48];
+    BenchSeries encode[NUM_SETTINGS];
+    BenchSeries decode[NUM_SETTINGS];
+    memset(encode, 0, sizeof(encode));
+    memset(decode, 0, sizeof(decode));
+    for (size_t s = 0; s < NUM_SETTINGS; s++) {
+        snprintf(names[s][0], sizeof(names[s][0]), "encode_%s", kSettings[s].label);
+        snprintf(names[s][1], sizeof(names[s][1]), "decode_%s", kSettings[s].label);
+        encode[s].name = names[s][0];
+        encode[s].unit = "MB/s";
+        decode[s].name = names[s][1];
+        decode[s].unit = "MB/s";
+    }
+
+    int rc = 0;
+    fprintf(stderr, "Benchmarking libwebp %d.%d.%d (SIMD: %s, threads: %d): %d runs of %d settings "
+                    "x %d images at %dx%d (+1 warm-up)\n",
+            (WebPGetDecoderVersion() >> 16) & 0xff, (WebPGetDecoderVersion() >> 8) & 0xff,
+            WebPGetDecoderVersion() & 0xff, BENCH_WEBP_SIMD, threads, runs, (int)NUM_SETTINGS,
+            NUM_IMAGES, size, size);
+    for (int run = 0; run <= runs && rc == 0; run++) {
+        for (size_t s = 0; s < NUM_SETTINGS && rc == 0; s++) {
+            for (int img = 0; img < NUM_IMAGES; img++) {
+                WebPMemoryWriter writer;
+                double encode_ms = 0.0;
+                size_t encoded = encode_image(&kSettings[s], threads, images[img], size, &writer, &encode_ms);
+                if (encoded == 0) {
+                    fprintf(stderr, "WebPEncode failed (%s, image %d)\n", kSettings[s].label, img);
+                    WebPMemoryWriterClear(&writer);
+                    rc = 1;
+                    break;
+                }
+
+                double t0 = bench_now_ms();
+                uint8_t* out = WebPDecodeRGBAInto(writer.mem, encoded, decoded, image_bytes, size * 4);
+                double decode_ms = bench_now_ms() - t0;
+                WebPMemoryWriterClear(&writer);
+                if (!out) {
+                    fprintf(stderr, "WebPDecodeRGBAInto failed (%s, image %d)\n", kSettings[s].label, img);
+                    rc = 1;
+                    break;
+                }
+
+                if (run == 0) continue; /* warm-up */
+                bench_series_add(&encode[s], mb_per_sec(image_bytes, encode_ms));
+                bench_series_add(&decode[s], mb_per_sec(image_bytes, decode_ms));
+            }
+        }
+    }
+
+    if (rc == 0) {
+        char extra[256];
+        snprintf(extra, sizeof(extra), "\"simd\": \"%s\", \"threads\": %s, \"corpus\": \"synthetic-%dpx\"",
+                 BENCH_WEBP_SIMD, threads ? "true" : "false", size);
+        BenchReport report = { "webp", "synthetic", 0.0, 0.0, 0.0 };
+        report.extra_json = extra;
+        for (size_t s = 0; s < NUM_SETTINGS; s++) {
+            bench_report_add_series(&report, &encode[s]);
+            bench_report_add_series(&report, &decode[s]);
+        }
+        rc = bench_report_write(&report, json_path) != 0;
+    }
+
+    for (size_t s = 0; s < NUM_SETTINGS; s++) {
+        bench_series_free(&encode[s]);
+        bench_series_free(&decode[s]);
+    }
+    free(images[0]);
+    free(images[1]);
+    free(decoded);
+    return rc;
+}
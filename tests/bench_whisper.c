@@ -0,0 +1,130 @@
+/**
+ * Benchmark for the whisper.cpp static libs: per-window mel, encoder and full
+ * transcription latency, real-time factor and peak memory.
+ *
+ * The input is split into fixed windows (default 5 s, 16 kHz) and each window is
+ * transcribed independently, the way a streaming dictation loop calls whisper.
+ *
+ * Usage:
+ *   ./bench_whisper <ggml_model.bin> [--windows N] [--window-sec S] [--threads N]
+ *                   [--json out.json]
+ *
+ * Writes the JSON report described in bench_common.h (stdout by default).
+ */
+
+#include "../build/include/whispercpp/whisper.h"
+#include "bench_common.h"
+
+#define WHISPER_RATE 16000
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <ggml_model.bin> [--windows N] [--window-sec S] "
+                        "[--threads N] [--json out.json]\n", argv[0]);
+        return 1;
+    }
+    const char* model_path = argv[1];
+    int windows = 6;
+    int window_sec = 5;
+    int threads = 4;
+    const char* json_path = NULL;
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "--windows") == 0 && i + 1 < argc) {
+            windows = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--window-sec") == 0 && i + 1 < argc) {
+            window_sec = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            json_path = argv[++i];
+        } else {
+            fprintf(stderr, "Unknown argument: %s\n", argv[i]);
+            return 1;
+        }
+    }
+    if (windows <= 0 || window_sec <= 0 || threads <= 0) {
+        fprintf(stderr, "--windows, --window-sec and --threads must be positive\n");
+        return 1;
+    }
+
+    double t_load = bench_now_ms();
+    struct whisper_context* ctx = whisper_init_from_file_with_params(
+        model_path, whisper_context_default_params());
+    if (!ctx) {
+        fprintf(stderr, "Failed to load whisper model: %s\n", model_path);
+        return 1;
+    }
+    double load_ms = bench_now_ms() - t_load;
+
+    int window_samples = window_sec * WHISPER_RATE;
+    float* pcm = (float*)malloc((size_t)window_samples * sizeof(float));
+    if (!pcm) {
+        fprintf(stderr, "malloc failed\n");
+        whisper_free(ctx);
+        return 1;
+    }
+    bench_fill_signal(pcm, (size_t)window_samples, WHISPER_RATE);
+
+    struct whisper_full_params params = whisper_full_default_params(WHISPER_SAMPLING_GREEDY);
+    params.n_threads = threads;
+    params.print_progress = false;
+    params.print_realtime = false;
+    params.print_timestamps = false;
+    params.print_special = false;
+    params.no_context = true;
+    params.language = "en";
+
+    BenchSeries mel = { "mel_ms" };
+    BenchSeries encode = { "encode_ms" };
+    BenchSeries transcribe = { "transcribe_ms" };
+    double processing_ms = 0.0;
+    int rc = 0;
+
+    fprintf(stderr, "Benchmarking whisper: %d x %d s windows (+1 warm-up)\n", windows, window_sec);
+    for (int i = 0; i <= windows; i++) {
+        /* Stage timings: mel spectrogram and encoder on their own */
+        double t0 = bench_now_ms();
+        if (whisper_pcm_to_mel(ctx, pcm, window_samples, threads) != 0) {
+            fprintf(stderr, "whisper_pcm_to_mel failed\n");
+            rc = 1;
+            break;
+        }
+        double t1 = bench_now_ms();
+        if (whisper_encode(ctx, 0, threads) != 0) {
+            fprintf(stderr, "whisper_encode failed\n");
+            rc = 1;
+            break;
+        }
+        double t2 = bench_now_ms();
+
+        /* End-to-end: mel + encode + decode of the window */
+        if (whisper_full(ctx, params, pcm, window_samples) != 0) {
+            fprintf(stderr, "whisper_full failed\n");
+            rc = 1;
+            break;
+        }
+        double t3 = bench_now_ms();
+
+        if (i == 0) continue; /* warm-up */
+        bench_series_add(&mel, t1 - t0);
+        bench_series_add(&encode, t2 - t1);
+        bench_series_add(&transcribe, t3 - t2);
+        processing_ms += t3 - t2;
+    }
+
+    if (rc == 0) {
+        BenchReport report = { "whispercpp", model_path, load_ms, processing_ms,
+                               transcribe.count * window_sec * 1000.0 };
+        bench_report_add_series(&report, &mel);
+        bench_report_add_series(&report, &encode);
+        bench_report_add_series(&report, &transcribe);
+        rc = bench_report_write(&report, json_path) != 0;
+    }
+
+    bench_series_free(&mel);
+    bench_series_free(&encode);
+    bench_series_free(&transcribe);
+    free(pcm);
+    whisper_free(ctx);
+    return rc;
+}
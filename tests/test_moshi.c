@@ -1,7 +1,15 @@
 /**
  * End-to-end test for libmoshi_ffi: Mimi encode/decode + Moshi LM forward pass.
  *
- * Pipeline: Generate PCM sine wave -> mimi_encode -> moshi_forward -> mimi_decode -> WAV file
+ * Pipeline: Generate PCM sine wave -> mimi_encode -> moshi_forward -> mimi_decode -> WAV file,
+ * then the same signal through the real-time streaming pipeline (moshi_stream_*)
+ * driven by a simulated audio callback. moshi_forward_topk is checked against a
+ * host top-k of moshi_forward's logits; with a Metal or CUDA build this runs the
+ * on-device selection on the GPU. moshi_step on a session and moshi_batch_step on a
+ * one-slot batch, sharing the loaded weights, must produce the same tokens and
+ * the same delay-aligned audio frames.
+ * mimi_encode_arena / mimi_decode_arena must match the buffer versions and
+ * reuse their arena's blocks after a reset.
  *
  * Build (Linux):
  *   gcc -o test_moshi test_moshi.c \
@@ -15,7 +23,12 @@
  *       -lc++ -lm -lpthread
  *
  * Usage:
- *   ./test_moshi <mimi_model_path> <moshi_model_path> [output.wav]
+ *   ./test_moshi <mimi_model_path> <moshi_model_path> [output.wav] [f32|f16|bf16|auto]
+ *
+ * The optional dtype selects how the LM weights are loaded (default f32); a .gguf
+ * moshi_model_path loads quantized weights. The run ends with a startup report:
+ * load times, time-to-first-token (program start to first sampled text token)
+ * and peak resident set size.
  *
  * Example:
  *   ./test_moshi ~/.pixieai/models/mimi/model.safetensors \
@@ -32,6 +45,8 @@
 #include <string.h>
 #include <math.h>
 #include <stdint.h>
+#include <time.h>
+#include <sys/resource.h>
 
 /* Include the FFI header */
 #include "../build/include/moshi/moshi.h"
@@ -49,17 +64,61 @@
 #define TEST_FREQUENCY_HZ 440.0f
 #define TEST_NUM_SAMPLES ((int)(WAV_SAMPLE_RATE * TEST_DURATION_SEC))
 
+/* Simulated audio callback: 10 ms buffers for 3 s */
+#define STREAM_CALLBACK_SAMPLES 240
+#define STREAM_DURATION_SEC 3
+
 /* Maximum buffers */
 #define MAX_CODEBOOKS 32
 #define MAX_FRAMES 256
 #define MAX_PCM_OUT (MIMI_FRAME_SAMPLES * MAX_FRAMES)
 #define MAX_TEXT_VOCAB 65536
+#define MAX_TOPK 512
 
 static const char* check_error(void) {
     const char* err = moshi_last_error();
     return err ? err : "unknown error";
 }
 
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+/* Peak resident set size in MB (ru_maxrss is bytes on macOS, KB on Linux) */
+static double peak_rss_mb(void) {
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0.0;
+#ifdef __APPLE__
+    return usage.ru_maxrss / (1024.0 * 1024.0);
+#else
+    return usage.ru_maxrss / 1024.0;
+#endif
+}
+
+static int parse_dtype(const char* name, uint32_t* out) {
+    if (strcmp(name, "f32") == 0) *out = MOSHI_DTYPE_F32;
+    else if (strcmp(name, "f16") == 0) *out = MOSHI_DTYPE_F16;
+    else if (strcmp(name, "bf16") == 0) *out = MOSHI_DTYPE_BF16;
+    else if (strcmp(name, "auto") == 0) *out = MOSHI_DTYPE_AUTO;
+    else return -1;
+    return 0;
+}
+
+/**
+ * Load progress: prints whole-percent updates on one line.
+ */
+static void print_progress(void* user_data, uint64_t loaded, uint64_t total) {
+    int* last_percent = (int*)user_data;
+    int percent = total > 0 ? (int)(loaded * 100 / total) : 100;
+    if (percent == *last_percent) return;
+    *last_percent = percent;
+    printf("\r  %3d%% (%.0f / %.0f MB)", percent, loaded / 1e6, total / 1e6);
+    if (percent >= 100) printf("\n");
+    fflush(stdout);
+}
+
 /**
  * Generate a test PCM signal: 440Hz sine wave, 24kHz, mono, float32.
  */
@@ -74,6 +133,278 @@ static float* generate_test_pcm(int num_samples) {
     return pcm;
 }
 
+static void sleep_ms(double ms) {
+    struct timespec ts;
+    ts.tv_sec = (time_t)(ms / 1000.0);
+    ts.tv_nsec = (long)((ms - ts.tv_sec * 1000.0) * 1e6);
+    nanosleep(&ts, NULL);
+}
+
+/**
+ * Compare moshi_forward_topk(k) with the k largest of moshi_forward's logits for
+ * the same input from a fresh state: same count, highest first, each value the
+ * logit of its id, ids distinct, and no logit left out that beats the last one.
+ * Returns 0 on success, -1 on mismatch or error.
+ */
+static int check_topk(MoshiModel* model, uint32_t text_token,
+                      const uint32_t* codes, uint32_t num_codebooks, size_t k) {
+    static float logits[MAX_TEXT_VOCAB];
+    uint32_t ids[MAX_TOPK];
+    float values[MAX_TOPK];
+    uint32_t vocab = 0;
+
+    moshi_reset(model);
+    if (moshi_forward(model, text_token, codes, num_codebooks, logits, MAX_TEXT_VOCAB, &vocab) != 0) {
+        fprintf(stderr, "  FAIL: moshi_forward: %s\n", check_error());
+        return -1;
+    }
+    moshi_reset(model);
+    int32_t n = moshi_forward_topk(model, text_token, codes, num_codebooks, k, ids, values);
+    if (n < 0) {
+        fprintf(stderr, "  FAIL: moshi_forward_topk(%zu): %s\n", k, check_error());
+        return -1;
+    }
+    if ((size_t)n != (k < vocab ? k : vocab)) {
+        fprintf(stderr, "  FAIL: top-%zu returned %d entries (vocab %u)\n", k, n, vocab);
+        return -1;
+    }
+
+    for (int32_t i = 0; i < n; i++) {
+        float tol = 1e-3f * (1.0f + fabsf(values[i]));
+        if (ids[i] >= vocab || fabsf(values[i] - logits[ids[i]]) > tol) {
+            fprintf(stderr, "  FAIL: top-%zu entry %d: id %u value %f\n", k, i, ids[i], values[i]);
+            return -1;
+        }
+        if (i > 0 && values[i] > values[i - 1]) {
+            fprintf(stderr, "  FAIL: top-%zu not sorted at %d\n", k, i);
+            return -1;
+        }
+        for (int32_t j = 0; j < i; j++) {
+            if (ids[j] == ids[i]) {
+                fprintf(stderr, "  FAIL: top-%zu repeats id %u\n", k, ids[i]);
+                return -1;
+            }
+        }
+    }
+    float last = values[n - 1] + 1e-3f * (1.0f + fabsf(values[n - 1]));
+    int32_t above = 0;
+    for (uint32_t j = 0; j < vocab; j++) {
+        if (logits[j] > last) above++;
+    }
+    if (above > n - 1) {
+        fprintf(stderr, "  FAIL: top-%zu missed %d larger logits\n", k, above - (n - 1));
+        return -1;
+    }
+    return 0;
+}
+
+/* Counts the blocks an arena takes, to check that reset reuses them */
+typedef struct CountingHeap {
+    int allocs;
+    int frees;
+} CountingHeap;
+
+static void* counting_alloc(void* user_data, size_t size, size_t align) {
+    ((CountingHeap*)user_data)->allocs++;
+    return aligned_alloc(align, (size + align - 1) / align * align);
+}
+
+static void counting_free(void* user_data, void* ptr, size_t size) {
+    (void)size;
+    ((CountingHeap*)user_data)->frees++;
+    free(ptr);
+}
+
+/**
+ * mimi_encode_arena / mimi_decode_arena must return the same codes and PCM as
+ * the buffer versions, and a second round after moshi_arena_reset must not take
+ * new blocks from the allocator. Returns 0 on success, -1 on mismatch or error.
+ */
+static int check_arena_outputs(MimiCodec* codec, const float* pcm, size_t pcm_len,
+                               const uint32_t* codes, int num_frames, uint32_t num_codebooks,
+                               const float* decoded, int num_samples) {
+    CountingHeap heap = { 0, 0 };
+    MoshiAllocator allocator = { counting_alloc, counting_free, &heap };
+    /* Small blocks, so the PCM output takes a block of its own */
+    MoshiArena* arena = moshi_arena_create(4096, &allocator);
+    if (!arena) {
+        fprintf(stderr, "  FAIL: moshi_arena_create\n");
+        return -1;
+    }
+
+    int failed = 0;
+    int allocs_after_first = 0;
+    for (int round = 0; round < 2 && !failed; round++) {
+        moshi_arena_reset(arena);
+        mimi_reset(codec);
+        const uint32_t* arena_codes = NULL;
+        uint32_t arena_codebooks = 0;
+        int32_t frames = mimi_encode_arena(codec, arena, pcm, pcm_len, &arena_codes, &arena_codebooks);
+        if (frames != num_frames || arena_codebooks != num_codebooks) {
+            fprintf(stderr, "  FAIL: mimi_encode_arena gave %d frames x %u codebooks (%s)\n",
+                    frames, arena_codebooks, check_error());
+            failed = 1;
+            break;
+        }
+        if (memcmp(arena_codes, codes, (size_t)frames * arena_codebooks * sizeof(uint32_t)) != 0) {
+            fprintf(stderr, "  FAIL: mimi_encode_arena codes differ from mimi_encode\n");
+            failed = 1;
+            break;
+        }
+
+        mimi_reset(codec);
+        const float* arena_pcm = NULL;
+        int32_t samples = mimi_decode_arena(codec, arena, codes, num_codebooks, (size_t)num_frames, &arena_pcm);
+        if (samples != num_samples) {
+            fprintf(stderr, "  FAIL: mimi_decode_arena gave %d samples, expected %d (%s)\n",
+                    samples, num_samples, check_error());
+            failed = 1;
+            break;
+        }
+        for (int i = 0; i < samples; i++) {
+            if (fabsf(arena_pcm[i] - decoded[i]) > 1e-5f) {
+                fprintf(stderr, "  FAIL: mimi_decode_arena sample %d is %f, expected %f\n",
+                        i, arena_pcm[i], decoded[i]);
+                failed = 1;
+                break;
+            }
+        }
+        if (round == 0) {
+            allocs_after_first = heap.allocs;
+        } else if (heap.allocs != allocs_after_first) {
+            fprintf(stderr, "  FAIL: arena took %d new blocks after reset\n",
+                    heap.allocs - allocs_after_first);
+            failed = 1;
+        }
+    }
+
+    if (!failed) {
+        printf("  OK: arena outputs match, %zu bytes in %d blocks\n", moshi_arena_used(arena), heap.allocs);
+    }
+    moshi_arena_destroy(arena);
+    if (heap.frees != heap.allocs) {
+        fprintf(stderr, "  FAIL: arena freed %d of %d blocks\n", heap.frees, heap.allocs);
+        failed = 1;
+    }
+    return failed ? -1 : 0;
+}
+
+/**
+ * Step the same user frames through moshi_step on a fresh session and
+ * moshi_batch_step on a fresh one-slot batch, both greedy, and require identical
+ * output: the same text tokens; for the first moshi_acoustic_delay() steps no
+ * audio from moshi_step and pad codes from the batch; then the same frames.
+ * Returns 0 on success, -1 on mismatch or error.
+ */
+static int check_step_matches_batch(MoshiWeights* weights, const uint32_t* codes_buf,
+                                    int num_frames, uint32_t num_codebooks) {
+    MoshiModel* session = moshi_session_create(weights);
+    MoshiBatch* batch = session ? moshi_batch_create(weights, 1) : NULL;
+    if (!batch) {
+        fprintf(stderr, "  FAIL: %s\n", check_error());
+        moshi_free(session);
+        return -1;
+    }
+    uint32_t generated = moshi_generated_codebooks(session);
+    uint32_t num_user = moshi_audio_codebooks(session) - generated;
+    uint32_t pad = moshi_audio_pad_token(session);
+    uint32_t delay = moshi_acoustic_delay();
+    int failed = 0;
+    if (num_user > num_codebooks || generated > MAX_CODEBOOKS) {
+        fprintf(stderr, "  FAIL: model needs %u user codebooks, Mimi gave %u\n", num_user, num_codebooks);
+        failed = 1;
+    }
+
+    for (int frame = 0; frame < num_frames && !failed; frame++) {
+        uint32_t user[MAX_CODEBOOKS];
+        for (uint32_t cb = 0; cb < num_user; cb++) {
+            user[cb] = codes_buf[cb * num_frames + frame];
+        }
+        uint32_t step_text = 0, batch_text = 0;
+        uint32_t step_audio[MAX_CODEBOOKS], batch_audio[MAX_CODEBOOKS];
+        int32_t n_step = moshi_step(session, NULL, user, num_user,
+                                    &step_text, step_audio, MAX_CODEBOOKS);
+        int32_t n_batch = moshi_batch_step(batch, NULL, user, num_user, NULL,
+                                           &batch_text, batch_audio, MAX_CODEBOOKS);
+        if (n_step < 0 || n_batch < 0) {
+            fprintf(stderr, "  FAIL at frame %d: %s\n", frame, check_error());
+            failed = 1;
+            break;
+        }
+
+        int filling = (uint32_t)frame < delay;
+        if (n_step != (filling ? 0 : (int32_t)generated) || n_batch != (int32_t)generated) {
+            fprintf(stderr, "  FAIL at frame %d: step wrote %d codes, batch %d (delay %u)\n",
+                    frame, n_step, n_batch, delay);
+            failed = 1;
+        } else if (step_text != batch_text) {
+            fprintf(stderr, "  FAIL at frame %d: text token %u (step) vs %u (batch)\n",
+                    frame, step_text, batch_text);
+            failed = 1;
+        }
+        for (uint32_t cb = 0; cb < generated && !failed; cb++) {
+            uint32_t expected = filling ? pad : step_audio[cb];
+            if (batch_audio[cb] != expected) {
+                fprintf(stderr, "  FAIL at frame %d: codebook %u is %u (batch), expected %u\n",
+                        frame, cb, batch_audio[cb], expected);
+                failed = 1;
+            }
+        }
+    }
+
+    moshi_batch_free(batch);
+    moshi_free(session);
+    return failed ? -1 : 0;
+}
+
+/**
+ * Drive the streaming pipeline like an audio device would: every 10 ms push one
+ * buffer of captured PCM and pull one buffer for playback.
+ * Returns 0 on success, -1 if the pipeline reported an error.
+ */
+static int run_streaming(MimiCodec* codec, MoshiModel* model, const float* pcm, int num_samples) {
+    MoshiStream* stream = moshi_stream_create(codec, model, NULL);
+    if (!stream) {
+        fprintf(stderr, "  FAIL: moshi_stream_create: %s\n", check_error());
+        return -1;
+    }
+
+    float playback[STREAM_CALLBACK_SAMPLES];
+    int callbacks = STREAM_DURATION_SEC * WAV_SAMPLE_RATE / STREAM_CALLBACK_SAMPLES;
+    int pos = 0;
+    double next = now_ms();
+    for (int i = 0; i < callbacks; i++) {
+        /* Loop the test signal as "microphone" input */
+        int n = STREAM_CALLBACK_SAMPLES;
+        if (pos + n > num_samples) pos = 0;
+        moshi_stream_push(stream, pcm + pos, (size_t)n);
+        moshi_stream_pull(stream, playback, (size_t)n);
+        pos += n;
+
+        next += 1000.0 * STREAM_CALLBACK_SAMPLES / WAV_SAMPLE_RATE;
+        double wait = next - now_ms();
+        if (wait > 0) sleep_ms(wait);
+    }
+
+    MoshiStreamStats stats;
+    int rc = moshi_stream_stats(stream, &stats);
+    moshi_stream_destroy(stream);
+    if (rc != 0) {
+        fprintf(stderr, "  FAIL: stream worker: %s\n", check_error());
+        return -1;
+    }
+
+    printf("  Frames: %llu, underruns: %llu (%llu samples), dropped in/out: %llu/%llu\n",
+           (unsigned long long)stats.frames_processed,
+           (unsigned long long)stats.underruns,
+           (unsigned long long)stats.underrun_samples,
+           (unsigned long long)stats.dropped_input_samples,
+           (unsigned long long)stats.dropped_output_samples);
+    printf("  Latency: last %.1f ms, mean %.1f ms, max %.1f ms\n",
+           stats.latency_ms_last, stats.latency_ms_mean, stats.latency_ms_max);
+    return 0;
+}
+
 /**
  * Write PCM float32 data to a 16-bit WAV file.
  */
@@ -132,7 +463,7 @@ static int write_wav(const char* path, const float* pcm, int num_samples) {
 
 int main(int argc, char** argv) {
     if (argc < 3) {
-        fprintf(stderr, "Usage: %s <mimi_model_path> <moshi_model_path> [output.wav]\n", argv[0]);
+        fprintf(stderr, "Usage: %s <mimi_model_path> <moshi_model_path> [output.wav] [f32|f16|bf16|auto]\n", argv[0]);
         fprintf(stderr, "\nExample:\n");
         fprintf(stderr, "  %s ~/.pixieai/models/mimi/model.safetensors \\\n", argv[0]);
         fprintf(stderr, "     ~/.pixieai/models/moshiko/model.safetensors \\\n");
@@ -144,10 +475,19 @@ int main(int argc, char** argv) {
     const char* moshi_path = argv[2];
     const char* output_path = argc > 3 ? argv[3] : "test_output.wav";
 
+    uint32_t dtype = MOSHI_DTYPE_F32;
+    if (argc > 4 && parse_dtype(argv[4], &dtype) != 0) {
+        fprintf(stderr, "Unknown dtype '%s' (expected f32, f16, bf16 or auto)\n", argv[4]);
+        return 1;
+    }
+
+    double t_start = now_ms();
+    double ttft_ms = -1.0;
+
     printf("=== Moshi FFI End-to-End Test ===\n\n");
 
     /* Step 1: Initialize library */
-    printf("[1/7] Initializing Moshi library...\n");
+    printf("[1/10] Initializing Moshi library...\n");
     int rc = moshi_init();
     if (rc != 0) {
         fprintf(stderr, "  FAIL: moshi_init returned %d: %s\n", rc, check_error());
@@ -156,19 +496,30 @@ int main(int argc, char** argv) {
     printf("  OK\n");
 
     /* Step 2: Load Mimi codec */
-    printf("[2/7] Loading Mimi codec from: %s\n", mimi_path);
-    MimiCodec* codec = mimi_load(mimi_path, 0); /* 0 = default codebooks */
+    printf("[2/10] Loading Mimi codec from: %s\n", mimi_path);
+    int mimi_percent = -1;
+    MoshiLoadOptions mimi_options = { MOSHI_DTYPE_F32, print_progress, &mimi_percent };
+    double t_mimi = now_ms();
+    MimiCodec* codec = mimi_load_ex(mimi_path, 0, &mimi_options); /* 0 = default codebooks */
     if (!codec) {
         fprintf(stderr, "  FAIL: %s\n", check_error());
         return 1;
     }
-    printf("  OK\n");
+    double mimi_load_ms = now_ms() - t_mimi;
+    printf("  OK (%.0f ms)\n", mimi_load_ms);
 
     /* Step 3: Load Moshi model */
-    printf("[3/7] Loading Moshi model from: %s\n", moshi_path);
-    MoshiModel* model = moshi_load(moshi_path);
+    printf("[3/10] Loading Moshi model from: %s\n", moshi_path);
+    int moshi_percent = -1;
+    MoshiLoadOptions moshi_options = { dtype, print_progress, &moshi_percent };
+    double t_moshi = now_ms();
+    /* Shared weights, so the step/batch check below adds no second copy */
+    MoshiWeights* weights = moshi_weights_load(moshi_path, &moshi_options);
+    MoshiModel* model = weights ? moshi_session_create(weights) : NULL;
+    double moshi_load_ms = now_ms() - t_moshi;
     if (!model) {
         fprintf(stderr, "  FAIL: %s\n", check_error());
+        moshi_weights_free(weights);
         mimi_free(codec);
         return 1;
     }
@@ -176,23 +527,24 @@ int main(int argc, char** argv) {
     uint32_t num_codebooks = moshi_audio_codebooks(model);
     uint32_t pad_token = moshi_audio_pad_token(model);
     uint32_t text_start = moshi_text_start_token(model);
-    printf("  OK (codebooks=%u, pad_token=%u, text_start=%u)\n",
-           num_codebooks, pad_token, text_start);
+    printf("  OK (%.0f ms, codebooks=%u, pad_token=%u, text_start=%u)\n",
+           moshi_load_ms, num_codebooks, pad_token, text_start);
 
     /* Step 4: Generate test PCM (440Hz sine) */
-    printf("[4/7] Generating test PCM (%.0fHz sine, %.1fs, %d samples)...\n",
+    printf("[4/10] Generating test PCM (%.0fHz sine, %.1fs, %d samples)...\n",
            TEST_FREQUENCY_HZ, TEST_DURATION_SEC, TEST_NUM_SAMPLES);
     float* input_pcm = generate_test_pcm(TEST_NUM_SAMPLES);
     if (!input_pcm) {
         fprintf(stderr, "  FAIL: malloc\n");
         moshi_free(model);
+        moshi_weights_free(weights);
         mimi_free(codec);
         return 1;
     }
     printf("  OK\n");
 
     /* Step 5: Encode PCM -> audio codes via Mimi */
-    printf("[5/7] Encoding PCM to Mimi audio codes...\n");
+    printf("[5/10] Encoding PCM to Mimi audio codes...\n");
     uint32_t codes_buf[MAX_CODEBOOKS * MAX_FRAMES];
     uint32_t out_num_codebooks = 0;
 
@@ -206,13 +558,14 @@ int main(int argc, char** argv) {
         fprintf(stderr, "  FAIL: mimi_encode: %s\n", check_error());
         free(input_pcm);
         moshi_free(model);
+        moshi_weights_free(weights);
         mimi_free(codec);
         return 1;
     }
     printf("  OK: %d frames, %u codebooks\n", num_frames, out_num_codebooks);
 
     /* Step 6: Run Moshi forward pass for each frame */
-    printf("[6/7] Running Moshi forward pass (%d steps)...\n", num_frames);
+    printf("[6/10] Running Moshi forward pass (%d steps)...\n", num_frames);
     float logits_buf[MAX_TEXT_VOCAB];
     uint32_t logits_len = 0;
     uint32_t text_token = text_start;
@@ -253,6 +606,9 @@ int main(int argc, char** argv) {
             }
             text_token = max_idx;
         }
+        if (ttft_ms < 0.0) {
+            ttft_ms = now_ms() - t_start;
+        }
 
         if (frame < 3 || frame == num_frames - 1) {
             printf("  Frame %d: logits_len=%u, text_token=%u\n",
@@ -269,8 +625,33 @@ int main(int argc, char** argv) {
                num_frames < 10 ? num_frames : 10);
     }
 
-    /* Step 7: Decode audio codes back to PCM via Mimi */
-    printf("[7/7] Decoding audio codes back to PCM...\n");
+    /* Step 7: Device top-k: chunked selection (k <= 256) and repeated argmax */
+    printf("[7/10] Checking moshi_forward_topk against host top-k...\n");
+    int topk_failed = 0;
+    {
+        uint32_t frame_codes[MAX_CODEBOOKS] = { 0 };
+        for (uint32_t cb = 0; cb < out_num_codebooks; cb++) {
+            frame_codes[cb] = codes_buf[cb * num_frames];
+        }
+        const size_t ks[] = { 1, 25, 300 };
+        for (size_t i = 0; i < sizeof(ks) / sizeof(ks[0]) && !topk_failed; i++) {
+            topk_failed = check_topk(model, text_start, frame_codes, num_codebooks, ks[i]) != 0;
+        }
+        moshi_reset(model);
+    }
+    if (!topk_failed) {
+        printf("  OK: k = 1, 25, 300\n");
+    }
+
+    /* Step 8: Streaming step vs batched step on the same weights */
+    printf("[8/10] Checking moshi_step against moshi_batch_step (%d frames)...\n", num_frames);
+    int step_failed = check_step_matches_batch(weights, codes_buf, num_frames, out_num_codebooks) != 0;
+    if (!step_failed) {
+        printf("  OK: identical tokens, audio from frame %u on\n", moshi_acoustic_delay());
+    }
+
+    /* Step 9: Decode audio codes back to PCM via Mimi */
+    printf("[9/10] Decoding audio codes back to PCM...\n");
 
     /* Reset Mimi state before decode (encoder state shouldn't bleed into decoder) */
     mimi_reset(codec);
@@ -286,11 +667,15 @@ int main(int argc, char** argv) {
         fprintf(stderr, "  FAIL: mimi_decode: %s\n", check_error());
         free(input_pcm);
         moshi_free(model);
+        moshi_weights_free(weights);
         mimi_free(codec);
         return 1;
     }
     printf("  OK: decoded %d PCM samples (%.2fs)\n",
            num_samples_out, (float)num_samples_out / WAV_SAMPLE_RATE);
+    int arena_failed = check_arena_outputs(codec, input_pcm, TEST_NUM_SAMPLES,
+                                           codes_buf, num_frames, out_num_codebooks,
+                                           pcm_out, num_samples_out) != 0;
 
     /* Write output WAV */
     if (num_samples_out > 0) {
@@ -304,9 +689,20 @@ int main(int argc, char** argv) {
         write_wav(input_wav, input_pcm, TEST_NUM_SAMPLES);
     }
 
+    /* Step 10: Real-time streaming pipeline */
+    printf("[10/10] Streaming %ds through moshi_stream (%d-sample callbacks)...\n",
+           STREAM_DURATION_SEC, STREAM_CALLBACK_SAMPLES);
+    mimi_reset(codec);
+    moshi_reset(model);
+    int stream_failed = run_streaming(codec, model, input_pcm, TEST_NUM_SAMPLES) != 0;
+    if (!stream_failed) {
+        printf("  OK\n");
+    }
+
     /* Cleanup */
     free(input_pcm);
     moshi_free(model);
+    moshi_weights_free(weights);
     mimi_free(codec);
 
     printf("\n=== Test Complete ===\n");
@@ -316,5 +712,13 @@ int main(int argc, char** argv) {
            output_path, num_samples_out,
            num_samples_out > 0 ? (float)num_samples_out / WAV_SAMPLE_RATE : 0.0f);
 
-    return forward_errors > 0 ? 1 : 0;
+    printf("\n=== Startup ===\n");
+    printf("Mimi load:  %.0f ms\n", mimi_load_ms);
+    printf("Moshi load: %.0f ms (dtype=%s)\n", moshi_load_ms, argc > 4 ? argv[4] : "f32");
+    if (ttft_ms >= 0.0) {
+        printf("TTFT:       %.0f ms\n", ttft_ms);
+    }
+    printf("Peak RSS:   %.0f MB\n", peak_rss_mb());
+
+    return (forward_errors > 0 || topk_failed || step_failed || arena_failed || stream_failed) ? 1 : 0;
 }
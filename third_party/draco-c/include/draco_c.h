@@ -0,0 +1,137 @@
+#ifndef DRACO_C_H
+#define DRACO_C_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Thin C API over the Draco decoder that writes straight into caller-owned
+// vertex/index memory (a CPU staging array or a mapped WebGPU buffer), so a
+// KHR_draco_mesh_compression primitive costs one copy: Draco's decoded
+// attributes -> the final interleaved layout.
+//
+// The compressed bytes are read in place (never copied) and must stay valid for
+// the duration of the call.
+
+typedef enum DracoStatus {
+    DRACO_OK = 0,
+    DRACO_INVALID_ARGUMENT,     // NULL pointer, bad layout or unaligned element
+    DRACO_DECODE_FAILED,        // corrupt or unsupported bitstream
+    DRACO_MISSING_ATTRIBUTE,    // a layout element names an attribute the mesh lacks
+    DRACO_BUFFER_TOO_SMALL,     // destination smaller than count * stride (or indices)
+    DRACO_INDEX_OVERFLOW,       // more than 65535 vertices for DRACO_INDEX_U16
+} DracoStatus;
+
+const char* draco_status_string(DracoStatus status);
+
+// Values match draco::GeometryAttribute::Type
+typedef enum DracoSemantic {
+    DRACO_POSITION = 0,
+    DRACO_NORMAL = 1,
+    DRACO_COLOR = 2,
+    DRACO_TEX_COORD = 3,
+    DRACO_GENERIC = 4,          // glTF JOINTS_n / WEIGHTS_n / custom attributes
+} DracoSemantic;
+
+// Component type written to the destination; values are converted (and
+// normalized when the Draco attribute is normalized) from the decoded type
+typedef enum DracoComponentType {
+    DRACO_INT8 = 1,
+    DRACO_UINT8,
+    DRACO_INT16,
+    DRACO_UINT16,
+    DRACO_INT32,
+    DRACO_UINT32,
+    DRACO_FLOAT32,
+} DracoComponentType;
+
+typedef enum DracoIndexFormat {
+    DRACO_INDEX_U16 = 0,
+    DRACO_INDEX_U32 = 1,
+} DracoIndexFormat;
+
+// One attribute in an interleaved vertex. `offset` must be a multiple of the
+// component size; WebGPU additionally wants it (and the stride) 4-byte aligned.
+typedef struct DracoVertexElement {
+    int32_t unique_id;          // attribute id from the glTF extension, or -1 to use semantic
+    DracoSemantic semantic;     // used when unique_id < 0
+    uint32_t semantic_index;    // e.g. 1 for TEXCOORD_1
+    DracoComponentType component_type;
+    uint32_t num_components;    // 1-4; missing source components are zero-filled
+    uint32_t offset;            // byte offset within a vertex
+} DracoVertexElement;
+
+typedef struct DracoVertexLayout {
+    const DracoVertexElement* elements;
+    uint32_t num_elements;
+    uint32_t stride;            // bytes per vertex
+} DracoVertexLayout;
+
+// --- Two-phase decode, when the vertex/index counts are not known up front ---
+
+typedef struct DracoMesh DracoMesh;
+
+// Decode a mesh or point cloud. The decoded geometry lives in *out_mesh until
+// draco_mesh_destroy; write it out and destroy it promptly to keep peak memory low.
+DracoStatus draco_mesh_decode(const void* data, size_t size, DracoMesh** out_mesh);
+
+uint32_t draco_mesh_num_vertices(const DracoMesh* mesh);
+uint32_t draco_mesh_num_indices(const DracoMesh* mesh);   // 3 per face; 0 for point clouds
+
+// Write every vertex in `layout` order to dst (num_vertices * stride bytes)
+DracoStatus draco_mesh_write_vertices(const DracoMesh* mesh, const DracoVertexLayout* layout,
+                                      void* dst, size_t dst_size);
+
+DracoStatus draco_mesh_write_indices(const DracoMesh* mesh, DracoIndexFormat format,
+                                     void* dst, size_t dst_size);
+
+void draco_mesh_destroy(DracoMesh* mesh);
+
+// --- One-shot decode into preallocated memory ---
+//
+// glTF accessors already give the vertex and index counts, so a loader can size
+// (or map) the destination buffers before decoding and skip the two-phase API.
+
+typedef struct DracoDecodeJob {
+    const void* data;                   // compressed bufferView bytes
+    size_t size;
+    const DracoVertexLayout* layout;
+    void* vertices;                     // may be NULL to skip vertices
+    size_t vertices_size;
+    void* indices;                      // may be NULL to skip indices (or for point clouds)
+    size_t indices_size;
+    DracoIndexFormat index_format;
+
+    // Filled in by the decode
+    uint32_t num_vertices;
+    uint32_t num_indices;
+    DracoStatus status;
+} DracoDecodeJob;
+
+// Decode one job on the calling thread; also returns job->status. The decoded
+// Draco geometry is released before returning.
+DracoStatus draco_decode_into(DracoDecodeJob* job);
+
+// Persistent worker pool for batch decodes. One pool may be shared by the whole
+// loader; batches submitted from different threads run one after another.
+typedef struct DracoPool DracoPool;
+
+// num_threads == 0 uses one thread per core. The calling thread of
+// draco_decode_batch also decodes, so the pool starts num_threads - 1 workers.
+DracoPool* draco_pool_create(uint32_t num_threads);
+void draco_pool_destroy(DracoPool* pool);
+
+// Decode `count` jobs in parallel (pool may be NULL to decode serially). Each
+// worker holds at most one decoded mesh at a time, so peak memory grows with the
+// thread count, not with the scene. Returns DRACO_OK if every job succeeded,
+// otherwise the status of the first failed job (each job has its own status).
+DracoStatus draco_decode_batch(DracoPool* pool, DracoDecodeJob* jobs, size_t count);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // DRACO_C_H
@@ -0,0 +1,340 @@
+// C API over the Draco decoder; see include/draco_c.h.
+
+#include "draco_c.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "draco/compression/decode.h"
+#include "draco/core/decoder_buffer.h"
+#include "draco/mesh/mesh.h"
+#include "draco/point_cloud/point_cloud.h"
+
+struct DracoMesh {
+    std::unique_ptr<draco::PointCloud> geometry;
+    const draco::Mesh* mesh = nullptr;     // geometry as a mesh; NULL for point clouds
+};
+
+namespace {
+
+size_t component_size(DracoComponentType type) {
+    switch (type) {
+        case DRACO_INT8: case DRACO_UINT8: return 1;
+        case DRACO_INT16: case DRACO_UINT16: return 2;
+        case DRACO_INT32: case DRACO_UINT32: case DRACO_FLOAT32: return 4;
+    }
+    return 0;
+}
+
+draco::DataType to_draco_type(DracoComponentType type) {
+    switch (type) {
+        case DRACO_INT8: return draco::DT_INT8;
+        case DRACO_UINT8: return draco::DT_UINT8;
+        case DRACO_INT16: return draco::DT_INT16;
+        case DRACO_UINT16: return draco::DT_UINT16;
+        case DRACO_INT32: return draco::DT_INT32;
+        case DRACO_UINT32: return draco::DT_UINT32;
+        case DRACO_FLOAT32: return draco::DT_FLOAT32;
+    }
+    return draco::DT_INVALID;
+}
+
+const draco::PointAttribute* find_attribute(const draco::PointCloud& geometry,
+                                            const DracoVertexElement& element) {
+    if (element.unique_id >= 0) {
+        return geometry.GetAttributeByUniqueId(static_cast<uint32_t>(element.unique_id));
+    }
+    auto type = static_cast<draco::GeometryAttribute::Type>(element.semantic);
+    if (static_cast<int>(element.semantic_index) >= geometry.NumNamedAttributes(type)) return nullptr;
+    return geometry.GetNamedAttribute(type, static_cast<int>(element.semantic_index));
+}
+
+DracoStatus validate_layout(const DracoVertexLayout* layout) {
+    if (!layout || (layout->num_elements > 0 && !layout->elements) || layout->stride == 0) {
+        return DRACO_INVALID_ARGUMENT;
+    }
+    for (uint32_t i = 0; i < layout->num_elements; i++) {
+        const DracoVertexElement& e = layout->elements[i];
+        size_t size = component_size(e.component_type);
+        if (size == 0 || e.num_components < 1 || e.num_components > 4 || e.offset % size != 0 ||
+            layout->stride % size != 0 || e.offset + size * e.num_components > layout->stride) {
+            return DRACO_INVALID_ARGUMENT;
+        }
+    }
+    return DRACO_OK;
+}
+
+template <typename T>
+void write_converted(const draco::PointAttribute& attribute, uint32_t num_vertices,
+                     const DracoVertexElement& element, uint32_t stride, uint8_t* dst) {
+    const auto components = static_cast<int8_t>(element.num_components);
+    uint8_t* out = dst + element.offset;
+    for (uint32_t i = 0; i < num_vertices; i++, out += stride) {
+        attribute.ConvertValue<T>(attribute.mapped_index(draco::PointIndex(i)), components,
+                                  reinterpret_cast<T*>(out));
+    }
+}
+
+void write_element(const draco::PointAttribute& attribute, uint32_t num_vertices,
+                   const DracoVertexElement& element, uint32_t stride, uint8_t* dst) {
+    // Same type and width: copy each value as stored instead of converting per component
+    if (attribute.data_type() == to_draco_type(element.component_type) &&
+        attribute.num_components() == static_cast<int8_t>(element.num_components)) {
+        const size_t bytes = component_size(element.component_type) * element.num_components;
+        uint8_t* out = dst + element.offset;
+        for (uint32_t i = 0; i < num_vertices; i++, out += stride) {
+            std::memcpy(out, attribute.GetAddress(attribute.mapped_index(draco::PointIndex(i))), bytes);
+        }
+        return;
+    }
+
+    switch (element.component_type) {
+        case DRACO_INT8: write_converted<int8_t>(attribute, num_vertices, element, stride, dst); break;
+        case DRACO_UINT8: write_converted<uint8_t>(attribute, num_vertices, element, stride, dst); break;
+        case DRACO_INT16: write_converted<int16_t>(attribute, num_vertices, element, stride, dst); break;
+        case DRACO_UINT16: write_converted<uint16_t>(attribute, num_vertices, element, stride, dst); break;
+        case DRACO_INT32: write_converted<int32_t>(attribute, num_vertices, element, stride, dst); break;
+        case DRACO_UINT32: write_converted<uint32_t>(attribute, num_vertices, element, stride, dst); break;
+        case DRACO_FLOAT32: write_converted<float>(attribute, num_vertices, element, stride, dst); break;
+    }
+}
+
+template <typename T>
+void write_faces(const draco::Mesh& mesh, T* out) {
+    const uint32_t num_faces = mesh.num_faces();
+    for (uint32_t f = 0; f < num_faces; f++) {
+        const draco::Mesh::Face& face = mesh.face(draco::FaceIndex(f));
+        *out++ = static_cast<T>(face[0].value());
+        *out++ = static_cast<T>(face[1].value());
+        *out++ = static_cast<T>(face[2].value());
+    }
+}
+
+DracoStatus decode_job(DracoDecodeJob* job) {
+    if (!job) return DRACO_INVALID_ARGUMENT;
+    job->num_vertices = 0;
+    job->num_indices = 0;
+
+    DracoMesh* mesh = nullptr;
+    DracoStatus status = draco_mesh_decode(job->data, job->size, &mesh);
+    if (status == DRACO_OK) {
+        job->num_vertices = draco_mesh_num_vertices(mesh);
+        job->num_indices = draco_mesh_num_indices(mesh);
+        if (job->vertices) {
+            status = draco_mesh_write_vertices(mesh, job->layout, job->vertices, job->vertices_size);
+        }
+        if (status == DRACO_OK && job->indices && job->num_indices > 0) {
+            status = draco_mesh_write_indices(mesh, job->index_format, job->indices, job->indices_size);
+        }
+    }
+    draco_mesh_destroy(mesh);
+    job->status = status;
+    return status;
+}
+
+} // namespace
+
+// Worker pool: each batch hands out job indices through an atomic counter and the
+// submitting thread decodes alongside the workers.
+struct DracoPool {
+    struct Batch {
+        const std::function<void(size_t)>* fn;
+        size_t count;
+        std::atomic<size_t> next{0};
+    };
+
+    std::vector<std::thread> workers;
+    std::mutex submit_mutex;            // one batch at a time
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable idle;
+    Batch* batch = nullptr;             // current batch, NULL once it stops taking workers
+    uint64_t generation = 0;
+    uint32_t active = 0;                // workers inside the current batch
+    bool stop = false;
+
+    static void drain(Batch* b) {
+        for (size_t i = b->next.fetch_add(1); i < b->count; i = b->next.fetch_add(1)) {
+            (*b->fn)(i);
+        }
+    }
+
+    void worker_loop() {
+        uint64_t seen = 0;
+        for (;;) {
+            Batch* b;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [&] { return stop || (batch && generation != seen); });
+                if (stop) return;
+                seen = generation;
+                b = batch;
+                active++;
+            }
+            drain(b);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (--active == 0) idle.notify_all();
+            }
+        }
+    }
+
+    void parallel_for(size_t count, const std::function<void(size_t)>& fn) {
+        std::lock_guard<std::mutex> submit(submit_mutex);
+        Batch b;
+        b.fn = &fn;
+        b.count = count;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            batch = &b;
+            generation++;
+        }
+        wake.notify_all();
+        drain(&b);
+        std::unique_lock<std::mutex> lock(mutex);
+        batch = nullptr;
+        idle.wait(lock, [&] { return active == 0; });
+    }
+};
+
+extern "C" {
+
+const char* draco_status_string(DracoStatus status) {
+    switch (status) {
+        case DRACO_OK: return "ok";
+        case DRACO_INVALID_ARGUMENT: return "invalid argument";
+        case DRACO_DECODE_FAILED: return "decode failed";
+        case DRACO_MISSING_ATTRIBUTE: return "missing attribute";
+        case DRACO_BUFFER_TOO_SMALL: return "buffer too small";
+        case DRACO_INDEX_OVERFLOW: return "index overflow";
+    }
+    return "unknown";
+}
+
+DracoStatus draco_mesh_decode(const void* data, size_t size, DracoMesh** out_mesh) {
+    if (!out_mesh) return DRACO_INVALID_ARGUMENT;
+    *out_mesh = nullptr;
+    if (!data || size == 0) return DRACO_INVALID_ARGUMENT;
+
+    // DecoderBuffer only points at the bytes; nothing is copied
+    draco::DecoderBuffer buffer;
+    buffer.Init(static_cast<const char*>(data), size);
+    auto type = draco::Decoder::GetEncodedGeometryType(&buffer);
+    if (!type.ok()) return DRACO_DECODE_FAILED;
+
+    std::unique_ptr<DracoMesh> result(new DracoMesh());
+    draco::Decoder decoder;
+    if (type.value() == draco::TRIANGULAR_MESH) {
+        auto decoded = decoder.DecodeMeshFromBuffer(&buffer);
+        if (!decoded.ok()) return DRACO_DECODE_FAILED;
+        std::unique_ptr<draco::Mesh> mesh = std::move(decoded).value();
+        result->mesh = mesh.get();
+        result->geometry = std::move(mesh);
+    } else if (type.value() == draco::POINT_CLOUD) {
+        auto decoded = decoder.DecodePointCloudFromBuffer(&buffer);
+        if (!decoded.ok()) return DRACO_DECODE_FAILED;
+        result->geometry = std::move(decoded).value();
+    } else {
+        return DRACO_DECODE_FAILED;
+    }
+    *out_mesh = result.release();
+    return DRACO_OK;
+}
+
+uint32_t draco_mesh_num_vertices(const DracoMesh* mesh) {
+    return mesh ? mesh->geometry->num_points() : 0;
+}
+
+uint32_t draco_mesh_num_indices(const DracoMesh* mesh) {
+    return mesh && mesh->mesh ? mesh->mesh->num_faces() * 3 : 0;
+}
+
+DracoStatus draco_mesh_write_vertices(const DracoMesh* mesh, const DracoVertexLayout* layout,
+                                      void* dst, size_t dst_size) {
+    if (!mesh || !dst) return DRACO_INVALID_ARGUMENT;
+    DracoStatus status = validate_layout(layout);
+    if (status != DRACO_OK) return status;
+
+    const uint32_t num_vertices = mesh->geometry->num_points();
+    if (dst_size < static_cast<size_t>(num_vertices) * layout->stride) return DRACO_BUFFER_TOO_SMALL;
+
+    // Resolve every element before writing so a missing one leaves dst untouched
+    std::vector<const draco::PointAttribute*> attributes(layout->num_elements);
+    for (uint32_t i = 0; i < layout->num_elements; i++) {
+        attributes[i] = find_attribute(*mesh->geometry, layout->elements[i]);
+        if (!attributes[i]) return DRACO_MISSING_ATTRIBUTE;
+    }
+    for (uint32_t i = 0; i < layout->num_elements; i++) {
+        write_element(*attributes[i], num_vertices, layout->elements[i], layout->stride,
+                      static_cast<uint8_t*>(dst));
+    }
+    return DRACO_OK;
+}
+
+DracoStatus draco_mesh_write_indices(const DracoMesh* mesh, DracoIndexFormat format,
+                                     void* dst, size_t dst_size) {
+    if (!mesh || !dst || !mesh->mesh) return DRACO_INVALID_ARGUMENT;
+    const size_t num_indices = static_cast<size_t>(mesh->mesh->num_faces()) * 3;
+    if (format == DRACO_INDEX_U16) {
+        if (mesh->geometry->num_points() > 0xFFFF) return DRACO_INDEX_OVERFLOW;
+        if (dst_size < num_indices * sizeof(uint16_t)) return DRACO_BUFFER_TOO_SMALL;
+        write_faces(*mesh->mesh, static_cast<uint16_t*>(dst));
+    } else if (format == DRACO_INDEX_U32) {
+        if (dst_size < num_indices * sizeof(uint32_t)) return DRACO_BUFFER_TOO_SMALL;
+        write_faces(*mesh->mesh, static_cast<uint32_t*>(dst));
+    } else {
+        return DRACO_INVALID_ARGUMENT;
+    }
+    return DRACO_OK;
+}
+
+void draco_mesh_destroy(DracoMesh* mesh) {
+    delete mesh;
+}
+
+DracoStatus draco_decode_into(DracoDecodeJob* job) {
+    return decode_job(job);
+}
+
+DracoPool* draco_pool_create(uint32_t num_threads) {
+    if (num_threads == 0) num_threads = std::max(1u, std::thread::hardware_concurrency());
+    DracoPool* pool = new DracoPool();
+    for (uint32_t i = 1; i < num_threads; i++) {
+        pool->workers.emplace_back([pool] { pool->worker_loop(); });
+    }
+    return pool;
+}
+
+void draco_pool_destroy(DracoPool* pool) {
+    if (!pool) return;
+    {
+        std::lock_guard<std::mutex> lock(pool->mutex);
+        pool->stop = true;
+    }
+    pool->wake.notify_all();
+    for (std::thread& worker : pool->workers) worker.join();
+    delete pool;
+}
+
+DracoStatus draco_decode_batch(DracoPool* pool, DracoDecodeJob* jobs, size_t count) {
+    if (!jobs && count > 0) return DRACO_INVALID_ARGUMENT;
+    std::function<void(size_t)> fn = [jobs](size_t i) { decode_job(&jobs[i]); };
+    if (pool && !pool->workers.empty() && count > 1) {
+        pool->parallel_for(count, fn);
+    } else {
+        for (size_t i = 0; i < count; i++) fn(i);
+    }
+    for (size_t i = 0; i < count; i++) {
+        if (jobs[i].status != DRACO_OK) return jobs[i].status;
+    }
+    return DRACO_OK;
+}
+
+} // extern "C"
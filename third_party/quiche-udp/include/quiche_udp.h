@@ -0,0 +1,122 @@
+#ifndef QUICHE_UDP_H
+#define QUICHE_UDP_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "uv.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Batched UDP I/O for quiche on a libuv loop (libquiche_udp, linked next to
+// libquiche): one socket, datagrams queued and written with sendmmsg + UDP GSO
+// and read with recvmmsg + UDP GRO on Linux, paced by quiche's send_info.at.
+// Other platforms use the same API over one sendto / recvfrom per datagram.
+//
+// Everything runs on the loop thread; a socket is not thread-safe.
+
+typedef struct QuicheUdpSocket QuicheUdpSocket;
+
+typedef struct QuicheUdpConfig {
+    uint32_t batch_size;            // datagrams per sendmmsg / recvmmsg (1-1024)
+    uint32_t queue_size;            // queued datagrams before quiche_udp_send returns UV_ENOBUFS
+    uint16_t max_datagram;          // largest UDP payload queued or delivered
+    int gso;                        // UDP segmentation offload: 1 on, 0 off (Linux only)
+    int gro;                        // UDP receive offload: 1 on, 0 off (Linux only)
+    uint32_t pacing_slack_us;       // datagrams due within this are sent now
+    uint32_t socket_buffer;         // SO_SNDBUF / SO_RCVBUF request in bytes, 0 = OS default
+} QuicheUdpConfig;
+
+// batch 32, queue 256, 1500-byte datagrams, GSO/GRO on, 1 ms slack, 4 MB buffers
+void quiche_udp_config_default(QuicheUdpConfig* config);
+
+// One received datagram (GRO-coalesced reads are split before this is called).
+// `to` is the socket's local address, as quiche_recv_info wants it. data is
+// only valid during the call; quiche_conn_recv may modify it in place.
+typedef void (*QuicheUdpRecvFn)(QuicheUdpSocket* sock, uint8_t* data, size_t len,
+                                const struct sockaddr* from, socklen_t from_len,
+                                const struct sockaddr* to, socklen_t to_len, void* user_data);
+
+// Bind a non-blocking UDP socket to `addr` and start reading. config may be NULL
+// (defaults). Returns 0 or a libuv error code.
+int quiche_udp_open(uv_loop_t* loop, const struct sockaddr* addr, const QuicheUdpConfig* config,
+                    QuicheUdpRecvFn on_recv, void* user_data, QuicheUdpSocket** out);
+
+// Stop reading, drop anything still queued and free the socket on the loop thread
+void quiche_udp_close(QuicheUdpSocket* sock);
+
+// Local address after bind (port filled in when bound to port 0)
+int quiche_udp_local_addr(QuicheUdpSocket* sock, struct sockaddr_storage* out, socklen_t* out_len);
+
+// Whether GSO / GRO are in use: requested, supported by the kernel, and (GSO)
+// not turned off after the NIC rejected a segmented write
+int quiche_udp_gso_enabled(QuicheUdpSocket* sock);
+int quiche_udp_gro_enabled(QuicheUdpSocket* sock);
+
+// --- Sending ---
+//
+// Queue one datagram to `to`, due at `at` (quiche_send_info.at; NULL or zero
+// means now). Nothing is written until quiche_udp_flush runs, so queue a whole
+// quiche_conn_send loop and flush once. Returns 0, UV_ENOBUFS when the queue is
+// full (flush and retry) or UV_EMSGSIZE when len > max_datagram.
+int quiche_udp_send(QuicheUdpSocket* sock, const uint8_t* data, size_t len,
+                    const struct sockaddr* to, socklen_t to_len, const struct timespec* at);
+
+// Write every queued datagram that is due: runs of same-destination datagrams
+// of one size (the last may be shorter) become one GSO write, and up to
+// batch_size writes go out per sendmmsg. Datagrams due later stay queued behind
+// a timer; a full socket buffer waits for writability. Both resume on their own.
+// Returns the number of datagrams written so far, which is short (possibly 0)
+// when the socket buffer filled up; send errors are not reported, the datagram
+// is dropped as the network would drop it. The only error is UV_EBADF once the
+// socket is closing.
+int quiche_udp_flush(QuicheUdpSocket* sock);
+
+// Datagrams still queued (not yet due, or waiting for the socket)
+uint32_t quiche_udp_queued(QuicheUdpSocket* sock);
+
+// Called once the queue is at most half full again after quiche_udp_send
+// returned UV_ENOBUFS or a flush hit a full socket buffer, so the caller can
+// pull more packets from quiche
+typedef void (*QuicheUdpWritableFn)(QuicheUdpSocket* sock, void* user_data);
+void quiche_udp_on_writable(QuicheUdpSocket* sock, QuicheUdpWritableFn fn);
+
+// Monotonic clock quiche uses for send_info.at on this platform
+void quiche_udp_now(struct timespec* out);
+
+// --- Counters ---
+
+typedef struct QuicheUdpStats {
+    uint64_t datagrams_sent;
+    uint64_t datagrams_received;
+    uint64_t bytes_sent;
+    uint64_t bytes_received;
+    uint64_t send_syscalls;         // sendmmsg / sendto calls
+    uint64_t recv_syscalls;         // recvmmsg / recvfrom calls, including the final EAGAIN
+    uint64_t gso_writes;            // writes that carried more than one datagram
+    uint64_t gro_reads;             // reads that delivered more than one datagram
+    uint64_t paced_waits;           // flushes that left datagrams queued until due
+    uint64_t send_blocked;          // flushes that hit a full socket buffer
+} QuicheUdpStats;
+
+void quiche_udp_stats(QuicheUdpSocket* sock, QuicheUdpStats* out);
+
+// --- quiche glue (quiche_udp_conn.c; needs libquiche) ---
+
+struct quiche_conn;
+
+// Pull packets from quiche_conn_send straight into the queue until quiche is
+// done or the queue is full, then flush.
+// Returns the number of packets quiche produced, or a libuv error code
+// (UV_EPROTO if quiche_conn_send failed). When it returns with the queue full,
+// call it again from the quiche_udp_on_writable callback.
+int quiche_udp_send_conn(QuicheUdpSocket* sock, struct quiche_conn* conn);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // QUICHE_UDP_H
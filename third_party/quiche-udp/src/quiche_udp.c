@@ -0,0 +1,634 @@
+// Batched UDP I/O for quiche on a libuv loop; see include/quiche_udp.h.
+
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE  // sendmmsg / recvmmsg
+#endif
+
+#include "quiche_udp.h"
+#include "quiche_udp_internal.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+typedef SOCKET socket_t;
+#define INVALID_SOCKET_VALUE INVALID_SOCKET
+#define close_socket closesocket
+#define last_socket_error() uv_translate_sys_error(WSAGetLastError())
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+typedef int socket_t;
+#define INVALID_SOCKET_VALUE (-1)
+#define close_socket close
+#define last_socket_error() uv_translate_sys_error(errno)
+#endif
+
+#ifdef __linux__
+#include <netinet/udp.h>
+#define QUICHE_UDP_MMSG 1
+#ifndef SOL_UDP
+#define SOL_UDP 17
+#endif
+#ifndef UDP_SEGMENT
+#define UDP_SEGMENT 103
+#endif
+#ifndef UDP_GRO
+#define UDP_GRO 104
+#endif
+#endif
+
+// Kernel limits for one GSO write (UDP_MAX_SEGMENTS on older kernels, and the
+// largest UDP payload with headroom for IPv6 headers)
+#define GSO_MAX_SEGMENTS 64
+#define GSO_MAX_BYTES 65000
+#define GRO_BUFFER_SIZE 65535
+
+// recvmmsg / recvfrom rounds per readable event before yielding to the loop
+#define RECV_MAX_ROUNDS 16
+
+typedef struct QueuedDatagram {
+    uint8_t* data;
+    uint16_t len;
+    socklen_t to_len;
+    struct sockaddr_storage to;
+    uint64_t due_ns;
+} QueuedDatagram;
+
+struct QuicheUdpSocket {
+    uv_loop_t* loop;
+    QuicheUdpConfig config;
+    socket_t fd;
+    uv_poll_t poll;
+    uv_timer_t timer;
+    int poll_events;
+    int handles_open;
+    int closing;
+    int gso;
+    int gro;
+
+    QuicheUdpRecvFn on_recv;
+    QuicheUdpWritableFn on_writable;
+    void* user_data;
+    int want_writable;
+    int blocked;
+
+    struct sockaddr_storage local;
+    socklen_t local_len;
+
+    // Send queue: ring of config.queue_size slots, max_datagram bytes each
+    QueuedDatagram* queue;
+    uint8_t* queue_data;
+    uint32_t head;
+    uint32_t count;
+
+    // Receive buffers: batch_size slots of recv_size bytes
+    uint8_t* recv_data;
+    size_t recv_size;
+    struct sockaddr_storage* recv_from;
+
+#ifdef QUICHE_UDP_MMSG
+    struct mmsghdr* send_msgs;
+    struct iovec* send_iov;         // one per queued datagram
+    char* send_control;             // batch_size x CMSG_SPACE(uint16_t)
+    uint32_t* send_segments;        // datagrams carried by each send_msgs entry
+    struct mmsghdr* recv_msgs;
+    struct iovec* recv_iov;
+    char* recv_control;             // batch_size x CMSG_SPACE(int)
+#endif
+
+    QuicheUdpStats stats;
+};
+
+void quiche_udp_config_default(QuicheUdpConfig* config) {
+    memset(config, 0, sizeof(*config));
+    config->batch_size = 32;
+    config->queue_size = 256;
+    config->max_datagram = 1500;
+    config->gso = 1;
+    config->gro = 1;
+    config->pacing_slack_us = 1000;
+    config->socket_buffer = 4 * 1024 * 1024;
+}
+
+void quiche_udp_now(struct timespec* out) {
+#if defined(__APPLE__)
+    // Rust's Instant (and so quiche's send_info.at) uses CLOCK_UPTIME_RAW on Apple
+    clock_gettime(CLOCK_UPTIME_RAW, out);
+#elif defined(_WIN32)
+    // quiche leaves send_info.at zeroed on Windows, so this only has to be monotonic
+    uint64_t now = uv_hrtime();
+    out->tv_sec = (time_t)(now / 1000000000);
+    out->tv_nsec = (long)(now % 1000000000);
+#else
+    clock_gettime(CLOCK_MONOTONIC, out);
+#endif
+}
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    quiche_udp_now(&ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+}
+
+static void update_poll(QuicheUdpSocket* sock);
+static void on_poll(uv_poll_t* handle, int status, int events);
+
+static int set_nonblocking(socket_t fd) {
+#ifdef _WIN32
+    u_long on = 1;
+    return ioctlsocket(fd, FIONBIO, &on) == 0 ? 0 : last_socket_error();
+#else
+    int flags = fcntl(fd, F_GETFL, 0);
+    if (flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0) return last_socket_error();
+    return 0;
+#endif
+}
+
+static void set_buffer_sizes(socket_t fd, uint32_t size) {
+    int value = (int)size;
+    if (size == 0) return;
+    // Best effort: the kernel caps these (net.core.{w,r}mem_max on Linux)
+    setsockopt(fd, SOL_SOCKET, SO_SNDBUF, (const char*)&value, sizeof(value));
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, (const char*)&value, sizeof(value));
+}
+
+static void enable_offloads(QuicheUdpSocket* sock) {
+#ifdef QUICHE_UDP_MMSG
+    int zero = 0;
+    int one = 1;
+    // A zero socket-wide segment size is accepted wherever UDP_SEGMENT exists
+    // and leaves plain writes unsegmented; per-write sizes come in a cmsg
+    if (sock->config.gso) {
+        sock->gso = setsockopt(sock->fd, SOL_UDP, UDP_SEGMENT, &zero, sizeof(zero)) == 0;
+    }
+    if (sock->config.gro) {
+        sock->gro = setsockopt(sock->fd, SOL_UDP, UDP_GRO, &one, sizeof(one)) == 0;
+    }
+#else
+    (void)sock;
+#endif
+}
+
+static void socket_free(QuicheUdpSocket* sock) {
+    free(sock->queue);
+    free(sock->queue_data);
+    free(sock->recv_data);
+    free(sock->recv_from);
+#ifdef QUICHE_UDP_MMSG
+    free(sock->send_msgs);
+    free(sock->send_iov);
+    free(sock->send_control);
+    free(sock->send_segments);
+    free(sock->recv_msgs);
+    free(sock->recv_iov);
+    free(sock->recv_control);
+#endif
+    free(sock);
+}
+
+static int allocate_buffers(QuicheUdpSocket* sock) {
+    const QuicheUdpConfig* c = &sock->config;
+    sock->queue = (QueuedDatagram*)calloc(c->queue_size, sizeof(QueuedDatagram));
+    sock->queue_data = (uint8_t*)malloc((size_t)c->queue_size * c->max_datagram);
+    sock->recv_size = sock->gro ? GRO_BUFFER_SIZE : c->max_datagram;
+    sock->recv_data = (uint8_t*)malloc((size_t)c->batch_size * sock->recv_size);
+    sock->recv_from = (struct sockaddr_storage*)calloc(c->batch_size, sizeof(struct sockaddr_storage));
+    if (!sock->queue || !sock->queue_data || !sock->recv_data || !sock->recv_from) return UV_ENOMEM;
+    for (uint32_t i = 0; i < c->queue_size; i++) {
+        sock->queue[i].data = sock->queue_data + (size_t)i * c->max_datagram;
+    }
+#ifdef QUICHE_UDP_MMSG
+    sock->send_msgs = (struct mmsghdr*)calloc(c->batch_size, sizeof(struct mmsghdr));
+    sock->send_iov = (struct iovec*)calloc(c->queue_size, sizeof(struct iovec));
+    sock->send_control = (char*)calloc(c->batch_size, CMSG_SPACE(sizeof(uint16_t)));
+    sock->send_segments = (uint32_t*)calloc(c->batch_size, sizeof(uint32_t));
+    sock->recv_msgs = (struct mmsghdr*)calloc(c->batch_size, sizeof(struct mmsghdr));
+    sock->recv_iov = (struct iovec*)calloc(c->batch_size, sizeof(struct iovec));
+    sock->recv_control = (char*)calloc(c->batch_size, CMSG_SPACE(sizeof(int)));
+    if (!sock->send_msgs || !sock->send_iov || !sock->send_control || !sock->send_segments
+        || !sock->recv_msgs || !sock->recv_iov || !sock->recv_control) {
+        return UV_ENOMEM;
+    }
+#endif
+    return 0;
+}
+
+int quiche_udp_open(uv_loop_t* loop, const struct sockaddr* addr, const QuicheUdpConfig* config,
+                    QuicheUdpRecvFn on_recv, void* user_data, QuicheUdpSocket** out) {
+    if (!loop || !addr || !on_recv || !out) return UV_EINVAL;
+    *out = NULL;
+
+    QuicheUdpSocket* sock = (QuicheUdpSocket*)calloc(1, sizeof(QuicheUdpSocket));
+    if (!sock) return UV_ENOMEM;
+    if (config) {
+        sock->config = *config;
+    } else {
+        quiche_udp_config_default(&sock->config);
+    }
+    QuicheUdpConfig* c = &sock->config;
+    if (c->batch_size == 0 || c->batch_size > 1024 || c->queue_size == 0 || c->max_datagram == 0) {
+        free(sock);
+        return UV_EINVAL;
+    }
+    sock->loop = loop;
+    sock->on_recv = on_recv;
+    sock->user_data = user_data;
+
+    socklen_t addr_len = addr->sa_family == AF_INET6 ? sizeof(struct sockaddr_in6)
+                                                      : sizeof(struct sockaddr_in);
+    sock->fd = socket(addr->sa_family, SOCK_DGRAM, IPPROTO_UDP);
+    if (sock->fd == INVALID_SOCKET_VALUE) {
+        int rc = last_socket_error();
+        free(sock);
+        return rc;
+    }
+    int rc = set_nonblocking(sock->fd);
+    if (rc == 0 && bind(sock->fd, addr, addr_len) != 0) rc = last_socket_error();
+    if (rc == 0) {
+        sock->local_len = sizeof(sock->local);
+        if (getsockname(sock->fd, (struct sockaddr*)&sock->local, &sock->local_len) != 0) {
+            rc = last_socket_error();
+        }
+    }
+    if (rc == 0) {
+        set_buffer_sizes(sock->fd, c->socket_buffer);
+        enable_offloads(sock);
+        rc = allocate_buffers(sock);
+    }
+    if (rc == 0) rc = uv_poll_init_socket(loop, &sock->poll, sock->fd);
+    if (rc != 0) {
+        close_socket(sock->fd);
+        socket_free(sock);
+        return rc;
+    }
+    uv_timer_init(loop, &sock->timer);
+    sock->poll.data = sock;
+    sock->timer.data = sock;
+    sock->handles_open = 2;
+    update_poll(sock);
+
+    *out = sock;
+    return 0;
+}
+
+static void on_handle_closed(uv_handle_t* handle) {
+    QuicheUdpSocket* sock = (QuicheUdpSocket*)handle->data;
+    if (--sock->handles_open == 0) {
+        close_socket(sock->fd);
+        socket_free(sock);
+    }
+}
+
+void quiche_udp_close(QuicheUdpSocket* sock) {
+    if (!sock || sock->closing) return;
+    sock->closing = 1;
+    sock->count = 0;
+    uv_close((uv_handle_t*)&sock->poll, on_handle_closed);
+    uv_close((uv_handle_t*)&sock->timer, on_handle_closed);
+}
+
+int quiche_udp_local_addr(QuicheUdpSocket* sock, struct sockaddr_storage* out, socklen_t* out_len) {
+    if (!sock || !out || !out_len) return UV_EINVAL;
+    memcpy(out, &sock->local, sizeof(sock->local));
+    *out_len = sock->local_len;
+    return 0;
+}
+
+int quiche_udp_gso_enabled(QuicheUdpSocket* sock) {
+    return sock->gso;
+}
+
+int quiche_udp_gro_enabled(QuicheUdpSocket* sock) {
+    return sock->gro;
+}
+
+uint32_t quiche_udp_queued(QuicheUdpSocket* sock) {
+    return sock->count;
+}
+
+void quiche_udp_on_writable(QuicheUdpSocket* sock, QuicheUdpWritableFn fn) {
+    sock->on_writable = fn;
+}
+
+void quiche_udp_stats(QuicheUdpSocket* sock, QuicheUdpStats* out) {
+    *out = sock->stats;
+}
+
+// --- Sending ---
+
+int quiche_udp_send(QuicheUdpSocket* sock, const uint8_t* data, size_t len,
+                    const struct sockaddr* to, socklen_t to_len, const struct timespec* at) {
+    if (sock->closing) return UV_EBADF;
+    if (!to || to_len == 0 || to_len > (socklen_t)sizeof(struct sockaddr_storage)) return UV_EINVAL;
+    if (len > sock->config.max_datagram) return UV_EMSGSIZE;
+    size_t capacity;
+    uint8_t* slot = quiche_udp_reserve(sock, &capacity);
+    if (!slot) return UV_ENOBUFS;
+    memcpy(slot, data, len);
+    quiche_udp_commit(sock, len, to, to_len, at);
+    return 0;
+}
+
+uint8_t* quiche_udp_reserve(QuicheUdpSocket* sock, size_t* capacity) {
+    if (sock->closing || sock->count == sock->config.queue_size) {
+        sock->want_writable = 1;
+        return NULL;
+    }
+    *capacity = sock->config.max_datagram;
+    return sock->queue[(sock->head + sock->count) % sock->config.queue_size].data;
+}
+
+void quiche_udp_commit(QuicheUdpSocket* sock, size_t len, const struct sockaddr* to,
+                       socklen_t to_len, const struct timespec* at) {
+    QueuedDatagram* d = &sock->queue[(sock->head + sock->count) % sock->config.queue_size];
+    d->len = (uint16_t)len;
+    memcpy(&d->to, to, to_len);
+    d->to_len = to_len;
+    d->due_ns = at && (at->tv_sec != 0 || at->tv_nsec != 0)
+                    ? (uint64_t)at->tv_sec * 1000000000 + (uint64_t)at->tv_nsec
+                    : 0;
+    sock->count++;
+}
+
+static QueuedDatagram* queued_at(QuicheUdpSocket* sock, uint32_t i) {
+    return &sock->queue[(sock->head + i) % sock->config.queue_size];
+}
+
+static void pop_datagrams(QuicheUdpSocket* sock, uint32_t n) {
+    sock->head = (sock->head + n) % sock->config.queue_size;
+    sock->count -= n;
+}
+
+static int is_send_retryable(int err) {
+    return err == UV_EAGAIN || err == UV_ENOBUFS || err == UV_EINTR;
+}
+
+#ifdef QUICHE_UDP_MMSG
+
+static int same_destination(const QueuedDatagram* a, const QueuedDatagram* b) {
+    return a->to_len == b->to_len && memcmp(&a->to, &b->to, a->to_len) == 0;
+}
+
+// One sendmmsg over the due datagrams at the head of the queue. Returns the
+// number of datagrams written or a libuv error code.
+static int send_batch(QuicheUdpSocket* sock, uint64_t limit_ns) {
+    const size_t control_space = CMSG_SPACE(sizeof(uint16_t));
+    uint32_t num_msgs = 0;
+    uint32_t i = 0;
+    while (num_msgs < sock->config.batch_size && i < sock->count) {
+        QueuedDatagram* first = queued_at(sock, i);
+        if (first->due_ns > limit_ns) break;
+
+        // Gather a GSO run: same destination and size, the last may be shorter
+        uint32_t segments = 1;
+        size_t bytes = first->len;
+        sock->send_iov[i].iov_base = first->data;
+        sock->send_iov[i].iov_len = first->len;
+        while (sock->gso && segments < GSO_MAX_SEGMENTS && i + segments < sock->count) {
+            QueuedDatagram* prev = queued_at(sock, i + segments - 1);
+            QueuedDatagram* next = queued_at(sock, i + segments);
+            if (prev->len != first->len || next->len > first->len || next->due_ns > limit_ns
+                || bytes + next->len > GSO_MAX_BYTES || !same_destination(first, next)) {
+                break;
+            }
+            sock->send_iov[i + segments].iov_base = next->data;
+            sock->send_iov[i + segments].iov_len = next->len;
+            bytes += next->len;
+            segments++;
+        }
+
+        struct msghdr* msg = &sock->send_msgs[num_msgs].msg_hdr;
+        memset(msg, 0, sizeof(*msg));
+        msg->msg_name = &first->to;
+        msg->msg_namelen = first->to_len;
+        msg->msg_iov = &sock->send_iov[i];
+        msg->msg_iovlen = segments;
+        if (segments > 1) {
+            char* control = sock->send_control + num_msgs * control_space;
+            memset(control, 0, control_space);
+            msg->msg_control = control;
+            msg->msg_controllen = control_space;
+            struct cmsghdr* cmsg = CMSG_FIRSTHDR(msg);
+            cmsg->cmsg_level = SOL_UDP;
+            cmsg->cmsg_type = UDP_SEGMENT;
+            cmsg->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+            uint16_t segment_size = first->len;
+            memcpy(CMSG_DATA(cmsg), &segment_size, sizeof(segment_size));
+        }
+        sock->send_segments[num_msgs++] = segments;
+        i += segments;
+    }
+    if (num_msgs == 0) return 0;
+
+    sock->stats.send_syscalls++;
+    int sent = sendmmsg(sock->fd, sock->send_msgs, num_msgs, 0);
+    if (sent < 0) {
+        int err = last_socket_error();
+        if (err == UV_EIO && sock->send_segments[0] > 1) {
+            // The device cannot checksum-offload segmented writes; send them unsegmented
+            sock->gso = 0;
+            return 0;
+        }
+        if (is_send_retryable(err)) return err;
+        // Anything else (ICMP errors, unroutable destination) loses the first
+        // write, as the network would; QUIC recovers it
+        pop_datagrams(sock, sock->send_segments[0]);
+        return 0;
+    }
+
+    uint32_t written = 0;
+    for (int m = 0; m < sent; m++) {
+        uint32_t segments = sock->send_segments[m];
+        if (segments > 1) sock->stats.gso_writes++;
+        for (uint32_t s = 0; s < segments; s++) {
+            sock->stats.bytes_sent += queued_at(sock, written + s)->len;
+        }
+        written += segments;
+    }
+    pop_datagrams(sock, written);
+    sock->stats.datagrams_sent += written;
+    return (int)written;
+}
+
+#else
+
+static int send_batch(QuicheUdpSocket* sock, uint64_t limit_ns) {
+    uint32_t written = 0;
+    while (written < sock->config.batch_size && sock->count > 0) {
+        QueuedDatagram* d = queued_at(sock, 0);
+        if (d->due_ns > limit_ns) break;
+        sock->stats.send_syscalls++;
+        if (sendto(sock->fd, (const char*)d->data, d->len, 0, (const struct sockaddr*)&d->to,
+                   d->to_len) < 0) {
+            int err = last_socket_error();
+            if (is_send_retryable(err)) return written > 0 ? (int)written : err;
+        } else {
+            sock->stats.datagrams_sent++;
+            sock->stats.bytes_sent += d->len;
+            written++;
+        }
+        pop_datagrams(sock, 1);
+    }
+    return (int)written;
+}
+
+#endif
+
+static void on_timer(uv_timer_t* timer);
+
+static void notify_writable(QuicheUdpSocket* sock) {
+    if (sock->want_writable && !sock->blocked && sock->count <= sock->config.queue_size / 2) {
+        sock->want_writable = 0;
+        if (sock->on_writable) sock->on_writable(sock, sock->user_data);
+    }
+}
+
+int quiche_udp_flush(QuicheUdpSocket* sock) {
+    if (sock->closing) return UV_EBADF;
+    if (sock->blocked) return 0;  // resumes when the socket is writable
+
+    uint64_t now = now_ns();
+    uint64_t limit = now + (uint64_t)sock->config.pacing_slack_us * 1000;
+    int total = 0;
+    while (sock->count > 0) {
+        int rc = send_batch(sock, limit);
+        if (rc < 0) {
+            sock->blocked = 1;
+            sock->want_writable = 1;
+            sock->stats.send_blocked++;
+            update_poll(sock);
+            return total;
+        }
+        if (rc == 0 && sock->count > 0 && queued_at(sock, 0)->due_ns > limit) break;
+        total += rc;
+    }
+
+    uv_timer_stop(&sock->timer);
+    if (sock->count > 0) {
+        // Wake when the head is due; libuv timers have millisecond resolution
+        uint64_t due = queued_at(sock, 0)->due_ns;
+        uint64_t wait_ms = due > now ? (due - now + 999999) / 1000000 : 1;
+        sock->stats.paced_waits++;
+        uv_timer_start(&sock->timer, on_timer, wait_ms, 0);
+    }
+    return total;
+}
+
+static void on_timer(uv_timer_t* timer) {
+    QuicheUdpSocket* sock = (QuicheUdpSocket*)timer->data;
+    quiche_udp_flush(sock);
+    notify_writable(sock);
+}
+
+// --- Receiving ---
+
+static void deliver(QuicheUdpSocket* sock, uint8_t* data, size_t len, size_t segment_size,
+                    const struct sockaddr_storage* from, socklen_t from_len) {
+    if (segment_size == 0 || segment_size > len) segment_size = len;
+    if (len > segment_size) sock->stats.gro_reads++;
+    for (size_t offset = 0; offset < len && !sock->closing; offset += segment_size) {
+        size_t n = len - offset < segment_size ? len - offset : segment_size;
+        sock->stats.datagrams_received++;
+        sock->stats.bytes_received += n;
+        sock->on_recv(sock, data + offset, n, (const struct sockaddr*)from, from_len,
+                      (const struct sockaddr*)&sock->local, sock->local_len, sock->user_data);
+    }
+}
+
+#ifdef QUICHE_UDP_MMSG
+
+// One recvmmsg; returns datagrams read (before GRO splitting), 0 when drained
+static int recv_batch(QuicheUdpSocket* sock) {
+    const size_t control_space = CMSG_SPACE(sizeof(int));
+    uint32_t n = sock->config.batch_size;
+    for (uint32_t i = 0; i < n; i++) {
+        struct msghdr* msg = &sock->recv_msgs[i].msg_hdr;
+        memset(msg, 0, sizeof(*msg));
+        sock->recv_iov[i].iov_base = sock->recv_data + i * sock->recv_size;
+        sock->recv_iov[i].iov_len = sock->recv_size;
+        msg->msg_name = &sock->recv_from[i];
+        msg->msg_namelen = sizeof(struct sockaddr_storage);
+        msg->msg_iov = &sock->recv_iov[i];
+        msg->msg_iovlen = 1;
+        if (sock->gro) {
+            msg->msg_control = sock->recv_control + i * control_space;
+            msg->msg_controllen = control_space;
+        }
+    }
+
+    sock->stats.recv_syscalls++;
+    int received = recvmmsg(sock->fd, sock->recv_msgs, n, 0, NULL);
+    if (received <= 0) return 0;
+
+    for (int i = 0; i < received && !sock->closing; i++) {
+        struct msghdr* msg = &sock->recv_msgs[i].msg_hdr;
+        if (msg->msg_flags & MSG_TRUNC) continue;  // larger than max_datagram
+        size_t segment_size = 0;
+        if (sock->gro) {
+            for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(msg); cmsg; cmsg = CMSG_NXTHDR(msg, cmsg)) {
+                if (cmsg->cmsg_level == SOL_UDP && cmsg->cmsg_type == UDP_GRO) {
+                    int value;
+                    memcpy(&value, CMSG_DATA(cmsg), sizeof(value));
+                    segment_size = (size_t)value;
+                }
+            }
+        }
+        deliver(sock, (uint8_t*)sock->recv_iov[i].iov_base, sock->recv_msgs[i].msg_len,
+                segment_size, &sock->recv_from[i], msg->msg_namelen);
+    }
+    return received;
+}
+
+#else
+
+static int recv_batch(QuicheUdpSocket* sock) {
+    int received = 0;
+    while ((uint32_t)received < sock->config.batch_size && !sock->closing) {
+        socklen_t from_len = sizeof(struct sockaddr_storage);
+        sock->stats.recv_syscalls++;
+        int len = (int)recvfrom(sock->fd, (char*)sock->recv_data, (int)sock->recv_size, 0,
+                                (struct sockaddr*)&sock->recv_from[0], &from_len);
+        if (len < 0) {
+#ifdef _WIN32
+            // ICMP port unreachable from an earlier send surfaces here
+            if (WSAGetLastError() == WSAECONNRESET) continue;
+#endif
+            break;
+        }
+        received++;
+        deliver(sock, sock->recv_data, (size_t)len, 0, &sock->recv_from[0], from_len);
+    }
+    return received;
+}
+
+#endif
+
+static void update_poll(QuicheUdpSocket* sock) {
+    int events = UV_READABLE | (sock->blocked ? UV_WRITABLE : 0);
+    if (events != sock->poll_events) {
+        sock->poll_events = events;
+        uv_poll_start(&sock->poll, events, on_poll);
+    }
+}
+
+static void on_poll(uv_poll_t* handle, int status, int events) {
+    QuicheUdpSocket* sock = (QuicheUdpSocket*)handle->data;
+    if (status < 0) return;
+    if (events & UV_WRITABLE) {
+        sock->blocked = 0;
+        update_poll(sock);
+        quiche_udp_flush(sock);
+        notify_writable(sock);
+    }
+    if (events & UV_READABLE) {
+        for (int round = 0; round < RECV_MAX_ROUNDS && !sock->closing; round++) {
+            if ((uint32_t)recv_batch(sock) < sock->config.batch_size) break;
+        }
+    }
+}
@@ -0,0 +1,29 @@
+// quiche_udp_send_conn: quiche_conn_send straight into the send queue. Kept out
+// of quiche_udp.c so programs that only need the socket do not pull in libquiche.
+
+#include <quiche.h>
+
+#include "quiche_udp.h"
+#include "quiche_udp_internal.h"
+
+int quiche_udp_send_conn(QuicheUdpSocket* sock, quiche_conn* conn) {
+    int produced = 0;
+    for (;;) {
+        size_t capacity;
+        uint8_t* slot = quiche_udp_reserve(sock, &capacity);
+        if (!slot) break;  // queue full: on_writable fires once it drains
+
+        quiche_send_info info;
+        ssize_t written = quiche_conn_send(conn, slot, capacity, &info);
+        if (written == QUICHE_ERR_DONE) break;
+        if (written < 0) {
+            quiche_udp_flush(sock);
+            return UV_EPROTO;
+        }
+        quiche_udp_commit(sock, (size_t)written, (const struct sockaddr*)&info.to, info.to_len,
+                          &info.at);
+        produced++;
+    }
+    int rc = quiche_udp_flush(sock);
+    return rc < 0 ? rc : produced;
+}
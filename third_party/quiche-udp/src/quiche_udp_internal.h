@@ -0,0 +1,14 @@
+// Zero-copy queueing shared by quiche_udp.c and quiche_udp_conn.c (not installed)
+
+#ifndef QUICHE_UDP_INTERNAL_H
+#define QUICHE_UDP_INTERNAL_H
+
+#include "quiche_udp.h"
+
+// Next free queue slot (max_datagram bytes, size in *capacity), or NULL when
+// the queue is full; fill it, then commit it or leave it for the next reserve
+uint8_t* quiche_udp_reserve(QuicheUdpSocket* sock, size_t* capacity);
+void quiche_udp_commit(QuicheUdpSocket* sock, size_t len, const struct sockaddr* to,
+                       socklen_t to_len, const struct timespec* at);
+
+#endif // QUICHE_UDP_INTERNAL_H
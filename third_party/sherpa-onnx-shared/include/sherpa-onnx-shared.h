@@ -0,0 +1,46 @@
+// Shared ONNX Runtime environment and execution-provider queries for the
+// sherpa-onnx build (compiled into sherpa-onnx-core by build-sherpaonnx.py).
+//
+// By default every recognizer, TTS or VAD session starts its own ORT intra-op
+// pool of config.num_threads threads, so running ASR and TTS side by side
+// oversubscribes the cores. After SherpaOnnxInitSharedRuntime, all sessions
+// run on one process-wide pool instead.
+
+#ifndef SHERPA_ONNX_SHARED_H_
+#define SHERPA_ONNX_SHARED_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct SherpaOnnxSharedRuntimeConfig {
+  int32_t intra_op_num_threads;  // 0 = ORT default (one per physical core)
+  int32_t inter_op_num_threads;  // 0 = 1
+  int32_t allow_spinning;        // 0 = idle pool threads sleep (right on phones)
+} SherpaOnnxSharedRuntimeConfig;
+
+// Create the process-wide ORT environment with the shared thread pools. Call
+// once, before creating any recognizer / TTS / VAD: sessions created afterwards
+// use the shared pools and ignore their own num_threads. The environment lives
+// until the process exits. config may be NULL (defaults above).
+// Returns 0, or -1 if a session already exists or ORT failed (logged to stderr).
+int32_t SherpaOnnxInitSharedRuntime(const SherpaOnnxSharedRuntimeConfig *config);
+
+// 1 once SherpaOnnxInitSharedRuntime has succeeded
+int32_t SherpaOnnxSharedRuntimeEnabled(void);
+
+// Execution providers compiled into the linked ORT, comma separated in ORT's
+// names, e.g. "CoreMLExecutionProvider,CPUExecutionProvider". Static storage.
+const char *SherpaOnnxAvailableProviders(void);
+
+// Value for a model config's `provider`: "coreml", "nnapi" or "xnnpack" when
+// the linked ORT has that provider (in that order), else "cpu"
+const char *SherpaOnnxPreferredProvider(void);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif  // SHERPA_ONNX_SHARED_H_
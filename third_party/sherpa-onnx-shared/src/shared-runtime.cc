@@ -0,0 +1,120 @@
+// sherpa-onnx/csrc/shared-runtime.cc
+//
+// See sherpa-onnx-shared.h. Copied into sherpa-onnx/csrc and added to
+// sherpa-onnx-core by build-sherpaonnx.py.
+
+#include "sherpa-onnx/csrc/shared-runtime.h"
+
+#include <atomic>
+#include <cstdio>
+#include <mutex>  // NOLINT
+#include <string>
+#include <vector>
+
+#include "sherpa-onnx/csrc/sherpa-onnx-shared.h"
+
+namespace {
+
+std::mutex g_mutex;
+std::atomic<bool> g_enabled{false};
+std::atomic<bool> g_session_created{false};
+
+// ORT keeps one environment per process: every Ort::Env sherpa-onnx creates
+// later is this one, global thread pools included, as long as it stays alive
+OrtEnv *g_env = nullptr;
+
+bool Check(const OrtApi &api, OrtStatus *status, const char *what) {
+  if (!status) return true;
+  fprintf(stderr, "SherpaOnnxInitSharedRuntime: %s failed: %s\n", what,
+          api.GetErrorMessage(status));
+  api.ReleaseStatus(status);
+  return false;
+}
+
+const std::vector<std::string> &Providers() {
+  static std::vector<std::string> providers = Ort::GetAvailableProviders();
+  return providers;
+}
+
+bool HasProvider(const char *name) {
+  for (const auto &p : Providers()) {
+    if (p == name) return true;
+  }
+  return false;
+}
+
+}  // namespace
+
+namespace sherpa_onnx {
+
+void ApplySharedRuntime(Ort::SessionOptions *sess_opts) {
+  g_session_created = true;
+  if (g_enabled) sess_opts->DisablePerSessionThreads();
+}
+
+}  // namespace sherpa_onnx
+
+int32_t SherpaOnnxInitSharedRuntime(
+    const SherpaOnnxSharedRuntimeConfig *config) {
+  std::lock_guard<std::mutex> lock(g_mutex);
+  if (g_enabled) return 0;
+  if (g_session_created) {
+    fprintf(stderr,
+            "SherpaOnnxInitSharedRuntime: call it before creating any "
+            "recognizer or TTS\n");
+    return -1;
+  }
+
+  SherpaOnnxSharedRuntimeConfig defaults = {0, 0, 0};
+  if (!config) config = &defaults;
+
+  const OrtApi &api = Ort::GetApi();
+  OrtThreadingOptions *options = nullptr;
+  if (!Check(api, api.CreateThreadingOptions(&options),
+             "CreateThreadingOptions")) {
+    return -1;
+  }
+  bool ok =
+      Check(api,
+            api.SetGlobalIntraOpNumThreads(options,
+                                           config->intra_op_num_threads),
+            "SetGlobalIntraOpNumThreads") &&
+      Check(api,
+            api.SetGlobalInterOpNumThreads(
+                options, config->inter_op_num_threads > 0
+                             ? config->inter_op_num_threads
+                             : 1),
+            "SetGlobalInterOpNumThreads") &&
+      Check(api, api.SetGlobalSpinControl(options, config->allow_spinning),
+            "SetGlobalSpinControl") &&
+      Check(api,
+            api.CreateEnvWithGlobalThreadPools(ORT_LOGGING_LEVEL_ERROR,
+                                               "sherpa-onnx", options, &g_env),
+            "CreateEnvWithGlobalThreadPools");
+  api.ReleaseThreadingOptions(options);
+  if (!ok) return -1;
+
+  g_enabled = true;
+  return 0;
+}
+
+int32_t SherpaOnnxSharedRuntimeEnabled(void) { return g_enabled ? 1 : 0; }
+
+const char *SherpaOnnxAvailableProviders(void) {
+  static std::string joined = [] {
+    std::string s;
+    for (const auto &p : Providers()) {
+      if (!s.empty()) s += ",";
+      s += p;
+    }
+    return s;
+  }();
+  return joined.c_str();
+}
+
+const char *SherpaOnnxPreferredProvider(void) {
+  if (HasProvider("CoreMLExecutionProvider")) return "coreml";
+  if (HasProvider("NnapiExecutionProvider")) return "nnapi";
+  if (HasProvider("XnnpackExecutionProvider")) return "xnnpack";
+  return "cpu";
+}
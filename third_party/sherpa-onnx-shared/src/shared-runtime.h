@@ -0,0 +1,19 @@
+// sherpa-onnx/csrc/shared-runtime.h
+//
+// Session-options hook for sherpa-onnx-shared.h; copied into sherpa-onnx/csrc
+// by build-sherpaonnx.py, which also adds the call in session.cc.
+
+#ifndef SHERPA_ONNX_CSRC_SHARED_RUNTIME_H_
+#define SHERPA_ONNX_CSRC_SHARED_RUNTIME_H_
+
+#include "onnxruntime_cxx_api.h"  // NOLINT
+
+namespace sherpa_onnx {
+
+// Called for every session's options: switches them to the shared thread
+// pools once SherpaOnnxInitSharedRuntime has run
+void ApplySharedRuntime(Ort::SessionOptions *sess_opts);
+
+}  // namespace sherpa_onnx
+
+#endif  // SHERPA_ONNX_CSRC_SHARED_RUNTIME_H_
@@ -0,0 +1,19 @@
+// Post-build check run by build-sherpaonnx.py: lists the execution providers
+// compiled into the linked ONNX Runtime and creates the shared runtime once.
+//
+// Usage: sherpa_onnx_ep_check
+// Prints key=value lines; exits non-zero if the shared runtime cannot be created.
+
+#include <stdio.h>
+
+#include "sherpa-onnx-shared.h"
+
+int main(void) {
+  printf("providers=%s\n", SherpaOnnxAvailableProviders());
+  printf("preferred=%s\n", SherpaOnnxPreferredProvider());
+
+  SherpaOnnxSharedRuntimeConfig config = {2, 1, 0};
+  int32_t rc = SherpaOnnxInitSharedRuntime(&config);
+  printf("shared_runtime=%d\n", rc == 0 ? SherpaOnnxSharedRuntimeEnabled() : 0);
+  return rc == 0 ? 0 : 1;
+}
@@ -1,8 +1,15 @@
+#include <stddef.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 // Returns 0 on success, non-zero on error. Output is heap-allocated and must be freed.
+// Source maps are generated in the same emit pass as the JS:
+//   "none" (or NULL)  no map; *out_sourcemap is NULL
+//   "inline"          map appended to *out_js as a base64 data URL comment
+//   "file"            map JSON in *out_sourcemap; *out_js ends with a
+//                     sourceMappingURL comment naming "<basename>.js.map"
 int swc_transpile_ts(const char* source,
                      const char* filename,
                      const char* source_map_mode, // "none" | "inline" | "file"
@@ -10,9 +17,125 @@ int swc_transpile_ts(const char* source,
                      char** out_sourcemap,
                      char** out_error);
 
-// Free buffers allocated by SWC.
+// Free buffers allocated by SWC: output strings and swc_transpile_batch results.
 void swc_free(char* ptr);
 
+// Result of one module in a batch. Exactly one of `js` and `error` is non-NULL.
+typedef struct SwcBatchResult {
+    const char* js;
+    const char* sourcemap;  // NULL unless requested with source_map_mode
+    const char* error;
+} SwcBatchResult;
+
+// Transpile `count` modules in parallel on an internal thread pool.
+// `source_lens` may be NULL, in which case every source is NUL-terminated.
+// `threads` <= 0 uses one thread per core.
+// On return *out_results points to `count` results; the results and every string
+// they reference live in a single allocation, freed with swc_free((char*)results).
+// Returns the number of modules that failed, or -1 on invalid arguments.
+int swc_transpile_batch(const char* const* sources,
+                        const size_t* source_lens,
+                        const char* const* filenames,
+                        size_t count,
+                        const char* source_map_mode, // "none" | "inline" | "file"
+                        int threads,
+                        SwcBatchResult** out_results);
+
+// Reusable compiler session for transpiling many modules (e.g. hot reload).
+// A session keeps compiler state alive between calls and remembers each module's
+// output by filename: transpiling a filename again with byte-identical source
+// returns the cached output without re-parsing. Hygiene state is dropped and
+// rebuilt every 256 re-parses, so a session's memory stays bounded by its cache.
+// Not thread-safe; use one session per thread.
+typedef struct SwcSession SwcSession;
+
+SwcSession* swc_session_create(void);
+
+// Like swc_transpile_ts, but `source` and `filename` are (pointer, length) pairs
+// that need not be NUL-terminated (UTF-8). The source is lexed in place, not copied.
+// Outputs are owned by the caller and freed with swc_free.
+int swc_session_transpile(SwcSession* session,
+                          const char* source,
+                          size_t source_len,
+                          const char* filename,
+                          size_t filename_len,
+                          const char* source_map_mode, // "none" | "inline" | "file"
+                          char** out_js,
+                          char** out_sourcemap,
+                          char** out_error);
+
+void swc_session_destroy(SwcSession* session);
+
+// Allocation contract. Every output is either
+//   - a heap buffer the caller releases with swc_free (the functions above), or
+//   - memory in an SwcArena the caller owns (the *_arena functions below), valid
+//     until swc_arena_reset or swc_arena_destroy and never freed individually.
+// Reset an arena once per frame or per batch; after it has grown to fit one
+// frame's outputs it stops allocating. The compiler's own scratch memory
+// (AST, codegen buffers) still comes from the Rust global allocator.
+
+// Memory source for an arena's blocks. `alloc` must return `size` bytes aligned
+// to `align` (16) or NULL; `free` receives the same size and may be NULL if the
+// caller reclaims the memory itself (e.g. a frame allocator).
+typedef struct SwcAllocator {
+    void* (*alloc)(void* user_data, size_t size, size_t align);
+    void (*free)(void* user_data, void* ptr, size_t size);
+    void* user_data;
+} SwcAllocator;
+
+// Not thread-safe; use one arena per thread, like sessions.
+typedef struct SwcArena SwcArena;
+
+// `block_size` 0 picks 1 MiB; outputs larger than a block get a block of their
+// own. `allocator` NULL uses the global heap; the struct is copied.
+SwcArena* swc_arena_create(size_t block_size, const SwcAllocator* allocator);
+
+// Invalidates every output allocated from the arena; keeps its blocks.
+void swc_arena_reset(SwcArena* arena);
+
+// Bytes used since the last reset (including unused tails of filled blocks),
+// for sizing `block_size`.
+size_t swc_arena_used(const SwcArena* arena);
+
+// Returns the blocks to the allocator.
+void swc_arena_destroy(SwcArena* arena);
+
+// swc_session_transpile with the outputs (including the error) in `arena`.
+// Cache hits copy the cached output into the arena and allocate nothing else.
+int swc_session_transpile_arena(SwcSession* session,
+                                SwcArena* arena,
+                                const char* source,
+                                size_t source_len,
+                                const char* filename,
+                                size_t filename_len,
+                                const char* source_map_mode, // "none" | "inline" | "file"
+                                const char** out_js,
+                                const char** out_sourcemap,
+                                const char** out_error);
+
+// swc_transpile_batch with the results table and its strings in `arena`.
+int swc_transpile_batch_arena(SwcArena* arena,
+                              const char* const* sources,
+                              const size_t* source_lens,
+                              const char* const* filenames,
+                              size_t count,
+                              const char* source_map_mode, // "none" | "inline" | "file"
+                              int threads,
+                              const SwcBatchResult** out_results);
+
+// Tracing: begin/end are called around swc_transpile_ts, swc_session_transpile
+// and swc_transpile_batch on the calling thread, with the function name (static
+// storage). The struct is copied; set it once, before the first call. NULL
+// removes the hooks. With the trace shim (build-skia.py -variant traced):
+//   SwcTraceHooks hooks = { trace_shim_hook_begin, trace_shim_hook_end, (void*)"swc" };
+typedef struct SwcTraceHooks {
+    void (*begin)(void* user_data, const char* name);
+    void (*end)(void* user_data, const char* name);
+    void* user_data;
+} SwcTraceHooks;
+
+void swc_set_trace_hooks(const SwcTraceHooks* hooks);
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
@@ -1,44 +1,94 @@
-use std::ffi::{CStr, CString};
-use std::os::raw::{c_char, c_int};
+use std::alloc::{alloc, dealloc, Layout};
+use std::collections::hash_map::DefaultHasher;
+use std::collections::HashMap;
+use std::ffi::CStr;
+use std::hash::{Hash, Hasher};
+use std::os::raw::{c_char, c_int, c_void};
 use std::ptr;
+use std::sync::atomic::{AtomicPtr, Ordering};
+use std::sync::{Arc, Mutex};
 
 use anyhow::{Context, Result};
 use swc_core::common::{
     errors::{Handler, EmitterWriter},
-    FileName, SourceMap, Globals, GLOBALS, Mark,
+    source_map::SourceMapGenConfig,
+    BytePos, FileName, LineCol, SourceMap, Globals, GLOBALS, Mark,
     sync::Lrc,
 };
+use swc_core::ecma::ast::Program;
 use swc_core::ecma::codegen::{text_writer::JsWriter, Config, Emitter};
 use swc_core::ecma::parser::{lexer::Lexer, Parser, StringInput, Syntax};
 use swc_core::ecma::transforms::typescript::strip;
+use rayon::prelude::*;
 // use swc_core::ecma::visit::FoldWith; // fold_with replaced by apply
 
+/// Mirrors SwcTraceHooks in swc.h
+#[repr(C)]
+#[derive(Clone, Copy)]
+pub struct SwcTraceHooks {
+    pub begin: Option<extern "C" fn(user_data: *mut c_void, name: *const c_char)>,
+    pub end: Option<extern "C" fn(user_data: *mut c_void, name: *const c_char)>,
+    pub user_data: *mut c_void,
+}
+
+static TRACE_HOOKS: AtomicPtr<SwcTraceHooks> = AtomicPtr::new(ptr::null_mut());
+
+/// Replaced hooks are leaked: a span on another thread may still call them
+#[no_mangle]
+pub unsafe extern "C" fn swc_set_trace_hooks(hooks: *const SwcTraceHooks) {
+    let copy = match hooks.as_ref() {
+        Some(h) => Box::into_raw(Box::new(*h)),
+        None => ptr::null_mut(),
+    };
+    TRACE_HOOKS.store(copy, Ordering::Release);
+}
+
+struct TraceSpan {
+    hooks: *const SwcTraceHooks,
+    name: &'static CStr,
+}
+
+impl TraceSpan {
+    fn new(name: &'static CStr) -> Self {
+        let hooks = TRACE_HOOKS.load(Ordering::Acquire);
+        if let Some(h) = unsafe { hooks.as_ref() } {
+            if let Some(begin) = h.begin {
+                begin(h.user_data, name.as_ptr());
+            }
+        }
+        TraceSpan { hooks, name }
+    }
+}
+
+impl Drop for TraceSpan {
+    fn drop(&mut self) {
+        if let Some(h) = unsafe { self.hooks.as_ref() } {
+            if let Some(end) = h.end {
+                end(h.user_data, self.name.as_ptr());
+            }
+        }
+    }
+}
+
 #[no_mangle]
 pub unsafe extern "C" fn swc_transpile_ts(
     source: *const c_char,
     filename: *const c_char,
-    _source_map_mode: *const c_char, // Unused for now
+    source_map_mode: *const c_char,
     out_js: *mut *mut c_char,
     out_sourcemap: *mut *mut c_char,
     out_error: *mut *mut c_char,
 ) -> c_int {
-    // Helper to set error output
-    let set_error = |err_msg: String| {
-        let c_err = CString::new(err_msg).unwrap_or_default();
-        *out_error = c_err.into_raw();
-        *out_js = ptr::null_mut();
-        *out_sourcemap = ptr::null_mut();
-    };
-
+    let _span = TraceSpan::new(c"swc_transpile_ts");
     if source.is_null() || filename.is_null() {
-        set_error("Source or filename is null".to_string());
+        write_error(&mut OutputSink::Heap, out_js, out_sourcemap, out_error, "Source or filename is null".to_string());
         return 1;
     }
 
     let source_str = match CStr::from_ptr(source).to_str() {
         Ok(s) => s,
         Err(e) => {
-            set_error(format!("Invalid source encoding: {}", e));
+            write_error(&mut OutputSink::Heap, out_js, out_sourcemap, out_error, format!("Invalid source encoding: {}", e));
             return 1;
         }
     };
@@ -46,91 +96,839 @@ pub unsafe extern "C" fn swc_transpile_ts(
     let filename_str = match CStr::from_ptr(filename).to_str() {
         Ok(s) => s,
         Err(e) => {
-            set_error(format!("Invalid filename encoding: {}", e));
+            write_error(&mut OutputSink::Heap, out_js, out_sourcemap, out_error, format!("Invalid filename encoding: {}", e));
+            return 1;
+        }
+    };
+
+    let mode = match SourceMapMode::from_c(source_map_mode) {
+        Ok(mode) => mode,
+        Err(e) => {
+            write_error(&mut OutputSink::Heap, out_js, out_sourcemap, out_error, e);
             return 1;
         }
     };
 
-    match transpile(source_str, filename_str) {
-        Ok(js) => {
-            let c_js = CString::new(js).unwrap_or_default();
-            *out_js = c_js.into_raw();
-            *out_sourcemap = ptr::null_mut(); // Not implemented yet
+    let globals = Globals::new();
+    let result = GLOBALS.set(&globals, || transpile(source_str, filename_str, mode));
+    write_result(&mut OutputSink::Heap, result.as_ref(), out_js, out_sourcemap, out_error)
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn swc_free(ptr: *mut c_char) {
+    if !ptr.is_null() {
+        free_buffer(ptr as *mut u8);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Buffers handed to C
+//
+// Every buffer is a single allocation laid out as [header: payload size][payload],
+// and C receives a pointer to the payload. swc_free reads the size back from the
+// header, so the same call frees a lone string and a whole batch arena.
+// ---------------------------------------------------------------------------
+
+// Header size; also the payload alignment, so arenas can hold any C struct
+const BUFFER_HEADER: usize = 16;
+
+fn buffer_layout(payload_size: usize) -> Layout {
+    Layout::from_size_align(BUFFER_HEADER + payload_size, BUFFER_HEADER).expect("buffer too large")
+}
+
+/// Allocate `payload_size` bytes that the C side releases with `swc_free`.
+fn alloc_buffer(payload_size: usize) -> *mut u8 {
+    let layout = buffer_layout(payload_size);
+    unsafe {
+        let base = alloc(layout);
+        if base.is_null() {
+            std::alloc::handle_alloc_error(layout);
+        }
+        (base as *mut usize).write(payload_size);
+        base.add(BUFFER_HEADER)
+    }
+}
+
+unsafe fn free_buffer(payload: *mut u8) {
+    let base = payload.sub(BUFFER_HEADER);
+    let payload_size = (base as *const usize).read();
+    dealloc(base, buffer_layout(payload_size));
+}
+
+// ---------------------------------------------------------------------------
+// Arenas
+//
+// An arena is a chain of blocks that outputs are bump-allocated from. Reset
+// rewinds it without freeing blocks, so once the arena has grown to fit a
+// frame's (or batch's) outputs, later frames allocate nothing. Blocks come from
+// the caller's SwcAllocator if one was given, else from the global heap.
+// ---------------------------------------------------------------------------
+
+/// Mirrors SwcAllocator in swc.h
+#[repr(C)]
+#[derive(Clone, Copy)]
+pub struct SwcAllocator {
+    pub alloc: Option<unsafe extern "C" fn(user_data: *mut c_void, size: usize, align: usize) -> *mut c_void>,
+    pub free: Option<unsafe extern "C" fn(user_data: *mut c_void, ptr: *mut c_void, size: usize)>,
+    pub user_data: *mut c_void,
+}
+
+const ARENA_DEFAULT_BLOCK: usize = 1 << 20;
+// Block and allocation alignment, the same as alloc_buffer's payloads
+const ARENA_ALIGN: usize = BUFFER_HEADER;
+
+struct ArenaBlock {
+    base: *mut u8,
+    size: usize,
+}
+
+/// Opaque arena handed to C as `SwcArena*`.
+pub struct SwcArena {
+    allocator: Option<SwcAllocator>,
+    block_size: usize,
+    blocks: Vec<ArenaBlock>,
+    current: usize, // block being filled
+    used: usize,    // bytes taken from blocks[current]
+}
+
+impl SwcArena {
+    fn alloc_block(&self, size: usize) -> *mut u8 {
+        let base = match self.allocator {
+            Some(SwcAllocator { alloc: Some(alloc_fn), user_data, .. }) => unsafe {
+                alloc_fn(user_data, size, ARENA_ALIGN) as *mut u8
+            },
+            _ => unsafe { alloc(Layout::from_size_align(size, ARENA_ALIGN).expect("arena block too large")) },
+        };
+        if base.is_null() {
+            std::alloc::handle_alloc_error(Layout::from_size_align(size, ARENA_ALIGN).unwrap());
+        }
+        base
+    }
+
+    fn free_block(&self, block: &ArenaBlock) {
+        match self.allocator {
+            Some(SwcAllocator { free: Some(free_fn), user_data, .. }) => unsafe {
+                free_fn(user_data, block.base as *mut c_void, block.size)
+            },
+            Some(_) => {} // no free callback: the caller reclaims its own memory
+            None => unsafe { dealloc(block.base, Layout::from_size_align(block.size, ARENA_ALIGN).unwrap()) },
+        }
+    }
+
+    /// `size` bytes aligned to ARENA_ALIGN, valid until the next reset.
+    fn alloc(&mut self, size: usize) -> *mut u8 {
+        let size = (size.max(1) + ARENA_ALIGN - 1) & !(ARENA_ALIGN - 1);
+        if let Some(block) = self.blocks.get(self.current) {
+            if block.size - self.used >= size {
+                let p = unsafe { block.base.add(self.used) };
+                self.used += size;
+                return p;
+            }
+        }
+
+        // Move on to the next retained block that fits, or add one after the current
+        let mut next = if self.blocks.is_empty() { 0 } else { self.current + 1 };
+        while next < self.blocks.len() && self.blocks[next].size < size {
+            next += 1;
+        }
+        if next == self.blocks.len() {
+            let block_size = self.block_size.max(size);
+            let base = self.alloc_block(block_size);
+            self.blocks.push(ArenaBlock { base, size: block_size });
+        }
+        // Blocks skipped over stay unused until the next reset
+        self.current = next;
+        self.used = size;
+        self.blocks[next].base
+    }
+
+    /// Bytes consumed since the last reset, counting the unused tails of filled blocks
+    fn used_bytes(&self) -> usize {
+        self.blocks[..self.current.min(self.blocks.len())].iter().map(|b| b.size).sum::<usize>() + self.used
+    }
+}
+
+impl Drop for SwcArena {
+    fn drop(&mut self) {
+        for block in &self.blocks {
+            self.free_block(block);
+        }
+    }
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn swc_arena_create(block_size: usize, allocator: *const SwcAllocator) -> *mut SwcArena {
+    let allocator = allocator.as_ref().copied();
+    if let Some(a) = allocator {
+        if a.alloc.is_none() {
+            return ptr::null_mut();
+        }
+    }
+    Box::into_raw(Box::new(SwcArena {
+        allocator,
+        block_size: if block_size == 0 { ARENA_DEFAULT_BLOCK } else { block_size },
+        blocks: Vec::new(),
+        current: 0,
+        used: 0,
+    }))
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn swc_arena_reset(arena: *mut SwcArena) {
+    if let Some(arena) = arena.as_mut() {
+        arena.current = 0;
+        arena.used = 0;
+    }
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn swc_arena_used(arena: *const SwcArena) -> usize {
+    arena.as_ref().map_or(0, |a| a.used_bytes())
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn swc_arena_destroy(arena: *mut SwcArena) {
+    if !arena.is_null() {
+        drop(Box::from_raw(arena));
+    }
+}
+
+/// Where the strings and tables handed to C are allocated.
+enum OutputSink<'a> {
+    /// One alloc_buffer per output, released with swc_free
+    Heap,
+    /// Bump-allocated, released by swc_arena_reset / swc_arena_destroy
+    Arena(&'a mut SwcArena),
+}
+
+impl OutputSink<'_> {
+    fn alloc(&mut self, size: usize) -> *mut u8 {
+        match self {
+            OutputSink::Heap => alloc_buffer(size),
+            OutputSink::Arena(arena) => arena.alloc(size),
+        }
+    }
+
+    /// Copy `s` into a NUL-terminated buffer owned by the caller.
+    fn c_string(&mut self, s: &str) -> *mut c_char {
+        let buffer = self.alloc(s.len() + 1);
+        unsafe {
+            ptr::copy_nonoverlapping(s.as_ptr(), buffer, s.len());
+            *buffer.add(s.len()) = 0;
+        }
+        buffer as *mut c_char
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Sessions
+//
+// A session keeps one `Globals` (hygiene marks) alive across calls, lexes the caller's buffer in place, and remembers the output of
+// every module by filename so unchanged content is returned without re-parsing.
+//
+// Marks are only ever appended to `Globals`, so a long-lived session swaps in a fresh one every
+// `SESSION_GLOBALS_RESET` transpiles. Nothing outlives a call but the printed output, so no mark is
+// ever looked up in a table that has been replaced.
+// ---------------------------------------------------------------------------
+
+/// Cache-miss transpiles sharing one `Globals` before the session replaces it.
+const SESSION_GLOBALS_RESET: u32 = 256;
+
+/// Output cached for one module, keyed by filename in `SwcSession::modules`.
+struct CachedModule {
+    content_hash: u64,
+    content_len: usize,
+    mode: SourceMapMode,
+    output: Output,
+}
+
+/// Opaque compiler session handed to C as `SwcSession*`.
+pub struct SwcSession {
+    globals: Globals,
+    /// Transpiles run against `globals` since it was created.
+    globals_uses: u32,
+    modules: HashMap<String, CachedModule>,
+}
+
+#[no_mangle]
+pub extern "C" fn swc_session_create() -> *mut SwcSession {
+    Box::into_raw(Box::new(SwcSession {
+        globals: Globals::new(),
+        globals_uses: 0,
+        modules: HashMap::new(),
+    }))
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn swc_session_destroy(session: *mut SwcSession) {
+    if !session.is_null() {
+        drop(Box::from_raw(session));
+    }
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn swc_session_transpile(
+    session: *mut SwcSession,
+    source: *const c_char,
+    source_len: usize,
+    filename: *const c_char,
+    filename_len: usize,
+    source_map_mode: *const c_char,
+    out_js: *mut *mut c_char,
+    out_sourcemap: *mut *mut c_char,
+    out_error: *mut *mut c_char,
+) -> c_int {
+    let _span = TraceSpan::new(c"swc_session_transpile");
+    session_transpile(
+        &mut OutputSink::Heap, session, source, source_len, filename, filename_len, source_map_mode,
+        out_js, out_sourcemap, out_error,
+    )
+}
+
+/// Like swc_session_transpile, but the outputs live in `arena` until it is reset.
+#[no_mangle]
+pub unsafe extern "C" fn swc_session_transpile_arena(
+    session: *mut SwcSession,
+    arena: *mut SwcArena,
+    source: *const c_char,
+    source_len: usize,
+    filename: *const c_char,
+    filename_len: usize,
+    source_map_mode: *const c_char,
+    out_js: *mut *const c_char,
+    out_sourcemap: *mut *const c_char,
+    out_error: *mut *const c_char,
+) -> c_int {
+    let _span = TraceSpan::new(c"swc_session_transpile");
+    let Some(arena) = arena.as_mut() else {
+        // Nothing to allocate an error message in
+        *out_js = ptr::null();
+        *out_sourcemap = ptr::null();
+        *out_error = ptr::null();
+        return 1;
+    };
+    session_transpile(
+        &mut OutputSink::Arena(arena), session, source, source_len, filename, filename_len,
+        source_map_mode, out_js as _, out_sourcemap as _, out_error as _,
+    )
+}
+
+#[allow(clippy::too_many_arguments)]
+unsafe fn session_transpile(
+    sink: &mut OutputSink,
+    session: *mut SwcSession,
+    source: *const c_char,
+    source_len: usize,
+    filename: *const c_char,
+    filename_len: usize,
+    source_map_mode: *const c_char,
+    out_js: *mut *mut c_char,
+    out_sourcemap: *mut *mut c_char,
+    out_error: *mut *mut c_char,
+) -> c_int {
+    if session.is_null() || (source.is_null() && source_len > 0) || filename.is_null() {
+        write_error(sink, out_js, out_sourcemap, out_error, "Session, source or filename is null".to_string());
+        return 1;
+    }
+    let session = &mut *session;
+
+    let source_str = match str_from_raw(source, source_len) {
+        Ok(s) => s,
+        Err(e) => {
+            write_error(sink, out_js, out_sourcemap, out_error, format!("Invalid source encoding: {}", e));
+            return 1;
+        }
+    };
+
+    let filename_str = match str_from_raw(filename, filename_len) {
+        Ok(s) => s,
+        Err(e) => {
+            write_error(sink, out_js, out_sourcemap, out_error, format!("Invalid filename encoding: {}", e));
+            return 1;
+        }
+    };
+
+    let mode = match SourceMapMode::from_c(source_map_mode) {
+        Ok(mode) => mode,
+        Err(e) => {
+            write_error(sink, out_js, out_sourcemap, out_error, e);
+            return 1;
+        }
+    };
+
+    let result = session.transpile(source_str, filename_str, mode);
+    write_result(sink, result.as_ref().map(|output| *output), out_js, out_sourcemap, out_error)
+}
+
+impl SwcSession {
+    /// Cache hits are returned by reference, so a hit allocates nothing until the
+    /// output is copied out to C.
+    fn transpile(&mut self, source: &str, filename: &str, mode: SourceMapMode) -> Result<&Output> {
+        let content_hash = hash_source(source);
+        let hit = self.modules.get(filename).is_some_and(|cached| {
+            cached.content_hash == content_hash && cached.content_len == source.len() && cached.mode == mode
+        });
+        if !hit {
+            if self.globals_uses == SESSION_GLOBALS_RESET {
+                self.globals = Globals::new();
+                self.globals_uses = 0;
+            }
+            self.globals_uses += 1;
+            let output = GLOBALS.set(&self.globals, || transpile_in_place(source, filename, mode))?;
+            let module = CachedModule { content_hash, content_len: source.len(), mode, output };
+            match self.modules.get_mut(filename) {
+                Some(cached) => *cached = module,
+                None => {
+                    self.modules.insert(filename.to_string(), module);
+                }
+            }
+        }
+        Ok(&self.modules[filename].output)
+    }
+}
+
+fn hash_source(source: &str) -> u64 {
+    let mut hasher = DefaultHasher::new();
+    source.hash(&mut hasher);
+    hasher.finish()
+}
+
+/// Borrow `len` bytes at `ptr` as UTF-8 without copying or scanning for a NUL.
+unsafe fn str_from_raw<'a>(ptr: *const c_char, len: usize) -> std::result::Result<&'a str, std::str::Utf8Error> {
+    if len == 0 {
+        return Ok("");
+    }
+    std::str::from_utf8(std::slice::from_raw_parts(ptr as *const u8, len))
+}
+
+// ---------------------------------------------------------------------------
+// Batch transpilation
+//
+// Modules are transpiled in parallel on a rayon pool (rebuilt only when the
+// requested thread count changes), each with its own Globals. All results and
+// their strings are packed into one buffer from alloc_buffer, or into an arena.
+// ---------------------------------------------------------------------------
+
+/// Per-module result exposed to C as `SwcBatchResult`.
+#[repr(C)]
+pub struct SwcBatchResult {
+    pub js: *const c_char,
+    pub sourcemap: *const c_char,
+    pub error: *const c_char,
+}
+
+static BATCH_POOL: Mutex<Option<(usize, Arc<rayon::ThreadPool>)>> = Mutex::new(None);
+
+fn batch_pool(threads: usize) -> Result<Arc<rayon::ThreadPool>> {
+    let mut pool = BATCH_POOL.lock().unwrap_or_else(|e| e.into_inner());
+    if let Some((pool_threads, pool)) = pool.as_ref() {
+        if *pool_threads == threads {
+            return Ok(pool.clone());
+        }
+    }
+    let new_pool = Arc::new(
+        rayon::ThreadPoolBuilder::new()
+            .num_threads(threads)
+            .thread_name(|i| format!("swc-batch-{}", i))
+            .build()
+            .context("Failed to create transpile thread pool")?,
+    );
+    *pool = Some((threads, new_pool.clone()));
+    Ok(new_pool)
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn swc_transpile_batch(
+    sources: *const *const c_char,
+    source_lens: *const usize,
+    filenames: *const *const c_char,
+    count: usize,
+    source_map_mode: *const c_char,
+    threads: c_int,
+    out_results: *mut *mut SwcBatchResult,
+) -> c_int {
+    let _span = TraceSpan::new(c"swc_transpile_batch");
+    transpile_batch(&mut OutputSink::Heap, sources, source_lens, filenames, count, source_map_mode, threads, out_results)
+}
+
+/// Like swc_transpile_batch, but the results live in `arena` until it is reset.
+#[no_mangle]
+pub unsafe extern "C" fn swc_transpile_batch_arena(
+    arena: *mut SwcArena,
+    sources: *const *const c_char,
+    source_lens: *const usize,
+    filenames: *const *const c_char,
+    count: usize,
+    source_map_mode: *const c_char,
+    threads: c_int,
+    out_results: *mut *const SwcBatchResult,
+) -> c_int {
+    let _span = TraceSpan::new(c"swc_transpile_batch");
+    let Some(arena) = arena.as_mut() else {
+        return -1;
+    };
+    transpile_batch(
+        &mut OutputSink::Arena(arena), sources, source_lens, filenames, count, source_map_mode, threads,
+        out_results as _,
+    )
+}
+
+#[allow(clippy::too_many_arguments)]
+unsafe fn transpile_batch(
+    sink: &mut OutputSink,
+    sources: *const *const c_char,
+    source_lens: *const usize,
+    filenames: *const *const c_char,
+    count: usize,
+    source_map_mode: *const c_char,
+    threads: c_int,
+    out_results: *mut *mut SwcBatchResult,
+) -> c_int {
+    if out_results.is_null() {
+        return -1;
+    }
+    *out_results = ptr::null_mut();
+    if count == 0 {
+        return 0;
+    }
+    if sources.is_null() || filenames.is_null() {
+        return -1;
+    }
+    let mode = match SourceMapMode::from_c(source_map_mode) {
+        Ok(mode) => mode,
+        Err(_) => return -1,
+    };
+
+    // Borrow every input up front: the raw pointers stay on this thread and the
+    // workers only see &str slices
+    let mut inputs: Vec<std::result::Result<(&str, &str), String>> = Vec::with_capacity(count);
+    for i in 0..count {
+        let source = *sources.add(i);
+        let filename = *filenames.add(i);
+        if source.is_null() || filename.is_null() {
+            inputs.push(Err("Source or filename is null".to_string()));
+            continue;
+        }
+        let source_str = if source_lens.is_null() {
+            CStr::from_ptr(source).to_str()
+        } else {
+            str_from_raw(source, *source_lens.add(i))
+        };
+        let filename_str = CStr::from_ptr(filename).to_str();
+        inputs.push(match (source_str, filename_str) {
+            (Ok(s), Ok(f)) => Ok((s, f)),
+            (Err(e), _) => Err(format!("Invalid source encoding: {}", e)),
+            (_, Err(e)) => Err(format!("Invalid filename encoding: {}", e)),
+        });
+    }
+
+    let threads = if threads > 0 {
+        threads as usize
+    } else {
+        std::thread::available_parallelism().map(|n| n.get()).unwrap_or(1)
+    };
+
+    let outputs: Vec<std::result::Result<Output, String>> = match batch_pool(threads) {
+        Ok(pool) => pool.install(|| {
+            inputs
+                .par_iter()
+                .map(|input| {
+                    let (source, filename) = input.clone()?;
+                    let globals = Globals::new();
+                    GLOBALS
+                        .set(&globals, || transpile_in_place(source, filename, mode))
+                        .map_err(|e| format!("{:#}", e))
+                })
+                .collect()
+        }),
+        Err(e) => {
+            let message = format!("{:#}", e);
+            inputs.iter().map(|_| Err(message.clone())).collect()
+        }
+    };
+
+    *out_results = pack_batch_results(sink, &outputs);
+    outputs.iter().filter(|output| output.is_err()).count() as c_int
+}
+
+/// Lay out `[SwcBatchResult; n][string bytes...]` in a single buffer.
+fn pack_batch_results(sink: &mut OutputSink, outputs: &[std::result::Result<Output, String>]) -> *mut SwcBatchResult {
+    let c_len = |s: &str| s.len() + 1;
+    let table_size = outputs.len() * std::mem::size_of::<SwcBatchResult>();
+    let strings_size: usize = outputs
+        .iter()
+        .map(|output| match output {
+            Ok(output) => c_len(&output.js) + output.source_map.as_deref().map_or(0, c_len),
+            Err(message) => c_len(message),
+        })
+        .sum();
+
+    let buffer = sink.alloc(table_size + strings_size);
+    unsafe {
+        let table = buffer as *mut SwcBatchResult;
+        let mut cursor = buffer.add(table_size);
+        let mut push = |text: &str| {
+            ptr::copy_nonoverlapping(text.as_ptr(), cursor, text.len());
+            *cursor.add(text.len()) = 0;
+            let text_ptr = cursor as *const c_char;
+            cursor = cursor.add(text.len() + 1);
+            text_ptr
+        };
+
+        for (i, output) in outputs.iter().enumerate() {
+            let result = match output {
+                Ok(output) => SwcBatchResult {
+                    js: push(&output.js),
+                    sourcemap: output.source_map.as_deref().map_or(ptr::null(), &mut push),
+                    error: ptr::null(),
+                },
+                Err(message) => SwcBatchResult {
+                    js: ptr::null(),
+                    sourcemap: ptr::null(),
+                    error: push(message),
+                },
+            };
+            table.add(i).write(result);
+        }
+        table
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Output helpers shared by every entry point
+// ---------------------------------------------------------------------------
+
+unsafe fn write_error(
+    sink: &mut OutputSink,
+    out_js: *mut *mut c_char,
+    out_sourcemap: *mut *mut c_char,
+    out_error: *mut *mut c_char,
+    err_msg: String,
+) {
+    *out_error = sink.c_string(&err_msg);
+    *out_js = ptr::null_mut();
+    *out_sourcemap = ptr::null_mut();
+}
+
+unsafe fn write_result(
+    sink: &mut OutputSink,
+    result: std::result::Result<&Output, &anyhow::Error>,
+    out_js: *mut *mut c_char,
+    out_sourcemap: *mut *mut c_char,
+    out_error: *mut *mut c_char,
+) -> c_int {
+    match result {
+        Ok(output) => {
+            *out_js = sink.c_string(&output.js);
+            *out_sourcemap = match output.source_map.as_deref() {
+                Some(map) => sink.c_string(map),
+                None => ptr::null_mut(),
+            };
             *out_error = ptr::null_mut();
             0
         }
         Err(e) => {
-            set_error(format!("{:#}", e));
+            write_error(sink, out_js, out_sourcemap, out_error, format!("{:#}", e));
             1
         }
     }
 }
 
-#[no_mangle]
-pub unsafe extern "C" fn swc_free(ptr: *mut c_char) {
-    if !ptr.is_null() {
-        let _ = CString::from_raw(ptr);
+// ---------------------------------------------------------------------------
+// Transpilation
+// ---------------------------------------------------------------------------
+
+fn ts_syntax(filename: &str) -> Syntax {
+    let mut syntax = Syntax::Typescript(Default::default());
+    if let Syntax::Typescript(config) = &mut syntax {
+        config.tsx = filename.ends_with(".tsx");
+        config.decorators = true;
     }
+    syntax
 }
 
-fn transpile(source: &str, filename: &str) -> Result<String> {
-    let globals = Globals::new();
-    GLOBALS.set(&globals, || {
-        let cm: Lrc<SourceMap> = Default::default();
-        
-        let handler = Handler::with_emitter(
-            true,
+fn stderr_handler(cm: &Lrc<SourceMap>) -> Handler {
+    Handler::with_emitter(
+        true,
+        false,
+        Box::new(EmitterWriter::new(
+            Box::new(std::io::stderr()),
+            Some(cm.clone()),
             false,
-            Box::new(EmitterWriter::new(
-                Box::new(std::io::stderr()),
-                Some(cm.clone()),
-                false,
-                true,
-            )),
-        );
-
-        let fm = cm.new_source_file(FileName::Real(filename.into()).into(), source.to_string());
-
-        let mut syntax = Syntax::Typescript(Default::default());
-        if let Syntax::Typescript(config) = &mut syntax {
-            config.tsx = filename.ends_with(".tsx");
-            config.decorators = true;
-        }
-
-        let lexer = Lexer::new(
-            syntax,
-            Default::default(),
-            StringInput::from(&*fm),
-            None,
-        );
-
-        let mut parser = Parser::new_from(lexer);
-
-        let program = parser
-            .parse_program()
-            .map_err(|e| {
-                e.into_diagnostic(&handler).emit();
-                anyhow::anyhow!("Failed to parse TypeScript")
-            })?;
-
-        // Apply transforms
-        // Use apply directly if supported by Program, or map over program
-        let program = program.apply(&mut strip(Mark::new(), Mark::new()));
-
-        // Emit
-        let mut buf = vec![];
-        {
-            let mut emitter = Emitter {
-                cfg: Config::default(),
-                cm: cm.clone(),
-                comments: None,
-                wr: JsWriter::new(cm.clone(), "\n", &mut buf, None),
-            };
+            true,
+        )),
+    )
+}
 
-            emitter.emit_program(&program).context("Failed to emit JS")?;
+/// Strip types and print `program`. When a source map is requested, the writer
+/// records (output position, source position) pairs during the same emit pass and
+/// they are only turned into a serialized map afterwards.
+/// Must run inside `GLOBALS.set`.
+fn strip_and_emit(program: Program, cm: &Lrc<SourceMap>, filename: &str, mode: SourceMapMode) -> Result<Output> {
+    // Apply transforms
+    // Use apply directly if supported by Program, or map over program
+    let program = program.apply(&mut strip(Mark::new(), Mark::new()));
+
+    // Emit
+    let mut buf = vec![];
+    let mut mappings: Vec<(BytePos, LineCol)> = vec![];
+    {
+        let mut emitter = Emitter {
+            cfg: Config::default(),
+            cm: cm.clone(),
+            comments: None,
+            wr: JsWriter::new(
+                cm.clone(),
+                "\n",
+                &mut buf,
+                if mode == SourceMapMode::None { None } else { Some(&mut mappings) },
+            ),
+        };
+
+        emitter.emit_program(&program).context("Failed to emit JS")?;
+    }
+
+    let mut js = String::from_utf8(buf).context("Output is not valid UTF-8")?;
+    if mode == SourceMapMode::None {
+        return Ok(Output { js, source_map: None });
+    }
+
+    let mut map_json = vec![];
+    cm.build_source_map(&mappings, None, MapConfig)
+        .to_writer(&mut map_json)
+        .context("Failed to serialize source map")?;
+    let map_json = String::from_utf8(map_json).context("Source map is not valid UTF-8")?;
+
+    if mode == SourceMapMode::Inline {
+        js.push_str("\n//# sourceMappingURL=data:application/json;charset=utf-8;base64,");
+        js.push_str(&base64_encode(map_json.as_bytes()));
+        js.push('\n');
+        return Ok(Output { js, source_map: None });
+    }
+
+    js.push_str(&format!("\n//# sourceMappingURL={}\n", map_file_name(filename)));
+    Ok(Output { js, source_map: Some(map_json) })
+}
+
+/// Transpile by lexing `source` directly, without copying it into a `SourceMap`.
+/// Spans are only resolved to lines when a parse error has to be reported or a
+/// source map is requested; both go through `transpile`, which registers the file.
+/// Must run inside `GLOBALS.set`.
+fn transpile_in_place(source: &str, filename: &str, mode: SourceMapMode) -> Result<Output> {
+    if mode != SourceMapMode::None {
+        return transpile(source, filename, mode);
+    }
+
+    let start = BytePos(1);
+    let end = BytePos(1 + source.len() as u32);
+    let lexer = Lexer::new(
+        ts_syntax(filename),
+        Default::default(),
+        StringInput::new(source, start, end),
+        None,
+    );
+
+    let mut parser = Parser::new_from(lexer);
+    let program = match parser.parse_program() {
+        Ok(program) => program,
+        Err(_) => return transpile(source, filename, mode),
+    };
+
+    // Codegen only consults the SourceMap for source maps, so an empty one works here
+    let cm: Lrc<SourceMap> = Default::default();
+    strip_and_emit(program, &cm, filename, mode)
+}
+
+/// Transpile through a `SourceMap` that owns a copy of `source`.
+/// Must run inside `GLOBALS.set`.
+fn transpile(source: &str, filename: &str, mode: SourceMapMode) -> Result<Output> {
+    let cm: Lrc<SourceMap> = Default::default();
+    let handler = stderr_handler(&cm);
+
+    let fm = cm.new_source_file(FileName::Real(filename.into()).into(), source.to_string());
+
+    let lexer = Lexer::new(
+        ts_syntax(filename),
+        Default::default(),
+        StringInput::from(&*fm),
+        None,
+    );
+
+    let mut parser = Parser::new_from(lexer);
+
+    let program = parser
+        .parse_program()
+        .map_err(|e| {
+            e.into_diagnostic(&handler).emit();
+            anyhow::anyhow!("Failed to parse TypeScript")
+        })?;
+
+    strip_and_emit(program, &cm, filename, mode)
+}
+
+// ---------------------------------------------------------------------------
+// Source maps
+// ---------------------------------------------------------------------------
+
+/// `source_map_mode` argument: "none" (or NULL), "inline" (appended to the JS as a
+/// data URL) or "file" (returned separately through `out_sourcemap`).
+#[derive(Clone, Copy, PartialEq, Eq)]
+enum SourceMapMode {
+    None,
+    Inline,
+    File,
+}
+
+impl SourceMapMode {
+    unsafe fn from_c(mode: *const c_char) -> std::result::Result<Self, String> {
+        if mode.is_null() {
+            return Ok(SourceMapMode::None);
         }
+        match CStr::from_ptr(mode).to_bytes() {
+            b"" | b"none" => Ok(SourceMapMode::None),
+            b"inline" => Ok(SourceMapMode::Inline),
+            b"file" => Ok(SourceMapMode::File),
+            other => Err(format!("Unknown source map mode: {}", String::from_utf8_lossy(other))),
+        }
+    }
+}
+
+/// Transpiled module: JS plus the separate map for "file" mode.
+#[derive(Clone)]
+struct Output {
+    js: String,
+    source_map: Option<String>,
+}
+
+/// Names sources in the map by the filename the caller passed in.
+struct MapConfig;
+
+impl SourceMapGenConfig for MapConfig {
+    fn file_name_to_source(&self, f: &FileName) -> String {
+        f.to_string()
+    }
+}
+
+/// "src/app.ts" -> "app.js.map", the name used in the sourceMappingURL comment.
+fn map_file_name(filename: &str) -> String {
+    let base = filename.rsplit(|c: char| c == '/' || c == '\\').next().unwrap_or(filename);
+    let stem = base
+        .strip_suffix(".tsx")
+        .or_else(|| base.strip_suffix(".ts"))
+        .unwrap_or(base);
+    format!("{}.js.map", stem)
+}
 
-        let js = String::from_utf8(buf).context("Output is not valid UTF-8")?;
-        Ok(js)
-    })
+fn base64_encode(bytes: &[u8]) -> String {
+    const ALPHABET: &[u8; 64] = b"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    let mut out = String::with_capacity((bytes.len() + 2) / 3 * 4);
+    for chunk in bytes.chunks(3) {
+        let b = [chunk[0], *chunk.get(1).unwrap_or(&0), *chunk.get(2).unwrap_or(&0)];
+        let n = (u32::from(b[0]) << 16) | (u32::from(b[1]) << 8) | u32::from(b[2]);
+        out.push(ALPHABET[(n >> 18) as usize & 63] as char);
+        out.push(ALPHABET[(n >> 12) as usize & 63] as char);
+        out.push(if chunk.len() > 1 { ALPHABET[(n >> 6) as usize & 63] as char } else { '=' });
+        out.push(if chunk.len() > 2 { ALPHABET[n as usize & 63] as char } else { '=' });
+    }
+    out
 }
@@ -0,0 +1,80 @@
+#ifndef TRACE_SHIM_H
+#define TRACE_SHIM_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// One tracing sink for everything an app links (libtrace_shim, built by
+// build-skia.py -variant traced): Skia's trace events through SkEventTracer,
+// Dawn's through dawn::platform::Platform (trace_shim_dawn.h), and the spans the
+// FFIs emit through their trace hooks (moshi_set_trace_hooks,
+// swc_set_trace_hooks), so one timeline shows which library a frame spent its
+// time in.
+//
+// Backends:
+//   JSON   Chrome trace event format, written by trace_shim_shutdown; opens in
+//          ui.perfetto.dev (and chrome://tracing)
+//   Tracy  live zones for the Tracy profiler; only when libtrace_shim was built
+//          with TRACY_DIR (build-skia.py -tracy)
+//
+// All functions are thread-safe. Spans nest per thread: trace_shim_end closes the
+// calling thread's innermost trace_shim_begin. Category and name strings must
+// outlive the trace (string literals, as the libraries pass).
+
+typedef enum TraceShimBackend {
+    TRACE_SHIM_BACKEND_JSON = 0,
+    TRACE_SHIM_BACKEND_TRACY = 1,
+} TraceShimBackend;
+
+typedef struct TraceShimConfig {
+    TraceShimBackend backend;
+    const char* output_path;  // JSON trace file, default "trace.json"
+    // Comma-separated categories to record, e.g. "skia,dawn,moshi". NULL or "*":
+    // everything except "disabled-by-default-*" categories. A trailing '*'
+    // matches by prefix ("skia*" covers skia.gpu).
+    const char* categories;
+} TraceShimConfig;
+
+// Start recording. config may be NULL (JSON to trace.json, all categories).
+// Returns 0, or -1 if tracing is already on or the backend is not compiled in.
+int trace_shim_init(const TraceShimConfig* config);
+
+// Stop recording; the JSON backend writes its file here. Spans still open are
+// dropped. Returns 0, or -1 if the file could not be written.
+int trace_shim_shutdown(void);
+
+// 1 between trace_shim_init and trace_shim_shutdown
+int trace_shim_active(void);
+
+// Enabled flag for a category (group): nonzero while it is being recorded. The
+// pointer is stable for the life of the process, so callers can cache it.
+const uint8_t* trace_shim_category(const char* category);
+
+void trace_shim_begin(const char* category, const char* name);
+void trace_shim_end(void);
+void trace_shim_instant(const char* category, const char* name);
+void trace_shim_counter(const char* category, const char* name, double value);
+
+// Label the calling thread in the timeline
+void trace_shim_thread_name(const char* name);
+
+// For the FFIs' trace hooks, with the category as user_data:
+//   MoshiTraceHooks hooks = { trace_shim_hook_begin, trace_shim_hook_end, (void*)"moshi" };
+//   moshi_set_trace_hooks(&hooks);
+void trace_shim_hook_begin(void* category, const char* name);
+void trace_shim_hook_end(void* category, const char* name);
+
+// Route Skia's TRACE_EVENT macros here (SkEventTracer). Needs Skia built with
+// tracing compiled in (-variant traced) and libtrace_shim built against its
+// headers. Call once, before Skia records anything. Returns 0, or -1 if Skia
+// already has a tracer.
+int trace_shim_install_skia(void);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif  // TRACE_SHIM_H
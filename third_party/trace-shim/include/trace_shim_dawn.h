@@ -0,0 +1,17 @@
+#ifndef TRACE_SHIM_DAWN_H
+#define TRACE_SHIM_DAWN_H
+
+#include "dawn/platform/DawnPlatform.h"
+
+// Dawn platform whose trace events go to the trace shim (category "dawn",
+// or "dawn.<category>" for Validation, Recording and GPUWork). Chain it into the
+// instance before creating it:
+//
+//   dawn::native::DawnInstanceDescriptor dawnDesc;
+//   dawnDesc.platform = TraceShimDawnPlatform();
+//   instanceDesc.nextInChain = &dawnDesc;
+//
+// The platform is static and outlives every instance.
+dawn::platform::Platform* TraceShimDawnPlatform();
+
+#endif  // TRACE_SHIM_DAWN_H
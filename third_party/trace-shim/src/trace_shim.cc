@@ -0,0 +1,371 @@
+// Trace shim core: category registry, per-thread span stacks and the JSON and
+// Tracy backends. See trace_shim.h.
+
+#include "trace_shim.h"
+#include "trace_shim_internal.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#if defined(TRACE_SHIM_TRACY)
+#include "tracy/TracyC.h"
+#endif
+
+namespace {
+
+// `enabled` comes first: the flag pointer handed out is the Category's address
+struct Category {
+    uint8_t enabled = 0;
+    std::string name;
+};
+
+// One finished JSON event; strings are the callers' (static) ones
+struct Event {
+    char phase;  // 'X' complete, 'i' instant, 'C' counter
+    const char* category;
+    const char* name;
+    uint32_t tid;
+    uint64_t start_ns;
+    uint64_t duration_ns;
+    double value;
+};
+
+struct OpenSpan {
+    const char* category;
+    const char* name;
+    uint64_t start_ns;
+    uint32_t session;  // 0: not recorded
+#if defined(TRACE_SHIM_TRACY)
+    TracyCZoneCtx zone;
+#endif
+};
+
+struct ThreadState {
+    uint32_t tid;
+    std::vector<OpenSpan> stack;
+};
+
+std::mutex g_mutex;  // categories, filter, events, thread names
+std::unordered_map<std::string, std::unique_ptr<Category>> g_categories;
+std::vector<std::string> g_filter;
+std::vector<Event> g_events;
+std::vector<std::pair<uint32_t, std::string>> g_threadNames;
+std::string g_outputPath;
+TraceShimBackend g_backend = TRACE_SHIM_BACKEND_JSON;
+
+std::atomic<bool> g_active{false};
+// Bumped by every trace_shim_init, so spans opened in an earlier session are dropped
+std::atomic<uint32_t> g_session{0};
+std::atomic<uint32_t> g_nextTid{1};
+std::chrono::steady_clock::time_point g_epoch;
+
+ThreadState& Thread() {
+    thread_local ThreadState state{g_nextTid++, {}};
+    return state;
+}
+
+uint64_t NowNs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - g_epoch).count());
+}
+
+bool TokenEnabled(const std::string& token) {
+    if (g_filter.empty()) {
+        return token.compare(0, 20, "disabled-by-default-") != 0;
+    }
+    for (const std::string& pattern : g_filter) {
+        if (!pattern.empty() && pattern.back() == '*') {
+            if (token.compare(0, pattern.size() - 1, pattern, 0, pattern.size() - 1) == 0) {
+                return true;
+            }
+        } else if (token == pattern) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// A group ("skia,skia.gpu") is on when any of its categories is
+bool GroupEnabled(const std::string& group) {
+    size_t start = 0;
+    while (start <= group.size()) {
+        size_t comma = group.find(',', start);
+        if (comma == std::string::npos) {
+            comma = group.size();
+        }
+        if (TokenEnabled(group.substr(start, comma - start))) {
+            return true;
+        }
+        start = comma + 1;
+    }
+    return false;
+}
+
+// Caller holds g_mutex
+void UpdateFlags(bool active) {
+    for (auto& entry : g_categories) {
+        entry.second->enabled = active && GroupEnabled(entry.second->name) ? 1 : 0;
+    }
+}
+
+void AddEvent(const Event& event) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    if (g_active) {
+        g_events.push_back(event);
+    }
+}
+
+void WriteJsonString(FILE* f, const char* s) {
+    fputc('"', f);
+    for (; *s; s++) {
+        unsigned char c = static_cast<unsigned char>(*s);
+        if (c == '"' || c == '\\') {
+            fputc('\\', f);
+            fputc(c, f);
+        } else if (c < 0x20) {
+            fprintf(f, "\\u%04x", c);
+        } else {
+            fputc(c, f);
+        }
+    }
+    fputc('"', f);
+}
+
+// Chrome trace event format; caller holds g_mutex
+bool WriteJson(const std::string& path) {
+    FILE* f = fopen(path.c_str(), "w");
+    if (!f) {
+        fprintf(stderr, "trace_shim: cannot write %s\n", path.c_str());
+        return false;
+    }
+    fprintf(f, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+    bool first = true;
+    for (const auto& thread : g_threadNames) {
+        fprintf(f, "%s{\"ph\": \"M\", \"name\": \"thread_name\", \"pid\": 1, \"tid\": %u, \"args\": {\"name\": ",
+                first ? "" : ",\n", thread.first);
+        WriteJsonString(f, thread.second.c_str());
+        fprintf(f, "}}");
+        first = false;
+    }
+    for (const Event& event : g_events) {
+        fprintf(f, "%s{\"ph\": \"%c\", \"cat\": ", first ? "" : ",\n", event.phase);
+        WriteJsonString(f, event.category);
+        fprintf(f, ", \"name\": ");
+        WriteJsonString(f, event.name);
+        fprintf(f, ", \"pid\": 1, \"tid\": %u, \"ts\": %.3f", event.tid, event.start_ns / 1000.0);
+        if (event.phase == 'X') {
+            fprintf(f, ", \"dur\": %.3f", event.duration_ns / 1000.0);
+        } else if (event.phase == 'i') {
+            fprintf(f, ", \"s\": \"t\"");
+        } else if (event.phase == 'C') {
+            fprintf(f, ", \"args\": {\"value\": %.17g}", event.value);
+        }
+        fprintf(f, "}");
+        first = false;
+    }
+    fprintf(f, "\n]}\n");
+    bool ok = !ferror(f);
+    ok = fclose(f) == 0 && ok;
+    if (ok) {
+        fprintf(stderr, "trace_shim: wrote %zu events to %s\n", g_events.size(), path.c_str());
+    }
+    return ok;
+}
+
+}  // namespace
+
+namespace trace_shim {
+
+void BeginSpan(const uint8_t* enabled, const char* name) {
+    ThreadState& thread = Thread();
+    OpenSpan span = {};
+    span.name = name;
+    if (*enabled && g_active) {
+        span.category = CategoryName(enabled);
+        span.session = g_session;
+#if defined(TRACE_SHIM_TRACY)
+        if (g_backend == TRACE_SHIM_BACKEND_TRACY) {
+            uint64_t srcloc = ___tracy_alloc_srcloc_name(0, span.category, strlen(span.category), name,
+                                                         strlen(name), name, strlen(name), 0);
+            span.zone = ___tracy_emit_zone_begin_alloc(srcloc, 1);
+        }
+#endif
+        span.start_ns = NowNs();
+    }
+    thread.stack.push_back(span);
+}
+
+void EndSpan() {
+    ThreadState& thread = Thread();
+    if (thread.stack.empty()) {
+        return;
+    }
+    OpenSpan span = thread.stack.back();
+    thread.stack.pop_back();
+    if (span.session == 0 || span.session != g_session || !g_active) {
+        return;
+    }
+#if defined(TRACE_SHIM_TRACY)
+    if (g_backend == TRACE_SHIM_BACKEND_TRACY) {
+        ___tracy_emit_zone_end(span.zone);
+        return;
+    }
+#endif
+    AddEvent({'X', span.category, span.name, thread.tid, span.start_ns, NowNs() - span.start_ns, 0.0});
+}
+
+void Instant(const uint8_t* enabled, const char* name) {
+    if (!*enabled || !g_active) {
+        return;
+    }
+#if defined(TRACE_SHIM_TRACY)
+    if (g_backend == TRACE_SHIM_BACKEND_TRACY) {
+        ___tracy_emit_message(name, strlen(name), 0);
+        return;
+    }
+#endif
+    AddEvent({'i', CategoryName(enabled), name, Thread().tid, NowNs(), 0, 0.0});
+}
+
+void Counter(const uint8_t* enabled, const char* name, double value) {
+    if (!*enabled || !g_active) {
+        return;
+    }
+#if defined(TRACE_SHIM_TRACY)
+    if (g_backend == TRACE_SHIM_BACKEND_TRACY) {
+        ___tracy_emit_plot(name, value);
+        return;
+    }
+#endif
+    AddEvent({'C', CategoryName(enabled), name, Thread().tid, NowNs(), 0, value});
+}
+
+const char* CategoryName(const uint8_t* enabled) {
+    return reinterpret_cast<const Category*>(enabled)->name.c_str();
+}
+
+}  // namespace trace_shim
+
+int trace_shim_init(const TraceShimConfig* config) {
+    TraceShimConfig defaults = {TRACE_SHIM_BACKEND_JSON, nullptr, nullptr};
+    if (!config) {
+        config = &defaults;
+    }
+#if !defined(TRACE_SHIM_TRACY)
+    if (config->backend == TRACE_SHIM_BACKEND_TRACY) {
+        fprintf(stderr, "trace_shim: built without Tracy (build-skia.py -tracy)\n");
+        return -1;
+    }
+#endif
+
+    std::lock_guard<std::mutex> lock(g_mutex);
+    if (g_active) {
+        return -1;
+    }
+    g_backend = config->backend;
+    g_outputPath = config->output_path ? config->output_path : "trace.json";
+    g_filter.clear();
+    if (config->categories && strcmp(config->categories, "*") != 0) {
+        std::string list = config->categories;
+        size_t start = 0;
+        while (start < list.size()) {
+            size_t comma = list.find(',', start);
+            if (comma == std::string::npos) {
+                comma = list.size();
+            }
+            if (comma > start) {
+                g_filter.push_back(list.substr(start, comma - start));
+            }
+            start = comma + 1;
+        }
+    }
+    g_events.clear();
+    g_epoch = std::chrono::steady_clock::now();
+    g_session++;
+    UpdateFlags(true);
+    g_active = true;
+    return 0;
+}
+
+int trace_shim_shutdown(void) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    if (!g_active) {
+        return 0;
+    }
+    g_active = false;
+    UpdateFlags(false);
+    bool ok = g_backend != TRACE_SHIM_BACKEND_JSON || WriteJson(g_outputPath);
+    g_events.clear();
+    g_events.shrink_to_fit();
+    return ok ? 0 : -1;
+}
+
+int trace_shim_active(void) {
+    return g_active ? 1 : 0;
+}
+
+const uint8_t* trace_shim_category(const char* category) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    std::unique_ptr<Category>& entry = g_categories[category];
+    if (!entry) {
+        entry.reset(new Category);
+        entry->name = category;
+        entry->enabled = g_active && GroupEnabled(entry->name) ? 1 : 0;
+    }
+    return &entry->enabled;
+}
+
+void trace_shim_begin(const char* category, const char* name) {
+    trace_shim::BeginSpan(trace_shim_category(category), name);
+}
+
+void trace_shim_end(void) {
+    trace_shim::EndSpan();
+}
+
+void trace_shim_instant(const char* category, const char* name) {
+    trace_shim::Instant(trace_shim_category(category), name);
+}
+
+void trace_shim_counter(const char* category, const char* name, double value) {
+    trace_shim::Counter(trace_shim_category(category), name, value);
+}
+
+void trace_shim_thread_name(const char* name) {
+#if defined(TRACE_SHIM_TRACY)
+    ___tracy_set_thread_name(name);
+#endif
+    uint32_t tid = Thread().tid;
+    std::lock_guard<std::mutex> lock(g_mutex);
+    for (auto& thread : g_threadNames) {
+        if (thread.first == tid) {
+            thread.second = name;
+            return;
+        }
+    }
+    g_threadNames.emplace_back(tid, name);
+}
+
+void trace_shim_hook_begin(void* category, const char* name) {
+    trace_shim_begin(category ? static_cast<const char*>(category) : "ffi", name);
+}
+
+void trace_shim_hook_end(void* category, const char* name) {
+    (void)category;
+    (void)name;
+    trace_shim_end();
+}
+
+#if !defined(TRACE_SHIM_SKIA)
+int trace_shim_install_skia(void) {
+    fprintf(stderr, "trace_shim: built without Skia headers (SKIA_INCLUDE_DIR)\n");
+    return -1;
+}
+#endif
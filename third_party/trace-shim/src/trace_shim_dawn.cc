@@ -0,0 +1,61 @@
+// dawn::platform::Platform that forwards Dawn's TRACE_EVENT macros to the trace
+// shim. Dawn's scoped events are begin ('B') / end ('E') pairs on one thread.
+
+#include "trace_shim.h"
+#include "trace_shim_dawn.h"
+#include "trace_shim_internal.h"
+
+#include <chrono>
+
+namespace {
+
+class ShimDawnPlatform : public dawn::platform::Platform {
+public:
+    const unsigned char* GetTraceCategoryEnabledFlag(dawn::platform::TraceCategory category) override {
+        static const uint8_t* general = trace_shim_category("dawn");
+        static const uint8_t* validation = trace_shim_category("dawn.validation");
+        static const uint8_t* recording = trace_shim_category("dawn.recording");
+        static const uint8_t* gpuWork = trace_shim_category("dawn.gpu_work");
+        switch (category) {
+            case dawn::platform::TraceCategory::Validation:
+                return validation;
+            case dawn::platform::TraceCategory::Recording:
+                return recording;
+            case dawn::platform::TraceCategory::GPUWork:
+                return gpuWork;
+            default:
+                return general;
+        }
+    }
+
+    double MonotonicallyIncreasingTime() override {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    uint64_t AddTraceEvent(char phase, const unsigned char* categoryGroupEnabled, const char* name, uint64_t id,
+                           double timestamp, int numArgs, const char** argNames, const unsigned char* argTypes,
+                           const uint64_t* argValues, unsigned char flags) override {
+        switch (phase) {
+            case 'B':  // TRACE_EVENT_PHASE_BEGIN
+                trace_shim::BeginSpan(categoryGroupEnabled, name);
+                break;
+            case 'E':  // TRACE_EVENT_PHASE_END
+                trace_shim::EndSpan();
+                break;
+            case 'I':  // TRACE_EVENT_PHASE_INSTANT
+            case 'i':
+                trace_shim::Instant(categoryGroupEnabled, name);
+                break;
+            default:
+                break;
+        }
+        return 0;
+    }
+};
+
+}  // namespace
+
+dawn::platform::Platform* TraceShimDawnPlatform() {
+    static ShimDawnPlatform platform;
+    return &platform;
+}
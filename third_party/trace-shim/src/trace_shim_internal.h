@@ -0,0 +1,22 @@
+#ifndef TRACE_SHIM_INTERNAL_H
+#define TRACE_SHIM_INTERNAL_H
+
+#include <stdint.h>
+
+// Entry points for the Skia and Dawn adapters, which already hold the category's
+// enabled flag (from trace_shim_category) and skip the name lookup
+namespace trace_shim {
+
+// Opens a span on the calling thread; it is recorded only if `enabled` is
+// nonzero, but always pushed so EndSpan stays balanced
+void BeginSpan(const uint8_t* enabled, const char* name);
+void EndSpan();
+void Instant(const uint8_t* enabled, const char* name);
+void Counter(const uint8_t* enabled, const char* name, double value);
+
+// Category group name behind a flag returned by trace_shim_category
+const char* CategoryName(const uint8_t* enabled);
+
+}  // namespace trace_shim
+
+#endif  // TRACE_SHIM_INTERNAL_H
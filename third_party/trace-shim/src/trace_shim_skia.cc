@@ -0,0 +1,57 @@
+// SkEventTracer that forwards Skia's TRACE_EVENT macros to the trace shim.
+// Skia's scoped events arrive as a complete ('X') event followed by
+// updateTraceEventDuration on the same thread, which map onto a begin/end span.
+
+#include "trace_shim.h"
+#include "trace_shim_internal.h"
+
+#include "include/utils/SkEventTracer.h"
+
+namespace {
+
+class ShimEventTracer : public SkEventTracer {
+public:
+    const uint8_t* getCategoryGroupEnabled(const char* name) override {
+        return trace_shim_category(name);
+    }
+
+    const char* getCategoryGroupName(const uint8_t* categoryEnabledFlag) override {
+        return trace_shim::CategoryName(categoryEnabledFlag);
+    }
+
+    SkEventTracer::Handle addTraceEvent(char phase, const uint8_t* categoryEnabledFlag, const char* name,
+                                        uint64_t id, int32_t numArgs, const char** argNames,
+                                        const uint8_t* argTypes, const uint64_t* argValues,
+                                        uint8_t flags) override {
+        switch (phase) {
+            case 'X':  // TRACE_EVENT_PHASE_COMPLETE
+                trace_shim::BeginSpan(categoryEnabledFlag, name);
+                return 1;
+            case 'I':  // TRACE_EVENT_PHASE_INSTANT
+            case 'i':
+                trace_shim::Instant(categoryEnabledFlag, name);
+                break;
+            case 'C':  // TRACE_EVENT_PHASE_COUNTER: first argument, as an integer
+                if (numArgs > 0) {
+                    trace_shim::Counter(categoryEnabledFlag, name, static_cast<double>(argValues[0]));
+                }
+                break;
+            default:
+                break;
+        }
+        return 0;
+    }
+
+    void updateTraceEventDuration(const uint8_t*, const char*, SkEventTracer::Handle handle) override {
+        if (handle) {
+            trace_shim::EndSpan();
+        }
+    }
+};
+
+}  // namespace
+
+int trace_shim_install_skia(void) {
+    // Skia keeps the tracer for the rest of the process
+    return SkEventTracer::SetInstance(new ShimEventTracer, /*leakTracer=*/true) ? 0 : -1;
+}
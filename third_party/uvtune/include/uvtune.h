@@ -0,0 +1,96 @@
+#ifndef UVTUNE_H
+#define UVTUNE_H
+
+#include <stdint.h>
+
+#include "uv.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Thread-pool / io_uring tuning and an event-loop latency probe for the libuv
+// build (libuvtune, linked next to libuv).
+
+// --- Thread pool ---
+//
+// libuv sizes its pool once, from UV_THREADPOOL_SIZE, the first time any loop
+// queues work (uv_queue_work, uv_fs_*, uv_getaddrinfo...), so this must run
+// before that. It returns UV_EBUSY once the pool is running: after
+// uvtune_queue_work, or on Linux once libuv's worker threads exist, whatever
+// started them. Elsewhere a pool started by plain libuv calls (uv_fs_*,
+// uv_getaddrinfo, uv_queue_work) cannot be detected and the new size is
+// silently ignored, so call this first thing in main.
+//
+// size > 0 sets the pool size (1-1024). size == 0 keeps UV_THREADPOOL_SIZE if the
+// environment sets it, else applies the default baked in at build time
+// (build-libuv.py -threadpool-size, else libuv's 4).
+int uvtune_set_threadpool_size(unsigned int size);
+
+// Pool size libuv will use (or is using) given the settings above
+unsigned int uvtune_threadpool_size(void);
+
+// --- Loop setup ---
+//
+// Call after uv_loop_init and before the loop runs: enables idle-time metrics
+// for the probe and, on Linux when built with io_uring on, the SQPOLL io_uring
+// ring for file operations, so uv_fs_* reads and writes skip the thread pool.
+// Returns 0 or a libuv error code; io_uring being unavailable (old kernel,
+// seccomp) is not an error, see uvtune_io_uring_active.
+int uvtune_loop_init(uv_loop_t* loop);
+
+// 1 if a file operation on `loop` has gone through io_uring (Linux only).
+// libuv creates the SQPOLL ring lazily on the first file operation, so this
+// compares the process's io_uring rings with the count when uvtune_loop_init
+// ran for this loop; call it after at least one uv_fs_* request completed. Rings
+// opened since by other loops count too. 0 for a loop uvtune_loop_init never saw.
+int uvtune_io_uring_active(uv_loop_t* loop);
+
+// --- Loop lag / pool depth probe ---
+
+typedef struct UvtuneStats {
+    double window_ms;               // time covered by these stats
+    uint32_t lag_samples;
+    double lag_mean_ms;             // how late the probe timer fired (loop blocked)
+    double lag_max_ms;
+    double loop_idle_ratio;         // fraction of the window spent waiting for events
+    uint32_t pool_size;
+    uint32_t queue_depth;           // jobs waiting for a pool thread right now
+    uint32_t queue_depth_max;       // over the window
+    uint32_t jobs_running;
+    uint64_t jobs_completed;        // over the window
+    double queue_wait_mean_ms;      // submit -> start on a pool thread
+    double queue_wait_max_ms;
+} UvtuneStats;
+
+typedef struct UvtuneProbe UvtuneProbe;
+
+// Called on the loop thread every report_ms with the stats of the last window
+typedef void (*UvtuneReportFn)(const UvtuneStats* stats, void* user_data);
+
+// Start sampling `loop` every sample_ms (e.g. 10). The probe timer is unref'd, so
+// it never keeps the loop alive. report may be NULL (use uvtune_probe_snapshot).
+UvtuneProbe* uvtune_probe_start(uv_loop_t* loop, uint32_t sample_ms, uint32_t report_ms,
+                                UvtuneReportFn report, void* user_data);
+
+// Copy the current window (from the loop thread); reset != 0 starts a new one
+void uvtune_probe_snapshot(UvtuneProbe* probe, UvtuneStats* out, int reset);
+
+// Stop sampling; the probe is freed on the loop thread once the timer has closed
+// and every job queued through it has run its done callback
+void uvtune_probe_stop(UvtuneProbe* probe);
+
+// uv_queue_work that the probe can see: counts queue depth and time spent
+// waiting for a pool thread. work runs on the pool, done on the loop thread with
+// libuv's status. probe may be NULL (plain uv_queue_work). Call from the loop
+// thread only, like uv_queue_work. Returns 0 or a libuv error code.
+typedef void (*UvtuneWorkFn)(void* arg);
+typedef void (*UvtuneDoneFn)(void* arg, int status);
+int uvtune_queue_work(UvtuneProbe* probe, uv_loop_t* loop, UvtuneWorkFn work, UvtuneDoneFn done,
+                      void* arg);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // UVTUNE_H
@@ -0,0 +1,358 @@
+// Thread-pool / io_uring tuning and loop probe for libuv; see include/uvtune.h.
+
+#include "uvtune.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __linux__
+#include <dirent.h>
+#include <unistd.h>
+#endif
+
+// Set by build-libuv.py -threadpool-size; 0 leaves libuv's default
+#ifndef UVTUNE_DEFAULT_THREADPOOL_SIZE
+#define UVTUNE_DEFAULT_THREADPOOL_SIZE 0
+#endif
+
+// Set to 0 by build-libuv.py -io-uring off
+#ifndef UVTUNE_IO_URING
+#define UVTUNE_IO_URING 1
+#endif
+
+#define LIBUV_DEFAULT_THREADPOOL_SIZE 4
+#define LIBUV_MAX_THREADPOOL_SIZE 1024
+
+// Loops remembered by uvtune_loop_init; past this the oldest is forgotten
+#define UVTUNE_MAX_LOOPS 64
+
+static int g_pool_started = 0;
+
+typedef struct LoopBaseline {
+    uv_loop_t* loop;
+    int io_uring_rings;             // rings open when the loop was set up
+} LoopBaseline;
+
+static uv_once_t g_loops_once = UV_ONCE_INIT;
+static uv_mutex_t g_loops_mutex;
+static LoopBaseline g_loops[UVTUNE_MAX_LOOPS];
+static unsigned int g_loops_next = 0;
+
+static void loops_mutex_init(void) {
+    uv_mutex_init(&g_loops_mutex);
+}
+
+static unsigned int env_threadpool_size(void) {
+    char value[32];
+    size_t size = sizeof(value);
+    if (uv_os_getenv("UV_THREADPOOL_SIZE", value, &size) != 0) return 0;
+    return (unsigned int)strtoul(value, NULL, 10);
+}
+
+// libuv (1.50+) names its pool threads, so a pool started by uv_fs_*,
+// uv_getaddrinfo or plain uv_queue_work shows up in the thread list
+static int pool_threads_running(void) {
+#ifdef __linux__
+    int found = 0;
+    DIR* dir = opendir("/proc/self/task");
+    if (!dir) return 0;
+    struct dirent* entry;
+    while (!found && (entry = readdir(dir)) != NULL) {
+        if (entry->d_name[0] == '.') continue;
+        char path[300];
+        char name[32] = {0};
+        snprintf(path, sizeof(path), "/proc/self/task/%s/comm", entry->d_name);
+        FILE* file = fopen(path, "r");
+        if (!file) continue;
+        if (fgets(name, sizeof(name), file)) found = strncmp(name, "libuv-worker", 12) == 0;
+        fclose(file);
+    }
+    closedir(dir);
+    return found;
+#else
+    return 0;
+#endif
+}
+
+int uvtune_set_threadpool_size(unsigned int size) {
+    char value[32];
+    if (g_pool_started || pool_threads_running()) return UV_EBUSY;
+    if (size == 0) {
+        if (env_threadpool_size() > 0 || UVTUNE_DEFAULT_THREADPOOL_SIZE == 0) return 0;
+        size = UVTUNE_DEFAULT_THREADPOOL_SIZE;
+    }
+    if (size > LIBUV_MAX_THREADPOOL_SIZE) return UV_EINVAL;
+    snprintf(value, sizeof(value), "%u", size);
+    return uv_os_setenv("UV_THREADPOOL_SIZE", value);
+}
+
+unsigned int uvtune_threadpool_size(void) {
+    unsigned int size = env_threadpool_size();
+    if (size == 0) size = UVTUNE_DEFAULT_THREADPOOL_SIZE > 0 ? UVTUNE_DEFAULT_THREADPOOL_SIZE
+                                                              : LIBUV_DEFAULT_THREADPOOL_SIZE;
+    return size > LIBUV_MAX_THREADPOOL_SIZE ? LIBUV_MAX_THREADPOOL_SIZE : size;
+}
+
+static int count_io_uring_rings(void) {
+#ifdef __linux__
+    int count = 0;
+    DIR* dir = opendir("/proc/self/fd");
+    if (!dir) return 0;
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != NULL) {
+        char path[300];
+        char target[64];
+        snprintf(path, sizeof(path), "/proc/self/fd/%s", entry->d_name);
+        ssize_t len = readlink(path, target, sizeof(target) - 1);
+        if (len <= 0) continue;
+        target[len] = '\0';
+        if (strcmp(target, "anon_inode:[io_uring]") == 0) count++;
+    }
+    closedir(dir);
+    return count;
+#else
+    return 0;
+#endif
+}
+
+int uvtune_loop_init(uv_loop_t* loop) {
+    int rc = uv_loop_configure(loop, UV_METRICS_IDLE_TIME);
+    if (rc != 0) return rc;
+#if defined(__linux__) && UVTUNE_IO_URING && defined(UV_LOOP_USE_IO_URING_SQPOLL)
+    // File operations only go through io_uring when the loop opts in
+    rc = uv_loop_configure(loop, UV_LOOP_USE_IO_URING_SQPOLL);
+    if (rc != 0 && rc != UV_ENOSYS) return rc;
+#endif
+    int rings = count_io_uring_rings();
+
+    uv_once(&g_loops_once, loops_mutex_init);
+    uv_mutex_lock(&g_loops_mutex);
+    LoopBaseline* slot = NULL;
+    for (unsigned int i = 0; i < UVTUNE_MAX_LOOPS && !slot; i++) {
+        if (g_loops[i].loop == loop) slot = &g_loops[i];
+    }
+    if (!slot) slot = &g_loops[g_loops_next++ % UVTUNE_MAX_LOOPS];
+    slot->loop = loop;
+    slot->io_uring_rings = rings;
+    uv_mutex_unlock(&g_loops_mutex);
+    return 0;
+}
+
+int uvtune_io_uring_active(uv_loop_t* loop) {
+    int baseline = -1;
+    uv_once(&g_loops_once, loops_mutex_init);
+    uv_mutex_lock(&g_loops_mutex);
+    for (unsigned int i = 0; i < UVTUNE_MAX_LOOPS; i++) {
+        if (g_loops[i].loop == loop) baseline = g_loops[i].io_uring_rings;
+    }
+    uv_mutex_unlock(&g_loops_mutex);
+    return baseline >= 0 && count_io_uring_rings() > baseline;
+}
+
+struct UvtuneProbe {
+    uv_loop_t* loop;
+    uv_timer_t timer;
+    uint64_t sample_ns;
+    uint64_t report_ns;
+    UvtuneReportFn report;
+    void* user_data;
+    int closed;
+    uint32_t outstanding;           // jobs whose done callback has not run yet
+
+    // Loop-thread window
+    uint64_t window_start;
+    uint64_t idle_start;
+    uint64_t last_tick;
+    uint32_t lag_samples;
+    uint64_t lag_sum_ns;
+    uint64_t lag_max_ns;
+
+    // Pool counters, shared with pool threads
+    uv_mutex_t mutex;
+    uint32_t queued;
+    uint32_t queued_max;
+    uint32_t running;
+    uint64_t completed;
+    uint64_t started;
+    uint64_t wait_sum_ns;
+    uint64_t wait_max_ns;
+};
+
+typedef struct UvtuneJob {
+    uv_work_t req;
+    UvtuneProbe* probe;
+    UvtuneWorkFn work;
+    UvtuneDoneFn done;
+    void* arg;
+    uint64_t submitted;
+} UvtuneJob;
+
+static void probe_free(UvtuneProbe* probe) {
+    uv_mutex_destroy(&probe->mutex);
+    free(probe);
+}
+
+static void probe_reset_window(UvtuneProbe* probe) {
+    probe->window_start = uv_hrtime();
+    probe->idle_start = uv_metrics_idle_time(probe->loop);
+    probe->lag_samples = 0;
+    probe->lag_sum_ns = 0;
+    probe->lag_max_ns = 0;
+    uv_mutex_lock(&probe->mutex);
+    probe->queued_max = probe->queued;
+    probe->completed = 0;
+    probe->started = 0;
+    probe->wait_sum_ns = 0;
+    probe->wait_max_ns = 0;
+    uv_mutex_unlock(&probe->mutex);
+}
+
+static void probe_tick(uv_timer_t* timer) {
+    UvtuneProbe* probe = (UvtuneProbe*)timer->data;
+    uint64_t now = uv_hrtime();
+    if (probe->last_tick != 0) {
+        uint64_t expected = probe->last_tick + probe->sample_ns;
+        uint64_t late = now > expected ? now - expected : 0;
+        probe->lag_samples++;
+        probe->lag_sum_ns += late;
+        if (late > probe->lag_max_ns) probe->lag_max_ns = late;
+    }
+    probe->last_tick = now;
+
+    if (probe->report && now - probe->window_start >= probe->report_ns) {
+        UvtuneStats stats;
+        uvtune_probe_snapshot(probe, &stats, 1);
+        probe->report(&stats, probe->user_data);
+    }
+}
+
+UvtuneProbe* uvtune_probe_start(uv_loop_t* loop, uint32_t sample_ms, uint32_t report_ms,
+                                UvtuneReportFn report, void* user_data) {
+    if (!loop || sample_ms == 0) return NULL;
+    UvtuneProbe* probe = (UvtuneProbe*)calloc(1, sizeof(UvtuneProbe));
+    if (!probe) return NULL;
+    if (uv_mutex_init(&probe->mutex) != 0) {
+        free(probe);
+        return NULL;
+    }
+    probe->loop = loop;
+    probe->sample_ns = (uint64_t)sample_ms * 1000000;
+    probe->report_ns = (uint64_t)(report_ms > sample_ms ? report_ms : sample_ms) * 1000000;
+    probe->report = report;
+    probe->user_data = user_data;
+    probe_reset_window(probe);
+
+    uv_timer_init(loop, &probe->timer);
+    probe->timer.data = probe;
+    uv_timer_start(&probe->timer, probe_tick, sample_ms, sample_ms);
+    uv_unref((uv_handle_t*)&probe->timer);
+    return probe;
+}
+
+void uvtune_probe_snapshot(UvtuneProbe* probe, UvtuneStats* out, int reset) {
+    uint64_t now = uv_hrtime();
+    uint64_t window_ns = now - probe->window_start;
+    uint64_t idle_ns = uv_metrics_idle_time(probe->loop) - probe->idle_start;
+
+    memset(out, 0, sizeof(*out));
+    out->window_ms = window_ns / 1e6;
+    out->lag_samples = probe->lag_samples;
+    out->lag_mean_ms = probe->lag_samples ? probe->lag_sum_ns / 1e6 / probe->lag_samples : 0.0;
+    out->lag_max_ms = probe->lag_max_ns / 1e6;
+    out->loop_idle_ratio = window_ns ? (double)idle_ns / (double)window_ns : 0.0;
+    out->pool_size = uvtune_threadpool_size();
+
+    uv_mutex_lock(&probe->mutex);
+    out->queue_depth = probe->queued;
+    out->queue_depth_max = probe->queued_max;
+    out->jobs_running = probe->running;
+    out->jobs_completed = probe->completed;
+    out->queue_wait_mean_ms = probe->started ? probe->wait_sum_ns / 1e6 / probe->started : 0.0;
+    out->queue_wait_max_ms = probe->wait_max_ns / 1e6;
+    uv_mutex_unlock(&probe->mutex);
+
+    if (reset) probe_reset_window(probe);
+}
+
+static void probe_closed(uv_handle_t* handle) {
+    UvtuneProbe* probe = (UvtuneProbe*)handle->data;
+    probe->closed = 1;
+    if (probe->outstanding == 0) probe_free(probe);
+}
+
+void uvtune_probe_stop(UvtuneProbe* probe) {
+    if (!probe) return;
+    uv_timer_stop(&probe->timer);
+    uv_close((uv_handle_t*)&probe->timer, probe_closed);
+}
+
+static void job_work(uv_work_t* req) {
+    UvtuneJob* job = (UvtuneJob*)req->data;
+    UvtuneProbe* probe = job->probe;
+    if (probe) {
+        uint64_t wait = uv_hrtime() - job->submitted;
+        uv_mutex_lock(&probe->mutex);
+        probe->queued--;
+        probe->running++;
+        probe->started++;
+        probe->wait_sum_ns += wait;
+        if (wait > probe->wait_max_ns) probe->wait_max_ns = wait;
+        uv_mutex_unlock(&probe->mutex);
+    }
+    job->work(job->arg);
+    if (probe) {
+        uv_mutex_lock(&probe->mutex);
+        probe->running--;
+        probe->completed++;
+        uv_mutex_unlock(&probe->mutex);
+    }
+}
+
+static void job_after(uv_work_t* req, int status) {
+    UvtuneJob* job = (UvtuneJob*)req->data;
+    UvtuneProbe* probe = job->probe;
+    if (probe) {
+        if (status == UV_ECANCELED) {
+            uv_mutex_lock(&probe->mutex);
+            probe->queued--;
+            uv_mutex_unlock(&probe->mutex);
+        }
+        if (--probe->outstanding == 0 && probe->closed) probe_free(probe);
+    }
+    if (job->done) job->done(job->arg, status);
+    free(job);
+}
+
+int uvtune_queue_work(UvtuneProbe* probe, uv_loop_t* loop, UvtuneWorkFn work, UvtuneDoneFn done,
+                      void* arg) {
+    if (!loop || !work) return UV_EINVAL;
+    UvtuneJob* job = (UvtuneJob*)calloc(1, sizeof(UvtuneJob));
+    if (!job) return UV_ENOMEM;
+    job->req.data = job;
+    job->probe = probe;
+    job->work = work;
+    job->done = done;
+    job->arg = arg;
+    job->submitted = uv_hrtime();
+
+    if (probe) {
+        uv_mutex_lock(&probe->mutex);
+        probe->queued++;
+        if (probe->queued > probe->queued_max) probe->queued_max = probe->queued;
+        uv_mutex_unlock(&probe->mutex);
+        probe->outstanding++;
+    }
+    g_pool_started = 1;
+    int rc = uv_queue_work(loop, &job->req, job_work, job_after);
+    if (rc != 0) {
+        if (probe) {
+            uv_mutex_lock(&probe->mutex);
+            probe->queued--;
+            uv_mutex_unlock(&probe->mutex);
+            probe->outstanding--;
+        }
+        free(job);
+    }
+    return rc;
+}
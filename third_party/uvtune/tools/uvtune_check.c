@@ -0,0 +1,89 @@
+// Post-build check run by build-libuv.py: confirms the thread pool really runs
+// with the configured size and whether file reads went through io_uring.
+//
+// Usage: uvtune_check [pool_size]     (0 or omitted: build default / environment)
+// Prints key=value lines; exits non-zero if the observed pool size is wrong.
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "uvtune.h"
+
+#define JOB_SLEEP_MS 30
+
+static uv_mutex_t g_mutex;
+static unsigned int g_running = 0;
+static unsigned int g_running_max = 0;
+
+static void sleep_job(void* arg) {
+    (void)arg;
+    uv_mutex_lock(&g_mutex);
+    if (++g_running > g_running_max) g_running_max = g_running;
+    uv_mutex_unlock(&g_mutex);
+    uv_sleep(JOB_SLEEP_MS);
+    uv_mutex_lock(&g_mutex);
+    g_running--;
+    uv_mutex_unlock(&g_mutex);
+}
+
+static char g_buffer[4096];
+
+static void on_read(uv_fs_t* req) {
+    uv_fs_t close_req;
+    uv_file file = (uv_file)(intptr_t)req->data;
+    uv_fs_req_cleanup(req);
+    uv_fs_close(req->loop, &close_req, file, NULL);
+    uv_fs_req_cleanup(&close_req);
+}
+
+int main(int argc, char** argv) {
+    unsigned int requested = argc > 1 ? (unsigned int)atoi(argv[1]) : 0;
+    int rc = uvtune_set_threadpool_size(requested);
+    if (rc != 0) {
+        fprintf(stderr, "uvtune_set_threadpool_size failed: %s\n", uv_strerror(rc));
+        return 1;
+    }
+    unsigned int pool_size = uvtune_threadpool_size();
+
+    uv_loop_t loop;
+    uv_loop_init(&loop);
+    rc = uvtune_loop_init(&loop);
+    if (rc != 0) {
+        fprintf(stderr, "uvtune_loop_init failed: %s\n", uv_strerror(rc));
+        return 1;
+    }
+    uv_mutex_init(&g_mutex);
+    UvtuneProbe* probe = uvtune_probe_start(&loop, 5, 1000, NULL, NULL);
+
+    // Oversubscribe the pool: concurrency tops out at its real size
+    for (unsigned int i = 0; i < pool_size * 2; i++) {
+        uvtune_queue_work(probe, &loop, sleep_job, NULL, NULL);
+    }
+
+    // One async file read; with io_uring on it bypasses the pool
+    uv_fs_t open_req;
+    uv_fs_t read_req;
+    uv_file file = uv_fs_open(&loop, &open_req, argv[0], UV_FS_O_RDONLY, 0, NULL);
+    uv_fs_req_cleanup(&open_req);
+    if (file >= 0) {
+        uv_buf_t buf = uv_buf_init(g_buffer, sizeof(g_buffer));
+        read_req.data = (void*)(intptr_t)file;
+        uv_fs_read(&loop, &read_req, file, &buf, 1, 0, on_read);
+    }
+
+    uv_run(&loop, UV_RUN_DEFAULT);
+
+    UvtuneStats stats;
+    uvtune_probe_snapshot(probe, &stats, 0);
+    printf("threadpool_size=%u\n", pool_size);
+    printf("threadpool_observed=%u\n", g_running_max);
+    printf("io_uring=%d\n", uvtune_io_uring_active(&loop));
+    printf("queue_depth_max=%u\n", stats.queue_depth_max);
+    printf("queue_wait_max_ms=%.1f\n", stats.queue_wait_max_ms);
+
+    uvtune_probe_stop(probe);
+    uv_run(&loop, UV_RUN_DEFAULT);
+    uv_loop_close(&loop);
+    uv_mutex_destroy(&g_mutex);
+    return g_running_max == pool_size ? 0 : 1;
+}